@@ -0,0 +1,113 @@
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+#include "Quaternion.h"
+#include "Vector3DStack.h"
+
+/**
+ * Compares the checked and unchecked accessors of Quaternion and
+ * Vector3DStack in loops over arrays.
+ *
+ * Usage: AccessorBench [num values] [repeats]
+ */
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  const size_t repeats = argc > 2 ? strtoul(argv[2], NULL, 10) : 5;
+
+  srand(1);
+  std::vector<Vector3DStack> vectors(count);
+  std::vector<Quaternion> quaternions(count);
+  for (size_t n = 0; n < count; n++)
+  {
+    vectors[n] = Vector3DStack(rand() % 200 - 99.5, rand() % 200 - 99.5,
+                               rand() % 200 - 99.5);
+    quaternions[n] = Quaternion(rand() % 200 - 99.5, rand() % 200 - 99.5,
+                                rand() % 200 - 99.5, rand() % 200 - 99.5);
+  }
+  std::vector<Vector3DStack> unitVectors(count);
+  std::vector<Quaternion> unitQuaternions(count);
+
+  double seconds = benchBest(
+      [&]() {
+        double sum = 0.0;
+        for (size_t n = 0; n < count; n++)
+          for (int c = 0; c < 3; c++)
+            sum += vectors[n][c];
+        benchKeep(sum);
+      },
+      repeats);
+  benchReport("vector operator[]", count, seconds, "vector");
+
+  seconds = benchBest(
+      [&]() {
+        double sum = 0.0;
+        for (size_t n = 0; n < count; n++)
+          for (int c = 0; c < 3; c++)
+            sum += vectors[n].unchecked(c);
+        benchKeep(sum);
+      },
+      repeats);
+  benchReport("vector unchecked()", count, seconds, "vector");
+
+  seconds = benchBest(
+      [&]() {
+        double sum = 0.0;
+        for (size_t n = 0; n < count; n++)
+          for (int c = 0; c < 4; c++)
+            sum += quaternions[n][c];
+        benchKeep(sum);
+      },
+      repeats);
+  benchReport("quaternion operator[]", count, seconds, "quaternion");
+
+  seconds = benchBest(
+      [&]() {
+        double sum = 0.0;
+        for (size_t n = 0; n < count; n++)
+          for (int c = 0; c < 4; c++)
+            sum += quaternions[n].unchecked(c);
+        benchKeep(sum);
+      },
+      repeats);
+  benchReport("quaternion unchecked()", count, seconds, "quaternion");
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+          unitVectors[n] = vectors[n].getUnitVector();
+        benchKeep(unitVectors[count / 2].getX());
+      },
+      repeats);
+  benchReport("getUnitVector", count, seconds, "vector");
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+          unitVectors[n] = vectors[n].getUnitVectorUnchecked();
+        benchKeep(unitVectors[count / 2].getX());
+      },
+      repeats);
+  benchReport("getUnitVectorUnchecked", count, seconds, "vector");
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+          unitQuaternions[n] = quaternions[n].getUnitQuaternion();
+        benchKeep(unitQuaternions[count / 2].getReal());
+      },
+      repeats);
+  benchReport("getUnitQuaternion", count, seconds, "quaternion");
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+          unitQuaternions[n] = quaternions[n].getUnitQuaternionUnchecked();
+        benchKeep(unitQuaternions[count / 2].getReal());
+      },
+      repeats);
+  benchReport("getUnitQuaternionUnchecked", count, seconds, "quaternion");
+
+  return 0;
+}
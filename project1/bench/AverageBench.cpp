@@ -0,0 +1,62 @@
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+#include "Quaternion.h"
+#include "QuaternionAverager.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+/**
+ * Measures accumulation of samples by QuaternionAverager.
+ *
+ * Usage: AverageBench [num samples] [repeats] [num threads]
+ */
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+  const size_t repeats = argc > 2 ? strtoul(argv[2], NULL, 10) : 5;
+  const unsigned int numThreads =
+      argc > 3 ? (unsigned int)strtoul(argv[3], NULL, 10) : 0;
+
+  srand(1);
+  std::vector<double> c[4];
+  for (int n = 0; n < 4; n++)
+    c[n].resize(count);
+
+  const Quaternion centre(75.0, Vector3DStack(1.0, -1.0, 0.5));
+  for (size_t n = 0; n < count; n++)
+  {
+    const Quaternion q =
+        centre * Quaternion(rand() % 20 - 10.0, Vector3DStack(1.0, 2.0, 3.0));
+    c[0][n] = q.getReal();
+    c[1][n] = q.getI();
+    c[2][n] = q.getJ();
+    c[3][n] = q.getK();
+  }
+
+  const char *methods[] = {"eigen", "sign aligned"};
+  const char *variants[] = {" scalar", " SIMD", " SIMD threaded"};
+
+  for (int method = 0; method < 2; method++)
+  {
+    for (int run = 0; run < 3; run++)
+    {
+      Vector3DArray::setUseSimd(run > 0 && Vector3DArray::simdAvailable());
+      QuaternionAverager averager((AverageMethod)method,
+                                  run == 2 ? numThreads : 1);
+
+      const double seconds = benchBest(
+          [&]() {
+            averager.clear();
+            averager.add(&c[0][0], &c[1][0], &c[2][0], &c[3][0], count);
+            benchKeep(averager.average());
+          },
+          repeats);
+      benchReport(std::string(methods[method]) + variants[run], count,
+                  seconds, "sample");
+    }
+  }
+
+  return 0;
+}
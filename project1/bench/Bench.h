@@ -0,0 +1,99 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+/* Stops the optimiser from discarding a result that is otherwise unused */
+template <typename T> inline void benchKeep(const T &value)
+{
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+/**
+ * Times a function, returning the fastest of a number of repeats.
+ *
+ * @param func Function to time
+ * @param repeats Number of times to call the function, at least 1
+ * @return Fastest call duration in seconds
+ */
+template <typename Func> double benchBest(Func func, const size_t repeats)
+{
+  if (repeats == 0)
+    throw std::runtime_error("Benchmark repeats must be at least 1");
+
+  double best = 0.0;
+  for (size_t n = 0; n < repeats; n++)
+  {
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    func();
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+    if (n == 0 || seconds < best)
+      best = seconds;
+  }
+  return best;
+}
+
+/* Report formats, CSV is intended to be diffed across releases */
+enum BenchFormat
+{
+  BENCH_TEXT,
+  BENCH_CSV
+};
+
+/**
+ * Gets the format used by benchReport().
+ *
+ * @return Reference to the report format
+ */
+inline BenchFormat &benchFormat()
+{
+  static BenchFormat format = BENCH_TEXT;
+  return format;
+}
+
+/**
+ * Outputs the header of a benchmark report, if the format has one.
+ */
+inline void benchHeader()
+{
+  if (benchFormat() == BENCH_CSV)
+    std::cout << "name,items,ns_per_item,items_per_second,unit" << std::endl;
+}
+
+/**
+ * Outputs a line of a benchmark report.
+ *
+ * @param name Benchmark name
+ * @param items Number of items processed by one call
+ * @param seconds Duration of one call
+ * @param unit Name of one item
+ */
+inline void benchReport(const std::string &name, const size_t items,
+                        const double seconds,
+                        const std::string &unit = "item")
+{
+  if (benchFormat() == BENCH_CSV)
+  {
+    std::cout << name << "," << items << "," << std::defaultfloat
+              << std::setprecision(6)
+              << (seconds * 1e9 / items) << "," << (items / seconds) << ","
+              << unit << std::endl;
+    return;
+  }
+
+  std::cout << std::left << std::setw(44) << name << std::right
+            << std::setw(10) << std::fixed << std::setprecision(2)
+            << (seconds * 1e9 / items) << " ns/" << unit << std::setw(10)
+            << std::setprecision(1) << (items / seconds / 1e6) << " M "
+            << unit << "/s" << std::endl;
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+#include "Quaternion.h"
+#include "QuaternionCodec.h"
+#include "Vector3DArray.h"
+
+/**
+ * Calculates the angle of the rotation between two unit quaternions.
+ *
+ * @param a First quaternion
+ * @param b Second quaternion
+ * @return Angle in degrees
+ */
+static double angleBetween(const Quaternion &a, const Quaternion &b)
+{
+  const double d = std::min(1.0, std::abs(a.dot(b)));
+  return 2.0 * acos(d) * 180.0 / 3.14159265358979323846;
+}
+
+/**
+ * Reports the largest component and angle errors of decoded quaternions.
+ *
+ * @param name Format name
+ * @param in Original quaternions
+ * @param out Decoded quaternions
+ * @param bound Documented component error bound
+ */
+static void reportError(const std::string &name,
+                        const std::vector<Quaternion> &in,
+                        const std::vector<Quaternion> &out, const double bound)
+{
+  double maxError = 0.0;
+  double maxAngle = 0.0;
+  for (size_t n = 0; n < in.size(); n++)
+  {
+    const double sign = in[n].dot(out[n]) < 0.0 ? -1.0 : 1.0;
+    for (int c = 0; c < 4; c++)
+      maxError = std::max(maxError, std::abs(in[n][c] - sign * out[n][c]));
+    maxAngle = std::max(maxAngle, angleBetween(in[n], out[n]));
+  }
+
+  std::cout << name << " max component error " << std::scientific
+            << std::setprecision(2) << maxError << " (bound " << bound
+            << "), max angle error " << std::fixed << std::setprecision(4)
+            << maxAngle << " deg" << std::endl;
+}
+
+/**
+ * Measures smallest three encode and decode throughput and the error of the
+ * decoded quaternions.
+ *
+ * Usage: CodecBench [num quaternions] [repeats]
+ */
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  const size_t repeats = argc > 2 ? strtoul(argv[2], NULL, 10) : 5;
+
+  srand(1);
+  std::vector<Quaternion> in;
+  while (in.size() < count)
+  {
+    Quaternion q(rand() / (double)RAND_MAX * 2.0 - 1.0,
+                 rand() / (double)RAND_MAX * 2.0 - 1.0,
+                 rand() / (double)RAND_MAX * 2.0 - 1.0,
+                 rand() / (double)RAND_MAX * 2.0 - 1.0);
+    if (q.magnitude() > 0.1)
+      in.push_back(q.getUnitQuaternion());
+  }
+
+  std::vector<Quaternion> out(count);
+  std::vector<uint32_t> packed32(count);
+  std::vector<uint8_t> packed48(count * QuaternionCodec::PACKED48_BYTES);
+
+  std::cout << "Bytes per quaternion: " << sizeof(Quaternion) << " raw, 4 (32 bit, "
+            << sizeof(Quaternion) / 4.0 << "x), "
+            << QuaternionCodec::PACKED48_BYTES << " (48 bit, "
+            << sizeof(Quaternion) / (double)QuaternionCodec::PACKED48_BYTES
+            << "x)" << std::endl;
+
+  double seconds = benchBest(
+      [&]() {
+        QuaternionCodec::encode32(&in[0], &packed32[0], count);
+        benchKeep(packed32[0]);
+      },
+      repeats);
+  benchReport("encode32", count, seconds);
+
+  seconds = benchBest(
+      [&]() {
+        QuaternionCodec::encode48(&in[0], &packed48[0], count);
+        benchKeep(packed48[0]);
+      },
+      repeats);
+  benchReport("encode48", count, seconds);
+
+  for (int simd = 0; simd < 2; simd++)
+  {
+    Vector3DArray::setUseSimd(simd == 1 && Vector3DArray::simdAvailable());
+    const std::string kernel = simd == 1 ? " SIMD" : " scalar";
+
+    seconds = benchBest(
+        [&]() {
+          QuaternionCodec::decode32(&packed32[0], &out[0], count);
+          benchKeep(out[0]);
+        },
+        repeats);
+    benchReport("decode32" + kernel, count, seconds);
+
+    seconds = benchBest(
+        [&]() {
+          QuaternionCodec::decode48(&packed48[0], &out[0], count);
+          benchKeep(out[0]);
+        },
+        repeats);
+    benchReport("decode48" + kernel, count, seconds);
+  }
+
+  QuaternionCodec::decode32(&packed32[0], &out[0], count);
+  reportError("32 bit", in, out, QuaternionCodec::MAX_ERROR_32);
+  QuaternionCodec::decode48(&packed48[0], &out[0], count);
+  reportError("48 bit", in, out, QuaternionCodec::MAX_ERROR_48);
+
+  return 0;
+}
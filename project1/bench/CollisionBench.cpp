@@ -0,0 +1,105 @@
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+#include "ColliderSet.h"
+#include "Collision3D.h"
+#include "SweepAndPrune3D.h"
+#include "UniformGrid3D.h"
+#include "Vector3DStack.h"
+
+/**
+ * Compares the broad phases against testing every pair, for colliders spread
+ * through a cube at constant density so each has a few neighbours.
+ *
+ * Usage: CollisionBench [num colliders] [repeats]
+ */
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  const size_t repeats = argc > 2 ? strtoul(argv[2], NULL, 10) : 5;
+
+  /* About one collider per 8 unit cube */
+  const double worldSize = 2.0 * std::cbrt((double)count);
+
+  srand(1);
+  ColliderSet colliders;
+  colliders.reserve(count);
+  for (size_t n = 0; n < count; n++)
+  {
+    const Vector3DStack centre(rand() / (double)RAND_MAX * worldSize,
+                               rand() / (double)RAND_MAX * worldSize,
+                               rand() / (double)RAND_MAX * worldSize);
+    const double size = 0.2 + 0.5 * rand() / (double)RAND_MAX;
+    if (n % 2 == 0)
+      colliders.addSphere(centre, size);
+    else
+      colliders.addBox(centre, Vector3DStack(size, size, size));
+  }
+
+  std::vector<ColliderPair> pairs;
+  double seconds;
+
+  /* Testing every pair is only feasible for small counts */
+  if (count <= 20000)
+  {
+    seconds = benchBest(
+        [&]() {
+          Collision3D::findPairsBruteForce(colliders, pairs);
+          benchKeep(pairs.size());
+        },
+        repeats);
+    benchReport("brute force", count, seconds, "collider");
+  }
+
+  /* Sweep and prune tests every collider overlapping on the sweep axis, of
+   * which there are many in a large cube */
+  SweepAndPrune3D sap;
+  if (count <= 100000)
+  {
+  seconds = benchBest(
+      [&]() {
+        sap.findPairs(colliders, pairs);
+        benchKeep(pairs.size());
+      },
+      repeats);
+  benchReport("sweep and prune", count, seconds, "collider");
+
+  /* Move slightly so the sweep repairs its order rather than sorting */
+  double *x = colliders.centres().x();
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+          x[n] += (n % 3 == 0) ? 0.01 : -0.005;
+        sap.findPairs(colliders, pairs);
+        benchKeep(pairs.size());
+      },
+      repeats);
+  benchReport("sweep and prune moving", count, seconds, "collider");
+  }
+
+  UniformGrid3D grid;
+  seconds = benchBest(
+      [&]() {
+        grid.findPairs(colliders, pairs);
+        benchKeep(pairs.size());
+      },
+      repeats);
+  benchReport("uniform grid", count, seconds, "collider");
+
+  const std::vector<ColliderPair> candidates = pairs;
+  seconds = benchBest(
+      [&]() {
+        pairs = candidates;
+        Collision3D::filterPairs(colliders, pairs);
+        benchKeep(pairs.size());
+      },
+      repeats);
+  benchReport("narrow phase", candidates.size(), seconds, "pair");
+
+  std::cout << candidates.size() << " candidate pairs, " << pairs.size()
+            << " intersecting" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+#include "GeometryExpr.h"
+#include "Quaternion.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+/**
+ * Compares the plain operators against the expression templates in
+ * GeometryExpr.h on the expressions of a rigid body update step.
+ *
+ * Usage: ExprBench [num bodies] [repeats]
+ */
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+  const size_t repeats = argc > 2 ? strtoul(argv[2], NULL, 10) : 20;
+
+  const double dt = 1.0 / 60.0;
+  const Vector3DStack g(0.0, -9.81, 0.0);
+
+  srand(1);
+  std::vector<Vector3DStack> p(count), v(count), w(count);
+  std::vector<Quaternion> q(count);
+  for (size_t n = 0; n < count; n++)
+  {
+    p[n] = Vector3DStack(rand() % 100, rand() % 100, rand() % 100);
+    v[n] = Vector3DStack(rand() % 10, rand() % 10, rand() % 10);
+    w[n] = Vector3DStack(rand() % 5, rand() % 5, rand() % 5);
+    q[n] = Quaternion(rand() % 360, Vector3DStack(1.0, 2.0, 3.0));
+  }
+
+  std::vector<Vector3DStack> pOut(count);
+  std::vector<Quaternion> qOut(count);
+
+  /* p' = p + v dt + g dt^2 / 2 */
+  double seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+          pOut[n] = p[n] + v[n] * dt + g * (0.5 * dt * dt);
+        benchKeep(pOut[0]);
+      },
+      repeats);
+  benchReport("position operators", count, seconds, "body");
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+          pOut[n] = eval(lazy(p[n]) + lazy(v[n]) * dt + lazy(g) * (0.5 * dt * dt));
+        benchKeep(pOut[0]);
+      },
+      repeats);
+  benchReport("position expression", count, seconds, "body");
+
+  /* q' = q + (w q) dt / 2 */
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+        {
+          const Quaternion wq(0.0, w[n].getX(), w[n].getY(), w[n].getZ());
+          qOut[n] = q[n] + wq * q[n] * Quaternion(0.5 * dt);
+        }
+        benchKeep(qOut[0]);
+      },
+      repeats);
+  benchReport("orientation operators", count, seconds, "body");
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+        {
+          const QuatValue wq(0.0, w[n].getX(), w[n].getY(), w[n].getZ());
+          qOut[n] = eval(lazy(q[n]) + wq * lazy(q[n]) * (0.5 * dt));
+        }
+        benchKeep(qOut[0]);
+      },
+      repeats);
+  benchReport("orientation expression", count, seconds, "body");
+
+  /* Position update over arrays */
+  const Vector3DArray pa(&p[0], count);
+  const Vector3DArray va(&v[0], count);
+  Vector3DArray pb(count);
+  Vector3DArray temp(count);
+  Vector3DArray ga(count);
+  for (size_t n = 0; n < count; n++)
+    ga.set(n, g);
+
+  seconds = benchBest(
+      [&]() {
+        Vector3DArray::scale(va, dt, temp);
+        Vector3DArray::add(pa, temp, pb);
+        Vector3DArray::scale(ga, 0.5 * dt * dt, temp);
+        Vector3DArray::add(pb, temp, pb);
+        benchKeep(pb.x()[0]);
+      },
+      repeats);
+  benchReport("position array kernels", count, seconds, "body");
+
+  seconds = benchBest(
+      [&]() {
+        assign(pb, lazy(pa) + lazy(va) * dt + lazy(g) * (0.5 * dt * dt));
+        benchKeep(pb.x()[0]);
+      },
+      repeats);
+  benchReport("position array expression", count, seconds, "body");
+
+  return 0;
+}
@@ -0,0 +1,237 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "Quaternion.h"
+#include "RotationMatrix.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+/*
+ * Microbenchmarks for the core Quaternion and Vector3DStack operations.
+ *
+ * Usage: GeometryBench [--csv] [--repeats n] [--filter text] [size ...]
+ *
+ * Each size runs every benchmark whose name contains the filter text (all by
+ * default). "latency" benchmarks feed each result into the next operation so
+ * they measure the dependent chain of a single operation, "batch" benchmarks
+ * run independent operations over arrays of the given size and so measure
+ * throughput. Where an operation has a SIMD path it is run with SIMD disabled
+ * and enabled.
+ *
+ * --repeats must be at least 1.
+ *
+ * --csv outputs "name,items,ns_per_item,items_per_second,unit" lines, which
+ * can be diffed or loaded into a spreadsheet to compare releases.
+ */
+
+/* Benchmark settings shared by all benchmarks */
+struct BenchSettings
+{
+  size_t size;
+  size_t repeats;
+  std::string filter;
+};
+
+/**
+ * Times and reports a benchmark if it passes the filter.
+ *
+ * @param settings Benchmark settings
+ * @param name Benchmark name, reported with the size appended
+ * @param func Function to time, processes settings.size items
+ */
+template <typename Func>
+static void run(const BenchSettings &settings, const std::string &name,
+                Func func)
+{
+  if (name.find(settings.filter) == std::string::npos)
+    return;
+
+  benchReport(name + "/" + std::to_string(settings.size), settings.size,
+              benchBest(func, settings.repeats), "op");
+}
+
+/**
+ * Gets a random value in [-1, 1].
+ *
+ * @return Random value
+ */
+static double randomValue()
+{
+  return 2.0 * rand() / (double)RAND_MAX - 1.0;
+}
+
+/**
+ * Runs all benchmarks for one size.
+ *
+ * @param settings Benchmark settings
+ */
+static void runAll(const BenchSettings &settings)
+{
+  const size_t size = settings.size;
+
+  srand(1);
+  std::vector<Quaternion> qa(size);
+  std::vector<Quaternion> qb(size);
+  std::vector<Quaternion> qOut(size);
+  std::vector<Vector3DStack> v(size);
+  std::vector<Vector3DStack> vOut(size);
+  for (size_t n = 0; n < size; n++)
+  {
+    qa[n] = Quaternion(randomValue(), randomValue(), randomValue(),
+                       randomValue());
+    qb[n] = Quaternion(randomValue(), randomValue(), randomValue(),
+                       randomValue());
+    v[n] = Vector3DStack(randomValue(), randomValue(), randomValue());
+  }
+
+  const Quaternion r(37.0, Vector3DStack(1.0, -2.0, 0.5));
+  const Quaternion rInverse = r.inverse();
+
+  /* Single operation latency */
+
+  run(settings, "Quaternion::operator*/latency", [&]() {
+    Quaternion q = qa[0];
+    for (size_t n = 0; n < size; n++)
+      q = q * r;
+    benchKeep(q);
+  });
+
+  run(settings, "Quaternion::inverse/latency", [&]() {
+    Quaternion q = qa[0];
+    for (size_t n = 0; n < size; n++)
+      q = q.inverse();
+    benchKeep(q);
+  });
+
+  run(settings, "Quaternion::rotateVector/latency", [&]() {
+    Vector3DStack u = v[0];
+    for (size_t n = 0; n < size; n++)
+      u = r.rotateVector(u);
+    benchKeep(u);
+  });
+
+  run(settings, "Vector3DStack::getUnitVector/latency", [&]() {
+    Vector3DStack u = v[0];
+    for (size_t n = 0; n < size; n++)
+      u = u.getUnitVector();
+    benchKeep(u);
+  });
+
+  /* Batch throughput */
+
+  run(settings, "Quaternion::operator*/batch", [&]() {
+    for (size_t n = 0; n < size; n++)
+      qOut[n] = qa[n] * qb[n];
+    benchKeep(qOut[0]);
+  });
+
+  run(settings, "Quaternion::inverse/batch", [&]() {
+    for (size_t n = 0; n < size; n++)
+      qOut[n] = qa[n].inverse();
+    benchKeep(qOut[0]);
+  });
+
+  run(settings, "Quaternion::rotateVector/batch", [&]() {
+    for (size_t n = 0; n < size; n++)
+      vOut[n] = r.rotateVector(v[n]);
+    benchKeep(vOut[0]);
+  });
+
+  run(settings, "Quaternion::rotateVector/sandwich", [&]() {
+    for (size_t n = 0; n < size; n++)
+    {
+      const Quaternion p(0.0, v[n].getX(), v[n].getY(), v[n].getZ());
+      const Quaternion result = r * p * rInverse;
+      vOut[n] =
+          Vector3DStack(result.getI(), result.getJ(), result.getK());
+    }
+    benchKeep(vOut[0]);
+  });
+
+  run(settings, "Quaternion::rotateVectors/batch", [&]() {
+    r.rotateVectors(&v[0], &vOut[0], size);
+    benchKeep(vOut[0]);
+  });
+
+  run(settings, "Vector3DStack::getUnitVector/batch", [&]() {
+    for (size_t n = 0; n < size; n++)
+      vOut[n] = v[n].getUnitVector();
+    benchKeep(vOut[0]);
+  });
+
+  /* Scalar vs SIMD */
+
+  const Vector3DArray vArray(&v[0], size);
+  Vector3DArray outArray(size);
+  const RotationMatrix m(r);
+  const bool useSimd = Vector3DArray::useSimd();
+
+  for (int simd = 0; simd < 2; simd++)
+  {
+    if (simd && !Vector3DArray::simdAvailable())
+      break;
+    Vector3DArray::setUseSimd(simd != 0);
+    const std::string variant = simd ? "/simd" : "/scalar";
+
+    /* Normalised in place, the copy is made outside the timed function.
+     * Later repeats normalise unit vectors, which takes the same time */
+    outArray = vArray;
+    run(settings, "Vector3DArray::normalise" + variant, [&]() {
+      outArray.normalise();
+      benchKeep(outArray.x()[0]);
+    });
+
+    run(settings, "RotationMatrix::apply" + variant, [&]() {
+      m.apply(vArray, outArray);
+      benchKeep(outArray.x()[0]);
+    });
+  }
+
+  Vector3DArray::setUseSimd(useSimd);
+}
+
+int main(int argc, char **argv)
+{
+  BenchSettings settings;
+  settings.repeats = 20;
+  std::vector<size_t> sizes;
+
+  for (int n = 1; n < argc; n++)
+  {
+    if (strcmp(argv[n], "--csv") == 0)
+      benchFormat() = BENCH_CSV;
+    else if (strcmp(argv[n], "--repeats") == 0 && n + 1 < argc &&
+             strtoul(argv[n + 1], NULL, 10) > 0)
+      settings.repeats = strtoul(argv[++n], NULL, 10);
+    else if (strcmp(argv[n], "--filter") == 0 && n + 1 < argc)
+      settings.filter = argv[++n];
+    else if (argv[n][0] != '-' && strtoul(argv[n], NULL, 10) > 0)
+      sizes.push_back(strtoul(argv[n], NULL, 10));
+    else
+    {
+      std::cerr << "Usage: " << argv[0]
+                << " [--csv] [--repeats n] [--filter text] [size ...]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (sizes.empty())
+  {
+    sizes.push_back(1000);
+    sizes.push_back(100000);
+  }
+
+  benchHeader();
+  for (size_t n = 0; n < sizes.size(); n++)
+  {
+    settings.size = sizes[n];
+    runAll(settings);
+  }
+
+  return 0;
+}
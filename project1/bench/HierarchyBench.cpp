@@ -0,0 +1,130 @@
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+#include "Quaternion.h"
+#include "TransformHierarchy.h"
+#include "Vector3DStack.h"
+
+/*
+ * A scene node as an object, for comparison with TransformHierarchy
+ */
+struct SceneNode
+{
+  SceneNode *parent;
+  Quaternion localRotation;
+  Vector3DStack localTranslation;
+  Quaternion worldRotation;
+  Vector3DStack worldTranslation;
+};
+
+/**
+ * Recomputes the world transform of every node, one object at a time.
+ */
+static void updateObjects(std::vector<SceneNode *> &nodes)
+{
+  for (size_t n = 0; n < nodes.size(); n++)
+  {
+    SceneNode *node = nodes[n];
+    if (node->parent == NULL)
+    {
+      node->worldRotation = node->localRotation;
+      node->worldTranslation = node->localTranslation;
+    }
+    else
+    {
+      node->worldRotation = node->parent->worldRotation * node->localRotation;
+      node->worldTranslation =
+          node->parent->worldTranslation +
+          node->parent->worldRotation.rotateVector(node->localTranslation);
+    }
+  }
+}
+
+/**
+ * Measures propagation of world transforms through a scene graph.
+ *
+ * Usage: HierarchyBench [num nodes] [repeats] [num threads]
+ */
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 500000;
+  const size_t repeats = argc > 2 ? strtoul(argv[2], NULL, 10) : 5;
+  const unsigned int numThreads =
+      argc > 3 ? (unsigned int)strtoul(argv[3], NULL, 10) : 0;
+
+  /* Roughly four children per node, added in no particular level order */
+  srand(1);
+  std::vector<size_t> parents(count, TransformHierarchy::NO_PARENT);
+  for (size_t n = 1; n < count; n++)
+    parents[n] = rand() % 2 ? (n - 1) / 4 : rand() % n;
+
+  std::vector<SceneNode *> objects(count);
+  TransformHierarchy single(1);
+  TransformHierarchy threaded(numThreads);
+  for (size_t n = 0; n < count; n++)
+  {
+    const Quaternion q(rand() % 360, Vector3DStack(rand() % 5 - 2.0,
+                                                   rand() % 5 - 2.0, 1.0));
+    const Vector3DStack t(rand() % 21 - 10.0, rand() % 21 - 10.0,
+                          rand() % 21 - 10.0);
+
+    objects[n] = new SceneNode();
+    objects[n]->parent =
+        parents[n] == TransformHierarchy::NO_PARENT ? NULL
+                                                     : objects[parents[n]];
+    objects[n]->localRotation = q;
+    objects[n]->localTranslation = t;
+    single.addNode(parents[n], q, t);
+    threaded.addNode(parents[n], q, t);
+  }
+  single.update();
+  threaded.update();
+
+  benchReport("Objects, all nodes", count,
+              benchBest(
+                  [&]() {
+                    updateObjects(objects);
+                    benchKeep(objects[count - 1]->worldTranslation);
+                  },
+                  repeats),
+              "node");
+
+  const Quaternion tilt(1.0, Vector3DStack(1.0, 0.0, 0.0));
+  TransformHierarchy *hierarchies[] = {&single, &threaded};
+  const char *names[] = {"", " threaded"};
+  for (int h = 0; h < 2; h++)
+  {
+    TransformHierarchy &hierarchy = *hierarchies[h];
+
+    /* Every root moves, so every node is recomputed */
+    benchReport(std::string("Hierarchy, all nodes") + names[h], count,
+                benchBest(
+                    [&]() {
+                      hierarchy.setLocalRotation(
+                          0, hierarchy.getLocalRotation(0) * tilt);
+                      hierarchy.update();
+                      benchKeep(hierarchy.getWorldTranslation(count - 1));
+                    },
+                    repeats),
+                "node");
+
+    /* A few leaves move */
+    benchReport(std::string("Hierarchy, 1% of leaves") + names[h], count,
+                benchBest(
+                    [&]() {
+                      for (size_t n = count - 1; n > count - count / 100; n--)
+                        hierarchy.setLocalRotation(
+                            n, hierarchy.getLocalRotation(n) * tilt);
+                      hierarchy.update();
+                      benchKeep(hierarchy.getWorldTranslation(count - 1));
+                    },
+                    repeats),
+                "node");
+  }
+
+  for (size_t n = 0; n < count; n++)
+    delete objects[n];
+
+  return 0;
+}
@@ -0,0 +1,90 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "GeometryIO.h"
+#include "Quaternion.h"
+#include "Vector3DStack.h"
+
+/**
+ * Measures writing and reading an array of quaternions through a file with
+ * operator<< and operator>> and with GeometryWriter and GeometryReader.
+ *
+ * Usage: IOBench [num quaternions] [repeats] [file]
+ */
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+  const size_t repeats = argc > 2 ? strtoul(argv[2], NULL, 10) : 3;
+  const std::string path = argc > 3 ? argv[3] : "IOBench.tmp";
+
+  srand(1);
+  std::vector<Quaternion> quaternions(count);
+  for (size_t n = 0; n < count; n++)
+  {
+    quaternions[n] =
+        Quaternion(rand() % 360, Vector3DStack(rand() % 5 - 2.0,
+                                               rand() % 5 - 2.0, 1.0));
+  }
+  std::vector<Quaternion> read(count);
+
+  benchReport("Stream write (17 digits)", count,
+              benchBest(
+                  [&]() {
+                    std::ofstream out(path.c_str());
+                    out.precision(17);
+                    for (size_t n = 0; n < count; n++)
+                      out << quaternions[n] << "\n";
+                  },
+                  repeats),
+              "quaternion");
+
+  benchReport("Stream read", count,
+              benchBest(
+                  [&]() {
+                    std::ifstream in(path.c_str());
+                    for (size_t n = 0; n < count; n++)
+                      in >> read[n];
+                    benchKeep(read[count - 1]);
+                  },
+                  repeats),
+              "quaternion");
+
+  const GeometryFormat formats[] = {GEOMETRY_TEXT, GEOMETRY_BINARY};
+  const char *names[] = {"text (17 digits)", "binary"};
+  for (int f = 0; f < 2; f++)
+  {
+    benchReport(std::string("GeometryWriter ") + names[f], count,
+                benchBest(
+                    [&]() {
+                      FILE *file = fopen(path.c_str(), "wb");
+                      {
+                        GeometryWriter writer(file, formats[f]);
+                        writer.write(&quaternions[0], count);
+                      }
+                      fclose(file);
+                    },
+                    repeats),
+                "quaternion");
+
+    benchReport(std::string("GeometryReader ") + names[f], count,
+                benchBest(
+                    [&]() {
+                      FILE *file = fopen(path.c_str(), "rb");
+                      {
+                        GeometryReader reader(file, formats[f]);
+                        reader.read(&read[0], count);
+                      }
+                      fclose(file);
+                      benchKeep(read[count - 1]);
+                    },
+                    repeats),
+                "quaternion");
+  }
+
+  remove(path.c_str());
+  return 0;
+}
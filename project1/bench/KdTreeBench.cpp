@@ -0,0 +1,120 @@
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+#include "KdTree.h"
+#include "Vector3DStack.h"
+
+/**
+ * Compares nearest neighbour and radius queries on a KdTree with a brute
+ * force search using operator- and magnitude().
+ *
+ * Usage: KdTreeBench [num points] [num queries] [repeats] [num threads]
+ */
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  const size_t numQueries = argc > 2 ? strtoul(argv[2], NULL, 10) : 100000;
+  const size_t repeats = argc > 3 ? strtoul(argv[3], NULL, 10) : 3;
+  const unsigned int numThreads =
+      argc > 4 ? (unsigned int)strtoul(argv[4], NULL, 10) : 0;
+
+  srand(1);
+  std::vector<Vector3DStack> points(count);
+  for (size_t n = 0; n < count; n++)
+    points[n] = Vector3DStack(rand() / (double)RAND_MAX,
+                              rand() / (double)RAND_MAX,
+                              rand() / (double)RAND_MAX);
+
+  std::vector<Vector3DStack> queries(numQueries);
+  for (size_t n = 0; n < numQueries; n++)
+    queries[n] = Vector3DStack(rand() / (double)RAND_MAX,
+                               rand() / (double)RAND_MAX,
+                               rand() / (double)RAND_MAX);
+
+  /* Brute force is far too slow for every query, time a few */
+  const size_t bruteQueries = std::min<size_t>(numQueries, 20);
+  double seconds = benchBest(
+      [&]() {
+        for (size_t q = 0; q < bruteQueries; q++)
+        {
+          size_t best = 0;
+          double bestDistance = (points[0] - queries[q]).magnitude();
+          for (size_t n = 1; n < count; n++)
+          {
+            const double d = (points[n] - queries[q]).magnitude();
+            if (d < bestDistance)
+            {
+              bestDistance = d;
+              best = n;
+            }
+          }
+          benchKeep(best);
+        }
+      },
+      1);
+  benchReport("brute force nearest", bruteQueries, seconds, "query");
+
+  KdTree tree(1);
+  seconds = benchBest([&]() { tree.build(&points[0], count); }, repeats);
+  benchReport("build", count, seconds, "point");
+
+  KdTree threadedTree(numThreads);
+  seconds =
+      benchBest([&]() { threadedTree.build(&points[0], count); }, repeats);
+  benchReport("build threaded", count, seconds, "point");
+
+  std::vector<KdNeighbour> result;
+  seconds = benchBest(
+      [&]() {
+        for (size_t q = 0; q < numQueries; q++)
+        {
+          tree.nearest(queries[q], 1, result);
+          benchKeep(result[0]);
+        }
+      },
+      repeats);
+  benchReport("nearest", numQueries, seconds, "query");
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t q = 0; q < numQueries; q++)
+        {
+          tree.nearest(queries[q], 16, result);
+          benchKeep(result[0]);
+        }
+      },
+      repeats);
+  benchReport("16 nearest", numQueries, seconds, "query");
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t q = 0; q < numQueries; q++)
+        {
+          tree.radiusSearch(queries[q], 0.01, result);
+          benchKeep(result.size());
+        }
+      },
+      repeats);
+  benchReport("radius", numQueries, seconds, "query");
+
+  seconds = benchBest(
+      [&]() {
+        threadedTree.nearest(&queries[0], numQueries, 16, result);
+        benchKeep(result[0]);
+      },
+      repeats);
+  benchReport("16 nearest batched", numQueries, seconds, "query");
+
+  std::vector<size_t> offsets;
+  seconds = benchBest(
+      [&]() {
+        threadedTree.radiusSearch(&queries[0], numQueries, 0.01, offsets,
+                                  result);
+        benchKeep(result.size());
+      },
+      repeats);
+  benchReport("radius batched", numQueries, seconds, "query");
+
+  return 0;
+}
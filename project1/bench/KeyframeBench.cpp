@@ -0,0 +1,86 @@
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+#include "KeyframeSampler.h"
+#include "KeyframeTrack.h"
+#include "Quaternion.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+/**
+ * Measures the number of keyframe tracks sampled per second when playing back
+ * many tracks frame by frame.
+ *
+ * Usage: KeyframeBench [num tracks] [num keys] [num frames]
+ */
+int main(int argc, char **argv)
+{
+  const size_t numTracks = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+  const size_t numKeys = argc > 2 ? strtoul(argv[2], NULL, 10) : 100;
+  const size_t numFrames = argc > 3 ? strtoul(argv[3], NULL, 10) : 200;
+
+  /* Keys once per second, played back at 60 frames per second */
+  const double frameTime = 1.0 / 60.0;
+
+  srand(1);
+  std::vector<KeyframeTrack> tracks(numTracks);
+  for (size_t n = 0; n < numTracks; n++)
+  {
+    for (size_t k = 0; k < numKeys; k++)
+    {
+      const Vector3DStack axis(rand() / (double)RAND_MAX - 0.5,
+                               rand() / (double)RAND_MAX - 0.5, 1.0);
+      tracks[n].addKey((double)k, Quaternion(rand() % 360, axis));
+    }
+  }
+
+  std::vector<Quaternion> out(numTracks);
+  std::vector<size_t> cursors(numTracks, 0);
+  KeyframeSampler sampler(&tracks[0], numTracks);
+
+  const Interpolation interps[] = {INTERP_NLERP, INTERP_SLERP};
+  const char *names[] = {"NLERP", "SLERP"};
+
+  for (int i = 0; i < 2; i++)
+  {
+    double seconds = benchBest(
+        [&]() {
+          for (size_t f = 0; f < numFrames; f++)
+          {
+            for (size_t n = 0; n < numTracks; n++)
+              out[n] = tracks[n].sample(f * frameTime, cursors[n], interps[i]);
+          }
+          benchKeep(out[0]);
+        },
+        3);
+    benchReport(std::string(names[i]) + " per track", numTracks * numFrames,
+                seconds, "track");
+
+    Vector3DArray::setUseSimd(false);
+    seconds = benchBest(
+        [&]() {
+          sampler.reset();
+          for (size_t f = 0; f < numFrames; f++)
+            sampler.sample(f * frameTime, &out[0], interps[i]);
+          benchKeep(out[0]);
+        },
+        3);
+    benchReport(std::string(names[i]) + " batch scalar", numTracks * numFrames,
+                seconds, "track");
+
+    Vector3DArray::setUseSimd(Vector3DArray::simdAvailable());
+    seconds = benchBest(
+        [&]() {
+          sampler.reset();
+          for (size_t f = 0; f < numFrames; f++)
+            sampler.sample(f * frameTime, &out[0], interps[i]);
+          benchKeep(out[0]);
+        },
+        3);
+    benchReport(std::string(names[i]) + " batch SIMD", numTracks * numFrames,
+                seconds, "track");
+  }
+
+  return 0;
+}
@@ -0,0 +1,132 @@
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+#include "OrientedBox.h"
+#include "OrientedBoxSet.h"
+#include "Quaternion.h"
+#include "Vector3DStack.h"
+
+/**
+ * Tests one box against every other in the same way as OrientedBox but
+ * finding the axes of both boxes with Quaternion::rotateVector() for every
+ * pair, for comparison with the cached axes.
+ */
+static size_t countUncached(const OrientedBox &query,
+                            const std::vector<OrientedBox> &boxes)
+{
+  const Vector3DStack unit[] = {Vector3DStack(1.0, 0.0, 0.0),
+                                Vector3DStack(0.0, 1.0, 0.0),
+                                Vector3DStack(0.0, 0.0, 1.0)};
+  size_t hits = 0;
+
+  for (size_t n = 0; n < boxes.size(); n++)
+  {
+    double axesA[9];
+    double axesB[9];
+    for (int axis = 0; axis < 3; axis++)
+    {
+      const Vector3DStack a =
+          query.getOrientation().rotateVector(unit[axis]);
+      const Vector3DStack b =
+          boxes[n].getOrientation().rotateVector(unit[axis]);
+      for (int c = 0; c < 3; c++)
+      {
+        axesA[3 * axis + c] = a[c];
+        axesB[3 * axis + c] = b[c];
+      }
+    }
+
+    const Vector3DStack ca = query.getCentre();
+    const Vector3DStack ha = query.getHalfExtents();
+    const Vector3DStack cb = boxes[n].getCentre();
+    const Vector3DStack hb = boxes[n].getHalfExtents();
+    const double centreA[] = {ca[0], ca[1], ca[2]};
+    const double halfA[] = {ha[0], ha[1], ha[2]};
+    const double centreB[] = {cb[0], cb[1], cb[2]};
+    const double halfB[] = {hb[0], hb[1], hb[2]};
+
+    if (OrientedBox::intersects(centreA, axesA, halfA, centreB, axesB, halfB))
+      hits++;
+  }
+
+  return hits;
+}
+
+/**
+ * Compares testing one oriented box against many using cached axes with
+ * finding the axes for every pair.
+ *
+ * Usage: OrientedBoxBench [num boxes] [repeats]
+ */
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+  const size_t repeats = argc > 2 ? strtoul(argv[2], NULL, 10) : 10;
+
+  const double worldSize = 2.0 * std::cbrt((double)count);
+
+  srand(1);
+  std::vector<OrientedBox> boxes;
+  OrientedBoxSet set;
+  for (size_t n = 0; n < count; n++)
+  {
+    boxes.push_back(OrientedBox(
+        Vector3DStack(rand() / (double)RAND_MAX * worldSize,
+                      rand() / (double)RAND_MAX * worldSize,
+                      rand() / (double)RAND_MAX * worldSize),
+        Vector3DStack(0.2 + 0.5 * rand() / (double)RAND_MAX,
+                      0.2 + 0.5 * rand() / (double)RAND_MAX,
+                      0.2 + 0.5 * rand() / (double)RAND_MAX),
+        Quaternion(rand() % 360, Vector3DStack(rand() % 5 - 2.0,
+                                               rand() % 5 - 2.0, 1.0))));
+    set.addBox(boxes.back());
+  }
+
+  const OrientedBox query(
+      Vector3DStack(worldSize / 2, worldSize / 2, worldSize / 2),
+      Vector3DStack(3.0, 1.0, 2.0),
+      Quaternion(30.0, Vector3DStack(1.0, 1.0, 0.0)));
+
+  double seconds = benchBest(
+      [&]() {
+        set.updateAxes();
+        benchKeep(set.axis(0, 0)[0]);
+      },
+      repeats);
+  benchReport("updateAxes", count, seconds, "box");
+
+  size_t hits = 0;
+  seconds = benchBest(
+      [&]() {
+        hits = countUncached(query, boxes);
+        benchKeep(hits);
+      },
+      repeats);
+  benchReport("one vs many, uncached axes", count, seconds, "box");
+
+  seconds = benchBest(
+      [&]() {
+        size_t n = 0;
+        for (size_t b = 0; b < boxes.size(); b++)
+          n += query.intersects(boxes[b]) ? 1 : 0;
+        benchKeep(n);
+      },
+      repeats);
+  benchReport("one vs many, OrientedBox", count, seconds, "box");
+
+  std::vector<size_t> found;
+  seconds = benchBest(
+      [&]() {
+        set.findIntersecting(query, found);
+        benchKeep(found.size());
+      },
+      repeats);
+  benchReport("one vs many, OrientedBoxSet", count, seconds, "box");
+
+  std::cout << hits << " uncached hits, " << found.size() << " set hits"
+            << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+#include "Quaternion.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+/**
+ * Calculates the angle of the rotation between two unit quaternions.
+ *
+ * @param a First quaternion
+ * @param b Second quaternion
+ * @return Angle in degrees
+ */
+static double angleBetween(const Quaternion &a, const Quaternion &b)
+{
+  const double d = std::min(1.0, std::abs(a.dot(b)));
+  return 2.0 * acos(d) * 180.0 / 3.14159265358979323846;
+}
+
+/**
+ * Reports the largest and RMS errors of float vectors against double ones,
+ * relative to the length of the double vectors.
+ *
+ * @param name Operation name
+ * @param expected Double results
+ * @param actual Float results
+ */
+static void reportError(const std::string &name,
+                        const std::vector<Vector3DStack> &expected,
+                        const std::vector<Vector3DStackF> &actual)
+{
+  double maxError = 0.0;
+  double sumSquares = 0.0;
+  for (size_t n = 0; n < expected.size(); n++)
+  {
+    const double e =
+        (Vector3DStack(actual[n]) - expected[n]).magnitude() /
+        std::max(expected[n].magnitude(), 1e-30);
+    maxError = std::max(maxError, e);
+    sumSquares += e * e;
+  }
+
+  std::cout << name << " max relative error " << std::scientific
+            << std::setprecision(2) << maxError << ", RMS "
+            << std::sqrt(sumSquares / expected.size()) << std::endl;
+}
+
+/**
+ * Reports the largest angle and magnitude errors of float quaternions against
+ * double ones.
+ *
+ * @param name Operation name
+ * @param expected Double results
+ * @param actual Float results
+ */
+static void reportError(const std::string &name,
+                        const std::vector<Quaternion> &expected,
+                        const std::vector<QuaternionF> &actual)
+{
+  double maxAngle = 0.0;
+  double maxMagnitude = 0.0;
+  for (size_t n = 0; n < expected.size(); n++)
+  {
+    const Quaternion q(actual[n]);
+    const double angle = angleBetween(q.getUnitQuaternion(),
+                                      expected[n].getUnitQuaternion());
+    maxAngle = std::max(maxAngle, angle);
+    maxMagnitude = std::max(maxMagnitude, std::abs(q.magnitude() - 1.0));
+  }
+
+  std::cout << name << " max angle error " << std::scientific
+            << std::setprecision(2) << maxAngle
+            << " deg, max magnitude error " << maxMagnitude << std::endl;
+}
+
+/**
+ * Converts an array of quaternions or vectors to another scalar type.
+ *
+ * @param in Array to convert
+ * @return Converted array
+ */
+template <typename To, typename From>
+static std::vector<To> convert(const std::vector<From> &in)
+{
+  std::vector<To> out;
+  out.reserve(in.size());
+  for (size_t n = 0; n < in.size(); n++)
+    out.push_back(To(in[n]));
+  return out;
+}
+
+/**
+ * Composes a chain of small rotations without renormalising, as an
+ * integrator would between renormalisations.
+ *
+ * @param steps Rotations to compose
+ * @param out Filled with the orientation after each step
+ */
+template <typename Q>
+static void compose(const std::vector<Q> &steps, std::vector<Q> &out)
+{
+  Q q;
+  for (size_t n = 0; n < steps.size(); n++)
+  {
+    q = steps[n] * q;
+    out[n] = q;
+  }
+}
+
+/**
+ * Measures the batch operations of Quaternion and Vector3DStack in float and
+ * double, and reports the error of the float results against double.
+ *
+ * Usage: PrecisionBench [num values] [repeats]
+ */
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  const size_t repeats = argc > 2 ? strtoul(argv[2], NULL, 10) : 5;
+
+  srand(1);
+  std::vector<Quaternion> a;
+  std::vector<Quaternion> b;
+  std::vector<Vector3DStack> vectors;
+  std::vector<Quaternion> steps;
+  while (a.size() < count)
+  {
+    Quaternion q(rand() / (double)RAND_MAX * 2.0 - 1.0,
+                 rand() / (double)RAND_MAX * 2.0 - 1.0,
+                 rand() / (double)RAND_MAX * 2.0 - 1.0,
+                 rand() / (double)RAND_MAX * 2.0 - 1.0);
+    if (q.magnitude() < 0.1)
+      continue;
+    a.push_back(q.getUnitQuaternion());
+    b.push_back(Quaternion(rand() % 360, Vector3DStack(rand() % 9 - 4.0, 1.0,
+                                                       rand() % 5 - 2.0)));
+    vectors.push_back(Vector3DStack(rand() % 2000 - 999.5,
+                                    rand() % 2000 - 999.5,
+                                    rand() % 2000 - 999.5));
+    steps.push_back(Quaternion::fromRotationVector(
+        Vector3DStack(rand() % 100 - 49.5, rand() % 100 - 49.5,
+                      rand() % 100 - 49.5) *
+        1e-4));
+  }
+
+  const std::vector<QuaternionF> aF = convert<QuaternionF>(a);
+  const std::vector<QuaternionF> bF = convert<QuaternionF>(b);
+  const std::vector<Vector3DStackF> vectorsF = convert<Vector3DStackF>(vectors);
+  const std::vector<QuaternionF> stepsF = convert<QuaternionF>(steps);
+
+  std::cout << "Bytes per quaternion: " << sizeof(Quaternion) << " double, "
+            << sizeof(QuaternionF) << " float; per vector: "
+            << sizeof(Vector3DStack) << " double, " << sizeof(Vector3DStackF)
+            << " float" << std::endl;
+
+  std::vector<Vector3DStack> rotated(count);
+  std::vector<Vector3DStackF> rotatedF(count);
+  std::vector<Quaternion> products(count);
+  std::vector<QuaternionF> productsF(count);
+  std::vector<Quaternion> slerped(count);
+  std::vector<QuaternionF> slerpedF(count);
+  std::vector<Quaternion> composed(count);
+  std::vector<QuaternionF> composedF(count);
+
+  double seconds;
+  for (int simd = 0; simd < 2; simd++)
+  {
+    Vector3DArray::setUseSimd(simd == 1 && Vector3DArray::simdAvailable());
+    const std::string kernel = simd == 1 ? " SIMD" : " scalar";
+
+    seconds = benchBest(
+        [&]() {
+          a[0].rotateVectors(&vectors[0], &rotated[0], count);
+          benchKeep(rotated[0]);
+        },
+        repeats);
+    benchReport("rotateVectors double" + kernel, count, seconds, "vector");
+
+    seconds = benchBest(
+        [&]() {
+          aF[0].rotateVectors(&vectorsF[0], &rotatedF[0], count);
+          benchKeep(rotatedF[0]);
+        },
+        repeats);
+    benchReport("rotateVectors float" + kernel, count, seconds, "vector");
+  }
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+          products[n] = a[n] * b[n];
+        benchKeep(products[0]);
+      },
+      repeats);
+  benchReport("product double", count, seconds, "quaternion");
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+          productsF[n] = aF[n] * bF[n];
+        benchKeep(productsF[0]);
+      },
+      repeats);
+  benchReport("product float", count, seconds, "quaternion");
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+          slerped[n] = Quaternion::slerp(a[n], b[n], 0.3);
+        benchKeep(slerped[0]);
+      },
+      repeats);
+  benchReport("slerp double", count, seconds, "quaternion");
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < count; n++)
+          slerpedF[n] = QuaternionF::slerp(aF[n], bF[n], 0.3f);
+        benchKeep(slerpedF[0]);
+      },
+      repeats);
+  benchReport("slerp float", count, seconds, "quaternion");
+
+  compose(steps, composed);
+  compose(stepsF, composedF);
+
+  /* The inputs are rounded to float too, so this is the error a float
+   * pipeline sees rather than that of the float arithmetic alone */
+  reportError("rotateVectors", rotated, rotatedF);
+  reportError("product", products, productsF);
+  reportError("slerp", slerped, slerpedF);
+
+  /* Error after composing the first 1000, then all, rotation steps */
+  const size_t shortChain = std::min(count, (size_t)1000);
+  reportError("compose x" + std::to_string(shortChain),
+              std::vector<Quaternion>(composed.begin() + shortChain - 1,
+                                      composed.begin() + shortChain),
+              std::vector<QuaternionF>(composedF.begin() + shortChain - 1,
+                                       composedF.begin() + shortChain));
+  reportError("compose x" + std::to_string(count),
+              std::vector<Quaternion>(composed.end() - 1, composed.end()),
+              std::vector<QuaternionF>(composedF.end() - 1, composedF.end()));
+
+  return 0;
+}
@@ -0,0 +1,50 @@
+#include <cstdlib>
+
+#include "Bench.h"
+#include "Quaternion.h"
+#include "RigidBodyIntegrator.h"
+#include "RigidBodySet.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+/**
+ * Measures the time taken by one RigidBodyIntegrator step.
+ *
+ * Usage: RigidBodyBench [num bodies] [repeats] [num threads]
+ */
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  const size_t repeats = argc > 2 ? strtoul(argv[2], NULL, 10) : 10;
+  const unsigned int numThreads =
+      argc > 3 ? (unsigned int)strtoul(argv[3], NULL, 10) : 0;
+
+  srand(1);
+  RigidBodySet bodies(count);
+  for (size_t n = 0; n < count; n++)
+  {
+    bodies.setPosition(n, Vector3DStack(rand() % 100, rand() % 100, rand() % 100));
+    bodies.setVelocity(n, Vector3DStack(rand() % 10, rand() % 10, rand() % 10));
+    bodies.setOrientation(n, Quaternion(rand() % 360, Vector3DStack(1.0, 2.0, 3.0)));
+    bodies.setAngularVelocity(n, Vector3DStack(rand() % 5, rand() % 5, rand() % 5));
+  }
+
+  RigidBodyIntegrator integrator;
+  integrator.setGravity(Vector3DStack(0.0, -9.81, 0.0));
+  const double dt = 1.0 / 60.0;
+
+  const char *names[] = {"step scalar", "step SIMD", "step SIMD threaded"};
+  for (int run = 0; run < 3; run++)
+  {
+    Vector3DArray::setUseSimd(run > 0 && Vector3DArray::simdAvailable());
+    integrator.setNumThreads(run == 2 ? numThreads : 1);
+
+    const double seconds =
+        benchBest([&]() { integrator.step(bodies, dt); }, repeats);
+    benchReport(names[run], count, seconds, "body");
+    std::cout << "  " << std::setprecision(3) << seconds * 1e3 << " ms per step, "
+              << integrator.getNumThreads() << " thread(s)" << std::endl;
+  }
+
+  return 0;
+}
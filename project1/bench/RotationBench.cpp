@@ -0,0 +1,98 @@
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+#include "Quaternion.h"
+#include "RotationMatrix.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+/**
+ * Compares rotation of vectors through rotateVector() against the normalised
+ * rotation path and a cached RotationMatrix.
+ *
+ * Usage: RotationBench [num vectors] [repeats] [num threads]
+ */
+int main(int argc, char **argv)
+{
+  const size_t numVectors = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+  const size_t repeats = argc > 2 ? strtoul(argv[2], NULL, 10) : 20;
+  const unsigned int numThreads =
+      argc > 3 ? (unsigned int)strtoul(argv[3], NULL, 10) : 0;
+
+  std::vector<Vector3DStack> in(numVectors);
+  std::vector<Vector3DStack> out(numVectors);
+  srand(1);
+  for (size_t n = 0; n < numVectors; n++)
+    in[n] = Vector3DStack(rand() / (double)RAND_MAX, rand() / (double)RAND_MAX,
+                          rand() / (double)RAND_MAX);
+
+  const Quaternion q(37.0, Vector3DStack(1.0, -2.0, 0.5));
+
+  double seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < numVectors; n++)
+          out[n] = q.rotateVector(in[n]);
+        benchKeep(out[0]);
+      },
+      repeats);
+  benchReport("rotateVector", numVectors, seconds);
+
+  seconds = benchBest(
+      [&]() {
+        for (size_t n = 0; n < numVectors; n++)
+          out[n] = q.rotateVectorNormalised(in[n]);
+        benchKeep(out[0]);
+      },
+      repeats);
+  benchReport("rotateVectorNormalised", numVectors, seconds);
+
+  seconds = benchBest(
+      [&]() {
+        q.rotateVectors(&in[0], &out[0], numVectors);
+        benchKeep(out[0]);
+      },
+      repeats);
+  benchReport("rotateVectors", numVectors, seconds);
+
+  const RotationMatrix m(q);
+
+  seconds = benchBest(
+      [&]() {
+        m.apply(&in[0], &out[0], numVectors);
+        benchKeep(out[0]);
+      },
+      repeats);
+  benchReport("RotationMatrix AoS", numVectors, seconds);
+
+  const Vector3DArray inArray(&in[0], numVectors);
+  Vector3DArray outArray(numVectors);
+
+  Vector3DArray::setUseSimd(false);
+  seconds = benchBest(
+      [&]() {
+        m.apply(inArray, outArray);
+        benchKeep(outArray.x()[0]);
+      },
+      repeats);
+  benchReport("RotationMatrix SoA scalar", numVectors, seconds);
+
+  Vector3DArray::setUseSimd(Vector3DArray::simdAvailable());
+  seconds = benchBest(
+      [&]() {
+        m.apply(inArray, outArray);
+        benchKeep(outArray.x()[0]);
+      },
+      repeats);
+  benchReport("RotationMatrix SoA SIMD", numVectors, seconds);
+
+  seconds = benchBest(
+      [&]() {
+        m.apply(inArray, outArray, numThreads);
+        benchKeep(outArray.x()[0]);
+      },
+      repeats);
+  benchReport("RotationMatrix SoA threaded", numVectors, seconds);
+
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+#include "DualQuaternion.h"
+#include "DualQuaternionSkinner.h"
+#include "Quaternion.h"
+#include "RotationMatrix.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+/**
+ * Skins vertices one at a time by blending bone matrices, using a
+ * RotationMatrix and Vector3DStack per bone, for comparison with the batch
+ * dual quaternion kernel.
+ */
+static void skinMatrices(const std::vector<RotationMatrix> &rotations,
+                         const std::vector<Vector3DStack> &translations,
+                         const std::vector<Vector3DStack> &in,
+                         const unsigned int *boneIndices,
+                         const double *weights, std::vector<Vector3DStack> &out)
+{
+  for (size_t n = 0; n < in.size(); n++)
+  {
+    Vector3DStack p(0.0, 0.0, 0.0);
+    for (size_t k = 0; k < DualQuaternionSkinner::MAX_INFLUENCES; k++)
+    {
+      const unsigned int bone = boneIndices[4 * n + k];
+      p = p + (rotations[bone] * in[n] + translations[bone]) *
+                  weights[4 * n + k];
+    }
+    out[n] = p;
+  }
+}
+
+/**
+ * Measures skinning a mesh with four bone influences per vertex.
+ *
+ * Usage: SkinningBench [num vertices] [num bones] [repeats] [num threads]
+ */
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 5000000;
+  const size_t numBones = argc > 2 ? strtoul(argv[2], NULL, 10) : 64;
+  const size_t repeats = argc > 3 ? strtoul(argv[3], NULL, 10) : 3;
+  const unsigned int numThreads =
+      argc > 4 ? (unsigned int)strtoul(argv[4], NULL, 10) : 0;
+
+  srand(1);
+  std::vector<DualQuaternion> bones;
+  std::vector<RotationMatrix> rotations;
+  std::vector<Vector3DStack> translations;
+  for (size_t n = 0; n < numBones; n++)
+  {
+    const Quaternion q(rand() % 360, Vector3DStack(rand() % 5 - 2.0,
+                                                   rand() % 5 - 2.0, 1.0));
+    const Vector3DStack t(rand() % 21 - 10.0, rand() % 21 - 10.0,
+                          rand() % 21 - 10.0);
+    bones.push_back(DualQuaternion(q, t));
+    rotations.push_back(RotationMatrix(q));
+    translations.push_back(t);
+  }
+
+  /* Neighbouring vertices mostly share bones, as in a real mesh */
+  Vector3DArray in(count);
+  std::vector<Vector3DStack> inStack(count);
+  std::vector<unsigned int> indices(4 * count);
+  std::vector<double> weights(4 * count);
+  for (size_t n = 0; n < count; n++)
+  {
+    inStack[n] = Vector3DStack(rand() / (double)RAND_MAX,
+                               rand() / (double)RAND_MAX,
+                               rand() / (double)RAND_MAX);
+    in.set(n, inStack[n]);
+
+    const size_t base = n * numBones / count;
+    double total = 0.0;
+    for (size_t k = 0; k < 4; k++)
+    {
+      indices[4 * n + k] = (unsigned int)((base + k) % numBones);
+      weights[4 * n + k] = 1.0 + rand() % 4;
+      total += weights[4 * n + k];
+    }
+    for (size_t k = 0; k < 4; k++)
+      weights[4 * n + k] /= total;
+  }
+
+  std::vector<Vector3DStack> outStack(count);
+  benchReport("Matrix blend per vertex", count,
+              benchBest(
+                  [&]() {
+                    skinMatrices(rotations, translations, inStack,
+                                 &indices[0], &weights[0], outStack);
+                    benchKeep(outStack[count / 2]);
+                  },
+                  repeats),
+              "vertex");
+
+  const char *names[] = {"Dual quaternion batch scalar",
+                         "Dual quaternion batch SIMD",
+                         "Dual quaternion batch SIMD threaded"};
+  Vector3DArray out(count);
+  for (int run = 0; run < 3; run++)
+  {
+    Vector3DArray::setUseSimd(run > 0 && Vector3DArray::simdAvailable());
+    DualQuaternionSkinner skinner(run == 2 ? numThreads : 1);
+
+    const double seconds = benchBest(
+        [&]() {
+          skinner.setBones(&bones[0], bones.size());
+          skinner.skin(in, &indices[0], &weights[0], out);
+          benchKeep(out.x()[count / 2]);
+        },
+        repeats);
+    benchReport(names[run], count, seconds, "vertex");
+  }
+
+  return 0;
+}
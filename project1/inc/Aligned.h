@@ -0,0 +1,53 @@
+#ifndef _ALIGNED_H_
+#define _ALIGNED_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/*
+ * Alignment used for all batch storage, suitable for loading whole SIMD
+ * registers up to 256 bits (AVX) without crossing cache lines.
+ */
+const size_t GEOMETRY_ALIGNMENT = 32;
+
+/**
+ * Allocates memory aligned to GEOMETRY_ALIGNMENT.
+ *
+ * @param bytes Number of bytes to allocate
+ * @return Pointer to memory, must be freed with alignedFree()
+ */
+inline void *alignedAlloc(size_t bytes)
+{
+  if (bytes == 0)
+    return NULL;
+
+  void *p = NULL;
+#ifdef _WIN32
+  p = _aligned_malloc(bytes, GEOMETRY_ALIGNMENT);
+#else
+  if (posix_memalign(&p, GEOMETRY_ALIGNMENT, bytes) != 0)
+    p = NULL;
+#endif
+
+  if (p == NULL)
+    throw std::bad_alloc();
+
+  return p;
+}
+
+/**
+ * Frees memory allocated by alignedAlloc().
+ *
+ * @param p Pointer to memory, may be NULL
+ */
+inline void alignedFree(void *p)
+{
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+#endif
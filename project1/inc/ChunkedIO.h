@@ -0,0 +1,109 @@
+#ifndef _CHUNKEDIO_H_
+#define _CHUNKEDIO_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Reads a file in fixed size chunks on a background thread.
+ *
+ * Two buffers are used, so the next chunk is read while the caller processes
+ * the current one.
+ */
+class ChunkedReader
+{
+public:
+  ChunkedReader(FILE *file, const size_t chunkSize);
+  ~ChunkedReader();
+
+  bool next(const char *&data, size_t &size);
+
+private:
+  void run();
+
+  FILE *m_file;
+  std::vector<char> m_buffers[2];
+  size_t m_sizes[2];
+  bool m_full[2];
+  bool m_eof;
+  bool m_stop;
+  int m_current;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  std::thread m_thread;
+};
+
+/**
+ * Splits the chunks of a ChunkedReader into records ending in a delimiter,
+ * e.g. lines.
+ *
+ * Records within a chunk are returned in place; a record split between chunks
+ * is joined in a carry buffer.
+ */
+class ChunkedSplitter
+{
+public:
+  ChunkedSplitter(ChunkedReader &reader, const char delimiter,
+                  const size_t maxRecord);
+  ~ChunkedSplitter();
+
+  bool next(const char *&begin, const char *&end);
+  bool terminated() const;
+
+private:
+  bool nextChunk();
+
+  ChunkedReader &m_reader;
+  char m_delimiter;
+  size_t m_maxRecord;
+
+  /* Unread part of the current chunk */
+  const char *m_pos;
+  const char *m_end;
+  bool m_eof;
+  bool m_terminated;
+
+  /* Record split between two chunks */
+  std::string m_carry;
+};
+
+/**
+ * Writes a file in fixed size chunks on a background thread.
+ *
+ * Two buffers are used, so the caller fills one while the other is written.
+ */
+class ChunkedWriter
+{
+public:
+  ChunkedWriter(FILE *file, const size_t chunkSize);
+  ~ChunkedWriter();
+
+  size_t chunkSize() const;
+  char *buffer();
+  void submit(const size_t size);
+  bool finish();
+
+private:
+  void run();
+
+  FILE *m_file;
+  size_t m_chunkSize;
+  std::vector<char> m_buffers[2];
+  size_t m_sizes[2];
+  bool m_full[2];
+  bool m_done;
+  bool m_error;
+  int m_current;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  std::thread m_thread;
+};
+
+#endif
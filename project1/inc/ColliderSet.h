@@ -0,0 +1,58 @@
+#ifndef _COLLIDERSET_H_
+#define _COLLIDERSET_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "GeometryFwd.h"
+#include "Vector3DArray.h"
+
+/* Collider shapes */
+enum ColliderShape
+{
+  COLLIDER_SPHERE,
+  COLLIDER_BOX
+};
+
+/* Pair of collider indices, lower index first */
+typedef std::pair<size_t, size_t> ColliderPair;
+
+class ColliderSet
+{
+public:
+  ColliderSet();
+  ~ColliderSet();
+
+  size_t size() const;
+  void clear();
+  void reserve(const size_t size);
+
+  size_t addSphere(const Vector3DStack &centre, const double radius);
+  size_t addBox(const Vector3DStack &centre, const Vector3DStack &halfExtents);
+
+  ColliderShape getShape(const size_t index) const;
+
+  Vector3DStack getCentre(const size_t index) const;
+  void setCentre(const size_t index, const Vector3DStack &centre);
+
+  Vector3DStack getHalfExtents(const size_t index) const;
+  double getRadius(const size_t index) const;
+
+  Vector3DStack getMin(const size_t index) const;
+  Vector3DStack getMax(const size_t index) const;
+
+  Vector3DArray &centres();
+  const Vector3DArray &centres() const;
+  const Vector3DArray &halfExtents() const;
+  const unsigned char *shapes() const;
+
+private:
+  void checkIndex(const size_t index) const;
+
+  Vector3DArray m_centres;
+  Vector3DArray m_halfExtents;
+  std::vector<unsigned char> m_shapes;
+};
+
+#endif
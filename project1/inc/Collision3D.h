@@ -0,0 +1,32 @@
+#ifndef _COLLISION3D_H_
+#define _COLLISION3D_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "ColliderSet.h"
+#include "GeometryFwd.h"
+
+class Collision3D
+{
+public:
+  static bool sphereSphere(const Vector3DStack &centreA, const double radiusA,
+                           const Vector3DStack &centreB, const double radiusB);
+  static bool sphereBox(const Vector3DStack &centre, const double radius,
+                        const Vector3DStack &boxCentre,
+                        const Vector3DStack &boxHalfExtents);
+  static bool boxBox(const Vector3DStack &centreA,
+                     const Vector3DStack &halfExtentsA,
+                     const Vector3DStack &centreB,
+                     const Vector3DStack &halfExtentsB);
+
+  static bool intersects(const ColliderSet &colliders, const size_t a,
+                         const size_t b);
+
+  static void filterPairs(const ColliderSet &colliders,
+                          std::vector<ColliderPair> &pairs);
+  static void findPairsBruteForce(const ColliderSet &colliders,
+                                  std::vector<ColliderPair> &pairs);
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef _DUALQUATERNION_H_
+#define _DUALQUATERNION_H_
+
+#include <cstddef>
+#include <iostream>
+
+#include "Quaternion.h"
+
+class DualQuaternion
+{
+public:
+  DualQuaternion();
+  DualQuaternion(const Quaternion &real, const Quaternion &dual);
+  DualQuaternion(const Quaternion &rotation, const Vector3DStack &translation);
+  DualQuaternion(const DualQuaternion &other);
+  ~DualQuaternion();
+
+  void operator=(const DualQuaternion &rhs);
+
+  bool operator==(const DualQuaternion &rhs) const;
+  bool operator!=(const DualQuaternion &rhs) const;
+
+  Quaternion getReal() const;
+  void setReal(const Quaternion &real);
+
+  Quaternion getDual() const;
+  void setDual(const Quaternion &dual);
+
+  Quaternion getRotation() const;
+  Vector3DStack getTranslation() const;
+
+  bool isUnit(const double tolerance = Quaternion::UNIT_TOLERANCE) const;
+  DualQuaternion getUnitDualQuaternion() const;
+
+  DualQuaternion operator+(const DualQuaternion &rhs) const;
+  DualQuaternion operator*(const DualQuaternion &rhs) const;
+  DualQuaternion operator*(const double rhs) const;
+
+  DualQuaternion conjugate() const;
+  DualQuaternion inverse() const;
+
+  Vector3DStack transformPoint(const Vector3DStack &point) const;
+  void transformPoints(const Vector3DStack *in, Vector3DStack *out,
+                       const size_t count) const;
+
+  static DualQuaternion blend(const DualQuaternion *transforms,
+                              const double *weights, const size_t count);
+
+  friend std::ostream &operator<<(std::ostream &stream,
+                                  const DualQuaternion &dq);
+
+private:
+  Quaternion m_real;
+  Quaternion m_dual;
+};
+
+#endif
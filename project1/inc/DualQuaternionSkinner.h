@@ -0,0 +1,38 @@
+#ifndef _DUALQUATERNIONSKINNER_H_
+#define _DUALQUATERNIONSKINNER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "GeometryFwd.h"
+
+class DualQuaternion;
+
+class DualQuaternionSkinner
+{
+public:
+  static const size_t MAX_INFLUENCES;
+
+  DualQuaternionSkinner(const unsigned int numThreads = 1);
+  ~DualQuaternionSkinner();
+
+  void setNumThreads(const unsigned int numThreads);
+  unsigned int getNumThreads() const;
+
+  void setBones(const DualQuaternion *bones, const size_t count);
+  size_t numBones() const;
+
+  void skin(const Vector3DArray &in, const unsigned int *boneIndices,
+            const double *weights, Vector3DArray &out) const;
+
+private:
+  void skinRange(const Vector3DArray &in, const unsigned int *boneIndices,
+                 const double *weights, Vector3DArray &out,
+                 const size_t begin, const size_t end) const;
+
+  /* Real then dual part of each bone, 8 values per bone */
+  std::vector<double> m_bones;
+  unsigned int m_numThreads;
+};
+
+#endif
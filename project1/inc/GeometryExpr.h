@@ -0,0 +1,614 @@
+#ifndef _GEOMETRYEXPR_H_
+#define _GEOMETRYEXPR_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+#include "Quaternion.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+/*
+ * Expression templates for Vector3DStack, Vector3DArray and Quaternion
+ *
+ * Opt in by including this header. Operands are wrapped with lazy(), the
+ * operators then build a tree of small inline expression objects instead of
+ * evaluating anything, and eval() or assign() evaluate the whole tree in a
+ * single pass with no intermediate vectors, quaternions or arrays:
+ *
+ *   Vector3DStack p1 = eval(lazy(p) + lazy(v) * dt + lazy(a) * (0.5 * dt * dt));
+ *   assign(positions, lazy(positions) + lazy(velocities) * dt);
+ *
+ * Vector expressions are evaluated one element at a time; a single vector
+ * used in an array expression is applied to every element (e.g. adding
+ * gravity to every velocity). An array expression may write to one of its own
+ * operands, as each element only reads the same element of its operands.
+ *
+ * Operand values are copied when wrapped (arrays by pointer), so the wrapped
+ * objects must outlive the expression only for arrays.
+ *
+ * Note: a cross product reads each component of its operands twice, and a
+ * quaternion product is evaluated when the expression is built (as each of
+ * its components needs all four of each operand); wrap deep sub expressions
+ * in eval() if they are repeated.
+ */
+
+/**
+ * Base of all vector expressions.
+ */
+template <typename E> struct VecExpr
+{
+  const E &derived() const
+  {
+    return static_cast<const E &>(*this);
+  }
+};
+
+/**
+ * A single vector.
+ */
+struct VecValue : public VecExpr<VecValue>
+{
+  static const bool IS_ARRAY = false;
+
+  VecValue(const Vector3DStack &v)
+      : m_x(v.getX())
+      , m_y(v.getY())
+      , m_z(v.getZ())
+  {
+  }
+
+  VecValue(const double x, const double y, const double z)
+      : m_x(x)
+      , m_y(y)
+      , m_z(z)
+  {
+  }
+
+  size_t size() const
+  {
+    return 0;
+  }
+
+  double x(size_t) const
+  {
+    return m_x;
+  }
+
+  double y(size_t) const
+  {
+    return m_y;
+  }
+
+  double z(size_t) const
+  {
+    return m_z;
+  }
+
+  double m_x, m_y, m_z;
+};
+
+/**
+ * An array of vectors.
+ */
+struct VecArray : public VecExpr<VecArray>
+{
+  static const bool IS_ARRAY = true;
+
+  VecArray(const Vector3DArray &a)
+      : m_x(a.x())
+      , m_y(a.y())
+      , m_z(a.z())
+      , m_size(a.size())
+  {
+  }
+
+  size_t size() const
+  {
+    return m_size;
+  }
+
+  double x(const size_t i) const
+  {
+    return m_x[i];
+  }
+
+  double y(const size_t i) const
+  {
+    return m_y[i];
+  }
+
+  double z(const size_t i) const
+  {
+    return m_z[i];
+  }
+
+  const double *m_x, *m_y, *m_z;
+  size_t m_size;
+};
+
+/**
+ * Gives the element count of a binary expression, zero if both sides are
+ * single vectors.
+ */
+template <typename L, typename R>
+inline size_t exprSize(const L &l, const R &r)
+{
+  if (L::IS_ARRAY && R::IS_ARRAY && l.size() != r.size())
+    throw std::runtime_error("Vector3DArray size mismatch");
+  return std::max(l.size(), r.size());
+}
+
+/* Sum of two vector expressions */
+template <typename L, typename R>
+struct VecAdd : public VecExpr<VecAdd<L, R> >
+{
+  static const bool IS_ARRAY = L::IS_ARRAY || R::IS_ARRAY;
+
+  VecAdd(const L &l, const R &r)
+      : m_l(l)
+      , m_r(r)
+      , m_size(exprSize(l, r))
+  {
+  }
+
+  size_t size() const
+  {
+    return m_size;
+  }
+
+  double x(const size_t i) const
+  {
+    return m_l.x(i) + m_r.x(i);
+  }
+
+  double y(const size_t i) const
+  {
+    return m_l.y(i) + m_r.y(i);
+  }
+
+  double z(const size_t i) const
+  {
+    return m_l.z(i) + m_r.z(i);
+  }
+
+  const L m_l;
+  const R m_r;
+  size_t m_size;
+};
+
+/* Difference of two vector expressions */
+template <typename L, typename R>
+struct VecSub : public VecExpr<VecSub<L, R> >
+{
+  static const bool IS_ARRAY = L::IS_ARRAY || R::IS_ARRAY;
+
+  VecSub(const L &l, const R &r)
+      : m_l(l)
+      , m_r(r)
+      , m_size(exprSize(l, r))
+  {
+  }
+
+  size_t size() const
+  {
+    return m_size;
+  }
+
+  double x(const size_t i) const
+  {
+    return m_l.x(i) - m_r.x(i);
+  }
+
+  double y(const size_t i) const
+  {
+    return m_l.y(i) - m_r.y(i);
+  }
+
+  double z(const size_t i) const
+  {
+    return m_l.z(i) - m_r.z(i);
+  }
+
+  const L m_l;
+  const R m_r;
+  size_t m_size;
+};
+
+/* Vector expression multiplied by a scalar */
+template <typename E> struct VecScale : public VecExpr<VecScale<E> >
+{
+  static const bool IS_ARRAY = E::IS_ARRAY;
+
+  VecScale(const E &e, const double s)
+      : m_e(e)
+      , m_s(s)
+  {
+  }
+
+  size_t size() const
+  {
+    return m_e.size();
+  }
+
+  double x(const size_t i) const
+  {
+    return m_e.x(i) * m_s;
+  }
+
+  double y(const size_t i) const
+  {
+    return m_e.y(i) * m_s;
+  }
+
+  double z(const size_t i) const
+  {
+    return m_e.z(i) * m_s;
+  }
+
+  const E m_e;
+  const double m_s;
+};
+
+/* Cross product of two vector expressions */
+template <typename L, typename R>
+struct VecCross : public VecExpr<VecCross<L, R> >
+{
+  static const bool IS_ARRAY = L::IS_ARRAY || R::IS_ARRAY;
+
+  VecCross(const L &l, const R &r)
+      : m_l(l)
+      , m_r(r)
+      , m_size(exprSize(l, r))
+  {
+  }
+
+  size_t size() const
+  {
+    return m_size;
+  }
+
+  double x(const size_t i) const
+  {
+    return m_l.y(i) * m_r.z(i) - m_l.z(i) * m_r.y(i);
+  }
+
+  double y(const size_t i) const
+  {
+    return m_l.z(i) * m_r.x(i) - m_l.x(i) * m_r.z(i);
+  }
+
+  double z(const size_t i) const
+  {
+    return m_l.x(i) * m_r.y(i) - m_l.y(i) * m_r.x(i);
+  }
+
+  const L m_l;
+  const R m_r;
+  size_t m_size;
+};
+
+/**
+ * Base of all quaternion expressions.
+ */
+template <typename E> struct QuatExpr
+{
+  const E &derived() const
+  {
+    return static_cast<const E &>(*this);
+  }
+};
+
+/**
+ * A single quaternion.
+ */
+struct QuatValue : public QuatExpr<QuatValue>
+{
+  QuatValue(const Quaternion &q)
+      : m_w(q.getReal())
+      , m_i(q.getI())
+      , m_j(q.getJ())
+      , m_k(q.getK())
+  {
+  }
+
+  QuatValue(const double w, const double i, const double j, const double k)
+      : m_w(w)
+      , m_i(i)
+      , m_j(j)
+      , m_k(k)
+  {
+  }
+
+  double w() const
+  {
+    return m_w;
+  }
+
+  double i() const
+  {
+    return m_i;
+  }
+
+  double j() const
+  {
+    return m_j;
+  }
+
+  double k() const
+  {
+    return m_k;
+  }
+
+  double m_w, m_i, m_j, m_k;
+};
+
+/* Sum of two quaternion expressions */
+template <typename L, typename R>
+struct QuatAdd : public QuatExpr<QuatAdd<L, R> >
+{
+  QuatAdd(const L &l, const R &r)
+      : m_l(l)
+      , m_r(r)
+  {
+  }
+
+  double w() const
+  {
+    return m_l.w() + m_r.w();
+  }
+
+  double i() const
+  {
+    return m_l.i() + m_r.i();
+  }
+
+  double j() const
+  {
+    return m_l.j() + m_r.j();
+  }
+
+  double k() const
+  {
+    return m_l.k() + m_r.k();
+  }
+
+  const L m_l;
+  const R m_r;
+};
+
+/* Difference of two quaternion expressions */
+template <typename L, typename R>
+struct QuatSub : public QuatExpr<QuatSub<L, R> >
+{
+  QuatSub(const L &l, const R &r)
+      : m_l(l)
+      , m_r(r)
+  {
+  }
+
+  double w() const
+  {
+    return m_l.w() - m_r.w();
+  }
+
+  double i() const
+  {
+    return m_l.i() - m_r.i();
+  }
+
+  double j() const
+  {
+    return m_l.j() - m_r.j();
+  }
+
+  double k() const
+  {
+    return m_l.k() - m_r.k();
+  }
+
+  const L m_l;
+  const R m_r;
+};
+
+/* Quaternion expression multiplied by a scalar */
+template <typename E> struct QuatScale : public QuatExpr<QuatScale<E> >
+{
+  QuatScale(const E &e, const double s)
+      : m_e(e)
+      , m_s(s)
+  {
+  }
+
+  double w() const
+  {
+    return m_e.w() * m_s;
+  }
+
+  double i() const
+  {
+    return m_e.i() * m_s;
+  }
+
+  double j() const
+  {
+    return m_e.j() * m_s;
+  }
+
+  double k() const
+  {
+    return m_e.k() * m_s;
+  }
+
+  const E m_e;
+  const double m_s;
+};
+
+/**
+ * Hamilton product of two quaternion expressions, evaluated when built (see
+ * the note at the top of this file).
+ */
+template <typename L, typename R>
+inline QuatValue quatMultiply(const L &l, const R &r)
+{
+  const double lw = l.w(), li = l.i(), lj = l.j(), lk = l.k();
+  const double rw = r.w(), ri = r.i(), rj = r.j(), rk = r.k();
+
+  return QuatValue(lw * rw - li * ri - lj * rj - lk * rk,
+                   lw * ri + rw * li + lj * rk - rj * lk,
+                   lw * rj + rw * lj - li * rk + lk * ri,
+                   lw * rk + rw * lk + li * rj - ri * lj);
+}
+
+/* Wrapping of operands */
+
+inline VecValue lazy(const Vector3DStack &v)
+{
+  return VecValue(v);
+}
+
+inline VecArray lazy(const Vector3DArray &a)
+{
+  return VecArray(a);
+}
+
+inline QuatValue lazy(const Quaternion &q)
+{
+  return QuatValue(q);
+}
+
+/* Vector operators */
+
+template <typename L, typename R>
+inline VecAdd<L, R> operator+(const VecExpr<L> &l, const VecExpr<R> &r)
+{
+  return VecAdd<L, R>(l.derived(), r.derived());
+}
+
+template <typename L, typename R>
+inline VecSub<L, R> operator-(const VecExpr<L> &l, const VecExpr<R> &r)
+{
+  return VecSub<L, R>(l.derived(), r.derived());
+}
+
+template <typename E>
+inline VecScale<E> operator*(const VecExpr<E> &e, const double s)
+{
+  return VecScale<E>(e.derived(), s);
+}
+
+template <typename E>
+inline VecScale<E> operator*(const double s, const VecExpr<E> &e)
+{
+  return VecScale<E>(e.derived(), s);
+}
+
+/* Throws on division by zero, as Vector3DStack::operator/ does */
+template <typename E>
+inline VecScale<E> operator/(const VecExpr<E> &e, const double s)
+{
+  if (std::abs(s) < std::numeric_limits<double>::epsilon())
+    throw std::runtime_error("Division by zero");
+
+  return VecScale<E>(e.derived(), 1.0 / s);
+}
+
+template <typename L, typename R>
+inline VecCross<L, R> operator%(const VecExpr<L> &l, const VecExpr<R> &r)
+{
+  return VecCross<L, R>(l.derived(), r.derived());
+}
+
+/* Quaternion operators */
+
+template <typename L, typename R>
+inline QuatAdd<L, R> operator+(const QuatExpr<L> &l, const QuatExpr<R> &r)
+{
+  return QuatAdd<L, R>(l.derived(), r.derived());
+}
+
+template <typename L, typename R>
+inline QuatSub<L, R> operator-(const QuatExpr<L> &l, const QuatExpr<R> &r)
+{
+  return QuatSub<L, R>(l.derived(), r.derived());
+}
+
+template <typename L, typename R>
+inline QuatValue operator*(const QuatExpr<L> &l, const QuatExpr<R> &r)
+{
+  return quatMultiply(l.derived(), r.derived());
+}
+
+template <typename E>
+inline QuatScale<E> operator*(const QuatExpr<E> &e, const double s)
+{
+  return QuatScale<E>(e.derived(), s);
+}
+
+template <typename E>
+inline QuatScale<E> operator*(const double s, const QuatExpr<E> &e)
+{
+  return QuatScale<E>(e.derived(), s);
+}
+
+/* Evaluation */
+
+/**
+ * Evaluates a vector expression of single vectors.
+ *
+ * @param e Expression
+ * @return Resulting vector
+ */
+template <typename E> inline Vector3DStack eval(const VecExpr<E> &e)
+{
+  const E &d = e.derived();
+  if (E::IS_ARRAY)
+    throw std::runtime_error("Array expression evaluated as a vector");
+
+  return Vector3DStack(d.x(0), d.y(0), d.z(0));
+}
+
+/**
+ * Evaluates a vector expression into an array.
+ *
+ * @param out Array to store results in, resized to the expression size
+ * @param e Expression, must contain at least one array
+ */
+template <typename E>
+inline void assign(Vector3DArray &out, const VecExpr<E> &e)
+{
+  const E &d = e.derived();
+  if (!E::IS_ARRAY)
+    throw std::runtime_error("Vector expression assigned to an array");
+
+  const size_t size = d.size();
+  out.resize(size);
+
+  double *ox = out.x(), *oy = out.y(), *oz = out.z();
+  for (size_t i = 0; i < size; i++)
+  {
+    const double x = d.x(i);
+    const double y = d.y(i);
+    const double z = d.z(i);
+    ox[i] = x;
+    oy[i] = y;
+    oz[i] = z;
+  }
+}
+
+/**
+ * Evaluates a quaternion expression.
+ *
+ * @param e Expression
+ * @return Resulting quaternion
+ */
+template <typename E> inline Quaternion eval(const QuatExpr<E> &e)
+{
+  const E &d = e.derived();
+  return Quaternion(d.w(), d.i(), d.j(), d.k());
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef _GEOMETRYFWD_H_
+#define _GEOMETRYFWD_H_
+
+/*
+ * Forward declarations of the scalar templated geometry types.
+ *
+ * Quaternion, Vector3DStack, Vector3DArray and RotationMatrix are the double
+ * precision versions used by the rest of the library, the F versions the
+ * single precision ones for batch pipelines that can trade accuracy for
+ * memory and SIMD width.
+ */
+template <typename T> class QuaternionT;
+template <typename T> class Vector3DStackT;
+template <typename T> class Vector3DArrayT;
+template <typename T> class RotationMatrixT;
+
+typedef QuaternionT<double> Quaternion;
+typedef Vector3DStackT<double> Vector3DStack;
+typedef Vector3DArrayT<double> Vector3DArray;
+typedef RotationMatrixT<double> RotationMatrix;
+
+typedef QuaternionT<float> QuaternionF;
+typedef Vector3DStackT<float> Vector3DStackF;
+typedef Vector3DArrayT<float> Vector3DArrayF;
+typedef RotationMatrixT<float> RotationMatrixF;
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef _GEOMETRYIO_H_
+#define _GEOMETRYIO_H_
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#include "ChunkedIO.h"
+#include "GeometryFwd.h"
+
+/*
+ * File formats for arrays of quaternions and vectors.
+ *
+ * GEOMETRY_TEXT is the format of operator<< and operator>>, "[w,i,j,k]" or
+ * "[x,y,z]", one record per line when written; any whitespace is accepted
+ * between records and around values when read.
+ *
+ * GEOMETRY_BINARY is the components of each record as little endian IEEE 754
+ * doubles, with no header or padding.
+ */
+enum GeometryFormat
+{
+  GEOMETRY_TEXT,
+  GEOMETRY_BINARY
+};
+
+size_t formatDouble(const double value, const int precision, char *out);
+const char *parseDouble(const char *begin, const char *end, double &value);
+
+/**
+ * Reads arrays of quaternions or vectors from a file a chunk at a time.
+ */
+class GeometryReader
+{
+public:
+  GeometryReader(FILE *file, const GeometryFormat format,
+                 const size_t chunkSize = 1 << 20);
+  ~GeometryReader();
+
+  size_t read(Quaternion *out, const size_t count);
+  size_t read(Vector3DStack *out, const size_t count);
+
+  size_t recordsRead() const;
+
+private:
+  bool nextChunk();
+  void checkReadError() const;
+  bool nextText(double *values, const int width);
+  bool nextBinary(double *values, const int width);
+
+  FILE *m_file;
+  GeometryFormat m_format;
+  ChunkedReader m_reader;
+
+  /* Text records, split at their closing bracket */
+  ChunkedSplitter m_splitter;
+
+  /* Unread part of the current binary chunk */
+  const char *m_pos;
+  const char *m_end;
+  bool m_eof;
+
+  /* Binary record split between two chunks */
+  std::string m_carry;
+
+  size_t m_records;
+};
+
+/**
+ * Writes arrays of quaternions or vectors to a file a chunk at a time.
+ */
+class GeometryWriter
+{
+public:
+  GeometryWriter(FILE *file, const GeometryFormat format,
+                 const int precision = 17, const size_t chunkSize = 1 << 20);
+  ~GeometryWriter();
+
+  void write(const Quaternion *in, const size_t count);
+  void write(const Vector3DStack *in, const size_t count);
+
+  bool finish();
+
+private:
+  void writeRecord(const double *values, const int width);
+
+  GeometryFormat m_format;
+  int m_precision;
+  ChunkedWriter m_writer;
+  size_t m_used;
+  bool m_finished;
+  bool m_ok;
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef _KDTREE_H_
+#define _KDTREE_H_
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "GeometryFwd.h"
+
+/* Point found by a KdTree query */
+struct KdNeighbour
+{
+  /* Index of the point in the array the tree was built from */
+  size_t index;
+
+  /* Squared distance from the query point */
+  double distanceSquared;
+};
+
+class KdTree
+{
+public:
+  static const size_t LEAF_SIZE;
+
+  KdTree(const unsigned int numThreads = 1);
+  ~KdTree();
+
+  void setNumThreads(const unsigned int numThreads);
+  unsigned int getNumThreads() const;
+
+  void build(const Vector3DStack *points, const size_t count);
+  void build(const Vector3DArray &points);
+
+  size_t size() const;
+
+  void nearest(const Vector3DStack &point, const size_t k,
+               std::vector<KdNeighbour> &result) const;
+  void radiusSearch(const Vector3DStack &point, const double radius,
+                    std::vector<KdNeighbour> &result) const;
+
+  void nearest(const Vector3DStack *points, const size_t count,
+               const size_t k, std::vector<KdNeighbour> &result) const;
+  void radiusSearch(const Vector3DStack *points, const size_t count,
+                    const double radius, std::vector<size_t> &offsets,
+                    std::vector<KdNeighbour> &result) const;
+
+private:
+  /* Node of the tree, stored depth first so the left child of a node
+   * directly follows it */
+  struct Node
+  {
+    /* Split position, points of the left subtree are no greater and points
+     * of the right subtree no less */
+    double split;
+
+    /* Range of points in the subtree */
+    uint32_t begin;
+    uint32_t end;
+
+    /* Index of the right child */
+    uint32_t right;
+
+    /* Split axis, -1 for a leaf */
+    int32_t axis;
+  };
+
+  /* Point record used while building */
+  struct BuildPoint
+  {
+    double coords[3];
+    size_t index;
+  };
+
+  void buildTree(const size_t count);
+  void buildNode(const size_t node, const size_t begin, const size_t end,
+                 const unsigned int threads);
+
+  void nearestNode(const size_t node, const double *p, const size_t k,
+                   std::vector<KdNeighbour> &heap, double *offsets,
+                   const double regionSquared) const;
+  void radiusNode(const size_t node, const double *p,
+                  const double radiusSquared,
+                  std::vector<KdNeighbour> &result) const;
+
+  void queryOrder(const Vector3DStack *points, const size_t count,
+                  std::vector<size_t> &order) const;
+  void nearestRange(const Vector3DStack *points, const size_t *order,
+                    const size_t begin, const size_t end, const size_t k,
+                    std::vector<KdNeighbour> &result) const;
+  void radiusRange(const Vector3DStack *points, const size_t *order,
+                   const size_t begin, const size_t end, const double radius,
+                   size_t *counts, std::vector<KdNeighbour> &result) const;
+
+  static size_t subtreeNodes(const size_t count);
+
+  unsigned int m_numThreads;
+
+  std::vector<Node> m_nodes;
+
+  /* Bounds of all points */
+  double m_lo[3];
+  double m_hi[3];
+
+  /* Point coordinates in tree order */
+  std::vector<double> m_points[3];
+
+  /* Index in the original array of each point in tree order */
+  std::vector<size_t> m_indices;
+
+  /* Points being partitioned, only used during build() */
+  std::vector<BuildPoint> m_build;
+};
+
+#endif
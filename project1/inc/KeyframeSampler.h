@@ -0,0 +1,42 @@
+#ifndef _KEYFRAMESAMPLER_H_
+#define _KEYFRAMESAMPLER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "GeometryFwd.h"
+#include "KeyframeTrack.h"
+
+class KeyframeSampler
+{
+public:
+  KeyframeSampler(const KeyframeTrack *tracks, const size_t count);
+  ~KeyframeSampler();
+
+  size_t size() const;
+  void reset();
+
+  void sample(const double time, Quaternion *out,
+              const Interpolation interp = INTERP_SLERP);
+
+private:
+  /* Number of tracks gathered and interpolated at a time */
+  static const size_t BLOCK_SIZE = 64;
+
+  void gather(const double time, const size_t begin, const size_t count);
+  void storeKeys(const size_t n, const double *a, const double *b,
+                 const double t);
+  void nlerp(const size_t count, Quaternion *out) const;
+  void slerp(const size_t count, Quaternion *out) const;
+
+  const KeyframeTrack *m_tracks;
+  size_t m_count;
+  std::vector<size_t> m_cursors;
+
+  /* Segment start and end keys and parameter of each track in a block, SoA */
+  double m_a[4][BLOCK_SIZE];
+  double m_b[4][BLOCK_SIZE];
+  double m_t[BLOCK_SIZE];
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef _KEYFRAMETRACK_H_
+#define _KEYFRAMETRACK_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "Quaternion.h"
+
+enum Interpolation
+{
+  INTERP_NLERP,
+  INTERP_SLERP
+};
+
+class KeyframeTrack
+{
+public:
+  KeyframeTrack();
+  ~KeyframeTrack();
+
+  void addKey(const double time, const Quaternion &key);
+  void clear();
+
+  size_t size() const;
+  double keyTime(const size_t index) const;
+  Quaternion key(const size_t index) const;
+
+  const double *keyTimes() const;
+  const double *keyData() const;
+
+  double startTime() const;
+  double endTime() const;
+
+  size_t seek(const double time, size_t cursor) const;
+  double segmentParameter(const double time, const size_t cursor) const;
+
+  Quaternion sample(const double time, size_t &cursor,
+                    const Interpolation interp = INTERP_SLERP) const;
+
+private:
+  std::vector<double> m_times;
+  std::vector<double> m_keys;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef _ORIENTEDBOX_H_
+#define _ORIENTEDBOX_H_
+
+#include "Quaternion.h"
+#include "Vector3DStack.h"
+
+class OrientedBox
+{
+public:
+  static const double PARALLEL_EPSILON;
+
+  OrientedBox();
+  OrientedBox(const Vector3DStack &centre, const Vector3DStack &halfExtents,
+              const Quaternion &orientation);
+  OrientedBox(const OrientedBox &other);
+  ~OrientedBox();
+
+  void operator=(const OrientedBox &other);
+
+  Vector3DStack getCentre() const;
+  void setCentre(const Vector3DStack &centre);
+
+  Vector3DStack getHalfExtents() const;
+  void setHalfExtents(const Vector3DStack &halfExtents);
+
+  Quaternion getOrientation() const;
+  void setOrientation(const Quaternion &orientation);
+
+  Vector3DStack getAxis(const int axis) const;
+  const double *axes() const;
+
+  Vector3DStack getBoundingHalfExtents() const;
+
+  bool intersects(const OrientedBox &other) const;
+
+  static bool intersects(const double *centreA, const double *axesA,
+                         const double *halfExtentsA, const double *centreB,
+                         const double *axesB, const double *halfExtentsB);
+
+private:
+  void updateAxes();
+
+  Vector3DStack m_centre;
+  Vector3DStack m_halfExtents;
+  Quaternion m_orientation;
+
+  /* Local x, y and z axes in world space, 3 components each */
+  double m_axes[9];
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef _ORIENTEDBOXSET_H_
+#define _ORIENTEDBOXSET_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "Vector3DArray.h"
+
+class OrientedBox;
+
+class OrientedBoxSet
+{
+public:
+  OrientedBoxSet();
+  ~OrientedBoxSet();
+
+  size_t size() const;
+  void clear();
+
+  size_t addBox(const OrientedBox &box);
+
+  OrientedBox getBox(const size_t index) const;
+  void setBox(const size_t index, const OrientedBox &box);
+
+  Vector3DArray &centres();
+  const Vector3DArray &centres() const;
+  const Vector3DArray &halfExtents() const;
+
+  double *orientation(const int component);
+  const double *orientation(const int component) const;
+
+  void updateAxes();
+
+  const double *axis(const int axis, const int component) const;
+  const Vector3DArray &boundingHalfExtents() const;
+
+  bool intersects(const size_t a, const size_t b) const;
+
+  void findIntersecting(const OrientedBox &box,
+                        std::vector<size_t> &hits) const;
+  void findIntersecting(const OrientedBox &box, const size_t *candidates,
+                        const size_t count, std::vector<size_t> &hits) const;
+
+private:
+  void checkIndex(const size_t index) const;
+  void updateAxes(const size_t begin, const size_t end);
+  bool intersectsBox(const size_t index, const double *centre,
+                     const double *axes, const double *halfExtents,
+                     const double radius) const;
+
+  Vector3DArray m_centres;
+  Vector3DArray m_halfExtents;
+
+  /* Orientation w, i, j and k components */
+  std::vector<double> m_orientation[4];
+
+  /* Cached world space axes, component c of axis a is m_axes[3 * a + c] */
+  std::vector<double> m_axes[9];
+
+  /* Cached bounding box half extents and bounding sphere radii */
+  Vector3DArray m_boundingHalfExtents;
+  std::vector<double> m_radii;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <cstddef>
+#include <functional>
+
+/*
+ * Splitting of batch work across threads.
+ *
+ * Used by the batch classes to split a range of elements into one chunk per
+ * thread, so the thread count, chunk size and alignment policy is the same
+ * everywhere.
+ */
+
+/**
+ * Function processing one chunk of a range: the index of the chunk and the
+ * elements begin to end - 1.
+ */
+typedef std::function<void(size_t, size_t, size_t)> ParallelRange;
+
+unsigned int resolveNumThreads(const unsigned int numThreads);
+unsigned int parallelThreads(const size_t count, const size_t minPerThread,
+                             const unsigned int maxThreads);
+size_t parallelChunks(const size_t count, const size_t minPerThread,
+                      const size_t alignment, const unsigned int maxThreads);
+void parallelFor(const size_t begin, const size_t end,
+                 const size_t minPerThread, const size_t alignment,
+                 const unsigned int maxThreads, const ParallelRange &fn);
+
+#endif
@@ -1,66 +1,478 @@
 #ifndef _QUATERNION_H_
 #define _QUATERNION_H_
 
+#include <cassert>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
+#include <limits>
+#include <type_traits>
 
 /*
- * Forward declare Vector3DStack class
+ * Forward declare the vector class template
  * (avoids including headers within other headers, saves compile time on much
  * larger projects)
  */
-class Vector3DStack;
+#include "GeometryFwd.h"
 
-class Quaternion
+/*
+ * Quaternion with components of type T.
+ *
+ * Instantiated for float and double only, Quaternion is the double version
+ * and QuaternionF the float version (see GeometryFwd.h).
+ */
+template <typename T> class QuaternionT
 {
 public:
-  Quaternion();
-  Quaternion(const double w);
-  Quaternion(const double w, const double i, const double j, const double k);
-  Quaternion(const double angle, const Vector3DStack &axis);
-  Quaternion(const Vector3DStack &v0, const Vector3DStack &v1);
-  Quaternion(const Quaternion &other);
-  ~Quaternion();
+  typedef T Scalar;
+
+  static const T UNIT_TOLERANCE;
+  static const T SLERP_THRESHOLD;
+
+  QuaternionT() noexcept;
+  QuaternionT(const T w) noexcept;
+  QuaternionT(const T w, const T i, const T j, const T k) noexcept;
+  QuaternionT(const T angle, const Vector3DStackT<T> &axis);
+  QuaternionT(const Vector3DStackT<T> &v0, const Vector3DStackT<T> &v1);
+  QuaternionT(const QuaternionT &other) noexcept;
+  ~QuaternionT() noexcept;
+
+  template <typename U> explicit QuaternionT(const QuaternionT<U> &other);
+
+  static QuaternionT fromRotationVector(const Vector3DStackT<T> &v);
+
+  void operator=(const QuaternionT &rhs) noexcept;
 
-  void operator=(const Quaternion &rhs);
+  bool operator==(const QuaternionT &rhs) const noexcept;
+  bool operator!=(const QuaternionT &rhs) const noexcept;
 
-  bool operator==(const Quaternion &rhs) const;
-  bool operator!=(const Quaternion &rhs) const;
+  void setReal(T w) noexcept;
+  T getReal() const noexcept;
 
-  void setReal(double w);
-  double getReal() const;
+  void setI(T i) noexcept;
+  T getI() const noexcept;
 
-  void setI(double i);
-  double getI() const;
+  void setJ(T j) noexcept;
+  T getJ() const noexcept;
 
-  void setJ(double j);
-  double getJ() const;
+  void setK(T k) noexcept;
+  T getK() const noexcept;
 
-  void setK(double k);
-  double getK() const;
+  T magnitude() const noexcept;
+  bool isUnit(const T tolerance = UNIT_TOLERANCE) const;
+  QuaternionT getUnitQuaternion() const;
+  QuaternionT getUnitQuaternionUnchecked() const noexcept;
 
-  double magnitude() const;
+  QuaternionT operator+(const QuaternionT &rhs) const noexcept;
+  QuaternionT operator-(const QuaternionT &rhs) const noexcept;
+  QuaternionT operator*(const QuaternionT &rhs) const noexcept;
 
-  Quaternion operator+(const Quaternion &rhs) const;
-  Quaternion operator-(const Quaternion &rhs) const;
-  Quaternion operator*(const Quaternion &rhs) const;
+  T operator[](const int index) const;
+  T& operator[](const int index);
 
-  double operator[](const int index) const;
-  double& operator[](const int index);
+  T unchecked(const int index) const noexcept;
+  T &unchecked(const int index) noexcept;
 
-  Quaternion conjugate() const;
-  Quaternion inverse() const;
+  const T *data() const noexcept;
+  T *data() noexcept;
 
-  Vector3DStack rotateVector(const Vector3DStack &vector) const;
+  QuaternionT conjugate() const noexcept;
+  QuaternionT inverse() const;
 
-  friend std::ostream &operator<<(std::ostream &stream, const Quaternion &q);
+  T dot(const QuaternionT &rhs) const noexcept;
+
+  static QuaternionT nlerp(const QuaternionT &a, const QuaternionT &b,
+                           const T t);
+  static QuaternionT slerp(const QuaternionT &a, const QuaternionT &b,
+                           const T t);
+
+  Vector3DStackT<T> rotateVector(const Vector3DStackT<T> &vector) const;
+  Vector3DStackT<T>
+  rotateVectorNormalised(const Vector3DStackT<T> &vector) const;
+  void rotateVectors(const Vector3DStackT<T> *in, Vector3DStackT<T> *out,
+                     const size_t count) const;
 
 private:
-  double m_w;
-  double m_i;
-  double m_j;
-  double m_k;
+  T m_w;
+  T m_i;
+  T m_j;
+  T m_k;
 };
 
-std::istream &operator>>(std::istream &stream, Quaternion &q);
+template <typename T>
+std::ostream &operator<<(std::ostream &stream, const QuaternionT<T> &q);
+template <typename T>
+std::istream &operator>>(std::istream &stream, QuaternionT<T> &q);
+
+/* Defined in Quaternion.cpp */
+template <> const float QuaternionT<float>::UNIT_TOLERANCE;
+template <> const double QuaternionT<double>::UNIT_TOLERANCE;
+template <> const float QuaternionT<float>::SLERP_THRESHOLD;
+template <> const double QuaternionT<double>::SLERP_THRESHOLD;
+
+extern template class QuaternionT<float>;
+extern template class QuaternionT<double>;
+
+/* data() treats the components as an array of four scalars */
+static_assert(std::is_standard_layout<Quaternion>::value &&
+                  sizeof(Quaternion) == 4 * sizeof(double) &&
+                  sizeof(QuaternionF) == 4 * sizeof(float),
+              "Quaternion must be four packed scalars");
+
+/*
+ * Inline definitions
+ *
+ * As for Vector3DStack, the operations that cannot fail are defined here so
+ * that batch code in other translation units can inline them, and the
+ * unchecked variants only assert their preconditions in debug builds.
+ */
+
+/**
+ * Construct a quaternion with a default value of 1.
+ */
+template <typename T>
+inline QuaternionT<T>::QuaternionT() noexcept
+    : m_w(1)
+    , m_i(0)
+    , m_j(0)
+    , m_k(0)
+{
+}
+
+/**
+ * Construct a real valued quaternion.
+ *
+ * Note: casting from integer to double is implicity, so this constructor
+ * covers the fourth bullet point in the spec.
+ *
+ * @param w Real value
+ */
+template <typename T>
+inline QuaternionT<T>::QuaternionT(const T w) noexcept
+    : m_w(w)
+    , m_i(0)
+    , m_j(0)
+    , m_k(0)
+{
+}
+
+/**
+ * Construct an imaginary valued quaternion.
+ *
+ * @param w Real value
+ * @param i Coefficient of i
+ * @param j Coefficient of j
+ * @param k Coefficient of k
+ */
+template <typename T>
+inline QuaternionT<T>::QuaternionT(const T w, const T i, const T j,
+                                   const T k) noexcept
+    : m_w(w)
+    , m_i(i)
+    , m_j(j)
+    , m_k(k)
+{
+}
+
+/**
+ * Construct a quaternion using the values of another.
+ *
+ * @param rhs Quaternion from which to take values
+ */
+template <typename T>
+inline QuaternionT<T>::QuaternionT(const QuaternionT &other) noexcept
+    : m_w(other.m_w)
+    , m_i(other.m_i)
+    , m_j(other.m_j)
+    , m_k(other.m_k)
+{
+}
+
+/**
+ * Construct a quaternion from one of another scalar type, e.g. a float
+ * quaternion from a double one.
+ *
+ * @param other Quaternion from which to take values
+ */
+template <typename T>
+template <typename U>
+inline QuaternionT<T>::QuaternionT(const QuaternionT<U> &other)
+    : m_w((T)other.getReal())
+    , m_i((T)other.getI())
+    , m_j((T)other.getJ())
+    , m_k((T)other.getK())
+{
+}
+
+/**
+ * Destructor
+ */
+template <typename T> inline QuaternionT<T>::~QuaternionT() noexcept
+{
+}
+
+/**
+ * Assign this quaternion the values of another.
+ *
+ * @param rhs Quaternion from which to take values
+ */
+template <typename T>
+inline void QuaternionT<T>::operator=(const QuaternionT &rhs) noexcept
+{
+  m_w = rhs.m_w;
+  m_i = rhs.m_i;
+  m_j = rhs.m_j;
+  m_k = rhs.m_k;
+}
+
+/**
+ * Check for equality between this quaternion and another.
+ *
+ * @param rhs Other quaternion to compare to
+ * @return True of values are equal
+ */
+template <typename T>
+inline bool QuaternionT<T>::operator==(const QuaternionT &rhs) const noexcept
+{
+  return (m_w == rhs.m_w && m_i == rhs.m_i && m_j == rhs.m_j && m_k == rhs.m_k);
+}
+
+/**
+ * Check for inequality between this quaternion and another.
+ *
+ * @param rhs Other quaternion to compare to
+ * @return True if values are not equal
+ */
+template <typename T>
+inline bool QuaternionT<T>::operator!=(const QuaternionT &rhs) const noexcept
+{
+  return !operator==(rhs);
+}
+
+/**
+ * Sets the real part of the quaternion.
+ *
+ * @param w Real part
+ */
+template <typename T> inline void QuaternionT<T>::setReal(T w) noexcept
+{
+  m_w = w;
+}
+
+/**
+ * Return the real part of the quaternion.
+ *
+ * @param Real part
+ */
+template <typename T> inline T QuaternionT<T>::getReal() const noexcept
+{
+  return m_w;
+}
+
+/**
+ * Sets the i imaginary part of the quaternion.
+ *
+ * @param i Imaginary part
+ */
+template <typename T> inline void QuaternionT<T>::setI(T i) noexcept
+{
+  m_i = i;
+}
+
+/**
+ * Return the i imaginary part of the quaternion.
+ *
+ * @return Coefficient of i
+ */
+template <typename T> inline T QuaternionT<T>::getI() const noexcept
+{
+  return m_i;
+}
+
+/**
+ * Sets the j imaginary part of the quaternion.
+ *
+ * @param j Imaginary part
+ */
+template <typename T> inline void QuaternionT<T>::setJ(T j) noexcept
+{
+  m_j = j;
+}
+
+/**
+ * Return the j imaginary part of the quaternion.
+ *
+ * @return Coefficient of j
+ */
+template <typename T> inline T QuaternionT<T>::getJ() const noexcept
+{
+  return m_j;
+}
+
+/**
+ * Sets the k imaginary part of the quaternion.
+ *
+ * @param k Imaginary part
+ */
+template <typename T> inline void QuaternionT<T>::setK(T k) noexcept
+{
+  m_k = k;
+}
+
+/**
+ * Return the k imaginary part of the quaternion.
+ *
+ * @return Coefficient of k
+ */
+template <typename T> inline T QuaternionT<T>::getK() const noexcept
+{
+  return m_k;
+}
+
+/**
+ * Calculate the sum of two quaternions.
+ *
+ * @param rhs Quaternion to add to the LHS
+ * @return Sum of quaternions
+ */
+template <typename T>
+inline QuaternionT<T>
+QuaternionT<T>::operator+(const QuaternionT &rhs) const noexcept
+{
+  return QuaternionT(m_w + rhs.m_w, m_i + rhs.m_i, m_j + rhs.m_j,
+                     m_k + rhs.m_k);
+}
+
+/**
+ * Subtract two quaternions.
+ *
+ * @param rhs Quaternion to subtract from the LHS
+ * @return Subtraction of quaternions
+ */
+template <typename T>
+inline QuaternionT<T>
+QuaternionT<T>::operator-(const QuaternionT &rhs) const noexcept
+{
+  return QuaternionT(m_w - rhs.m_w, m_i - rhs.m_i, m_j - rhs.m_j,
+                     m_k - rhs.m_k);
+}
+
+/**
+ * Calculate the product of two quaternions.
+ *
+ * @param rhs Quaternion to multiply by
+ * @return Product of quaternions
+ */
+template <typename T>
+inline QuaternionT<T>
+QuaternionT<T>::operator*(const QuaternionT &rhs) const noexcept
+{
+  T w = m_w * rhs.m_w - m_i * rhs.m_i - m_j * rhs.m_j - m_k * rhs.m_k;
+  T i = m_w * rhs.m_i + rhs.m_w * m_i + m_j * rhs.m_k - rhs.m_j * m_k;
+  T j = m_w * rhs.m_j + rhs.m_w * m_j - m_i * rhs.m_k + m_k * rhs.m_i;
+  T k = m_w * rhs.m_k + rhs.m_w * m_k + m_i * rhs.m_j - rhs.m_i * m_j;
+
+  return QuaternionT(w, i, j, k);
+}
+
+/**
+ * Returns the complex conjugate of this quaternion.
+ *
+ * @return Complex conjugate
+ */
+template <typename T>
+inline QuaternionT<T> QuaternionT<T>::conjugate() const noexcept
+{
+  return QuaternionT(m_w, -m_i, -m_j, -m_k);
+}
+
+/**
+ * Calculates the four dimensional dot product of two quaternions.
+ *
+ * @param rhs Right hand side quaternion
+ * @return Dot product
+ */
+template <typename T>
+inline T QuaternionT<T>::dot(const QuaternionT &rhs) const noexcept
+{
+  return m_w * rhs.m_w + m_i * rhs.m_i + m_j * rhs.m_j + m_k * rhs.m_k;
+}
+
+/**
+ * Calculate the magnitude (length) of the quaternion.
+ *
+ * @return Magnitude
+ */
+template <typename T> inline T QuaternionT<T>::magnitude() const noexcept
+{
+  return std::sqrt(m_w * m_w + m_i * m_i + m_j * m_j + m_k * m_k);
+}
+
+/**
+ * Calculates the unit quaternion of this quaternion without checking for a
+ * zero magnitude.
+ *
+ * @return Unit quaternion
+ */
+template <typename T>
+inline QuaternionT<T>
+QuaternionT<T>::getUnitQuaternionUnchecked() const noexcept
+{
+  const T m = magnitude();
+  assert(m >= std::numeric_limits<T>::epsilon());
+
+  const T r = 1 / m;
+  return QuaternionT(m_w * r, m_i * r, m_j * r, m_k * r);
+}
+
+/**
+ * Return elements of the quaternion by index without range checking.
+ *
+ * For reading only.
+ *
+ * @param index Index accessed, 0 for w to 3 for k
+ * @return Quaternion component
+ */
+template <typename T>
+inline T QuaternionT<T>::unchecked(const int index) const noexcept
+{
+  assert(index >= 0 && index < 4);
+  return (&m_w)[index];
+}
+
+/**
+ * Return elements of the quaternion by index without range checking.
+ *
+ * For reading and writing.
+ *
+ * @param index Index accessed, 0 for w to 3 for k
+ * @return Quaternion component
+ */
+template <typename T>
+inline T &QuaternionT<T>::unchecked(const int index) noexcept
+{
+  assert(index >= 0 && index < 4);
+  return (&m_w)[index];
+}
+
+/**
+ * Returns the components as an array of w, i, j and k.
+ *
+ * @return Pointer to four scalars
+ */
+template <typename T> inline const T *QuaternionT<T>::data() const noexcept
+{
+  return &m_w;
+}
+
+/**
+ * Returns the components as an array of w, i, j and k.
+ *
+ * @return Pointer to four scalars
+ */
+template <typename T> inline T *QuaternionT<T>::data() noexcept
+{
+  return &m_w;
+}
 
 #endif
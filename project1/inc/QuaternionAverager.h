@@ -0,0 +1,72 @@
+#ifndef _QUATERNIONAVERAGER_H_
+#define _QUATERNIONAVERAGER_H_
+
+#include <cstddef>
+
+#include "Quaternion.h"
+
+/* Averaging methods */
+enum AverageMethod
+{
+  /* Eigenvector of the summed outer products, handles samples spread over
+   * any range of orientations */
+  AVERAGE_EIGEN,
+
+  /* Normalised sum after flipping samples into the same hemisphere as the
+   * first, cheaper but only accurate for samples close together */
+  AVERAGE_SIGN_ALIGNED
+};
+
+class QuaternionAverager
+{
+public:
+  QuaternionAverager(const AverageMethod method = AVERAGE_EIGEN,
+                     const unsigned int numThreads = 1);
+  QuaternionAverager(const QuaternionAverager &other);
+  ~QuaternionAverager();
+
+  void operator=(const QuaternionAverager &other);
+
+  AverageMethod getMethod() const;
+
+  void setNumThreads(const unsigned int numThreads);
+  unsigned int getNumThreads() const;
+
+  void clear();
+
+  void add(const Quaternion &q, const double weight = 1.0);
+  void add(const Quaternion *samples, const size_t count);
+  void add(const double *w, const double *i, const double *j, const double *k,
+           const size_t count);
+
+  void merge(const QuaternionAverager &other);
+
+  size_t count() const;
+  double totalWeight() const;
+
+  Quaternion average() const;
+
+private:
+  void setReference(const double w, const double i, const double j,
+                    const double k);
+  void addRange(const double *w, const double *i, const double *j,
+                const double *k, const size_t begin, const size_t end);
+
+  AverageMethod m_method;
+  unsigned int m_numThreads;
+
+  /* Upper triangle of the summed outer products, row by row */
+  double m_products[10];
+
+  /* Sign aligned sum, w, i, j and k */
+  double m_sum[4];
+
+  /* Sample the signs of others are aligned with */
+  double m_reference[4];
+  bool m_hasReference;
+
+  size_t m_count;
+  double m_weight;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef _QUATERNIONCODEC_H_
+#define _QUATERNIONCODEC_H_
+
+#include <cstddef>
+#include <stdint.h>
+
+#include "GeometryFwd.h"
+
+class QuaternionCodec
+{
+public:
+  /* Bytes used by each encoded quaternion in the bulk 48 bit format */
+  static const size_t PACKED48_BYTES = 6;
+
+  static const double MAX_ERROR_32;
+  static const double MAX_ERROR_48;
+
+  static uint32_t encode32(const Quaternion &q);
+  static Quaternion decode32(const uint32_t packed);
+
+  static uint64_t encode48(const Quaternion &q);
+  static Quaternion decode48(const uint64_t packed);
+
+  static void encode32(const Quaternion *in, uint32_t *out,
+                       const size_t count);
+  static void decode32(const uint32_t *in, Quaternion *out,
+                       const size_t count);
+
+  static void encode48(const Quaternion *in, uint8_t *out,
+                       const size_t count);
+  static void decode48(const uint8_t *in, Quaternion *out,
+                       const size_t count);
+};
+
+#endif
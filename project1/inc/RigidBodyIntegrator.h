@@ -0,0 +1,32 @@
+#ifndef _RIGIDBODYINTEGRATOR_H_
+#define _RIGIDBODYINTEGRATOR_H_
+
+#include <cstddef>
+
+#include "Vector3DStack.h"
+
+class RigidBodySet;
+
+class RigidBodyIntegrator
+{
+public:
+  RigidBodyIntegrator(const unsigned int numThreads = 1);
+  ~RigidBodyIntegrator();
+
+  void setGravity(const Vector3DStack &gravity);
+  Vector3DStack getGravity() const;
+
+  void setNumThreads(const unsigned int numThreads);
+  unsigned int getNumThreads() const;
+
+  void step(RigidBodySet &bodies, const double dt) const;
+
+private:
+  void stepRange(RigidBodySet &bodies, const double dt, const size_t begin,
+                 const size_t end) const;
+
+  Vector3DStack m_gravity;
+  unsigned int m_numThreads;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef _RIGIDBODYSET_H_
+#define _RIGIDBODYSET_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "GeometryFwd.h"
+#include "Vector3DArray.h"
+
+class RigidBodySet
+{
+public:
+  RigidBodySet();
+  RigidBodySet(const size_t size);
+  ~RigidBodySet();
+
+  size_t size() const;
+  void resize(const size_t size);
+
+  size_t addBody(const Vector3DStack &position, const Vector3DStack &velocity,
+                 const Quaternion &orientation,
+                 const Vector3DStack &angularVelocity);
+
+  Vector3DStack getPosition(const size_t index) const;
+  void setPosition(const size_t index, const Vector3DStack &position);
+
+  Vector3DStack getVelocity(const size_t index) const;
+  void setVelocity(const size_t index, const Vector3DStack &velocity);
+
+  Quaternion getOrientation(const size_t index) const;
+  void setOrientation(const size_t index, const Quaternion &orientation);
+
+  Vector3DStack getAngularVelocity(const size_t index) const;
+  void setAngularVelocity(const size_t index,
+                          const Vector3DStack &angularVelocity);
+
+  Vector3DArray &positions();
+  Vector3DArray &velocities();
+  Vector3DArray &angularVelocities();
+  const Vector3DArray &positions() const;
+  const Vector3DArray &velocities() const;
+  const Vector3DArray &angularVelocities() const;
+
+  double *orientation(const int component);
+  const double *orientation(const int component) const;
+
+private:
+  void checkIndex(const size_t index) const;
+
+  Vector3DArray m_positions;
+  Vector3DArray m_velocities;
+  Vector3DArray m_angularVelocities;
+
+  /* Orientation w, i, j and k components */
+  std::vector<double> m_orientation[4];
+};
+
+#endif
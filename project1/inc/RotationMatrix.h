@@ -0,0 +1,72 @@
+#ifndef _ROTATIONMATRIX_H_
+#define _ROTATIONMATRIX_H_
+
+#include <cstddef>
+#include <iostream>
+
+#include "GeometryFwd.h"
+
+/*
+ * Rotation matrix with elements of type T.
+ *
+ * Instantiated for float and double only, RotationMatrix is the double
+ * version and RotationMatrixF the float version (see GeometryFwd.h).
+ */
+template <typename T> class RotationMatrixT
+{
+public:
+  typedef T Scalar;
+
+  RotationMatrixT();
+  RotationMatrixT(const QuaternionT<T> &q);
+  RotationMatrixT(const RotationMatrixT &other);
+  ~RotationMatrixT();
+
+  template <typename U>
+  explicit RotationMatrixT(const RotationMatrixT<U> &other);
+
+  void operator=(const RotationMatrixT &rhs);
+
+  bool operator==(const RotationMatrixT &rhs) const;
+  bool operator!=(const RotationMatrixT &rhs) const;
+
+  T operator()(const int row, const int column) const;
+
+  Vector3DStackT<T> operator*(const Vector3DStackT<T> &rhs) const;
+
+  void apply(const Vector3DStackT<T> *in, Vector3DStackT<T> *out,
+             const size_t count) const;
+  void apply(const T *in, T *out, const size_t count) const;
+  void apply(const Vector3DArrayT<T> &in, Vector3DArrayT<T> &out) const;
+  void apply(const Vector3DArrayT<T> &in, Vector3DArrayT<T> &out,
+             unsigned int numThreads) const;
+
+private:
+  void applyRange(const Vector3DArrayT<T> &in, Vector3DArrayT<T> &out,
+                  const size_t begin, const size_t end) const;
+
+  T m_m[9];
+};
+
+template <typename T>
+std::ostream &operator<<(std::ostream &stream, const RotationMatrixT<T> &m);
+
+/* Defined in RotationMatrix.cpp */
+extern template class RotationMatrixT<float>;
+extern template class RotationMatrixT<double>;
+
+/**
+ * Construct a matrix from one of another scalar type, e.g. a float matrix
+ * from a double one.
+ *
+ * @param other Matrix from which to take values
+ */
+template <typename T>
+template <typename U>
+RotationMatrixT<T>::RotationMatrixT(const RotationMatrixT<U> &other)
+{
+  for (int n = 0; n < 9; n++)
+    m_m[n] = (T)other(n / 3, n % 3);
+}
+
+#endif
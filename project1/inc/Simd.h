@@ -0,0 +1,160 @@
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+#include <cstddef>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Selection of the SIMD batch kernels.
+ *
+ * Every class with SIMD kernels checks useSimdKernels() and falls back to its
+ * scalar code when they are switched off or were not compiled in, so the two
+ * can be compared in tests and benchmarks.
+ */
+
+bool simdKernelsAvailable();
+void setUseSimdKernels(const bool useSimd);
+bool useSimdKernels();
+
+#ifdef __SSE2__
+/**
+ * SSE operations on a register of scalars of type T, so that a kernel can be
+ * written once for float and double.
+ *
+ * Aligned loads and stores need addresses aligned to 16 bytes.
+ */
+template <typename T> struct SimdOps;
+
+template <> struct SimdOps<double>
+{
+  typedef __m128d Vec;
+
+  /* Scalars per register */
+  static const size_t WIDTH = 2;
+
+  static Vec load(const double *p)
+  {
+    return _mm_load_pd(p);
+  }
+
+  static void store(double *p, const Vec v)
+  {
+    _mm_store_pd(p, v);
+  }
+
+  static void storeu(double *p, const Vec v)
+  {
+    _mm_storeu_pd(p, v);
+  }
+
+  static Vec set1(const double s)
+  {
+    return _mm_set1_pd(s);
+  }
+
+  static Vec add(const Vec a, const Vec b)
+  {
+    return _mm_add_pd(a, b);
+  }
+
+  static Vec sub(const Vec a, const Vec b)
+  {
+    return _mm_sub_pd(a, b);
+  }
+
+  static Vec mul(const Vec a, const Vec b)
+  {
+    return _mm_mul_pd(a, b);
+  }
+
+  static Vec div(const Vec a, const Vec b)
+  {
+    return _mm_div_pd(a, b);
+  }
+
+  static Vec sqrt(const Vec a)
+  {
+    return _mm_sqrt_pd(a);
+  }
+
+  /* a where mask is set, else b; mask from a comparison */
+  static Vec select(const Vec mask, const Vec a, const Vec b)
+  {
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+  }
+
+  static Vec cmpge(const Vec a, const Vec b)
+  {
+    return _mm_cmpge_pd(a, b);
+  }
+};
+
+template <> struct SimdOps<float>
+{
+  typedef __m128 Vec;
+
+  /* Scalars per register */
+  static const size_t WIDTH = 4;
+
+  static Vec load(const float *p)
+  {
+    return _mm_load_ps(p);
+  }
+
+  static void store(float *p, const Vec v)
+  {
+    _mm_store_ps(p, v);
+  }
+
+  static void storeu(float *p, const Vec v)
+  {
+    _mm_storeu_ps(p, v);
+  }
+
+  static Vec set1(const float s)
+  {
+    return _mm_set1_ps(s);
+  }
+
+  static Vec add(const Vec a, const Vec b)
+  {
+    return _mm_add_ps(a, b);
+  }
+
+  static Vec sub(const Vec a, const Vec b)
+  {
+    return _mm_sub_ps(a, b);
+  }
+
+  static Vec mul(const Vec a, const Vec b)
+  {
+    return _mm_mul_ps(a, b);
+  }
+
+  static Vec div(const Vec a, const Vec b)
+  {
+    return _mm_div_ps(a, b);
+  }
+
+  static Vec sqrt(const Vec a)
+  {
+    return _mm_sqrt_ps(a);
+  }
+
+  /* a where mask is set, else b; mask from a comparison */
+  static Vec select(const Vec mask, const Vec a, const Vec b)
+  {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+  }
+
+  static Vec cmpge(const Vec a, const Vec b)
+  {
+    return _mm_cmpge_ps(a, b);
+  }
+};
+#endif
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef _SWEEPANDPRUNE3D_H_
+#define _SWEEPANDPRUNE3D_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "ColliderSet.h"
+
+class SweepAndPrune3D
+{
+public:
+  SweepAndPrune3D();
+  ~SweepAndPrune3D();
+
+  void findPairs(const ColliderSet &colliders,
+                 std::vector<ColliderPair> &pairs);
+
+  int getAxis() const;
+
+private:
+  void sortOrder(const ColliderSet &colliders);
+
+  /* Axis colliders are sorted along, -1 before the first call */
+  int m_axis;
+
+  /* Collider indices in order of increasing minimum on m_axis */
+  std::vector<size_t> m_order;
+
+  /* Minimum on m_axis of each collider, indexed by collider */
+  std::vector<double> m_keys;
+
+  /* Bounds of each collider in sorted order, minimum then maximum per axis */
+  std::vector<double> m_bounds[6];
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef _TRANSFORMHIERARCHY_H_
+#define _TRANSFORMHIERARCHY_H_
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "GeometryFwd.h"
+
+class DualQuaternion;
+
+class TransformHierarchy
+{
+public:
+  static const size_t NO_PARENT;
+
+  TransformHierarchy(const unsigned int numThreads = 1);
+  ~TransformHierarchy();
+
+  void setNumThreads(const unsigned int numThreads);
+  unsigned int getNumThreads() const;
+
+  size_t size() const;
+  void reserve(const size_t size);
+  void clear();
+
+  size_t addNode(const size_t parent, const Quaternion &rotation,
+                 const Vector3DStack &translation);
+
+  size_t getParent(const size_t index) const;
+  size_t getDepth(const size_t index) const;
+  size_t numLevels() const;
+
+  Quaternion getLocalRotation(const size_t index) const;
+  void setLocalRotation(const size_t index, const Quaternion &rotation);
+
+  Vector3DStack getLocalTranslation(const size_t index) const;
+  void setLocalTranslation(const size_t index,
+                           const Vector3DStack &translation);
+
+  void setLocal(const size_t index, const Quaternion &rotation,
+                const Vector3DStack &translation);
+
+  bool isDirty(const size_t index) const;
+
+  void update();
+
+  Quaternion getWorldRotation(const size_t index) const;
+  Vector3DStack getWorldTranslation(const size_t index) const;
+  DualQuaternion getWorldTransform(const size_t index) const;
+
+private:
+  void checkIndex(const size_t index) const;
+  void buildLevels();
+  void updateRange(const size_t begin, const size_t end);
+
+  /* Parent and depth of each node, roots have a parent of UINT32_MAX */
+  std::vector<uint32_t> m_parents;
+  std::vector<uint32_t> m_depths;
+
+  /* Position of each node in the slot arrays below, which hold the nodes
+   * grouped by depth once update() has run */
+  std::vector<uint32_t> m_slots;
+  std::vector<uint32_t> m_slotParents;
+
+  /* Local and world transform of each slot as rotation w, i, j and k then
+   * translation x, y and z, padded to 8 values */
+  std::vector<double> m_local;
+  std::vector<double> m_world;
+
+  /* Non zero for slots whose world transform needs recomputing */
+  std::vector<unsigned char> m_dirty;
+  bool m_anyDirty;
+
+  /* Level l is slots m_levelOffsets[l] to m_levelOffsets[l + 1], the slots
+   * are in level order if m_levelsValid */
+  std::vector<size_t> m_levelOffsets;
+  size_t m_numLevels;
+  bool m_levelsValid;
+
+  unsigned int m_numThreads;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef _UNIFORMGRID3D_H_
+#define _UNIFORMGRID3D_H_
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "ColliderSet.h"
+
+class UniformGrid3D
+{
+public:
+  UniformGrid3D(const double cellSize = 0.0);
+  ~UniformGrid3D();
+
+  void setCellSize(const double cellSize);
+  double getCellSize() const;
+
+  void findPairs(const ColliderSet &colliders,
+                 std::vector<ColliderPair> &pairs);
+
+private:
+  double chooseCellSize(const ColliderSet &colliders) const;
+
+  uint64_t cellKey(const int32_t x, const int32_t y,
+                   const int32_t z) const;
+  size_t bucketOf(const uint64_t key) const;
+
+  /* Requested cell size, 0 to choose from the colliders */
+  double m_cellSize;
+
+  /* True if cells are indexed densely over the occupied extent, false if
+   * they are hashed */
+  bool m_dense;
+
+  /* Minimum occupied cell and number of occupied cells on each axis, used
+   * when m_dense */
+  int32_t m_cellMin[3];
+  uint64_t m_cellCount[3];
+
+  /* Number of buckets, and 64 - log2 of that when hashing */
+  size_t m_numBuckets;
+  int m_hashShift;
+
+  /* Offset of the first entry of each bucket in m_entries, plus one past the
+   * end */
+  std::vector<size_t> m_bucketStart;
+
+  /* True for each collider, by index, covering too many cells to be
+   * entered into the grid */
+  std::vector<char> m_isLarge;
+
+  /* Collider indices in order of their minimum cell */
+  std::vector<size_t> m_order;
+
+  /* Bounds of each collider in m_order order, minimum then maximum per
+   * axis */
+  std::vector<double> m_bounds[6];
+
+  /* Range of cells covered by each collider in m_order order, minimum then
+   * maximum per axis */
+  std::vector<int32_t> m_cellRange[6];
+
+  /* Position in m_order and cell key of each entry, grouped by bucket */
+  std::vector<size_t> m_entries;
+  std::vector<uint64_t> m_entryCells;
+};
+
+#endif
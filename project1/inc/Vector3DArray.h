@@ -0,0 +1,96 @@
+#ifndef _VECTOR3DARRAY_H_
+#define _VECTOR3DARRAY_H_
+
+#include <cstddef>
+
+#include "GeometryFwd.h"
+
+/*
+ * Array of three dimensional vectors with components of type T, stored as
+ * separate arrays of x, y and z components.
+ *
+ * Instantiated for float and double only, Vector3DArray is the double version
+ * and Vector3DArrayF the float version (see GeometryFwd.h).
+ */
+template <typename T> class Vector3DArrayT
+{
+public:
+  typedef T Scalar;
+
+  Vector3DArrayT();
+  Vector3DArrayT(const size_t size);
+  Vector3DArrayT(const Vector3DStackT<T> *vectors, const size_t size);
+  Vector3DArrayT(const Vector3DArrayT &other);
+  ~Vector3DArrayT();
+
+  template <typename U> explicit Vector3DArrayT(const Vector3DArrayT<U> &other);
+
+  void operator=(const Vector3DArrayT &other);
+
+  size_t size() const;
+  void resize(const size_t size);
+
+  Vector3DStackT<T> get(const size_t index) const;
+  void set(const size_t index, const Vector3DStackT<T> &v);
+
+  T *x();
+  T *y();
+  T *z();
+  const T *x() const;
+  const T *y() const;
+  const T *z() const;
+
+  static void add(const Vector3DArrayT &a, const Vector3DArrayT &b,
+                  Vector3DArrayT &out);
+  static void subtract(const Vector3DArrayT &a, const Vector3DArrayT &b,
+                       Vector3DArrayT &out);
+  static void scale(const Vector3DArrayT &a, const T s, Vector3DArrayT &out);
+  static void dot(const Vector3DArrayT &a, const Vector3DArrayT &b, T *out);
+  static void cross(const Vector3DArrayT &a, const Vector3DArrayT &b,
+                    Vector3DArrayT &out);
+
+  void magnitude(T *out) const;
+  void normalise();
+
+  static bool simdAvailable();
+  static void setUseSimd(const bool useSimd);
+  static bool useSimd();
+
+private:
+  static size_t maxCapacity();
+  void reallocate(const size_t size);
+
+  size_t m_size;
+  size_t m_capacity;
+  T *m_data;
+};
+
+/* Defined in Vector3DArray.cpp */
+extern template class Vector3DArrayT<float>;
+extern template class Vector3DArrayT<double>;
+
+/**
+ * Construct an array from one of another scalar type, e.g. a float array
+ * from a double one.
+ *
+ * @param other Array to copy values from
+ */
+template <typename T>
+template <typename U>
+Vector3DArrayT<T>::Vector3DArrayT(const Vector3DArrayT<U> &other)
+    : m_size(0)
+    , m_capacity(0)
+    , m_data(NULL)
+{
+  resize(other.size());
+
+  const U *from[] = {other.x(), other.y(), other.z()};
+  T *to[] = {x(), y(), z()};
+  for (int c = 0; c < 3; c++)
+  {
+    for (size_t i = 0; i < m_size; i++)
+      to[c][i] = (T)from[c][i];
+  }
+}
+
+#endif
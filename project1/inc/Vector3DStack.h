@@ -1,54 +1,418 @@
 #ifndef _VECTOR3DSTACK_H_
 #define _VECTOR3DSTACK_H_
 
+#include <cassert>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <type_traits>
 
-class Vector3DStack
+#include "GeometryFwd.h"
+
+/*
+ * Three dimensional vector with components of type T.
+ *
+ * Instantiated for float and double only, Vector3DStack is the double version
+ * and Vector3DStackF the float version (see GeometryFwd.h).
+ */
+template <typename T> class Vector3DStackT
 {
 public:
-  Vector3DStack();
-  Vector3DStack(const Vector3DStack &other);
-  Vector3DStack(const double x, const double y, const double z);
-  ~Vector3DStack();
+  typedef T Scalar;
+
+  Vector3DStackT() noexcept;
+  Vector3DStackT(const Vector3DStackT &other) noexcept;
+  Vector3DStackT(const T x, const T y, const T z) noexcept;
+  ~Vector3DStackT() noexcept;
+
+  template <typename U> explicit Vector3DStackT(const Vector3DStackT<U> &other);
+
+  void operator=(const Vector3DStackT &other) noexcept;
 
-  void operator=(const Vector3DStack &other);
+  bool operator==(const Vector3DStackT &other) const noexcept;
+  bool operator!=(const Vector3DStackT &other) const noexcept;
 
-  bool operator==(const Vector3DStack &other) const;
-  bool operator!=(const Vector3DStack &other) const;
+  void setX(T x) noexcept;
+  T getX() const noexcept;
 
-  void setX(double x);
-  double getX() const;
+  void setY(T y) noexcept;
+  T getY() const noexcept;
 
-  void setY(double y);
-  double getY() const;
+  void setZ(T z) noexcept;
+  T getZ() const noexcept;
 
-  void setZ(double z);
-  double getZ() const;
+  T magnitude() const noexcept;
+  Vector3DStackT getUnitVector() const;
+  Vector3DStackT getOrthogonalUnitVector(const Vector3DStackT &other) const;
+  Vector3DStackT getUnitVectorUnchecked() const noexcept;
 
-  double magnitude() const;
-  Vector3DStack getUnitVector() const;
-  Vector3DStack getOrthogonalUnitVector(const Vector3DStack &other) const;
+  Vector3DStackT operator+(const Vector3DStackT &rhs) const noexcept;
+  Vector3DStackT operator-(const Vector3DStackT &rhs) const noexcept;
 
-  Vector3DStack operator+(const Vector3DStack &rhs) const;
-  Vector3DStack operator-(const Vector3DStack &rhs) const;
+  Vector3DStackT operator*(const T rhs) const noexcept;
+  Vector3DStackT operator/(const T rhs) const;
+  Vector3DStackT divideUnchecked(const T rhs) const noexcept;
 
-  Vector3DStack operator*(const double rhs) const;
-  Vector3DStack operator/(const double rhs) const;
+  T operator*(const Vector3DStackT &rhs) const noexcept;
+  Vector3DStackT operator%(const Vector3DStackT &rhs) const noexcept;
 
-  double operator*(const Vector3DStack &rhs) const;
-  Vector3DStack operator%(const Vector3DStack &rhs) const;
+  T operator[](const int index) const;
+  T &operator[](const int index);
 
-  double operator[](const int index) const;
-  double &operator[](const int index);
+  T unchecked(const int index) const noexcept;
+  T &unchecked(const int index) noexcept;
 
-  friend std::ostream &operator<<(std::ostream &stream, const Vector3DStack &q);
+  const T *data() const noexcept;
+  T *data() noexcept;
 
 private:
-  double m_x;
-  double m_y;
-  double m_z;
+  T m_x;
+  T m_y;
+  T m_z;
 };
 
-std::istream &operator>>(std::istream &stream, Vector3DStack &q);
+template <typename T>
+std::ostream &operator<<(std::ostream &stream, const Vector3DStackT<T> &v);
+template <typename T>
+std::istream &operator>>(std::istream &stream, Vector3DStackT<T> &v);
+
+/* Defined in Vector3DStack.cpp */
+extern template class Vector3DStackT<float>;
+extern template class Vector3DStackT<double>;
+
+/* data() treats the components as an array of three scalars */
+static_assert(std::is_standard_layout<Vector3DStack>::value &&
+                  sizeof(Vector3DStack) == 3 * sizeof(double) &&
+                  sizeof(Vector3DStackF) == 3 * sizeof(float),
+              "Vector3DStack must be three packed scalars");
+
+/*
+ * Inline definitions
+ *
+ * Everything that cannot fail is defined here, so that loops over arrays of
+ * vectors in other translation units can inline and vectorise it. The
+ * unchecked variants of the checked operations only assert their
+ * preconditions, which compile out with NDEBUG.
+ */
+
+/**
+ * Instantiate a new vector will all components set to zero.
+ */
+template <typename T>
+inline Vector3DStackT<T>::Vector3DStackT() noexcept
+    : m_x(0)
+    , m_y(0)
+    , m_z(0)
+{
+}
+
+/**
+ * Instantiate a new vector taking values from another.
+ *
+ * @param other Vector to copy values from
+ */
+template <typename T>
+inline Vector3DStackT<T>::Vector3DStackT(const Vector3DStackT &other) noexcept
+    : m_x(other.m_x)
+    , m_y(other.m_y)
+    , m_z(other.m_z)
+{
+}
+
+/**
+ * Instantiate a new vector with given values.
+ *
+ * @param x Value of X component
+ * @param y Value of Y component
+ * @param z Value of Z component
+ */
+template <typename T>
+inline Vector3DStackT<T>::Vector3DStackT(const T x, const T y,
+                                         const T z) noexcept
+    : m_x(x)
+    , m_y(y)
+    , m_z(z)
+{
+}
+
+/**
+ * Instantiate a new vector from one of another scalar type, e.g. a float
+ * vector from a double one.
+ *
+ * @param other Vector to copy values from
+ */
+template <typename T>
+template <typename U>
+inline Vector3DStackT<T>::Vector3DStackT(const Vector3DStackT<U> &other)
+    : m_x((T)other.getX())
+    , m_y((T)other.getY())
+    , m_z((T)other.getZ())
+{
+}
+
+/**
+ * Destructor
+ */
+template <typename T> inline Vector3DStackT<T>::~Vector3DStackT() noexcept
+{
+}
+
+/**
+ * Set the values of this vector to the values of another.
+ *
+ * @param other Vector to copy values from
+ */
+template <typename T>
+inline void Vector3DStackT<T>::operator=(const Vector3DStackT &other) noexcept
+{
+  m_x = other.m_x;
+  m_y = other.m_y;
+  m_z = other.m_z;
+}
+
+/**
+ * Check for equality between this vector and another.
+ *
+ * @param other Other vector
+ * @return True if all component values are equal
+ */
+template <typename T>
+inline bool
+Vector3DStackT<T>::operator==(const Vector3DStackT &other) const noexcept
+{
+  return (m_x == other.m_x && m_y == other.m_y && m_z == other.m_z);
+}
+
+/**
+ * Check for inequality between this vector and another.
+ *
+ * @param other Other vector
+ * @return True if at least one component value differs
+ */
+template <typename T>
+inline bool
+Vector3DStackT<T>::operator!=(const Vector3DStackT &other) const noexcept
+{
+  return !operator==(other);
+}
+
+/**
+ * Sets the X componen of the vector.
+ *
+ * @param x X component
+ */
+template <typename T> inline void Vector3DStackT<T>::setX(T x) noexcept
+{
+  m_x = x;
+}
+
+/**
+ * Returns the X component of the vector.
+ *
+ * @return X component
+ */
+template <typename T> inline T Vector3DStackT<T>::getX() const noexcept
+{
+  return m_x;
+}
+
+/**
+ * Sets the Y componen of the vector.
+ *
+ * @param y Y component
+ */
+template <typename T> inline void Vector3DStackT<T>::setY(T y) noexcept
+{
+  m_y = y;
+}
+
+/**
+ * Returns the Y component of the vector.
+ *
+ * @return Y component
+ */
+template <typename T> inline T Vector3DStackT<T>::getY() const noexcept
+{
+  return m_y;
+}
+
+/**
+ * Sets the Z componen of the vector.
+ *
+ * @param z Z component
+ */
+template <typename T> inline void Vector3DStackT<T>::setZ(T z) noexcept
+{
+  m_z = z;
+}
+
+/**
+ * Returns the Z component of the vector.
+ *
+ * @return Z component
+ */
+template <typename T> inline T Vector3DStackT<T>::getZ() const noexcept
+{
+  return m_z;
+}
+
+/**
+ * Adds two vectors.
+ *
+ * @param rhs Right hand side vector
+ * @return This vector plus the RHS
+ */
+template <typename T>
+inline Vector3DStackT<T>
+Vector3DStackT<T>::operator+(const Vector3DStackT &rhs) const noexcept
+{
+  return Vector3DStackT(m_x + rhs.m_x, m_y + rhs.m_y, m_z + rhs.m_z);
+}
+
+/**
+ * Subtract a vector from this vector.
+ *
+ * @param rhs Right hand side vector
+ * @return This vector minus the RHS
+ */
+template <typename T>
+inline Vector3DStackT<T>
+Vector3DStackT<T>::operator-(const Vector3DStackT &rhs) const noexcept
+{
+  return Vector3DStackT(m_x - rhs.m_x, m_y - rhs.m_y, m_z - rhs.m_z);
+}
+
+/**
+ * Performs multiplication by a scalar.
+ *
+ * @param rhs Scalar to multiply by
+ * @return Product vector
+ */
+template <typename T>
+inline Vector3DStackT<T>
+Vector3DStackT<T>::operator*(const T rhs) const noexcept
+{
+  return Vector3DStackT(m_x * rhs, m_y * rhs, m_z * rhs);
+}
+
+/**
+ * Calculates dot (scalar) product of two vectors.
+ *
+ * @param rhs Right hand side vector
+ * @return Dot product
+ */
+template <typename T>
+inline T
+Vector3DStackT<T>::operator*(const Vector3DStackT &rhs) const noexcept
+{
+  return (m_x * rhs.m_x + m_y * rhs.m_y + m_z * rhs.m_z);
+}
+
+/**
+ * Calculates the cross (vector) product of two vectors.
+ *
+ * @param rhs Right hand side vector
+ * @return Cross product
+ */
+template <typename T>
+inline Vector3DStackT<T>
+Vector3DStackT<T>::operator%(const Vector3DStackT &rhs) const noexcept
+{
+  return Vector3DStackT(m_y * rhs.m_z - m_z * rhs.m_y,
+                        m_z * rhs.m_x - m_x * rhs.m_z,
+                        m_x * rhs.m_y - m_y * rhs.m_x);
+}
+
+/**
+ * Calculates the magnitude of the vector.
+ *
+ * @return Magnitude
+ */
+template <typename T> inline T Vector3DStackT<T>::magnitude() const noexcept
+{
+  return std::sqrt(m_x * m_x + m_y * m_y + m_z * m_z);
+}
+
+/**
+ * Calculates the unit vector of this vector without checking for a zero
+ * magnitude.
+ *
+ * @return Unit vector
+ */
+template <typename T>
+inline Vector3DStackT<T>
+Vector3DStackT<T>::getUnitVectorUnchecked() const noexcept
+{
+  return divideUnchecked(magnitude());
+}
+
+/**
+ * Performs division by a scalar without checking for division by zero.
+ *
+ * Multiplies by the reciprocal, so may differ from operator/ in the last bit.
+ *
+ * @param rhs Scalar to divide by, must not be zero
+ * @return Quotient vector
+ */
+template <typename T>
+inline Vector3DStackT<T>
+Vector3DStackT<T>::divideUnchecked(const T rhs) const noexcept
+{
+  assert(std::abs(rhs) >= std::numeric_limits<T>::epsilon());
+
+  const T r = 1 / rhs;
+  return Vector3DStackT(m_x * r, m_y * r, m_z * r);
+}
+
+/**
+ * Return elements of the vector by index without range checking.
+ *
+ * For reading only.
+ *
+ * @param index Index accessed, 0 to 2
+ * @return Vector component
+ */
+template <typename T>
+inline T Vector3DStackT<T>::unchecked(const int index) const noexcept
+{
+  assert(index >= 0 && index < 3);
+  return (&m_x)[index];
+}
+
+/**
+ * Return elements of the vector by index without range checking.
+ *
+ * For reading and writing.
+ *
+ * @param index Index accessed, 0 to 2
+ * @return Vector component
+ */
+template <typename T>
+inline T &Vector3DStackT<T>::unchecked(const int index) noexcept
+{
+  assert(index >= 0 && index < 3);
+  return (&m_x)[index];
+}
+
+/**
+ * Returns the components as an array of x, y and z.
+ *
+ * @return Pointer to three scalars
+ */
+template <typename T>
+inline const T *Vector3DStackT<T>::data() const noexcept
+{
+  return &m_x;
+}
+
+/**
+ * Returns the components as an array of x, y and z.
+ *
+ * @return Pointer to three scalars
+ */
+template <typename T> inline T *Vector3DStackT<T>::data() noexcept
+{
+  return &m_x;
+}
 
 #endif
@@ -0,0 +1,335 @@
+#include "ChunkedIO.h"
+
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * Construct a reader and start reading the first chunks.
+ *
+ * @param file File to read, must stay open until the reader is destroyed
+ * @param chunkSize Bytes per chunk
+ */
+ChunkedReader::ChunkedReader(FILE *file, const size_t chunkSize)
+    : m_file(file)
+    , m_eof(false)
+    , m_stop(false)
+    , m_current(-1)
+{
+  for (int b = 0; b < 2; b++)
+  {
+    m_buffers[b].resize(chunkSize);
+    m_sizes[b] = 0;
+    m_full[b] = false;
+  }
+
+  m_thread = std::thread(&ChunkedReader::run, this);
+}
+
+/**
+ * Destructor, stops reading if the file was not read to the end.
+ */
+ChunkedReader::~ChunkedReader()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cond.notify_all();
+  m_thread.join();
+}
+
+/**
+ * Returns the next chunk of the file.
+ *
+ * The chunk remains valid until the next call, at which point its buffer is
+ * given back to the reading thread.
+ *
+ * @param data Set to the start of the chunk
+ * @param size Set to the number of bytes in the chunk
+ * @return False once the end of the file has been reached
+ */
+bool ChunkedReader::next(const char *&data, size_t &size)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  /* Give the previous chunk back */
+  if (m_current >= 0)
+  {
+    m_full[m_current] = false;
+    m_cond.notify_all();
+  }
+
+  const int b = (m_current + 1) % 2;
+  m_cond.wait(lock, [&] { return m_full[b] || m_eof; });
+
+  if (!m_full[b])
+  {
+    m_current = -1;
+    return false;
+  }
+
+  m_current = b;
+  data = m_buffers[b].data();
+  size = m_sizes[b];
+  return true;
+}
+
+/**
+ * Reads chunks into whichever buffer is free until the end of the file.
+ */
+void ChunkedReader::run()
+{
+  for (int b = 0;; b = (b + 1) % 2)
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait(lock, [&] { return !m_full[b] || m_stop; });
+      if (m_stop)
+        return;
+    }
+
+    /* The buffer is not shared while it is empty */
+    const size_t size =
+        fread(m_buffers[b].data(), 1, m_buffers[b].size(), m_file);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (size > 0)
+    {
+      m_sizes[b] = size;
+      m_full[b] = true;
+    }
+    if (size < m_buffers[b].size())
+      m_eof = true;
+    m_cond.notify_all();
+
+    if (m_eof)
+      return;
+  }
+}
+
+/**
+ * Construct a splitter over the chunks of a reader.
+ *
+ * @param reader Reader to take chunks from, which must not be used directly
+ *               while the splitter is
+ * @param delimiter Character ending each record
+ * @param maxRecord Longest record split between chunks, in bytes
+ */
+ChunkedSplitter::ChunkedSplitter(ChunkedReader &reader, const char delimiter,
+                                 const size_t maxRecord)
+    : m_reader(reader)
+    , m_delimiter(delimiter)
+    , m_maxRecord(maxRecord)
+    , m_pos(NULL)
+    , m_end(NULL)
+    , m_eof(false)
+    , m_terminated(false)
+{
+}
+
+/**
+ * Destructor
+ */
+ChunkedSplitter::~ChunkedSplitter()
+{
+}
+
+/**
+ * Returns the next record.
+ *
+ * The record includes its delimiter, except for a final record the file
+ * ends without one for (see terminated()). It remains valid until the next
+ * call. Throws if a record split between chunks is longer than maxRecord.
+ *
+ * @param begin Set to the start of the record
+ * @param end Set to the end of the record
+ * @return False once the end of the file has been reached
+ */
+bool ChunkedSplitter::next(const char *&begin, const char *&end)
+{
+  if (m_pos == m_end && !nextChunk())
+    return false;
+
+  const char *found =
+      (const char *)memchr(m_pos, m_delimiter, m_end - m_pos);
+  if (found != NULL)
+  {
+    begin = m_pos;
+    end = found + 1;
+    m_pos = end;
+    m_terminated = true;
+    return true;
+  }
+
+  /* Complete a record split between chunks */
+  m_carry.assign(m_pos, m_end);
+  m_terminated = false;
+  while (nextChunk())
+  {
+    found = (const char *)memchr(m_pos, m_delimiter, m_end - m_pos);
+    if (found != NULL)
+    {
+      m_carry.append(m_pos, found + 1);
+      m_pos = found + 1;
+      m_terminated = true;
+      break;
+    }
+
+    m_carry.append(m_pos, m_end);
+    m_pos = m_end;
+    if (m_carry.size() > m_maxRecord)
+      throw std::runtime_error("Record too long");
+  }
+
+  /* The carry buffer is also null terminated, for strtod() */
+  begin = m_carry.c_str();
+  end = begin + m_carry.size();
+  return true;
+}
+
+/**
+ * Tells whether the last record returned by next() ended with the delimiter.
+ *
+ * @return False only for a final record without a delimiter
+ */
+bool ChunkedSplitter::terminated() const
+{
+  return m_terminated;
+}
+
+/**
+ * Moves on to the next chunk of the reader.
+ *
+ * @return False at the end of the file
+ */
+bool ChunkedSplitter::nextChunk()
+{
+  if (m_eof)
+    return false;
+
+  const char *data;
+  size_t size;
+  if (!m_reader.next(data, size))
+  {
+    m_eof = true;
+    m_pos = m_end = NULL;
+    return false;
+  }
+
+  m_pos = data;
+  m_end = data + size;
+  return true;
+}
+
+/**
+ * Construct a writer.
+ *
+ * @param file File to write, must stay open until finish() has returned
+ * @param chunkSize Bytes per chunk
+ */
+ChunkedWriter::ChunkedWriter(FILE *file, const size_t chunkSize)
+    : m_file(file)
+    , m_chunkSize(chunkSize)
+    , m_done(false)
+    , m_error(false)
+    , m_current(0)
+{
+  for (int b = 0; b < 2; b++)
+  {
+    m_buffers[b].resize(chunkSize);
+    m_sizes[b] = 0;
+    m_full[b] = false;
+  }
+
+  m_thread = std::thread(&ChunkedWriter::run, this);
+}
+
+/**
+ * Destructor, writes any submitted chunks.
+ */
+ChunkedWriter::~ChunkedWriter()
+{
+  finish();
+}
+
+/**
+ * Returns the number of bytes in a chunk.
+ *
+ * @return Chunk size
+ */
+size_t ChunkedWriter::chunkSize() const
+{
+  return m_chunkSize;
+}
+
+/**
+ * Returns the buffer to fill with the next chunk.
+ *
+ * @return Buffer of chunkSize() bytes
+ */
+char *ChunkedWriter::buffer()
+{
+  return m_buffers[m_current].data();
+}
+
+/**
+ * Queues the current buffer for writing and moves on to the other buffer,
+ * waiting for it to finish being written if required.
+ *
+ * @param size Number of bytes of the buffer to write, at most chunkSize()
+ */
+void ChunkedWriter::submit(const size_t size)
+{
+  if (size > m_chunkSize)
+    throw std::runtime_error("Chunk larger than buffer");
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_sizes[m_current] = size;
+  m_full[m_current] = true;
+  m_cond.notify_all();
+
+  m_current = (m_current + 1) % 2;
+  m_cond.wait(lock, [&] { return !m_full[m_current]; });
+}
+
+/**
+ * Waits for all submitted chunks to be written.
+ *
+ * @return True if all chunks were written successfully
+ */
+bool ChunkedWriter::finish()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_done = true;
+  }
+  m_cond.notify_all();
+
+  if (m_thread.joinable())
+    m_thread.join();
+
+  return !m_error && fflush(m_file) == 0;
+}
+
+/**
+ * Writes chunks in the order they were submitted.
+ */
+void ChunkedWriter::run()
+{
+  for (int b = 0;; b = (b + 1) % 2)
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait(lock, [&] { return m_full[b] || m_done; });
+      if (!m_full[b])
+        return;
+    }
+
+    if (fwrite(m_buffers[b].data(), 1, m_sizes[b], m_file) != m_sizes[b])
+      m_error = true;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_full[b] = false;
+    m_cond.notify_all();
+  }
+}
@@ -0,0 +1,249 @@
+#include "ColliderSet.h"
+
+#include <stdexcept>
+#include "Vector3DStack.h"
+
+/*
+ * Optimisation notes
+ *
+ * Colliders are stored as a structure of arrays of centres and half extents
+ * so the broad phase can sweep one axis of every collider without touching
+ * the others. A sphere stores its radius as all three half extents, which
+ * makes its box bounds the same calculation as for a box and leaves the
+ * radius available to the narrow phase without a lookup of its own.
+ */
+
+/**
+ * Construct an empty set of colliders.
+ */
+ColliderSet::ColliderSet()
+{
+}
+
+/**
+ * Destructor
+ */
+ColliderSet::~ColliderSet()
+{
+}
+
+/**
+ * Returns the number of colliders.
+ *
+ * @return Number of colliders
+ */
+size_t ColliderSet::size() const
+{
+  return m_shapes.size();
+}
+
+/**
+ * Removes all colliders.
+ */
+void ColliderSet::clear()
+{
+  m_centres.resize(0);
+  m_halfExtents.resize(0);
+  m_shapes.clear();
+}
+
+/**
+ * Allocates space for a number of colliders so they can be added without
+ * reallocating.
+ *
+ * @param size Number of colliders
+ */
+void ColliderSet::reserve(const size_t size)
+{
+  const size_t current = m_shapes.size();
+  if (size <= current)
+    return;
+
+  m_centres.resize(size);
+  m_halfExtents.resize(size);
+  m_centres.resize(current);
+  m_halfExtents.resize(current);
+  m_shapes.reserve(size);
+}
+
+/**
+ * Adds a sphere to the end of the set.
+ *
+ * @param centre Centre
+ * @param radius Radius
+ * @return Index of the new collider
+ */
+size_t ColliderSet::addSphere(const Vector3DStack &centre, const double radius)
+{
+  if (radius < 0.0)
+    throw std::runtime_error("Negative sphere radius");
+
+  const size_t index = size();
+  m_centres.resize(index + 1);
+  m_halfExtents.resize(index + 1);
+  m_shapes.push_back(COLLIDER_SPHERE);
+
+  m_centres.set(index, centre);
+  m_halfExtents.set(index, Vector3DStack(radius, radius, radius));
+
+  return index;
+}
+
+/**
+ * Adds an axis aligned box to the end of the set.
+ *
+ * @param centre Centre
+ * @param halfExtents Half of the size of the box on each axis
+ * @return Index of the new collider
+ */
+size_t ColliderSet::addBox(const Vector3DStack &centre,
+                           const Vector3DStack &halfExtents)
+{
+  if (halfExtents.getX() < 0.0 || halfExtents.getY() < 0.0 ||
+      halfExtents.getZ() < 0.0)
+    throw std::runtime_error("Negative box half extent");
+
+  const size_t index = size();
+  m_centres.resize(index + 1);
+  m_halfExtents.resize(index + 1);
+  m_shapes.push_back(COLLIDER_BOX);
+
+  m_centres.set(index, centre);
+  m_halfExtents.set(index, halfExtents);
+
+  return index;
+}
+
+/**
+ * Returns the shape of a collider.
+ *
+ * @param index Collider index
+ * @return Shape
+ */
+ColliderShape ColliderSet::getShape(const size_t index) const
+{
+  checkIndex(index);
+  return (ColliderShape)m_shapes[index];
+}
+
+/**
+ * Returns the centre of a collider.
+ *
+ * @param index Collider index
+ * @return Centre
+ */
+Vector3DStack ColliderSet::getCentre(const size_t index) const
+{
+  return m_centres.get(index);
+}
+
+/**
+ * Moves a collider.
+ *
+ * @param index Collider index
+ * @param centre New centre
+ */
+void ColliderSet::setCentre(const size_t index, const Vector3DStack &centre)
+{
+  m_centres.set(index, centre);
+}
+
+/**
+ * Returns the half extents of a collider, for a sphere these are all equal
+ * to the radius.
+ *
+ * @param index Collider index
+ * @return Half extents
+ */
+Vector3DStack ColliderSet::getHalfExtents(const size_t index) const
+{
+  return m_halfExtents.get(index);
+}
+
+/**
+ * Returns the radius of a sphere.
+ *
+ * @param index Collider index
+ * @return Radius
+ */
+double ColliderSet::getRadius(const size_t index) const
+{
+  if (getShape(index) != COLLIDER_SPHERE)
+    throw std::runtime_error("Collider is not a sphere");
+
+  return m_halfExtents.x()[index];
+}
+
+/**
+ * Returns the minimum corner of the bounding box of a collider.
+ *
+ * @param index Collider index
+ * @return Minimum corner
+ */
+Vector3DStack ColliderSet::getMin(const size_t index) const
+{
+  return getCentre(index) - getHalfExtents(index);
+}
+
+/**
+ * Returns the maximum corner of the bounding box of a collider.
+ *
+ * @param index Collider index
+ * @return Maximum corner
+ */
+Vector3DStack ColliderSet::getMax(const size_t index) const
+{
+  return getCentre(index) + getHalfExtents(index);
+}
+
+/**
+ * Returns the centres of all colliders, these may be updated in place to
+ * move colliders.
+ *
+ * @return Centres
+ */
+Vector3DArray &ColliderSet::centres()
+{
+  return m_centres;
+}
+
+/**
+ * Returns the centres of all colliders.
+ *
+ * @return Centres
+ */
+const Vector3DArray &ColliderSet::centres() const
+{
+  return m_centres;
+}
+
+/**
+ * Returns the half extents of all colliders.
+ *
+ * @return Half extents
+ */
+const Vector3DArray &ColliderSet::halfExtents() const
+{
+  return m_halfExtents;
+}
+
+/**
+ * Returns the shapes of all colliders, as ColliderShape values.
+ *
+ * @return Pointer to first shape
+ */
+const unsigned char *ColliderSet::shapes() const
+{
+  return m_shapes.empty() ? NULL : &m_shapes[0];
+}
+
+/**
+ * Checks that a collider index is in range.
+ *
+ * @param index Collider index
+ */
+void ColliderSet::checkIndex(const size_t index) const
+{
+  if (index >= size())
+    throw std::runtime_error("ColliderSet index out of range");
+}
@@ -0,0 +1,260 @@
+#include "Collision3D.h"
+
+#include <cmath>
+#include <stdexcept>
+#include "Vector3DStack.h"
+
+/*
+ * Optimisation notes
+ *
+ * The narrow phase kernels work on plain doubles read straight from the
+ * ColliderSet arrays and never allocate, so filtering a list of candidate
+ * pairs costs only the arithmetic. Distances are compared squared to avoid
+ * square roots. Touching shapes are treated as intersecting throughout.
+ *
+ * filterPairs() compacts the pair list in place, keeping the order of the
+ * pairs that intersect.
+ */
+
+/**
+ * Tests two spheres for intersection.
+ *
+ * @param ax, ay, az Centre of first sphere
+ * @param ar Radius of first sphere
+ * @param bx, by, bz Centre of second sphere
+ * @param br Radius of second sphere
+ * @return True if the spheres intersect
+ */
+static inline bool sphereSphereKernel(const double ax, const double ay,
+                                      const double az, const double ar,
+                                      const double bx, const double by,
+                                      const double bz, const double br)
+{
+  const double dx = bx - ax;
+  const double dy = by - ay;
+  const double dz = bz - az;
+  const double r = ar + br;
+  return dx * dx + dy * dy + dz * dz <= r * r;
+}
+
+/**
+ * Gets the distance along one axis from a point to the nearest point of an
+ * interval.
+ *
+ * @param p Point
+ * @param c Centre of interval
+ * @param h Half width of interval
+ * @return Distance, zero if p is inside the interval
+ */
+static inline double outsideDistance(const double p, const double c,
+                                     const double h)
+{
+  const double d = std::fabs(p - c) - h;
+  return d > 0.0 ? d : 0.0;
+}
+
+/**
+ * Tests a sphere and an axis aligned box for intersection.
+ *
+ * @param sx, sy, sz Centre of sphere
+ * @param sr Radius of sphere
+ * @param bx, by, bz Centre of box
+ * @param hx, hy, hz Half extents of box
+ * @return True if the sphere and box intersect
+ */
+static inline bool sphereBoxKernel(const double sx, const double sy,
+                                   const double sz, const double sr,
+                                   const double bx, const double by,
+                                   const double bz, const double hx,
+                                   const double hy, const double hz)
+{
+  const double dx = outsideDistance(sx, bx, hx);
+  const double dy = outsideDistance(sy, by, hy);
+  const double dz = outsideDistance(sz, bz, hz);
+  return dx * dx + dy * dy + dz * dz <= sr * sr;
+}
+
+/**
+ * Tests two axis aligned boxes for intersection.
+ *
+ * @param ax, ay, az Centre of first box
+ * @param ahx, ahy, ahz Half extents of first box
+ * @param bx, by, bz Centre of second box
+ * @param bhx, bhy, bhz Half extents of second box
+ * @return True if the boxes intersect
+ */
+static inline bool boxBoxKernel(const double ax, const double ay,
+                                const double az, const double ahx,
+                                const double ahy, const double ahz,
+                                const double bx, const double by,
+                                const double bz, const double bhx,
+                                const double bhy, const double bhz)
+{
+  /* Compared as bounds, as the broad phases do, so rounding cannot make a
+   * pair the broad phase rejected intersect here */
+  return ax - ahx <= bx + bhx && bx - bhx <= ax + ahx && ay - ahy <= by + bhy &&
+         by - bhy <= ay + ahy && az - ahz <= bz + bhz && bz - bhz <= az + ahz;
+}
+
+/**
+ * Tests two colliders for intersection without checking their indices.
+ *
+ * @param colliders Colliders
+ * @param a Index of first collider
+ * @param b Index of second collider
+ * @return True if the colliders intersect
+ */
+static inline bool intersectsKernel(const ColliderSet &colliders,
+                                    const size_t a, const size_t b)
+{
+  const double *cx = colliders.centres().x();
+  const double *cy = colliders.centres().y();
+  const double *cz = colliders.centres().z();
+  const double *hx = colliders.halfExtents().x();
+  const double *hy = colliders.halfExtents().y();
+  const double *hz = colliders.halfExtents().z();
+  const unsigned char *shapes = colliders.shapes();
+
+  if (shapes[a] == COLLIDER_SPHERE)
+  {
+    if (shapes[b] == COLLIDER_SPHERE)
+      return sphereSphereKernel(cx[a], cy[a], cz[a], hx[a], cx[b], cy[b],
+                                cz[b], hx[b]);
+
+    return sphereBoxKernel(cx[a], cy[a], cz[a], hx[a], cx[b], cy[b], cz[b],
+                           hx[b], hy[b], hz[b]);
+  }
+
+  if (shapes[b] == COLLIDER_SPHERE)
+    return sphereBoxKernel(cx[b], cy[b], cz[b], hx[b], cx[a], cy[a], cz[a],
+                           hx[a], hy[a], hz[a]);
+
+  return boxBoxKernel(cx[a], cy[a], cz[a], hx[a], hy[a], hz[a], cx[b], cy[b],
+                      cz[b], hx[b], hy[b], hz[b]);
+}
+
+/**
+ * Tests two spheres for intersection.
+ *
+ * @param centreA Centre of first sphere
+ * @param radiusA Radius of first sphere
+ * @param centreB Centre of second sphere
+ * @param radiusB Radius of second sphere
+ * @return True if the spheres intersect
+ */
+bool Collision3D::sphereSphere(const Vector3DStack &centreA,
+                               const double radiusA,
+                               const Vector3DStack &centreB,
+                               const double radiusB)
+{
+  return sphereSphereKernel(centreA.getX(), centreA.getY(), centreA.getZ(),
+                            radiusA, centreB.getX(), centreB.getY(),
+                            centreB.getZ(), radiusB);
+}
+
+/**
+ * Tests a sphere and an axis aligned box for intersection.
+ *
+ * @param centre Centre of sphere
+ * @param radius Radius of sphere
+ * @param boxCentre Centre of box
+ * @param boxHalfExtents Half extents of box
+ * @return True if the sphere and box intersect
+ */
+bool Collision3D::sphereBox(const Vector3DStack &centre, const double radius,
+                            const Vector3DStack &boxCentre,
+                            const Vector3DStack &boxHalfExtents)
+{
+  return sphereBoxKernel(centre.getX(), centre.getY(), centre.getZ(), radius,
+                         boxCentre.getX(), boxCentre.getY(), boxCentre.getZ(),
+                         boxHalfExtents.getX(), boxHalfExtents.getY(),
+                         boxHalfExtents.getZ());
+}
+
+/**
+ * Tests two axis aligned boxes for intersection.
+ *
+ * @param centreA Centre of first box
+ * @param halfExtentsA Half extents of first box
+ * @param centreB Centre of second box
+ * @param halfExtentsB Half extents of second box
+ * @return True if the boxes intersect
+ */
+bool Collision3D::boxBox(const Vector3DStack &centreA,
+                         const Vector3DStack &halfExtentsA,
+                         const Vector3DStack &centreB,
+                         const Vector3DStack &halfExtentsB)
+{
+  return boxBoxKernel(centreA.getX(), centreA.getY(), centreA.getZ(),
+                      halfExtentsA.getX(), halfExtentsA.getY(),
+                      halfExtentsA.getZ(), centreB.getX(), centreB.getY(),
+                      centreB.getZ(), halfExtentsB.getX(),
+                      halfExtentsB.getY(), halfExtentsB.getZ());
+}
+
+/**
+ * Tests two colliders for intersection.
+ *
+ * @param colliders Colliders
+ * @param a Index of first collider
+ * @param b Index of second collider
+ * @return True if the colliders intersect
+ */
+bool Collision3D::intersects(const ColliderSet &colliders, const size_t a,
+                             const size_t b)
+{
+  if (a >= colliders.size() || b >= colliders.size())
+    throw std::runtime_error("ColliderSet index out of range");
+
+  return intersectsKernel(colliders, a, b);
+}
+
+/**
+ * Removes the pairs that do not intersect from a list of candidate pairs,
+ * such as one produced by a broad phase.
+ *
+ * @param colliders Colliders
+ * @param pairs Candidate pairs, left holding only intersecting pairs
+ */
+void Collision3D::filterPairs(const ColliderSet &colliders,
+                              std::vector<ColliderPair> &pairs)
+{
+  const size_t numColliders = colliders.size();
+  size_t kept = 0;
+
+  for (size_t n = 0; n < pairs.size(); n++)
+  {
+    const ColliderPair &pair = pairs[n];
+    if (pair.first >= numColliders || pair.second >= numColliders)
+      throw std::runtime_error("ColliderSet index out of range");
+
+    if (intersectsKernel(colliders, pair.first, pair.second))
+      pairs[kept++] = pair;
+  }
+
+  pairs.resize(kept);
+}
+
+/**
+ * Finds all intersecting pairs by testing every pair.
+ *
+ * This is O(n^2) and intended only for small sets and for checking the broad
+ * phases.
+ *
+ * @param colliders Colliders
+ * @param pairs Filled with intersecting pairs, lower index first, ordered by
+ *              first then second index
+ */
+void Collision3D::findPairsBruteForce(const ColliderSet &colliders,
+                                      std::vector<ColliderPair> &pairs)
+{
+  pairs.clear();
+  for (size_t a = 0; a < colliders.size(); a++)
+  {
+    for (size_t b = a + 1; b < colliders.size(); b++)
+    {
+      if (intersectsKernel(colliders, a, b))
+        pairs.push_back(ColliderPair(a, b));
+    }
+  }
+}
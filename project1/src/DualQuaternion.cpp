@@ -0,0 +1,362 @@
+#include "DualQuaternion.h"
+
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+#include "Vector3DStack.h"
+
+/*
+ * A dual quaternion r + e d (e^2 = 0) represents the rigid transform that
+ * rotates by the unit quaternion r and then translates by t, where
+ * d = (0, t) r / 2. Composition is multiplication, in the same order as for
+ * Quaternion: (a * b) applies b first.
+ *
+ * Optimisation notes
+ *
+ * Points are transformed by rotating with the real part using
+ * Quaternion::rotateVectorNormalised() and adding the translation, rather
+ * than by the full sandwich product, which does around three times as many
+ * multiplies. Batch transforms normalise once and extract the translation
+ * once.
+ */
+
+/**
+ * Multiplies each component of a quaternion by a scalar.
+ *
+ * @param q Quaternion
+ * @param s Scalar
+ * @return Scaled quaternion
+ */
+static Quaternion scaled(const Quaternion &q, const double s)
+{
+  return Quaternion(q.getReal() * s, q.getI() * s, q.getJ() * s,
+                    q.getK() * s);
+}
+
+/**
+ * Construct the identity transform.
+ */
+DualQuaternion::DualQuaternion()
+    : m_real(1.0)
+    , m_dual(0.0)
+{
+}
+
+/**
+ * Construct a dual quaternion from its real and dual parts.
+ *
+ * @param real Real part
+ * @param dual Dual part
+ */
+DualQuaternion::DualQuaternion(const Quaternion &real, const Quaternion &dual)
+    : m_real(real)
+    , m_dual(dual)
+{
+}
+
+/**
+ * Construct a rigid transform that rotates and then translates.
+ *
+ * @param rotation Rotation, normalised if not of unit length
+ * @param translation Translation applied after the rotation
+ */
+DualQuaternion::DualQuaternion(const Quaternion &rotation,
+                               const Vector3DStack &translation)
+{
+  if (rotation.magnitude() < DBL_EPSILON)
+    throw std::runtime_error("Zero quaternion rotation");
+
+  m_real = rotation.isUnit() ? rotation : rotation.getUnitQuaternion();
+  m_dual = scaled(Quaternion(0.0, translation.getX(), translation.getY(),
+                             translation.getZ()) *
+                      m_real,
+                  0.5);
+}
+
+/**
+ * Construct a dual quaternion taking values from another.
+ *
+ * @param other Dual quaternion to copy
+ */
+DualQuaternion::DualQuaternion(const DualQuaternion &other)
+    : m_real(other.m_real)
+    , m_dual(other.m_dual)
+{
+}
+
+/**
+ * Destructor
+ */
+DualQuaternion::~DualQuaternion()
+{
+}
+
+/**
+ * Set the values of this dual quaternion to those of another.
+ *
+ * @param rhs Dual quaternion to copy
+ */
+void DualQuaternion::operator=(const DualQuaternion &rhs)
+{
+  m_real = rhs.m_real;
+  m_dual = rhs.m_dual;
+}
+
+/**
+ * Check for equality between this dual quaternion and another.
+ *
+ * @param rhs Other dual quaternion to compare to
+ * @return True if all components are equal
+ */
+bool DualQuaternion::operator==(const DualQuaternion &rhs) const
+{
+  return m_real == rhs.m_real && m_dual == rhs.m_dual;
+}
+
+/**
+ * Check for inequality between this dual quaternion and another.
+ *
+ * @param rhs Other dual quaternion to compare to
+ * @return True if any component differs
+ */
+bool DualQuaternion::operator!=(const DualQuaternion &rhs) const
+{
+  return !operator==(rhs);
+}
+
+/**
+ * Returns the real part.
+ *
+ * @return Real part
+ */
+Quaternion DualQuaternion::getReal() const
+{
+  return m_real;
+}
+
+/**
+ * Sets the real part.
+ *
+ * @param real Real part
+ */
+void DualQuaternion::setReal(const Quaternion &real)
+{
+  m_real = real;
+}
+
+/**
+ * Returns the dual part.
+ *
+ * @return Dual part
+ */
+Quaternion DualQuaternion::getDual() const
+{
+  return m_dual;
+}
+
+/**
+ * Sets the dual part.
+ *
+ * @param dual Dual part
+ */
+void DualQuaternion::setDual(const Quaternion &dual)
+{
+  m_dual = dual;
+}
+
+/**
+ * Returns the rotation of the transform.
+ *
+ * @return Rotation, of unit length
+ */
+Quaternion DualQuaternion::getRotation() const
+{
+  if (m_real.magnitude() < DBL_EPSILON)
+    throw std::runtime_error("Zero dual quaternion");
+
+  return m_real.isUnit() ? m_real : m_real.getUnitQuaternion();
+}
+
+/**
+ * Returns the translation of the transform, applied after the rotation.
+ *
+ * @return Translation
+ */
+Vector3DStack DualQuaternion::getTranslation() const
+{
+  const double m = m_real.dot(m_real);
+  if (m < DBL_EPSILON * DBL_EPSILON)
+    throw std::runtime_error("Zero dual quaternion");
+
+  /* t = 2 d r* / |r|^2 */
+  const Quaternion t = m_dual * m_real.conjugate();
+  const double s = 2.0 / m;
+  return Vector3DStack(t.getI() * s, t.getJ() * s, t.getK() * s);
+}
+
+/**
+ * Checks if this dual quaternion is a rigid transform, i.e. the real part is
+ * of unit length and orthogonal to the dual part.
+ *
+ * @param tolerance Allowed error
+ * @return True if of unit length
+ */
+bool DualQuaternion::isUnit(const double tolerance) const
+{
+  return m_real.isUnit(tolerance) &&
+         std::fabs(m_real.dot(m_dual)) <= tolerance;
+}
+
+/**
+ * Returns the nearest rigid transform to this dual quaternion, found by
+ * scaling to a unit real part and removing any part of the dual part along
+ * the real part.
+ *
+ * @return Unit dual quaternion
+ */
+DualQuaternion DualQuaternion::getUnitDualQuaternion() const
+{
+  const double m = m_real.magnitude();
+  if (m < DBL_EPSILON)
+    throw std::runtime_error("Zero dual quaternion");
+
+  const Quaternion real = scaled(m_real, 1.0 / m);
+  const Quaternion dual = scaled(m_dual, 1.0 / m);
+  return DualQuaternion(real, dual - scaled(real, real.dot(dual)));
+}
+
+/**
+ * Adds two dual quaternions component wise.
+ *
+ * @param rhs Dual quaternion to add
+ * @return Sum
+ */
+DualQuaternion DualQuaternion::operator+(const DualQuaternion &rhs) const
+{
+  return DualQuaternion(m_real + rhs.m_real, m_dual + rhs.m_dual);
+}
+
+/**
+ * Composes two transforms, the result applies rhs first.
+ *
+ * @param rhs Transform applied first
+ * @return Product
+ */
+DualQuaternion DualQuaternion::operator*(const DualQuaternion &rhs) const
+{
+  return DualQuaternion(m_real * rhs.m_real,
+                        m_real * rhs.m_dual + m_dual * rhs.m_real);
+}
+
+/**
+ * Multiplies every component by a scalar.
+ *
+ * @param rhs Scalar
+ * @return Scaled dual quaternion
+ */
+DualQuaternion DualQuaternion::operator*(const double rhs) const
+{
+  return DualQuaternion(scaled(m_real, rhs), scaled(m_dual, rhs));
+}
+
+/**
+ * Computes the quaternion conjugate of both parts, which is the inverse of a
+ * unit dual quaternion.
+ *
+ * @return Conjugate
+ */
+DualQuaternion DualQuaternion::conjugate() const
+{
+  return DualQuaternion(m_real.conjugate(), m_dual.conjugate());
+}
+
+/**
+ * Computes the inverse of this dual quaternion.
+ *
+ * @return Inverse
+ */
+DualQuaternion DualQuaternion::inverse() const
+{
+  if (m_real.magnitude() < DBL_EPSILON)
+    throw std::runtime_error("Zero dual quaternion");
+
+  /* (r + e d)^-1 = r^-1 - e r^-1 d r^-1 */
+  const Quaternion real = m_real.inverse();
+  return DualQuaternion(real, scaled(real * m_dual * real, -1.0));
+}
+
+/**
+ * Transforms a point, normalising this dual quaternion first if it is not
+ * of unit length.
+ *
+ * @param point Point to transform
+ * @return Transformed point
+ */
+Vector3DStack DualQuaternion::transformPoint(const Vector3DStack &point) const
+{
+  Vector3DStack out;
+  transformPoints(&point, &out, 1);
+  return out;
+}
+
+/**
+ * Transforms an array of points.
+ *
+ * in and out may be the same array.
+ *
+ * @param in Points to transform
+ * @param out Array to store transformed points in
+ * @param count Number of points
+ */
+void DualQuaternion::transformPoints(const Vector3DStack *in,
+                                     Vector3DStack *out,
+                                     const size_t count) const
+{
+  const DualQuaternion u = isUnit() ? *this : getUnitDualQuaternion();
+  const Vector3DStack translation = u.getTranslation();
+
+  for (size_t n = 0; n < count; n++)
+    out[n] = u.m_real.rotateVectorNormalised(in[n]) + translation;
+}
+
+/**
+ * Blends rigid transforms by dual quaternion linear blending: the weighted
+ * sum, with each transform negated if needed to lie in the same hemisphere
+ * as the first, normalised.
+ *
+ * @param transforms Transforms to blend
+ * @param weights Weight of each transform
+ * @param count Number of transforms
+ * @return Blended transform, of unit length
+ */
+DualQuaternion DualQuaternion::blend(const DualQuaternion *transforms,
+                                     const double *weights,
+                                     const size_t count)
+{
+  if (count == 0)
+    throw std::runtime_error("No transforms to blend");
+
+  DualQuaternion sum(Quaternion(0.0), Quaternion(0.0));
+  for (size_t n = 0; n < count; n++)
+  {
+    double w = weights[n];
+    if (transforms[n].m_real.dot(transforms[0].m_real) < 0.0)
+      w = -w;
+    sum = sum + transforms[n] * w;
+  }
+
+  return sum.getUnitDualQuaternion();
+}
+
+/**
+ * Outputs the components of a dual quaternion to a stream in the format
+ * "[w,i,j,k][w,i,j,k]", real part first.
+ *
+ * @param stream The stream to output to
+ * @param dq The dual quaternion to output
+ */
+std::ostream &operator<<(std::ostream &stream, const DualQuaternion &dq)
+{
+  stream << dq.m_real << dq.m_dual;
+  return stream;
+}
@@ -0,0 +1,333 @@
+#include "DualQuaternionSkinner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "DualQuaternion.h"
+#include "Parallel.h"
+#include "Simd.h"
+#include "Vector3DArray.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Skinning
+ *
+ * Each vertex is moved by dual quaternion linear blending of up to
+ * MAX_INFLUENCES bone transforms: the weighted sum of the bone dual
+ * quaternions, each negated if its rotation is in the opposite hemisphere to
+ * the first bone of the vertex, is normalised and applied to the vertex.
+ * Unlike blending matrices this keeps the transform rigid, so joints do not
+ * collapse when bones twist.
+ *
+ * Optimisation notes
+ *
+ * Bones are converted once by setBones() to a flat array of 8 doubles each
+ * (64 bytes per bone), normalised, so the kernel reads raw values and
+ * never constructs Quaternion or DualQuaternion objects. Vertices are read
+ * and written in the SoA layout of Vector3DArray.
+ *
+ * The SSE2 kernel skins two vertices per iteration, gathering the bone
+ * values of both with one load each into the low and high halves of a
+ * register; the hemisphere test is done without branches by copying the
+ * sign bit of the dot product onto the weight. The point is rotated by the
+ * unnormalised blend and scaled afterwards, saving a multiply per bone
+ * value. Large meshes are split into chunks across threads.
+ */
+
+/* Maximum number of bones affecting a single vertex */
+const size_t DualQuaternionSkinner::MAX_INFLUENCES = 4;
+
+/* Fewest vertices worth giving to a thread */
+static const size_t MIN_THREAD_VERTICES = 1 << 14;
+
+/* Threaded chunks are a multiple of this many vertices */
+static const size_t CHUNK_ALIGNMENT = 8;
+
+/**
+ * Construct a skinner with no bones.
+ *
+ * @param numThreads Maximum number of threads, zero to use one per core
+ */
+DualQuaternionSkinner::DualQuaternionSkinner(const unsigned int numThreads)
+{
+  setNumThreads(numThreads);
+}
+
+/**
+ * Destructor
+ */
+DualQuaternionSkinner::~DualQuaternionSkinner()
+{
+}
+
+/**
+ * Sets the maximum number of threads used by skin().
+ *
+ * @param numThreads Maximum number of threads, zero to use one per core
+ */
+void DualQuaternionSkinner::setNumThreads(const unsigned int numThreads)
+{
+  m_numThreads = resolveNumThreads(numThreads);
+}
+
+/**
+ * Returns the maximum number of threads used by skin().
+ *
+ * @return Number of threads
+ */
+unsigned int DualQuaternionSkinner::getNumThreads() const
+{
+  return m_numThreads;
+}
+
+/**
+ * Sets the bone transforms, typically once per frame.
+ *
+ * @param bones Transform of each bone from bind pose to current pose,
+ *              normalised if not of unit length
+ * @param count Number of bones
+ */
+void DualQuaternionSkinner::setBones(const DualQuaternion *bones,
+                                     const size_t count)
+{
+  m_bones.resize(8 * count);
+  for (size_t n = 0; n < count; n++)
+  {
+    const DualQuaternion b =
+        bones[n].isUnit() ? bones[n] : bones[n].getUnitDualQuaternion();
+    const Quaternion real = b.getReal();
+    const Quaternion dual = b.getDual();
+    std::copy(real.data(), real.data() + 4, &m_bones[8 * n]);
+    std::copy(dual.data(), dual.data() + 4, &m_bones[8 * n + 4]);
+  }
+}
+
+/**
+ * Returns the number of bones.
+ *
+ * @return Number of bones
+ */
+size_t DualQuaternionSkinner::numBones() const
+{
+  return m_bones.size() / 8;
+}
+
+/**
+ * Skins a mesh.
+ *
+ * Each vertex has MAX_INFLUENCES bone indices and weights; unused slots
+ * should have a weight of zero (and any valid index). Every vertex must have
+ * at least one non-zero weight. Weights need not sum to one.
+ *
+ * in and out may be the same array.
+ *
+ * @param in Vertices in the bind pose
+ * @param boneIndices MAX_INFLUENCES bone indices per vertex
+ * @param weights MAX_INFLUENCES weights per vertex
+ * @param out Array to store skinned vertices in, resized to match in
+ */
+void DualQuaternionSkinner::skin(const Vector3DArray &in,
+                                 const unsigned int *boneIndices,
+                                 const double *weights,
+                                 Vector3DArray &out) const
+{
+  const size_t size = in.size();
+  const size_t bones = numBones();
+  for (size_t n = 0; n < size * MAX_INFLUENCES; n++)
+  {
+    if (boneIndices[n] >= bones)
+      throw std::runtime_error("Bone index out of range");
+  }
+
+  out.resize(size);
+
+  parallelFor(0, size, MIN_THREAD_VERTICES, CHUNK_ALIGNMENT, m_numThreads,
+              [&](size_t, size_t begin, size_t end) {
+                skinRange(in, boneIndices, weights, out, begin, end);
+              });
+}
+
+#ifdef __SSE2__
+/**
+ * Loads one double from each of two addresses.
+ *
+ * @param a Address of low value
+ * @param b Address of high value
+ * @return Register holding both values
+ */
+static inline __m128d gather(const double *a, const double *b)
+{
+  return _mm_loadh_pd(_mm_load_sd(a), b);
+}
+#endif
+
+/**
+ * Skins part of a mesh.
+ *
+ * @param in Vertices in the bind pose
+ * @param boneIndices MAX_INFLUENCES bone indices per vertex
+ * @param weights MAX_INFLUENCES weights per vertex
+ * @param out Array to store skinned vertices in, at least as large as in
+ * @param begin Index of first vertex, must be even
+ * @param end Index after the last vertex
+ */
+void DualQuaternionSkinner::skinRange(const Vector3DArray &in,
+                                      const unsigned int *boneIndices,
+                                      const double *weights,
+                                      Vector3DArray &out, const size_t begin,
+                                      const size_t end) const
+{
+  const double *bones = m_bones.empty() ? NULL : &m_bones[0];
+  const double *inX = in.x();
+  const double *inY = in.y();
+  const double *inZ = in.z();
+  double *outX = out.x();
+  double *outY = out.y();
+  double *outZ = out.z();
+
+  size_t n = begin;
+#ifdef __SSE2__
+  if (useSimdKernels())
+  {
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    const __m128d two = _mm_set1_pd(2.0);
+
+    for (; n + 2 <= end; n += 2)
+    {
+      const unsigned int *ia = boneIndices + MAX_INFLUENCES * n;
+      const unsigned int *ib = ia + MAX_INFLUENCES;
+      const double *wa = weights + MAX_INFLUENCES * n;
+      const double *wb = wa + MAX_INFLUENCES;
+
+      /* Blend, first bone sets the hemisphere */
+      const double *a0 = bones + 8 * ia[0];
+      const double *b0 = bones + 8 * ib[0];
+      __m128d first[4];
+      __m128d acc[8];
+      const __m128d w0 = gather(wa, wb);
+      for (int c = 0; c < 4; c++)
+      {
+        first[c] = gather(a0 + c, b0 + c);
+        acc[c] = _mm_mul_pd(w0, first[c]);
+      }
+      for (int c = 4; c < 8; c++)
+        acc[c] = _mm_mul_pd(w0, gather(a0 + c, b0 + c));
+
+      for (size_t k = 1; k < MAX_INFLUENCES; k++)
+      {
+        const double *a = bones + 8 * ia[k];
+        const double *b = bones + 8 * ib[k];
+        __m128d v[8];
+        for (int c = 0; c < 8; c++)
+          v[c] = gather(a + c, b + c);
+
+        __m128d d = _mm_mul_pd(v[0], first[0]);
+        d = _mm_add_pd(d, _mm_mul_pd(v[1], first[1]));
+        d = _mm_add_pd(d, _mm_mul_pd(v[2], first[2]));
+        d = _mm_add_pd(d, _mm_mul_pd(v[3], first[3]));
+        const __m128d w =
+            _mm_xor_pd(gather(wa + k, wb + k), _mm_and_pd(d, signMask));
+
+        for (int c = 0; c < 8; c++)
+          acc[c] = _mm_add_pd(acc[c], _mm_mul_pd(w, v[c]));
+      }
+
+      const __m128d rw = acc[0];
+      const __m128d ri = acc[1];
+      const __m128d rj = acc[2];
+      const __m128d rk = acc[3];
+      __m128d m = _mm_mul_pd(rw, rw);
+      m = _mm_add_pd(m, _mm_mul_pd(ri, ri));
+      m = _mm_add_pd(m, _mm_mul_pd(rj, rj));
+      m = _mm_add_pd(m, _mm_mul_pd(rk, rk));
+      const __m128d s2 = _mm_div_pd(two, m);
+
+      /* Rotate, p' = p + 2(w t + r x t) / |r|^2 for t = r x p */
+      const __m128d x = _mm_load_pd(inX + n);
+      const __m128d y = _mm_load_pd(inY + n);
+      const __m128d z = _mm_load_pd(inZ + n);
+      const __m128d tx = _mm_sub_pd(_mm_mul_pd(rj, z), _mm_mul_pd(rk, y));
+      const __m128d ty = _mm_sub_pd(_mm_mul_pd(rk, x), _mm_mul_pd(ri, z));
+      const __m128d tz = _mm_sub_pd(_mm_mul_pd(ri, y), _mm_mul_pd(rj, x));
+      __m128d px = _mm_add_pd(
+          _mm_mul_pd(rw, tx),
+          _mm_sub_pd(_mm_mul_pd(rj, tz), _mm_mul_pd(rk, ty)));
+      __m128d py = _mm_add_pd(
+          _mm_mul_pd(rw, ty),
+          _mm_sub_pd(_mm_mul_pd(rk, tx), _mm_mul_pd(ri, tz)));
+      __m128d pz = _mm_add_pd(
+          _mm_mul_pd(rw, tz),
+          _mm_sub_pd(_mm_mul_pd(ri, ty), _mm_mul_pd(rj, tx)));
+
+      /* Translate by 2(rw dv - dw rv + rv x dv) / |r|^2 */
+      const __m128d dw = acc[4];
+      const __m128d di = acc[5];
+      const __m128d dj = acc[6];
+      const __m128d dk = acc[7];
+      px = _mm_add_pd(
+          px, _mm_add_pd(_mm_sub_pd(_mm_mul_pd(rw, di), _mm_mul_pd(dw, ri)),
+                         _mm_sub_pd(_mm_mul_pd(rj, dk), _mm_mul_pd(rk, dj))));
+      py = _mm_add_pd(
+          py, _mm_add_pd(_mm_sub_pd(_mm_mul_pd(rw, dj), _mm_mul_pd(dw, rj)),
+                         _mm_sub_pd(_mm_mul_pd(rk, di), _mm_mul_pd(ri, dk))));
+      pz = _mm_add_pd(
+          pz, _mm_add_pd(_mm_sub_pd(_mm_mul_pd(rw, dk), _mm_mul_pd(dw, rk)),
+                         _mm_sub_pd(_mm_mul_pd(ri, dj), _mm_mul_pd(rj, di))));
+
+      _mm_store_pd(outX + n, _mm_add_pd(x, _mm_mul_pd(s2, px)));
+      _mm_store_pd(outY + n, _mm_add_pd(y, _mm_mul_pd(s2, py)));
+      _mm_store_pd(outZ + n, _mm_add_pd(z, _mm_mul_pd(s2, pz)));
+    }
+  }
+#endif
+  for (; n < end; n++)
+  {
+    const unsigned int *index = boneIndices + MAX_INFLUENCES * n;
+    const double *weight = weights + MAX_INFLUENCES * n;
+
+    /* Blend, first bone sets the hemisphere */
+    const double *first = bones + 8 * index[0];
+    double acc[8];
+    for (int c = 0; c < 8; c++)
+      acc[c] = weight[0] * first[c];
+
+    for (size_t k = 1; k < MAX_INFLUENCES; k++)
+    {
+      const double *b = bones + 8 * index[k];
+      const double d =
+          b[0] * first[0] + b[1] * first[1] + b[2] * first[2] + b[3] * first[3];
+      const double w = d < 0.0 ? -weight[k] : weight[k];
+      for (int c = 0; c < 8; c++)
+        acc[c] += w * b[c];
+    }
+
+    const double rw = acc[0];
+    const double ri = acc[1];
+    const double rj = acc[2];
+    const double rk = acc[3];
+    const double dw = acc[4];
+    const double di = acc[5];
+    const double dj = acc[6];
+    const double dk = acc[7];
+    const double s2 = 2.0 / (rw * rw + ri * ri + rj * rj + rk * rk);
+
+    /* Rotate, p' = p + 2(w t + r x t) / |r|^2 for t = r x p */
+    const double x = inX[n];
+    const double y = inY[n];
+    const double z = inZ[n];
+    const double tx = rj * z - rk * y;
+    const double ty = rk * x - ri * z;
+    const double tz = ri * y - rj * x;
+    const double px = rw * tx + (rj * tz - rk * ty);
+    const double py = rw * ty + (rk * tx - ri * tz);
+    const double pz = rw * tz + (ri * ty - rj * tx);
+
+    /* Translate by 2(rw dv - dw rv + rv x dv) / |r|^2 */
+    outX[n] = x + s2 * (px + (rw * di - dw * ri) + (rj * dk - rk * dj));
+    outY[n] = y + s2 * (py + (rw * dj - dw * rj) + (rk * di - ri * dk));
+    outZ[n] = z + s2 * (pz + (rw * dk - dw * rk) + (ri * dj - rj * di));
+  }
+}
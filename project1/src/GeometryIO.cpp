@@ -0,0 +1,853 @@
+#include "GeometryIO.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+#include "Quaternion.h"
+#include "Vector3DStack.h"
+
+/*
+ * Optimisation notes
+ *
+ * Records are parsed and formatted directly in the chunk buffers of
+ * ChunkedReader and ChunkedWriter, so the file is read and written on
+ * background threads while the calling thread converts values, and no
+ * iostream, locale or per value allocation is involved.
+ *
+ * Numbers are converted with the fast paths below, falling back to strtod()
+ * or snprintf() only in the rare cases they cannot be sure of the correctly
+ * rounded result, so the output is always identical to the C library.
+ *
+ * Parsing: the decimal digits are read into a 64 bit integer m and the
+ * value is m * 10^e. When m < 2^53 and |e| <= 22 both are exact doubles and
+ * a single multiply or divide is correctly rounded. Longer mantissas (such
+ * as the 17 digits needed to write any double exactly) are multiplied or
+ * divided using an exact product (Dekker's algorithm), giving the value to
+ * about 106 bits; that is rounded once and only if it lies within a tiny
+ * distance of a halfway point between two doubles is strtod() used.
+ *
+ * Formatting: the value is scaled by a power of ten the same way to give an
+ * integer of the requested number of significant digits, which is then
+ * written out in the form of printf("%.*g"). Values too close to a halfway
+ * point between two outputs, or too large or small for a single exact power
+ * of ten, use snprintf().
+ *
+ * Binary files hold the doubles exactly as they are laid out in memory on
+ * little endian machines, so a record is a single copy; bytes are only
+ * swapped on big endian machines.
+ */
+
+/* Longest text of one formatted double, with its terminating null */
+static const size_t MAX_NUMBER = 32;
+
+/* Longest text of one formatted record */
+static const size_t MAX_RECORD = 4 * MAX_NUMBER + 8;
+
+/* Longest text record accepted when split between chunks */
+static const size_t MAX_TEXT_RECORD = 4096;
+
+/* Powers of ten that are exact doubles */
+static const double POW10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                               1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                               1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                               1e18, 1e19, 1e20, 1e21, 1e22};
+static const int MAX_POW10 = 22;
+
+/* Powers of ten as integers, for formatting */
+static const uint64_t INT_POW10[] = {1ULL,
+                                     10ULL,
+                                     100ULL,
+                                     1000ULL,
+                                     10000ULL,
+                                     100000ULL,
+                                     1000000ULL,
+                                     10000000ULL,
+                                     100000000ULL,
+                                     1000000000ULL,
+                                     10000000000ULL,
+                                     100000000000ULL,
+                                     1000000000000ULL,
+                                     10000000000000ULL,
+                                     100000000000000ULL,
+                                     1000000000000000ULL,
+                                     10000000000000000ULL,
+                                     100000000000000000ULL};
+
+/* Fraction of the gap between two doubles (or decimal outputs) within which
+ * a value is treated as too close to halfway to round without the C
+ * library */
+static const double TIE_MARGIN = 1e-6;
+
+/**
+ * Splits a double into two halves of 26 bits each.
+ *
+ * @param a Value to split
+ * @param hi Set to the high half
+ * @param lo Set to the low half, a - hi
+ */
+static inline void split(const double a, double &hi, double &lo)
+{
+  const double c = 134217729.0 * a;
+  hi = c - (c - a);
+  lo = a - hi;
+}
+
+/**
+ * Multiplies two doubles, giving the rounded product and its rounding error.
+ *
+ * @param a First value
+ * @param b Second value
+ * @param p Set to the rounded product
+ * @param e Set to the exact product minus p
+ */
+static inline void twoProduct(const double a, const double b, double &p,
+                              double &e)
+{
+  double ah, al, bh, bl;
+  split(a, ah, al);
+  split(b, bh, bl);
+  p = a * b;
+  e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+}
+
+/**
+ * Scales a value by a power of ten, giving the result to about twice double
+ * precision.
+ *
+ * @param hi High part of the value
+ * @param lo Low part of the value, much smaller than hi
+ * @param k Power of ten, at most MAX_POW10 in magnitude
+ * @param outHi Set to the high part of the result
+ * @param outLo Set to the low part of the result
+ */
+static inline void scale(const double hi, const double lo, const int k,
+                         double &outHi, double &outLo)
+{
+  if (k >= 0)
+  {
+    twoProduct(hi, POW10[k], outHi, outLo);
+    outLo += lo * POW10[k];
+  }
+  else
+  {
+    const double d = POW10[-k];
+    outHi = hi / d;
+    double p, e;
+    twoProduct(outHi, d, p, e);
+    outLo = (((hi - p) - e) + lo) / d;
+  }
+}
+
+/**
+ * Returns the power of two of a positive finite double.
+ *
+ * @param a Value
+ * @return Binary exponent, such that 2^e <= a < 2^(e + 1) for normal values
+ */
+static inline int binaryExponent(const double a)
+{
+  uint64_t bits;
+  memcpy(&bits, &a, sizeof(bits));
+  return (int)((bits >> 52) & 0x7ff) - 1023;
+}
+
+/**
+ * Returns the next double after a positive normal double.
+ *
+ * @param a Value
+ * @param up True for the next larger double, false for the next smaller
+ * @return Adjacent double
+ */
+static inline double adjacent(const double a, const bool up)
+{
+  uint64_t bits;
+  memcpy(&bits, &a, sizeof(bits));
+  bits = up ? bits + 1 : bits - 1;
+  double next;
+  memcpy(&next, &bits, sizeof(next));
+  return next;
+}
+
+/**
+ * Rounds a non negative value times a power of ten to the nearest integer.
+ *
+ * @param a Value
+ * @param k Power of ten
+ * @param n Set to the rounded result
+ * @return False if k is out of range or the result is too close to halfway
+ *         between two integers to be sure of
+ */
+static bool scaleRound(const double a, const int k, uint64_t &n)
+{
+  if (k > MAX_POW10 || k < -MAX_POW10)
+    return false;
+
+  double hi, lo;
+  scale(a, 0.0, k, hi, lo);
+  if (hi >= 1e18)
+    return false;
+
+  /* Truncation is floor for the non negative high part, the low part may
+   * take the sum either way by a few units */
+  const int64_t whole = (int64_t)hi;
+  double fraction = (hi - (double)whole) + lo;
+  int64_t carry = (int64_t)fraction;
+  if ((double)carry > fraction)
+    carry--;
+  fraction -= (double)carry;
+
+  if (std::fabs(fraction - 0.5) < TIE_MARGIN)
+    return false;
+
+  n = (uint64_t)(whole + carry) + (fraction > 0.5 ? 1 : 0);
+  return true;
+}
+
+/**
+ * Formats a double in the same way as printf("%.*g", precision, value).
+ *
+ * @param value Value to format
+ * @param precision Number of significant digits, 1 to 17 (17 is enough to
+ *                  read back any double exactly)
+ * @param out Buffer of at least 32 characters, null terminated
+ * @return Number of characters written, excluding the null
+ */
+size_t formatDouble(const double value, const int precision, char *out)
+{
+  const int p = std::min(std::max(precision, 1), 17);
+
+  if (value == 0.0)
+  {
+    char *o = out;
+    if (std::signbit(value))
+      *o++ = '-';
+    *o++ = '0';
+    *o = '\0';
+    return o - out;
+  }
+
+  uint64_t n = 0;
+  bool fast = std::isfinite(value);
+  int exponent = 0;
+  if (fast)
+  {
+    /* Estimate the decimal exponent from the binary one, which may be one
+     * too small, and correct it where there is an exact power of ten */
+    const double a = std::fabs(value);
+    exponent = (int)std::floor(0.30102999566398120 * binaryExponent(a));
+    if (exponent + 1 <= MAX_POW10 && exponent + 1 >= 0 &&
+        a >= POW10[exponent + 1])
+      exponent++;
+    fast = scaleRound(a, p - 1 - exponent, n);
+    if (fast && n >= INT_POW10[p])
+    {
+      exponent++;
+      fast = scaleRound(std::fabs(value), p - 1 - exponent, n);
+    }
+    else if (fast && n <= INT_POW10[p - 1])
+    {
+      /* Just below a power of ten may round up to it at this exponent but
+       * not at the one below */
+      uint64_t below;
+      if (scaleRound(std::fabs(value), p - exponent, below) &&
+          below < INT_POW10[p])
+      {
+        exponent--;
+        n = below;
+      }
+    }
+    fast = fast && n >= INT_POW10[p - 1] && n < INT_POW10[p];
+  }
+
+  if (!fast)
+    return (size_t)snprintf(out, MAX_NUMBER, "%.*g", p, value);
+
+  /* Significant digits, without trailing zeros */
+  char digits[17];
+  for (int d = p - 1; d >= 0; d--)
+  {
+    digits[d] = (char)('0' + n % 10);
+    n /= 10;
+  }
+  int numDigits = p;
+  while (numDigits > 1 && digits[numDigits - 1] == '0')
+    numDigits--;
+
+  char *o = out;
+  if (value < 0.0)
+    *o++ = '-';
+
+  if (exponent < -4 || exponent >= p)
+  {
+    /* d.ddde+XX */
+    *o++ = digits[0];
+    if (numDigits > 1)
+    {
+      *o++ = '.';
+      for (int d = 1; d < numDigits; d++)
+        *o++ = digits[d];
+    }
+    *o++ = 'e';
+    *o++ = exponent < 0 ? '-' : '+';
+    const int e = std::abs(exponent);
+    if (e >= 100)
+      *o++ = (char)('0' + e / 100);
+    *o++ = (char)('0' + e / 10 % 10);
+    *o++ = (char)('0' + e % 10);
+  }
+  else if (exponent >= 0)
+  {
+    /* ddd.ddd */
+    for (int d = 0; d <= exponent; d++)
+      *o++ = d < numDigits ? digits[d] : '0';
+    if (numDigits > exponent + 1)
+    {
+      *o++ = '.';
+      for (int d = exponent + 1; d < numDigits; d++)
+        *o++ = digits[d];
+    }
+  }
+  else
+  {
+    /* 0.000ddd */
+    *o++ = '0';
+    *o++ = '.';
+    for (int z = -1; z > exponent; z--)
+      *o++ = '0';
+    for (int d = 0; d < numDigits; d++)
+      *o++ = digits[d];
+  }
+
+  *o = '\0';
+  return o - out;
+}
+
+/**
+ * Parses a number with strtod(), for the cases parseDouble() does not
+ * handle itself.
+ *
+ * @param begin Start of the text
+ * @param end End of the text
+ * @param value Set to the value parsed
+ * @return Pointer after the number, NULL if there is no valid number
+ */
+static const char *parseDoubleSlow(const char *begin, const char *end,
+                                   double &value)
+{
+  /* Copy out the characters that may be part of the number, as the text is
+   * not null terminated */
+  const char *tokenEnd = begin;
+  while (tokenEnd < end &&
+         (isalnum((unsigned char)*tokenEnd) || *tokenEnd == '+' ||
+          *tokenEnd == '-' || *tokenEnd == '.'))
+    tokenEnd++;
+
+  const std::string token(begin, tokenEnd);
+  char *parsedEnd;
+  value = strtod(token.c_str(), &parsedEnd);
+  if (parsedEnd == token.c_str())
+    return NULL;
+
+  return begin + (parsedEnd - token.c_str());
+}
+
+/**
+ * Parses a decimal number, giving the same result as strtod() but without
+ * needing null terminated text.
+ *
+ * @param begin Start of the text, at the first character of the number
+ * @param end End of the text
+ * @param value Set to the value parsed
+ * @return Pointer after the number, NULL if there is no valid number
+ */
+const char *parseDouble(const char *begin, const char *end, double &value)
+{
+  const char *p = begin;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+  {
+    negative = *p == '-';
+    p++;
+  }
+
+  /* Up to 19 significant digits fit in 64 bits */
+  uint64_t m = 0;
+  int numDigits = 0;
+  int exponent = 0;
+  bool anyDigits = false;
+  bool truncated = false;
+
+  for (; p < end && *p >= '0' && *p <= '9'; p++)
+  {
+    anyDigits = true;
+    if (numDigits < 19)
+    {
+      m = m * 10 + (*p - '0');
+      if (m > 0)
+        numDigits++;
+    }
+    else
+    {
+      exponent++;
+      truncated |= *p != '0';
+    }
+  }
+
+  if (p < end && *p == '.')
+  {
+    for (p++; p < end && *p >= '0' && *p <= '9'; p++)
+    {
+      anyDigits = true;
+      if (numDigits < 19)
+      {
+        m = m * 10 + (*p - '0');
+        if (m > 0)
+          numDigits++;
+        exponent--;
+      }
+      else
+        truncated |= *p != '0';
+    }
+  }
+
+  /* Leave nan, inf and hex to strtod() */
+  if (!anyDigits || truncated)
+    return parseDoubleSlow(begin, end, value);
+
+  if (p < end && (*p == 'e' || *p == 'E'))
+  {
+    const char *e = p + 1;
+    bool negativeExponent = false;
+    if (e < end && (*e == '-' || *e == '+'))
+    {
+      negativeExponent = *e == '-';
+      e++;
+    }
+
+    /* An e without digits is not part of the number */
+    if (e < end && *e >= '0' && *e <= '9')
+    {
+      int written = 0;
+      for (; e < end && *e >= '0' && *e <= '9'; e++)
+        written = std::min(written * 10 + (*e - '0'), 100000);
+      exponent += negativeExponent ? -written : written;
+      p = e;
+    }
+  }
+
+  if (m == 0)
+  {
+    value = negative ? -0.0 : 0.0;
+    return p;
+  }
+
+  if (exponent < -MAX_POW10 || exponent > MAX_POW10)
+    return parseDoubleSlow(begin, end, value);
+
+  if (m <= (1ULL << 53))
+  {
+    /* Both exact, so one correctly rounded operation */
+    value = exponent >= 0 ? (double)m * POW10[exponent]
+                          : (double)m / POW10[-exponent];
+  }
+  else
+  {
+    const double mHi = (double)m;
+    const double mLo = (double)(int64_t)(m - (uint64_t)mHi);
+    double hi, lo;
+    scale(mHi, mLo, exponent, hi, lo);
+
+    const double rounded = hi + lo;
+    const double error = (hi - rounded) + lo;
+    const double gap = std::fabs(adjacent(rounded, error > 0.0) - rounded);
+    if (std::fabs(std::fabs(error) - 0.5 * gap) < TIE_MARGIN * gap)
+      return parseDoubleSlow(begin, end, value);
+
+    value = rounded;
+  }
+
+  if (negative)
+    value = -value;
+  return p;
+}
+
+/**
+ * Checks if doubles are stored little endian.
+ *
+ * @return True if little endian
+ */
+static bool isLittleEndian()
+{
+  const uint16_t one = 1;
+  unsigned char first;
+  memcpy(&first, &one, 1);
+  return first == 1;
+}
+
+/**
+ * Copies doubles, reversing the bytes of each on big endian machines so
+ * that the copy is little endian (or native, if copying from a file).
+ *
+ * @param out Destination
+ * @param in Source
+ * @param count Number of doubles
+ */
+static void copyLittleEndian(void *out, const void *in, const int count)
+{
+  memcpy(out, in, count * sizeof(double));
+  if (isLittleEndian())
+    return;
+
+  unsigned char *bytes = (unsigned char *)out;
+  for (int n = 0; n < count; n++)
+    std::reverse(bytes + n * sizeof(double), bytes + (n + 1) * sizeof(double));
+}
+
+/**
+ * Skips spaces, tabs and line breaks.
+ *
+ * @param p Start of the text
+ * @param end End of the text
+ * @return Pointer to the first other character, or end
+ */
+static inline const char *skipSpace(const char *p, const char *end)
+{
+  while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+    p++;
+  return p;
+}
+
+/**
+ * Parses one text record, "[a,b,...]".
+ *
+ * @param p Start of the record, at the opening bracket
+ * @param end End of the record, after the closing bracket
+ * @param values Array to store values in
+ * @param width Number of values
+ * @return True if the record is valid
+ */
+static bool parseRecord(const char *p, const char *end, double *values,
+                        const int width)
+{
+  if (*p != '[')
+    return false;
+  p++;
+
+  for (int n = 0; n < width; n++)
+  {
+    p = parseDouble(skipSpace(p, end), end - 1, values[n]);
+    if (p == NULL)
+      return false;
+
+    p = skipSpace(p, end);
+    if (p == end || *p != (n + 1 < width ? ',' : ']'))
+      return false;
+    p++;
+  }
+
+  return p == end;
+}
+
+/**
+ * Construct a reader and start reading the file.
+ *
+ * @param file File to read, must stay open until the reader is destroyed
+ * @param format Format of the file
+ * @param chunkSize Bytes per chunk
+ */
+GeometryReader::GeometryReader(FILE *file, const GeometryFormat format,
+                               const size_t chunkSize)
+    : m_file(file)
+    , m_format(format)
+    , m_reader(file, std::max<size_t>(chunkSize, 1))
+    , m_splitter(m_reader, ']', MAX_TEXT_RECORD)
+    , m_pos(NULL)
+    , m_end(NULL)
+    , m_eof(false)
+    , m_records(0)
+{
+}
+
+/**
+ * Destructor, stops reading if the file was not read to the end.
+ */
+GeometryReader::~GeometryReader()
+{
+}
+
+/**
+ * Reads the next quaternions from the file.
+ *
+ * @param out Array to store quaternions in
+ * @param count Maximum number of quaternions to read
+ * @return Number of quaternions read, less than count only at the end of
+ *         the file
+ */
+size_t GeometryReader::read(Quaternion *out, const size_t count)
+{
+  double values[4];
+  size_t n = 0;
+  for (; n < count && (m_format == GEOMETRY_TEXT ? nextText(values, 4)
+                                                 : nextBinary(values, 4));
+       n++)
+    out[n] = Quaternion(values[0], values[1], values[2], values[3]);
+
+  m_records += n;
+  return n;
+}
+
+/**
+ * Reads the next vectors from the file.
+ *
+ * @param out Array to store vectors in
+ * @param count Maximum number of vectors to read
+ * @return Number of vectors read, less than count only at the end of the
+ *         file
+ */
+size_t GeometryReader::read(Vector3DStack *out, const size_t count)
+{
+  double values[3];
+  size_t n = 0;
+  for (; n < count && (m_format == GEOMETRY_TEXT ? nextText(values, 3)
+                                                 : nextBinary(values, 3));
+       n++)
+    out[n] = Vector3DStack(values[0], values[1], values[2]);
+
+  m_records += n;
+  return n;
+}
+
+/**
+ * Returns the number of records read so far.
+ *
+ * @return Number of records
+ */
+size_t GeometryReader::recordsRead() const
+{
+  return m_records;
+}
+
+/**
+ * Moves on to the next chunk of a binary file.
+ *
+ * @return False at the end of the file
+ */
+bool GeometryReader::nextChunk()
+{
+  if (m_eof)
+    return false;
+
+  const char *data;
+  size_t size;
+  if (!m_reader.next(data, size))
+  {
+    m_eof = true;
+    m_pos = m_end = NULL;
+    checkReadError();
+    return false;
+  }
+
+  m_pos = data;
+  m_end = data + size;
+  return true;
+}
+
+/**
+ * Throws if reading the file failed, to tell an error from the end of it.
+ */
+void GeometryReader::checkReadError() const
+{
+  if (ferror(m_file))
+    throw std::runtime_error("Failed to read file");
+}
+
+/**
+ * Reads the next text record.
+ *
+ * @param values Array to store values in
+ * @param width Number of values in a record
+ * @return False at the end of the file
+ */
+bool GeometryReader::nextText(double *values, const int width)
+{
+  const char *begin;
+  const char *end;
+  if (!m_splitter.next(begin, end))
+  {
+    checkReadError();
+    return false;
+  }
+
+  begin = skipSpace(begin, end);
+  if (!m_splitter.terminated())
+  {
+    /* Only space may follow the last record */
+    checkReadError();
+    if (begin == end)
+      return false;
+    throw std::runtime_error("File ends with a partial record");
+  }
+
+  if (!parseRecord(begin, end, values, width))
+    throw std::runtime_error("Invalid text record");
+
+  return true;
+}
+
+/**
+ * Reads the next binary record.
+ *
+ * @param values Array to store values in
+ * @param width Number of values in a record
+ * @return False at the end of the file
+ */
+bool GeometryReader::nextBinary(double *values, const int width)
+{
+  const size_t bytes = width * sizeof(double);
+  if ((size_t)(m_end - m_pos) >= bytes)
+  {
+    copyLittleEndian(values, m_pos, width);
+    m_pos += bytes;
+    return true;
+  }
+
+  /* Complete a record split between chunks */
+  m_carry.assign(m_pos, m_end);
+  m_pos = m_end;
+  while (m_carry.size() < bytes)
+  {
+    if (!nextChunk())
+    {
+      if (m_carry.empty())
+        return false;
+      throw std::runtime_error("File ends with a partial record");
+    }
+
+    const size_t n = std::min(bytes - m_carry.size(), (size_t)(m_end - m_pos));
+    m_carry.append(m_pos, n);
+    m_pos += n;
+  }
+
+  copyLittleEndian(values, m_carry.data(), width);
+  return true;
+}
+
+/**
+ * Construct a writer.
+ *
+ * @param file File to write, must stay open until the writer is destroyed
+ * @param format Format to write
+ * @param precision Significant digits of text values, 1 to 17 (17 is enough
+ *                  to read back any double exactly)
+ * @param chunkSize Bytes per chunk
+ */
+GeometryWriter::GeometryWriter(FILE *file, const GeometryFormat format,
+                               const int precision, const size_t chunkSize)
+    : m_format(format)
+    , m_precision(precision)
+    , m_writer(file, std::max(chunkSize, MAX_RECORD))
+    , m_used(0)
+    , m_finished(false)
+    , m_ok(false)
+{
+  if (precision < 1 || precision > 17)
+    throw std::runtime_error("Invalid precision");
+}
+
+/**
+ * Destructor, writes anything not yet written.
+ */
+GeometryWriter::~GeometryWriter()
+{
+  finish();
+}
+
+/**
+ * Writes quaternions to the file.
+ *
+ * @param in Quaternions to write
+ * @param count Number of quaternions
+ */
+void GeometryWriter::write(const Quaternion *in, const size_t count)
+{
+  for (size_t n = 0; n < count; n++)
+  {
+    const double values[] = {in[n].getReal(), in[n].getI(), in[n].getJ(),
+                             in[n].getK()};
+    writeRecord(values, 4);
+  }
+}
+
+/**
+ * Writes vectors to the file.
+ *
+ * @param in Vectors to write
+ * @param count Number of vectors
+ */
+void GeometryWriter::write(const Vector3DStack *in, const size_t count)
+{
+  for (size_t n = 0; n < count; n++)
+  {
+    const double values[] = {in[n].getX(), in[n].getY(), in[n].getZ()};
+    writeRecord(values, 3);
+  }
+}
+
+/**
+ * Writes anything not yet written and waits for it to reach the file.
+ * Nothing more may be written afterwards.
+ *
+ * @return True if everything was written successfully
+ */
+bool GeometryWriter::finish()
+{
+  if (!m_finished)
+  {
+    if (m_used > 0)
+      m_writer.submit(m_used);
+    m_used = 0;
+    m_finished = true;
+    m_ok = m_writer.finish();
+  }
+
+  return m_ok;
+}
+
+/**
+ * Writes one record.
+ *
+ * @param values Values of the record
+ * @param width Number of values
+ */
+void GeometryWriter::writeRecord(const double *values, const int width)
+{
+  if (m_finished)
+    throw std::runtime_error("GeometryWriter has finished");
+
+  if (m_writer.chunkSize() - m_used < MAX_RECORD)
+  {
+    m_writer.submit(m_used);
+    m_used = 0;
+  }
+
+  char *out = m_writer.buffer() + m_used;
+  if (m_format == GEOMETRY_BINARY)
+  {
+    copyLittleEndian(out, values, width);
+    m_used += width * sizeof(double);
+    return;
+  }
+
+  char *o = out;
+  *o++ = '[';
+  for (int n = 0; n < width; n++)
+  {
+    o += formatDouble(values[n], m_precision, o);
+    *o++ = n + 1 < width ? ',' : ']';
+  }
+  *o++ = '\n';
+  m_used += o - out;
+}
@@ -0,0 +1,634 @@
+#include "KdTree.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include "Parallel.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+/*
+ * Optimisation notes
+ *
+ * The tree is static: it is built once over a set of points and then only
+ * queried. Each node splits its points at the median on the axis along which
+ * they are most spread out, so the tree is balanced and its shape depends
+ * only on the number of points. That means the number of nodes in any
+ * subtree is known before it is built, so nodes are stored depth first in
+ * one flat array (the left child follows its parent, the parent holds the
+ * index of the right child) and subtrees can be built on separate threads
+ * straight into their own part of the array.
+ *
+ * Points are copied into structure of arrays form in tree order, so the
+ * points of a leaf, and of every subtree, are contiguous. Leaves hold up to
+ * LEAF_SIZE points, which are scanned linearly; that is cheaper than
+ * descending further for a handful of points.
+ *
+ * All distances are compared squared, so no query takes a square root.
+ * Queries descend the side of each split holding the query point first and
+ * only visit the other side if it could hold a point nearer than the
+ * furthest point wanted. Nearest point queries track the distance to the
+ * region of each subtree on all three axes rather than just the last split,
+ * which rules out more subtrees.
+ *
+ * Batches of queries are first sorted into Z-order through the bounds of the
+ * tree, so consecutive queries descend mostly the same nodes and read mostly
+ * the same leaves, which are then already in cache. The sorted batch is split
+ * into chunks across threads, giving each thread a compact region.
+ */
+
+/* Most points held by a leaf */
+const size_t KdTree::LEAF_SIZE = 16;
+
+/* Fewest points worth giving a thread when building */
+static const size_t MIN_THREAD_BUILD_POINTS = 1 << 15;
+
+/* Fewest queries worth giving a thread */
+static const size_t MIN_THREAD_QUERIES = 1 << 10;
+
+/* Cells per axis when ordering batched queries, 10 bits per axis */
+static const double MORTON_CELLS = 1024.0;
+
+/**
+ * Orders neighbours by distance, for a max heap of the nearest points.
+ */
+static bool closer(const KdNeighbour &a, const KdNeighbour &b)
+{
+  return a.distanceSquared < b.distanceSquared;
+}
+
+/**
+ * Construct an empty tree.
+ *
+ * @param numThreads Maximum number of threads used by build() and batched
+ *                   queries, zero to use one per core
+ */
+KdTree::KdTree(const unsigned int numThreads)
+{
+  for (int a = 0; a < 3; a++)
+  {
+    m_lo[a] = 0.0;
+    m_hi[a] = 0.0;
+  }
+  setNumThreads(numThreads);
+}
+
+/**
+ * Destructor
+ */
+KdTree::~KdTree()
+{
+}
+
+/**
+ * Sets the maximum number of threads used by build() and batched queries.
+ *
+ * @param numThreads Maximum number of threads, zero to use one per core
+ */
+void KdTree::setNumThreads(const unsigned int numThreads)
+{
+  m_numThreads = resolveNumThreads(numThreads);
+}
+
+/**
+ * Returns the maximum number of threads used by build() and batched queries.
+ *
+ * @return Number of threads
+ */
+unsigned int KdTree::getNumThreads() const
+{
+  return m_numThreads;
+}
+
+/**
+ * Builds the tree over a set of points, replacing any previous points.
+ *
+ * @param points Pointer to first point
+ * @param count Number of points
+ */
+void KdTree::build(const Vector3DStack *points, const size_t count)
+{
+  for (int a = 0; a < 3; a++)
+    m_points[a].resize(count);
+
+  for (size_t n = 0; n < count; n++)
+  {
+    m_points[0][n] = points[n].getX();
+    m_points[1][n] = points[n].getY();
+    m_points[2][n] = points[n].getZ();
+  }
+
+  buildTree(count);
+}
+
+/**
+ * Builds the tree over a set of points, replacing any previous points.
+ *
+ * @param points Points
+ */
+void KdTree::build(const Vector3DArray &points)
+{
+  const size_t count = points.size();
+  m_points[0].assign(points.x(), points.x() + count);
+  m_points[1].assign(points.y(), points.y() + count);
+  m_points[2].assign(points.z(), points.z() + count);
+
+  buildTree(count);
+}
+
+/**
+ * Returns the number of points in the tree.
+ *
+ * @return Number of points
+ */
+size_t KdTree::size() const
+{
+  return m_indices.size();
+}
+
+/**
+ * Finds the nearest points to a point.
+ *
+ * @param point Query point
+ * @param k Number of points to find
+ * @param result Filled with the min(k, size()) nearest points, nearest first
+ */
+void KdTree::nearest(const Vector3DStack &point, const size_t k,
+                     std::vector<KdNeighbour> &result) const
+{
+  result.clear();
+  if (k == 0 || m_nodes.empty())
+    return;
+
+  const double p[] = {point.getX(), point.getY(), point.getZ()};
+  double offsets[] = {0.0, 0.0, 0.0};
+  result.reserve(std::min(k, size()));
+  nearestNode(0, p, k, result, offsets, 0.0);
+  std::sort_heap(result.begin(), result.end(), closer);
+}
+
+/**
+ * Finds all points within a distance of a point.
+ *
+ * @param point Query point
+ * @param radius Distance, points at exactly this distance are included
+ * @param result Filled with the points found, in no particular order
+ */
+void KdTree::radiusSearch(const Vector3DStack &point, const double radius,
+                          std::vector<KdNeighbour> &result) const
+{
+  result.clear();
+  if (m_nodes.empty() || radius < 0.0)
+    return;
+
+  const double p[] = {point.getX(), point.getY(), point.getZ()};
+  radiusNode(0, p, radius * radius, result);
+}
+
+/**
+ * Finds the nearest points to each of a set of points.
+ *
+ * @param points Pointer to first query point
+ * @param count Number of query points
+ * @param k Number of points to find for each query point
+ * @param result Filled with min(k, size()) points per query point, for each
+ *               query point in turn, nearest first
+ */
+void KdTree::nearest(const Vector3DStack *points, const size_t count,
+                     const size_t k, std::vector<KdNeighbour> &result) const
+{
+  const size_t found = std::min(k, size());
+  result.resize(count * found);
+  if (found == 0)
+    return;
+
+  std::vector<size_t> order;
+  queryOrder(points, count, order);
+
+  parallelFor(0, count, MIN_THREAD_QUERIES, 1, m_numThreads,
+              [&](size_t, size_t begin, size_t end) {
+                nearestRange(points, &order[0], begin, end, k, result);
+              });
+}
+
+/**
+ * Finds all points within a distance of each of a set of points.
+ *
+ * @param points Pointer to first query point
+ * @param count Number of query points
+ * @param radius Distance, points at exactly this distance are included
+ * @param offsets Filled with count + 1 values, the points found for query
+ *                point n are result[offsets[n]] to result[offsets[n + 1] - 1]
+ * @param result Filled with the points found, for each query point in turn
+ *               and in no particular order within one query point
+ */
+void KdTree::radiusSearch(const Vector3DStack *points, const size_t count,
+                          const double radius, std::vector<size_t> &offsets,
+                          std::vector<KdNeighbour> &result) const
+{
+  offsets.assign(count + 1, 0);
+  result.clear();
+  if (count == 0 || m_nodes.empty() || radius < 0.0)
+    return;
+
+  std::vector<size_t> order;
+  queryOrder(points, count, order);
+
+  /* Each chunk of queries collects its own results, in query order, with
+   * the number found for each query point in offsets */
+  const size_t numChunks =
+      parallelChunks(count, MIN_THREAD_QUERIES, 1, m_numThreads);
+  std::vector<std::vector<KdNeighbour> > chunkResults(numChunks);
+  std::vector<size_t> chunkBegin(numChunks + 1, count);
+
+  parallelFor(0, count, MIN_THREAD_QUERIES, 1, m_numThreads,
+              [&](size_t c, size_t begin, size_t end) {
+                chunkBegin[c] = begin;
+                radiusRange(points, &order[0], begin, end, radius,
+                            &offsets[0], chunkResults[c]);
+              });
+
+  /* Counts to offsets */
+  size_t total = 0;
+  for (size_t q = 0; q < count; q++)
+  {
+    const size_t found = offsets[q];
+    offsets[q] = total;
+    total += found;
+  }
+  offsets[count] = total;
+
+  result.resize(total);
+  for (size_t c = 0; c < numChunks; c++)
+  {
+    const std::vector<KdNeighbour> &found = chunkResults[c];
+    size_t from = 0;
+    for (size_t i = chunkBegin[c]; i < chunkBegin[c + 1]; i++)
+    {
+      const size_t q = order[i];
+      const size_t n = offsets[q + 1] - offsets[q];
+      std::copy(found.begin() + from, found.begin() + from + n,
+                result.begin() + offsets[q]);
+      from += n;
+    }
+  }
+}
+
+/**
+ * Builds the tree over the points in m_points, then puts them in tree order.
+ *
+ * @param count Number of points
+ */
+void KdTree::buildTree(const size_t count)
+{
+  if (count > std::numeric_limits<uint32_t>::max())
+    throw std::runtime_error("Too many points for KdTree");
+
+  m_nodes.clear();
+  m_indices.resize(count);
+
+  /* Points are partitioned as whole records, rather than through an index
+   * array, so the partitioning reads memory in order */
+  m_build.resize(count);
+  for (size_t n = 0; n < count; n++)
+  {
+    m_build[n].coords[0] = m_points[0][n];
+    m_build[n].coords[1] = m_points[1][n];
+    m_build[n].coords[2] = m_points[2][n];
+    m_build[n].index = n;
+  }
+
+  if (count > 0)
+  {
+    m_nodes.resize(subtreeNodes(count));
+
+    buildNode(0, 0, count,
+              parallelThreads(count, MIN_THREAD_BUILD_POINTS, m_numThreads));
+  }
+
+  for (int a = 0; a < 3; a++)
+  {
+    m_lo[a] = 0.0;
+    m_hi[a] = 0.0;
+  }
+  if (count > 0)
+  {
+    for (int a = 0; a < 3; a++)
+    {
+      m_lo[a] = *std::min_element(m_points[a].begin(), m_points[a].end());
+      m_hi[a] = *std::max_element(m_points[a].begin(), m_points[a].end());
+    }
+  }
+
+  for (size_t n = 0; n < count; n++)
+  {
+    m_points[0][n] = m_build[n].coords[0];
+    m_points[1][n] = m_build[n].coords[1];
+    m_points[2][n] = m_build[n].coords[2];
+    m_indices[n] = m_build[n].index;
+  }
+
+  std::vector<BuildPoint>().swap(m_build);
+}
+
+/**
+ * Builds a subtree.
+ *
+ * @param node Index of the subtree root in m_nodes
+ * @param begin First point of the subtree in m_build
+ * @param end One past the last point of the subtree
+ * @param threads Number of threads to build the subtree with
+ */
+void KdTree::buildNode(const size_t node, const size_t begin,
+                       const size_t end, const unsigned int threads)
+{
+  Node &n = m_nodes[node];
+  n.begin = (uint32_t)begin;
+  n.end = (uint32_t)end;
+  n.axis = -1;
+  n.split = 0.0;
+  n.right = 0;
+
+  if (end - begin <= LEAF_SIZE)
+    return;
+
+  /* Split along the axis the points are most spread out on */
+  double lo[3];
+  double hi[3];
+  for (int a = 0; a < 3; a++)
+    lo[a] = hi[a] = m_build[begin].coords[a];
+
+  for (size_t i = begin + 1; i < end; i++)
+  {
+    for (int a = 0; a < 3; a++)
+    {
+      lo[a] = std::min(lo[a], m_build[i].coords[a]);
+      hi[a] = std::max(hi[a], m_build[i].coords[a]);
+    }
+  }
+
+  int axis = 0;
+  if (hi[1] - lo[1] > hi[axis] - lo[axis])
+    axis = 1;
+  if (hi[2] - lo[2] > hi[axis] - lo[axis])
+    axis = 2;
+
+  const size_t mid = begin + (end - begin) / 2;
+  std::nth_element(m_build.begin() + begin, m_build.begin() + mid,
+                   m_build.begin() + end,
+                   [axis](const BuildPoint &a, const BuildPoint &b) {
+                     return a.coords[axis] < b.coords[axis];
+                   });
+
+  n.axis = axis;
+  n.split = m_build[mid].coords[axis];
+  n.right = (uint32_t)(node + 1 + subtreeNodes(mid - begin));
+
+  const size_t right = n.right;
+  if (threads > 1)
+  {
+    std::thread left(&KdTree::buildNode, this, node + 1, begin, mid,
+                     threads / 2);
+    buildNode(right, mid, end, threads - threads / 2);
+    left.join();
+  }
+  else
+  {
+    buildNode(node + 1, begin, mid, 1);
+    buildNode(right, mid, end, 1);
+  }
+}
+
+/**
+ * Searches a subtree for nearer points than those found so far.
+ *
+ * @param node Index of subtree root
+ * @param p Query point, 3 values
+ * @param k Number of points to find
+ * @param heap Max heap of the nearest points found so far
+ * @param offsets Distance along each axis from the query point to the region
+ *                of the subtree, 3 values, restored before returning
+ * @param regionSquared Squared distance from the query point to the region
+ *                      of the subtree
+ */
+void KdTree::nearestNode(const size_t node, const double *p, const size_t k,
+                         std::vector<KdNeighbour> &heap, double *offsets,
+                         const double regionSquared) const
+{
+  const Node &n = m_nodes[node];
+
+  if (n.axis < 0)
+  {
+    const double *x = &m_points[0][0];
+    const double *y = &m_points[1][0];
+    const double *z = &m_points[2][0];
+
+    for (size_t i = n.begin; i < n.end; i++)
+    {
+      const double dx = x[i] - p[0];
+      const double dy = y[i] - p[1];
+      const double dz = z[i] - p[2];
+      const double d = dx * dx + dy * dy + dz * dz;
+
+      if (heap.size() < k)
+      {
+        const KdNeighbour found = {m_indices[i], d};
+        heap.push_back(found);
+        std::push_heap(heap.begin(), heap.end(), closer);
+      }
+      else if (d < heap.front().distanceSquared)
+      {
+        std::pop_heap(heap.begin(), heap.end(), closer);
+        heap.back().index = m_indices[i];
+        heap.back().distanceSquared = d;
+        std::push_heap(heap.begin(), heap.end(), closer);
+      }
+    }
+    return;
+  }
+
+  const int axis = n.axis;
+  const double diff = p[axis] - n.split;
+  const size_t nearChild = diff < 0.0 ? node + 1 : n.right;
+  const size_t farChild = diff < 0.0 ? n.right : node + 1;
+
+  nearestNode(nearChild, p, k, heap, offsets, regionSquared);
+
+  /* The far side is at least diff away on this axis, in addition to the
+   * distance already known on the other axes */
+  const double oldOffset = offsets[axis];
+  const double farSquared =
+      regionSquared - oldOffset * oldOffset + diff * diff;
+
+  if (heap.size() < k || farSquared < heap.front().distanceSquared)
+  {
+    offsets[axis] = diff;
+    nearestNode(farChild, p, k, heap, offsets, farSquared);
+    offsets[axis] = oldOffset;
+  }
+}
+
+/**
+ * Collects the points of a subtree within a distance of a point.
+ *
+ * @param node Index of subtree root
+ * @param p Query point, 3 values
+ * @param radiusSquared Squared distance
+ * @param result Points found are added to this
+ */
+void KdTree::radiusNode(const size_t node, const double *p,
+                        const double radiusSquared,
+                        std::vector<KdNeighbour> &result) const
+{
+  const Node &n = m_nodes[node];
+
+  if (n.axis < 0)
+  {
+    const double *x = &m_points[0][0];
+    const double *y = &m_points[1][0];
+    const double *z = &m_points[2][0];
+
+    for (size_t i = n.begin; i < n.end; i++)
+    {
+      const double dx = x[i] - p[0];
+      const double dy = y[i] - p[1];
+      const double dz = z[i] - p[2];
+      const double d = dx * dx + dy * dy + dz * dz;
+      if (d <= radiusSquared)
+      {
+        const KdNeighbour found = {m_indices[i], d};
+        result.push_back(found);
+      }
+    }
+    return;
+  }
+
+  const double diff = p[n.axis] - n.split;
+
+  if (diff <= 0.0 || diff * diff <= radiusSquared)
+    radiusNode(node + 1, p, radiusSquared, result);
+  if (diff >= 0.0 || diff * diff <= radiusSquared)
+    radiusNode(n.right, p, radiusSquared, result);
+}
+
+/**
+ * Finds the nearest points to a range of query points.
+ *
+ * @param points Pointer to first query point of the batch
+ * @param order Order to process query points in
+ * @param begin First entry of order to process
+ * @param end One past the last entry of order to process
+ * @param k Number of points to find for each query point
+ * @param result Results of the whole batch, min(k, size()) per query point
+ */
+void KdTree::nearestRange(const Vector3DStack *points, const size_t *order,
+                          const size_t begin, const size_t end,
+                          const size_t k,
+                          std::vector<KdNeighbour> &result) const
+{
+  const size_t found = std::min(k, size());
+  std::vector<KdNeighbour> heap;
+  heap.reserve(found);
+
+  for (size_t i = begin; i < end; i++)
+  {
+    const size_t q = order[i];
+    const double p[] = {points[q].getX(), points[q].getY(), points[q].getZ()};
+    double offsets[] = {0.0, 0.0, 0.0};
+    heap.clear();
+    nearestNode(0, p, k, heap, offsets, 0.0);
+    std::sort_heap(heap.begin(), heap.end(), closer);
+    std::copy(heap.begin(), heap.end(), result.begin() + q * found);
+  }
+}
+
+/**
+ * Finds all points within a distance of a range of query points.
+ *
+ * @param points Pointer to first query point of the batch
+ * @param order Order to process query points in
+ * @param begin First entry of order to process
+ * @param end One past the last entry of order to process
+ * @param radius Distance
+ * @param counts Number of points found for each query point of the batch,
+ *               set for the query points of the range
+ * @param result Filled with the points found, in processing order
+ */
+void KdTree::radiusRange(const Vector3DStack *points, const size_t *order,
+                         const size_t begin, const size_t end,
+                         const double radius, size_t *counts,
+                         std::vector<KdNeighbour> &result) const
+{
+  result.clear();
+
+  for (size_t i = begin; i < end; i++)
+  {
+    const size_t q = order[i];
+    const double p[] = {points[q].getX(), points[q].getY(), points[q].getZ()};
+    const size_t before = result.size();
+    radiusNode(0, p, radius * radius, result);
+    counts[q] = result.size() - before;
+  }
+}
+
+/**
+ * Orders query points so that points close together are processed one after
+ * another, and so mostly visit nodes and points already in cache.
+ *
+ * Points are sorted along a Z-order (Morton) curve through the bounds of the
+ * tree.
+ *
+ * @param points Pointer to first query point
+ * @param count Number of query points
+ * @param order Filled with query point indices in processing order
+ */
+void KdTree::queryOrder(const Vector3DStack *points, const size_t count,
+                        std::vector<size_t> &order) const
+{
+  std::vector<std::pair<uint32_t, size_t> > codes(count);
+
+  for (size_t q = 0; q < count; q++)
+  {
+    const double p[] = {points[q].getX(), points[q].getY(), points[q].getZ()};
+    uint32_t code = 0;
+    for (int a = 0; a < 3; a++)
+    {
+      const double extent = m_hi[a] - m_lo[a];
+      double cell = extent > 0.0
+                        ? (p[a] - m_lo[a]) / extent * MORTON_CELLS
+                        : 0.0;
+      cell = std::min(std::max(cell, 0.0), MORTON_CELLS - 1.0);
+
+      /* Spread the bits of the cell to every third bit */
+      uint32_t v = (uint32_t)cell;
+      v = (v | (v << 16)) & 0x030000FF;
+      v = (v | (v << 8)) & 0x0300F00F;
+      v = (v | (v << 4)) & 0x030C30C3;
+      v = (v | (v << 2)) & 0x09249249;
+      code |= v << a;
+    }
+    codes[q] = std::make_pair(code, q);
+  }
+
+  std::sort(codes.begin(), codes.end());
+
+  order.resize(count);
+  for (size_t q = 0; q < count; q++)
+    order[q] = codes[q].second;
+}
+
+/**
+ * Returns the number of nodes in a subtree over a number of points.
+ *
+ * @param count Number of points
+ * @return Number of nodes
+ */
+size_t KdTree::subtreeNodes(const size_t count)
+{
+  if (count <= LEAF_SIZE)
+    return 1;
+
+  const size_t left = count / 2;
+  return 1 + subtreeNodes(left) + subtreeNodes(count - left);
+}
@@ -0,0 +1,259 @@
+#include "KeyframeSampler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+#include "Quaternion.h"
+#include "Simd.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Optimisation notes
+ *
+ * Sampling is split into two passes over blocks of BLOCK_SIZE tracks. The
+ * first moves each track's cursor and gathers the two keys either side of the
+ * sample time and the interpolation parameter into SoA scratch arrays. The
+ * second interpolates the whole block, so the NLERP kernel can work on two
+ * tracks per SSE2 register. Blocks are small enough that the scratch arrays
+ * stay in L1 cache between the passes.
+ *
+ * SLERP needs acos and sin per track, which SSE2 does not provide, so it is
+ * done a track at a time from the scratch arrays (still avoiding the cursor
+ * branches in the same loop).
+ *
+ * The scalar/SIMD choice follows useSimdKernels().
+ */
+
+const size_t KeyframeSampler::BLOCK_SIZE;
+
+/**
+ * Construct a sampler for an array of tracks.
+ *
+ * The tracks are not copied and must outlive the sampler; each must have at
+ * least one key.
+ *
+ * @param tracks Pointer to first track
+ * @param count Number of tracks
+ */
+KeyframeSampler::KeyframeSampler(const KeyframeTrack *tracks,
+                                 const size_t count)
+    : m_tracks(tracks)
+    , m_count(count)
+    , m_cursors(count, 0)
+{
+  for (size_t n = 0; n < count; n++)
+  {
+    if (tracks[n].size() == 0)
+      throw std::runtime_error("KeyframeTrack has no keys");
+  }
+}
+
+/**
+ * Destructor
+ */
+KeyframeSampler::~KeyframeSampler()
+{
+}
+
+/**
+ * Returns the number of tracks sampled.
+ *
+ * @return Number of tracks
+ */
+size_t KeyframeSampler::size() const
+{
+  return m_count;
+}
+
+/**
+ * Moves all cursors back to the start of their tracks.
+ *
+ * Not required for correctness, but avoids stepping back through every key
+ * when playback restarts.
+ */
+void KeyframeSampler::reset()
+{
+  for (size_t n = 0; n < m_count; n++)
+    m_cursors[n] = 0;
+}
+
+/**
+ * Samples every track at a given time.
+ *
+ * @param time Time to sample at
+ * @param out Array of size() quaternions to store orientations in
+ * @param interp Interpolation to use between keys
+ */
+void KeyframeSampler::sample(const double time, Quaternion *out,
+                             const Interpolation interp)
+{
+  for (size_t begin = 0; begin < m_count; begin += BLOCK_SIZE)
+  {
+    const size_t count = std::min(BLOCK_SIZE, m_count - begin);
+    gather(time, begin, count);
+
+    if (interp == INTERP_NLERP)
+      nlerp(count, out + begin);
+    else
+      slerp(count, out + begin);
+  }
+}
+
+/**
+ * Advances the cursors and fills the scratch arrays for a block of tracks.
+ *
+ * @param time Time to sample at
+ * @param begin Index of the first track in the block
+ * @param count Number of tracks in the block
+ */
+void KeyframeSampler::gather(const double time, const size_t begin,
+                             const size_t count)
+{
+  for (size_t n = 0; n < count; n++)
+  {
+    const KeyframeTrack &track = m_tracks[begin + n];
+    const double *keys = track.keyData();
+
+    if (track.size() == 1)
+    {
+      storeKeys(n, keys, keys, 0.0);
+      continue;
+    }
+
+    /* Only seek when the time has left the segment of the last sample */
+    const double *times = track.keyTimes();
+    size_t cursor = m_cursors[begin + n];
+    if (!(time >= times[cursor] && time < times[cursor + 1]))
+    {
+      cursor = track.seek(time, cursor);
+      m_cursors[begin + n] = cursor;
+    }
+
+    const double t =
+        (time - times[cursor]) / (times[cursor + 1] - times[cursor]);
+    storeKeys(n, keys + cursor * 4, keys + cursor * 4 + 4,
+              t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t));
+  }
+}
+
+/**
+ * Stores the keys and interpolation parameter of one track in the scratch
+ * arrays.
+ *
+ * @param n Index of the track in the block
+ * @param a Values of the key at the start of the segment
+ * @param b Values of the key at the end of the segment
+ * @param t Interpolation parameter
+ */
+void KeyframeSampler::storeKeys(const size_t n, const double *a,
+                                const double *b, const double t)
+{
+  for (int c = 0; c < 4; c++)
+  {
+    m_a[c][n] = a[c];
+    m_b[c][n] = b[c];
+  }
+  m_t[n] = t;
+}
+
+/**
+ * Interpolates the gathered keys using normalised linear interpolation.
+ *
+ * @param count Number of tracks in the block
+ * @param out Array to store orientations of the block in
+ */
+void KeyframeSampler::nlerp(const size_t count, Quaternion *out) const
+{
+  const double *aw = m_a[0], *ai = m_a[1], *aj = m_a[2], *ak = m_a[3];
+  const double *bw = m_b[0], *bi = m_b[1], *bj = m_b[2], *bk = m_b[3];
+  const double *pt = m_t;
+
+  size_t n = 0;
+#ifdef __SSE2__
+  if (useSimdKernels())
+  {
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d eps = _mm_set1_pd(DBL_EPSILON * DBL_EPSILON);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+
+    for (; n + 2 <= count; n += 2)
+    {
+      const __m128d a0 = _mm_loadu_pd(aw + n);
+      const __m128d a1 = _mm_loadu_pd(ai + n);
+      const __m128d a2 = _mm_loadu_pd(aj + n);
+      const __m128d a3 = _mm_loadu_pd(ak + n);
+      const __m128d b0 = _mm_loadu_pd(bw + n);
+      const __m128d b1 = _mm_loadu_pd(bi + n);
+      const __m128d b2 = _mm_loadu_pd(bj + n);
+      const __m128d b3 = _mm_loadu_pd(bk + n);
+      const __m128d t = _mm_loadu_pd(pt + n);
+
+      __m128d d = _mm_mul_pd(a0, b0);
+      d = _mm_add_pd(d, _mm_mul_pd(a1, b1));
+      d = _mm_add_pd(d, _mm_mul_pd(a2, b2));
+      d = _mm_add_pd(d, _mm_mul_pd(a3, b3));
+
+      /* Negate t for b where the keys are in opposite hemispheres */
+      const __m128d sb =
+          _mm_xor_pd(t, _mm_and_pd(_mm_cmplt_pd(d, zero), signBit));
+      const __m128d sa = _mm_sub_pd(one, t);
+
+      __m128d q0 = _mm_add_pd(_mm_mul_pd(sa, a0), _mm_mul_pd(sb, b0));
+      __m128d q1 = _mm_add_pd(_mm_mul_pd(sa, a1), _mm_mul_pd(sb, b1));
+      __m128d q2 = _mm_add_pd(_mm_mul_pd(sa, a2), _mm_mul_pd(sb, b2));
+      __m128d q3 = _mm_add_pd(_mm_mul_pd(sa, a3), _mm_mul_pd(sb, b3));
+
+      __m128d m = _mm_mul_pd(q0, q0);
+      m = _mm_add_pd(m, _mm_mul_pd(q1, q1));
+      m = _mm_add_pd(m, _mm_mul_pd(q2, q2));
+      m = _mm_add_pd(m, _mm_mul_pd(q3, q3));
+
+      /* Fall back to a where the result has no length */
+      const __m128d valid = _mm_cmpge_pd(m, eps);
+      const __m128d s = _mm_div_pd(one, _mm_sqrt_pd(m));
+      q0 = _mm_or_pd(_mm_and_pd(valid, _mm_mul_pd(q0, s)),
+                     _mm_andnot_pd(valid, a0));
+      q1 = _mm_or_pd(_mm_and_pd(valid, _mm_mul_pd(q1, s)),
+                     _mm_andnot_pd(valid, a1));
+      q2 = _mm_or_pd(_mm_and_pd(valid, _mm_mul_pd(q2, s)),
+                     _mm_andnot_pd(valid, a2));
+      q3 = _mm_or_pd(_mm_and_pd(valid, _mm_mul_pd(q3, s)),
+                     _mm_andnot_pd(valid, a3));
+
+      double r[4][2];
+      _mm_storeu_pd(r[0], q0);
+      _mm_storeu_pd(r[1], q1);
+      _mm_storeu_pd(r[2], q2);
+      _mm_storeu_pd(r[3], q3);
+      out[n] = Quaternion(r[0][0], r[1][0], r[2][0], r[3][0]);
+      out[n + 1] = Quaternion(r[0][1], r[1][1], r[2][1], r[3][1]);
+    }
+  }
+#endif
+  for (; n < count; n++)
+  {
+    out[n] = Quaternion::nlerp(Quaternion(aw[n], ai[n], aj[n], ak[n]),
+                               Quaternion(bw[n], bi[n], bj[n], bk[n]), pt[n]);
+  }
+}
+
+/**
+ * Interpolates the gathered keys using spherical linear interpolation.
+ *
+ * @param count Number of tracks in the block
+ * @param out Array to store orientations of the block in
+ */
+void KeyframeSampler::slerp(const size_t count, Quaternion *out) const
+{
+  for (size_t n = 0; n < count; n++)
+  {
+    out[n] = Quaternion::slerp(
+        Quaternion(m_a[0][n], m_a[1][n], m_a[2][n], m_a[3][n]),
+        Quaternion(m_b[0][n], m_b[1][n], m_b[2][n], m_b[3][n]), m_t[n]);
+  }
+}
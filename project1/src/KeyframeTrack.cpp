@@ -0,0 +1,216 @@
+#include "KeyframeTrack.h"
+
+#include <stdexcept>
+
+/*
+ * Optimisation notes
+ *
+ * Playback samples a track at times that usually move forward by a small
+ * amount each frame, so rather than binary searching the key times on every
+ * sample a cursor (the index of the key starting the current segment) is
+ * kept by the caller and stepped forwards or backwards from where it was
+ * last. This is O(1) for normal playback and still correct for seeking.
+ */
+
+/**
+ * Construct an empty track.
+ */
+KeyframeTrack::KeyframeTrack()
+{
+}
+
+/**
+ * Destructor
+ */
+KeyframeTrack::~KeyframeTrack()
+{
+}
+
+/**
+ * Adds a key to the end of the track.
+ *
+ * The key is stored normalised.
+ *
+ * @param time Time of the key, must be after the last key
+ * @param key Orientation at this time
+ */
+void KeyframeTrack::addKey(const double time, const Quaternion &key)
+{
+  if (!m_times.empty() && time <= m_times.back())
+    throw std::runtime_error("Keyframe times must be increasing");
+
+  const Quaternion q = key.isUnit() ? key : key.getUnitQuaternion();
+  m_keys.push_back(q.getReal());
+  m_keys.push_back(q.getI());
+  m_keys.push_back(q.getJ());
+  m_keys.push_back(q.getK());
+  m_times.push_back(time);
+}
+
+/**
+ * Removes all keys.
+ */
+void KeyframeTrack::clear()
+{
+  m_times.clear();
+  m_keys.clear();
+}
+
+/**
+ * Returns the number of keys in the track.
+ *
+ * @return Number of keys
+ */
+size_t KeyframeTrack::size() const
+{
+  return m_times.size();
+}
+
+/**
+ * Returns the time of a key.
+ *
+ * @param index Index of the key
+ * @return Key time
+ */
+double KeyframeTrack::keyTime(const size_t index) const
+{
+  if (index >= m_times.size())
+    throw std::runtime_error("KeyframeTrack index out of range");
+
+  return m_times[index];
+}
+
+/**
+ * Returns a key.
+ *
+ * @param index Index of the key
+ * @return Key orientation
+ */
+Quaternion KeyframeTrack::key(const size_t index) const
+{
+  if (index >= m_times.size())
+    throw std::runtime_error("KeyframeTrack index out of range");
+
+  const double *k = &m_keys[index * 4];
+  return Quaternion(k[0], k[1], k[2], k[3]);
+}
+
+/**
+ * Returns the times of all keys.
+ *
+ * @return Pointer to size() key times
+ */
+const double *KeyframeTrack::keyTimes() const
+{
+  return m_times.data();
+}
+
+/**
+ * Returns the values of all keys.
+ *
+ * @return Pointer to the w, i, j and k values of each of the size() keys in
+ *         turn
+ */
+const double *KeyframeTrack::keyData() const
+{
+  return m_keys.data();
+}
+
+/**
+ * Returns the time of the first key.
+ *
+ * @return Start time
+ */
+double KeyframeTrack::startTime() const
+{
+  return keyTime(0);
+}
+
+/**
+ * Returns the time of the last key.
+ *
+ * @return End time
+ */
+double KeyframeTrack::endTime() const
+{
+  return keyTime(m_times.size() - 1);
+}
+
+/**
+ * Moves a cursor to the segment containing a given time.
+ *
+ * Times before the first key give the first segment and times after the last
+ * key give the last segment.
+ *
+ * @param time Time to seek to
+ * @param cursor Cursor from the previous sample, or zero
+ * @return Index of the key starting the segment containing time
+ */
+size_t KeyframeTrack::seek(const double time, size_t cursor) const
+{
+  const size_t n = m_times.size();
+  if (n < 2)
+    return 0;
+
+  if (cursor > n - 2)
+    cursor = n - 2;
+
+  while (cursor < n - 2 && time >= m_times[cursor + 1])
+    cursor++;
+  while (cursor > 0 && time < m_times[cursor])
+    cursor--;
+
+  return cursor;
+}
+
+/**
+ * Calculates the interpolation parameter of a time within a segment.
+ *
+ * @param time Time to sample at
+ * @param cursor Segment index given by seek()
+ * @return Interpolation parameter, clamped to [0, 1]
+ */
+double KeyframeTrack::segmentParameter(const double time,
+                                       const size_t cursor) const
+{
+  if (m_times.size() < 2)
+    return 0.0;
+
+  const double t0 = m_times[cursor];
+  const double t1 = m_times[cursor + 1];
+  const double t = (time - t0) / (t1 - t0);
+
+  if (t < 0.0)
+    return 0.0;
+  if (t > 1.0)
+    return 1.0;
+  return t;
+}
+
+/**
+ * Samples the orientation of the track at a given time.
+ *
+ * @param time Time to sample at, clamped to the track
+ * @param cursor Cursor from the previous sample (or zero), updated to the
+ *               segment containing time
+ * @param interp Interpolation to use between keys
+ * @return Orientation at time
+ */
+Quaternion KeyframeTrack::sample(const double time, size_t &cursor,
+                                 const Interpolation interp) const
+{
+  if (m_times.empty())
+    throw std::runtime_error("KeyframeTrack has no keys");
+
+  cursor = seek(time, cursor);
+  if (m_times.size() == 1)
+    return key(0);
+
+  const double t = segmentParameter(time, cursor);
+  const Quaternion a = key(cursor);
+  const Quaternion b = key(cursor + 1);
+
+  if (interp == INTERP_NLERP)
+    return Quaternion::nlerp(a, b, t);
+  return Quaternion::slerp(a, b, t);
+}
@@ -0,0 +1,307 @@
+#include "OrientedBox.h"
+
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+#include "RotationMatrix.h"
+
+/*
+ * Optimisation notes
+ *
+ * The world space axes of the box are worked out from the orientation once,
+ * when it is set, and kept alongside it. The separating axis test then needs
+ * only dot products of cached axes rather than rotating vectors by
+ * quaternions for every pair.
+ *
+ * The test follows the usual form for two boxes: the relative rotation and
+ * offset are expressed in the frame of the first box, after which each of
+ * the 15 candidate axes (3 face normals of each box and 9 edge cross
+ * products) is a few multiplies. A small epsilon is added to the absolute
+ * rotation terms so that nearly parallel edges, whose cross product is close
+ * to zero, cannot report a false separation.
+ */
+
+/* Added to the absolute rotation terms of the separating axis test */
+const double OrientedBox::PARALLEL_EPSILON = 1e-9;
+
+/**
+ * Construct a box of zero size at the origin, aligned with the world axes.
+ */
+OrientedBox::OrientedBox()
+{
+  updateAxes();
+}
+
+/**
+ * Construct a box.
+ *
+ * @param centre Centre
+ * @param halfExtents Half of the size of the box along each of its axes
+ * @param orientation Rotation from the world axes to the box axes,
+ *                    normalised if not of unit length
+ */
+OrientedBox::OrientedBox(const Vector3DStack &centre,
+                         const Vector3DStack &halfExtents,
+                         const Quaternion &orientation)
+    : m_centre(centre)
+{
+  setHalfExtents(halfExtents);
+  setOrientation(orientation);
+}
+
+/**
+ * Construct a box taking values from another.
+ *
+ * @param other Box to copy
+ */
+OrientedBox::OrientedBox(const OrientedBox &other)
+{
+  operator=(other);
+}
+
+/**
+ * Destructor
+ */
+OrientedBox::~OrientedBox()
+{
+}
+
+/**
+ * Set the values of this box to the values of another.
+ *
+ * @param other Box to copy
+ */
+void OrientedBox::operator=(const OrientedBox &other)
+{
+  m_centre = other.m_centre;
+  m_halfExtents = other.m_halfExtents;
+  m_orientation = other.m_orientation;
+  for (int n = 0; n < 9; n++)
+    m_axes[n] = other.m_axes[n];
+}
+
+/**
+ * Returns the centre of the box.
+ *
+ * @return Centre
+ */
+Vector3DStack OrientedBox::getCentre() const
+{
+  return m_centre;
+}
+
+/**
+ * Moves the box.
+ *
+ * @param centre New centre
+ */
+void OrientedBox::setCentre(const Vector3DStack &centre)
+{
+  m_centre = centre;
+}
+
+/**
+ * Returns the half extents of the box along its own axes.
+ *
+ * @return Half extents
+ */
+Vector3DStack OrientedBox::getHalfExtents() const
+{
+  return m_halfExtents;
+}
+
+/**
+ * Sets the half extents of the box along its own axes.
+ *
+ * @param halfExtents Half extents
+ */
+void OrientedBox::setHalfExtents(const Vector3DStack &halfExtents)
+{
+  if (halfExtents.getX() < 0.0 || halfExtents.getY() < 0.0 ||
+      halfExtents.getZ() < 0.0)
+    throw std::runtime_error("Negative box half extent");
+
+  m_halfExtents = halfExtents;
+}
+
+/**
+ * Returns the orientation of the box.
+ *
+ * @return Orientation, of unit length
+ */
+Quaternion OrientedBox::getOrientation() const
+{
+  return m_orientation;
+}
+
+/**
+ * Rotates the box, updating its cached axes.
+ *
+ * @param orientation Rotation from the world axes to the box axes,
+ *                    normalised if not of unit length
+ */
+void OrientedBox::setOrientation(const Quaternion &orientation)
+{
+  if (orientation.magnitude() < DBL_EPSILON)
+    throw std::runtime_error("Zero quaternion orientation");
+
+  m_orientation =
+      orientation.isUnit() ? orientation : orientation.getUnitQuaternion();
+  updateAxes();
+}
+
+/**
+ * Returns one of the axes of the box in world space.
+ *
+ * @param axis 0, 1 or 2 for the local x, y or z axis
+ * @return Unit vector along the axis
+ */
+Vector3DStack OrientedBox::getAxis(const int axis) const
+{
+  if (axis < 0 || axis > 2)
+    throw std::runtime_error("Invalid box axis");
+
+  return Vector3DStack(m_axes[3 * axis], m_axes[3 * axis + 1],
+                       m_axes[3 * axis + 2]);
+}
+
+/**
+ * Returns the axes of the box in world space.
+ *
+ * @return Pointer to 9 values, the x, y and z components of each axis in
+ *         turn
+ */
+const double *OrientedBox::axes() const
+{
+  return m_axes;
+}
+
+/**
+ * Returns the half extents of the axis aligned box enclosing this box, e.g.
+ * to add it to a broad phase.
+ *
+ * @return Half extents along the world axes
+ */
+Vector3DStack OrientedBox::getBoundingHalfExtents() const
+{
+  const double h[] = {m_halfExtents.getX(), m_halfExtents.getY(),
+                      m_halfExtents.getZ()};
+  double bounds[] = {0.0, 0.0, 0.0};
+  for (int axis = 0; axis < 3; axis++)
+    for (int c = 0; c < 3; c++)
+      bounds[c] += h[axis] * std::fabs(m_axes[3 * axis + c]);
+
+  return Vector3DStack(bounds[0], bounds[1], bounds[2]);
+}
+
+/**
+ * Tests this box against another using the separating axis test.
+ *
+ * @param other Box to test against
+ * @return True if the boxes intersect, including touching
+ */
+bool OrientedBox::intersects(const OrientedBox &other) const
+{
+  const double centreA[] = {m_centre.getX(), m_centre.getY(),
+                            m_centre.getZ()};
+  const double halfA[] = {m_halfExtents.getX(), m_halfExtents.getY(),
+                          m_halfExtents.getZ()};
+  const double centreB[] = {other.m_centre.getX(), other.m_centre.getY(),
+                            other.m_centre.getZ()};
+  const double halfB[] = {other.m_halfExtents.getX(),
+                          other.m_halfExtents.getY(),
+                          other.m_halfExtents.getZ()};
+
+  return intersects(centreA, m_axes, halfA, centreB, other.m_axes, halfB);
+}
+
+/**
+ * Tests two boxes given by their cached axes using the separating axis test.
+ *
+ * @param centreA Centre of first box, 3 values
+ * @param axesA Axes of first box as returned by axes(), 9 values
+ * @param halfExtentsA Half extents of first box, 3 values
+ * @param centreB Centre of second box, 3 values
+ * @param axesB Axes of second box, 9 values
+ * @param halfExtentsB Half extents of second box, 3 values
+ * @return True if the boxes intersect, including touching
+ */
+bool OrientedBox::intersects(const double *centreA, const double *axesA,
+                             const double *halfExtentsA,
+                             const double *centreB, const double *axesB,
+                             const double *halfExtentsB)
+{
+  const double *a = halfExtentsA;
+  const double *b = halfExtentsB;
+
+  /* Rotation of B in the frame of A */
+  double r[3][3];
+  double absR[3][3];
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      r[i][j] = axesA[3 * i] * axesB[3 * j] +
+                axesA[3 * i + 1] * axesB[3 * j + 1] +
+                axesA[3 * i + 2] * axesB[3 * j + 2];
+      absR[i][j] = std::fabs(r[i][j]) + PARALLEL_EPSILON;
+    }
+  }
+
+  /* Offset of B from A in the frame of A */
+  const double d[] = {centreB[0] - centreA[0], centreB[1] - centreA[1],
+                      centreB[2] - centreA[2]};
+  double t[3];
+  for (int i = 0; i < 3; i++)
+    t[i] = d[0] * axesA[3 * i] + d[1] * axesA[3 * i + 1] +
+           d[2] * axesA[3 * i + 2];
+
+  /* Face normals of A */
+  for (int i = 0; i < 3; i++)
+  {
+    const double rb = b[0] * absR[i][0] + b[1] * absR[i][1] + b[2] * absR[i][2];
+    if (std::fabs(t[i]) > a[i] + rb)
+      return false;
+  }
+
+  /* Face normals of B */
+  for (int j = 0; j < 3; j++)
+  {
+    const double ra = a[0] * absR[0][j] + a[1] * absR[1][j] + a[2] * absR[2][j];
+    const double dist = t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j];
+    if (std::fabs(dist) > ra + b[j])
+      return false;
+  }
+
+  /* Cross products of an edge of A with an edge of B */
+  for (int i = 0; i < 3; i++)
+  {
+    const int i1 = (i + 1) % 3;
+    const int i2 = (i + 2) % 3;
+    for (int j = 0; j < 3; j++)
+    {
+      const int j1 = (j + 1) % 3;
+      const int j2 = (j + 2) % 3;
+      const double ra = a[i1] * absR[i2][j] + a[i2] * absR[i1][j];
+      const double rb = b[j1] * absR[i][j2] + b[j2] * absR[i][j1];
+      const double dist = t[i2] * r[i1][j] - t[i1] * r[i2][j];
+      if (std::fabs(dist) > ra + rb)
+        return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Works out the world space axes from the orientation.
+ */
+void OrientedBox::updateAxes()
+{
+  const RotationMatrix m(m_orientation);
+
+  /* Axis n is column n of the rotation matrix */
+  for (int axis = 0; axis < 3; axis++)
+    for (int c = 0; c < 3; c++)
+      m_axes[3 * axis + c] = m(c, axis);
+}
@@ -0,0 +1,413 @@
+#include "OrientedBoxSet.h"
+
+#include <cmath>
+#include <stdexcept>
+#include "OrientedBox.h"
+#include "Quaternion.h"
+#include "Vector3DStack.h"
+
+/*
+ * Optimisation notes
+ *
+ * Boxes are stored as a structure of arrays, like RigidBodySet, so that
+ * orientations written by an integrator can be converted to axes for the
+ * whole set in one pass by updateAxes(), once per tick. That loop has no
+ * branches and reads and writes each array in order, so the compiler can
+ * vectorise it. Every test after that uses the cached axes.
+ *
+ * updateAxes() also caches the radius of the sphere enclosing each box.
+ * Testing one box against many first rejects boxes whose enclosing spheres
+ * do not meet, which for a box among many scattered boxes is most of them,
+ * and only runs the full separating axis test on the rest.
+ */
+
+/**
+ * Construct an empty set of boxes.
+ */
+OrientedBoxSet::OrientedBoxSet()
+{
+}
+
+/**
+ * Destructor
+ */
+OrientedBoxSet::~OrientedBoxSet()
+{
+}
+
+/**
+ * Returns the number of boxes.
+ *
+ * @return Number of boxes
+ */
+size_t OrientedBoxSet::size() const
+{
+  return m_radii.size();
+}
+
+/**
+ * Removes all boxes.
+ */
+void OrientedBoxSet::clear()
+{
+  m_centres.resize(0);
+  m_halfExtents.resize(0);
+  m_boundingHalfExtents.resize(0);
+  for (int c = 0; c < 4; c++)
+    m_orientation[c].clear();
+  for (int n = 0; n < 9; n++)
+    m_axes[n].clear();
+  m_radii.clear();
+}
+
+/**
+ * Adds a box to the end of the set.
+ *
+ * @param box Box to add
+ * @return Index of the new box
+ */
+size_t OrientedBoxSet::addBox(const OrientedBox &box)
+{
+  const size_t index = size();
+  const size_t newSize = index + 1;
+
+  m_centres.resize(newSize);
+  m_halfExtents.resize(newSize);
+  m_boundingHalfExtents.resize(newSize);
+  for (int c = 0; c < 4; c++)
+    m_orientation[c].resize(newSize);
+  for (int n = 0; n < 9; n++)
+    m_axes[n].resize(newSize);
+  m_radii.resize(newSize);
+
+  setBox(index, box);
+  return index;
+}
+
+/**
+ * Returns a box.
+ *
+ * @param index Box index
+ * @return Copy of the box
+ */
+OrientedBox OrientedBoxSet::getBox(const size_t index) const
+{
+  checkIndex(index);
+  return OrientedBox(m_centres.get(index), m_halfExtents.get(index),
+                     Quaternion(m_orientation[0][index],
+                                m_orientation[1][index],
+                                m_orientation[2][index],
+                                m_orientation[3][index]));
+}
+
+/**
+ * Replaces a box, updating its cached axes.
+ *
+ * @param index Box index
+ * @param box New box
+ */
+void OrientedBoxSet::setBox(const size_t index, const OrientedBox &box)
+{
+  checkIndex(index);
+
+  m_centres.set(index, box.getCentre());
+  m_halfExtents.set(index, box.getHalfExtents());
+
+  const Quaternion q = box.getOrientation();
+  m_orientation[0][index] = q.getReal();
+  m_orientation[1][index] = q.getI();
+  m_orientation[2][index] = q.getJ();
+  m_orientation[3][index] = q.getK();
+
+  updateAxes(index, index + 1);
+}
+
+/**
+ * Returns the centres of all boxes, these may be updated in place to move
+ * boxes.
+ *
+ * @return Centres
+ */
+Vector3DArray &OrientedBoxSet::centres()
+{
+  return m_centres;
+}
+
+/**
+ * Returns the centres of all boxes.
+ *
+ * @return Centres
+ */
+const Vector3DArray &OrientedBoxSet::centres() const
+{
+  return m_centres;
+}
+
+/**
+ * Returns the half extents of all boxes along their own axes.
+ *
+ * @return Half extents
+ */
+const Vector3DArray &OrientedBoxSet::halfExtents() const
+{
+  return m_halfExtents;
+}
+
+/**
+ * Returns one component of the orientations of all boxes.
+ *
+ * Orientations may be updated in place, e.g. copied from a RigidBodySet each
+ * tick, but must be left of unit length and updateAxes() must be called
+ * before boxes are tested again.
+ *
+ * @param component 0, 1, 2 or 3 for the w, i, j or k component
+ * @return Pointer to the component of the first box
+ */
+double *OrientedBoxSet::orientation(const int component)
+{
+  if (component < 0 || component > 3)
+    throw std::runtime_error("Invalid quaternion component");
+
+  return m_orientation[component].empty() ? NULL
+                                          : &m_orientation[component][0];
+}
+
+/**
+ * Returns one component of the orientations of all boxes.
+ *
+ * @param component 0, 1, 2 or 3 for the w, i, j or k component
+ * @return Pointer to the component of the first box
+ */
+const double *OrientedBoxSet::orientation(const int component) const
+{
+  if (component < 0 || component > 3)
+    throw std::runtime_error("Invalid quaternion component");
+
+  return m_orientation[component].empty() ? NULL
+                                          : &m_orientation[component][0];
+}
+
+/**
+ * Works out the world space axes of every box from its orientation.
+ *
+ * Call once after orientations have been changed through orientation().
+ */
+void OrientedBoxSet::updateAxes()
+{
+  updateAxes(0, size());
+}
+
+/**
+ * Returns one component of one cached axis of all boxes.
+ *
+ * @param axis 0, 1 or 2 for the local x, y or z axis
+ * @param component 0, 1 or 2 for the world x, y or z component
+ * @return Pointer to the value for the first box
+ */
+const double *OrientedBoxSet::axis(const int axis, const int component) const
+{
+  if (axis < 0 || axis > 2 || component < 0 || component > 2)
+    throw std::runtime_error("Invalid box axis");
+
+  const std::vector<double> &values = m_axes[3 * axis + component];
+  return values.empty() ? NULL : &values[0];
+}
+
+/**
+ * Returns the half extents of the axis aligned boxes enclosing each box, as
+ * of the last updateAxes(), e.g. to add them to a broad phase.
+ *
+ * @return Bounding half extents
+ */
+const Vector3DArray &OrientedBoxSet::boundingHalfExtents() const
+{
+  return m_boundingHalfExtents;
+}
+
+/**
+ * Tests two boxes of the set for intersection.
+ *
+ * @param a Index of first box
+ * @param b Index of second box
+ * @return True if the boxes intersect, including touching
+ */
+bool OrientedBoxSet::intersects(const size_t a, const size_t b) const
+{
+  checkIndex(a);
+  checkIndex(b);
+
+  const double centre[] = {m_centres.x()[a], m_centres.y()[a],
+                           m_centres.z()[a]};
+  const double halfExtents[] = {m_halfExtents.x()[a], m_halfExtents.y()[a],
+                                m_halfExtents.z()[a]};
+  double axes[9];
+  for (int n = 0; n < 9; n++)
+    axes[n] = m_axes[n][a];
+
+  return intersectsBox(b, centre, axes, halfExtents, m_radii[a]);
+}
+
+/**
+ * Finds all boxes of the set that intersect a box.
+ *
+ * @param box Box to test
+ * @param hits Filled with the indices of intersecting boxes, in order
+ */
+void OrientedBoxSet::findIntersecting(const OrientedBox &box,
+                                      std::vector<size_t> &hits) const
+{
+  hits.clear();
+
+  const Vector3DStack c = box.getCentre();
+  const Vector3DStack h = box.getHalfExtents();
+  const double centre[] = {c.getX(), c.getY(), c.getZ()};
+  const double halfExtents[] = {h.getX(), h.getY(), h.getZ()};
+  const double radius = h.magnitude();
+
+  for (size_t n = 0; n < size(); n++)
+  {
+    if (intersectsBox(n, centre, box.axes(), halfExtents, radius))
+      hits.push_back(n);
+  }
+}
+
+/**
+ * Finds the boxes of a list of candidates, e.g. from a broad phase, that
+ * intersect a box.
+ *
+ * @param box Box to test
+ * @param candidates Indices of boxes to test
+ * @param count Number of candidates
+ * @param hits Filled with the indices of intersecting boxes, in candidate
+ *             order
+ */
+void OrientedBoxSet::findIntersecting(const OrientedBox &box,
+                                      const size_t *candidates,
+                                      const size_t count,
+                                      std::vector<size_t> &hits) const
+{
+  hits.clear();
+
+  const Vector3DStack c = box.getCentre();
+  const Vector3DStack h = box.getHalfExtents();
+  const double centre[] = {c.getX(), c.getY(), c.getZ()};
+  const double halfExtents[] = {h.getX(), h.getY(), h.getZ()};
+  const double radius = h.magnitude();
+
+  for (size_t n = 0; n < count; n++)
+  {
+    checkIndex(candidates[n]);
+    if (intersectsBox(candidates[n], centre, box.axes(), halfExtents, radius))
+      hits.push_back(candidates[n]);
+  }
+}
+
+/**
+ * Checks that a box index is in range.
+ *
+ * @param index Box index
+ */
+void OrientedBoxSet::checkIndex(const size_t index) const
+{
+  if (index >= size())
+    throw std::runtime_error("OrientedBoxSet index out of range");
+}
+
+/**
+ * Works out the world space axes, bounding half extents and bounding radius
+ * of a range of boxes.
+ *
+ * @param begin Index of first box
+ * @param end Index after last box
+ */
+void OrientedBoxSet::updateAxes(const size_t begin, const size_t end)
+{
+  const double *qw = orientation(0);
+  const double *qi = orientation(1);
+  const double *qj = orientation(2);
+  const double *qk = orientation(3);
+  const double *hx = m_halfExtents.x();
+  const double *hy = m_halfExtents.y();
+  const double *hz = m_halfExtents.z();
+  double *bx = m_boundingHalfExtents.x();
+  double *by = m_boundingHalfExtents.y();
+  double *bz = m_boundingHalfExtents.z();
+  double *radii = m_radii.empty() ? NULL : &m_radii[0];
+
+  double *a[9];
+  for (int n = 0; n < 9; n++)
+    a[n] = m_axes[n].empty() ? NULL : &m_axes[n][0];
+
+  for (size_t n = begin; n < end; n++)
+  {
+    const double w = qw[n];
+    const double i = qi[n];
+    const double j = qj[n];
+    const double k = qk[n];
+
+    /* Columns of the rotation matrix, as in RotationMatrix */
+    const double xx = 1.0 - 2.0 * (j * j + k * k);
+    const double xy = 2.0 * (i * j + w * k);
+    const double xz = 2.0 * (i * k - w * j);
+    const double yx = 2.0 * (i * j - w * k);
+    const double yy = 1.0 - 2.0 * (i * i + k * k);
+    const double yz = 2.0 * (j * k + w * i);
+    const double zx = 2.0 * (i * k + w * j);
+    const double zy = 2.0 * (j * k - w * i);
+    const double zz = 1.0 - 2.0 * (i * i + j * j);
+
+    a[0][n] = xx;
+    a[1][n] = xy;
+    a[2][n] = xz;
+    a[3][n] = yx;
+    a[4][n] = yy;
+    a[5][n] = yz;
+    a[6][n] = zx;
+    a[7][n] = zy;
+    a[8][n] = zz;
+
+    bx[n] = hx[n] * std::fabs(xx) + hy[n] * std::fabs(yx) +
+            hz[n] * std::fabs(zx);
+    by[n] = hx[n] * std::fabs(xy) + hy[n] * std::fabs(yy) +
+            hz[n] * std::fabs(zy);
+    bz[n] = hx[n] * std::fabs(xz) + hy[n] * std::fabs(yz) +
+            hz[n] * std::fabs(zz);
+
+    radii[n] = std::sqrt(hx[n] * hx[n] + hy[n] * hy[n] + hz[n] * hz[n]);
+  }
+}
+
+/**
+ * Tests a box of the set against a box given by its cached axes.
+ *
+ * @param index Index of box in the set
+ * @param centre Centre of other box, 3 values
+ * @param axes Axes of other box, 9 values
+ * @param halfExtents Half extents of other box, 3 values
+ * @param radius Radius of the sphere enclosing the other box
+ * @return True if the boxes intersect
+ */
+bool OrientedBoxSet::intersectsBox(const size_t index, const double *centre,
+                                   const double *axes,
+                                   const double *halfExtents,
+                                   const double radius) const
+{
+  const double dx = m_centres.x()[index] - centre[0];
+  const double dy = m_centres.y()[index] - centre[1];
+  const double dz = m_centres.z()[index] - centre[2];
+  const double r = m_radii[index] + radius;
+  if (dx * dx + dy * dy + dz * dz > r * r)
+    return false;
+
+  const double otherCentre[] = {m_centres.x()[index], m_centres.y()[index],
+                                m_centres.z()[index]};
+  const double otherHalfExtents[] = {m_halfExtents.x()[index],
+                                     m_halfExtents.y()[index],
+                                     m_halfExtents.z()[index]};
+  double otherAxes[9];
+  for (int n = 0; n < 9; n++)
+    otherAxes[n] = m_axes[n][index];
+
+  return OrientedBox::intersects(centre, axes, halfExtents, otherCentre,
+                                 otherAxes, otherHalfExtents);
+}
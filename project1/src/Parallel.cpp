@@ -0,0 +1,177 @@
+#include "Parallel.h"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/*
+ * Optimisation notes
+ *
+ * Each call spawns its threads and joins them before returning, so a chunk
+ * is only worth a thread when it holds at least minPerThread elements; below
+ * that the whole range is processed on the calling thread with no thread
+ * created at all. The calling thread always does the first chunk itself.
+ */
+
+/**
+ * Gives the size of each chunk when splitting a range.
+ *
+ * @param count Number of elements
+ * @param minPerThread Fewest elements worth giving to a thread
+ * @param alignment Chunks are a multiple of this many elements
+ * @param maxThreads Maximum number of threads
+ * @return Chunk size, zero if count is zero
+ */
+static size_t chunkSize(const size_t count, const size_t minPerThread,
+                        const size_t alignment, const unsigned int maxThreads)
+{
+  const unsigned int threads =
+      parallelThreads(count, minPerThread, maxThreads);
+  if (threads == 1)
+    return count;
+
+  const size_t align = std::max<size_t>(1, alignment);
+  const size_t chunk = (count + threads - 1) / threads;
+  return (chunk + align - 1) / align * align;
+}
+
+/**
+ * Resolves a requested number of threads.
+ *
+ * @param numThreads Number of threads, zero to use one per core
+ * @return Number of threads, at least one
+ */
+unsigned int resolveNumThreads(const unsigned int numThreads)
+{
+  if (numThreads != 0)
+    return numThreads;
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * Gives the number of threads worth using for a number of elements.
+ *
+ * @param count Number of elements
+ * @param minPerThread Fewest elements worth giving to a thread
+ * @param maxThreads Maximum number of threads
+ * @return Number of threads, at least one
+ */
+unsigned int parallelThreads(const size_t count, const size_t minPerThread,
+                             const unsigned int maxThreads)
+{
+  const size_t useful = count / std::max<size_t>(1, minPerThread);
+  return (unsigned int)std::max<size_t>(
+      1, std::min<size_t>(maxThreads, useful));
+}
+
+/**
+ * Gives the number of chunks parallelFor() splits a range into, e.g. to size
+ * per chunk results.
+ *
+ * @param count Number of elements in the range
+ * @param minPerThread Fewest elements worth giving to a thread
+ * @param alignment Chunks are a multiple of this many elements
+ * @param maxThreads Maximum number of threads
+ * @return Number of chunks, zero if count is zero
+ */
+size_t parallelChunks(const size_t count, const size_t minPerThread,
+                      const size_t alignment, const unsigned int maxThreads)
+{
+  const size_t chunk = chunkSize(count, minPerThread, alignment, maxThreads);
+  return chunk == 0 ? 0 : (count + chunk - 1) / chunk;
+}
+
+/**
+ * Calls a chunk function, catching anything it throws.
+ *
+ * @param fn Function to process a chunk
+ * @param chunk Index of the chunk
+ * @param begin Index of the first element
+ * @param end Index after the last element
+ * @param error Set to the exception thrown by fn, if any
+ */
+static void runChunk(const ParallelRange &fn, const size_t chunk,
+                     const size_t begin, const size_t end,
+                     std::exception_ptr &error)
+{
+  try
+  {
+    fn(chunk, begin, end);
+  }
+  catch (...)
+  {
+    error = std::current_exception();
+  }
+}
+
+/**
+ * Processes a range of elements, split into chunks across threads.
+ *
+ * Every chunk but the last is a multiple of alignment elements, so each
+ * starts at begin plus a multiple of alignment. fn is called once per chunk,
+ * on a separate thread for all but the first, and all calls have returned
+ * when this does. Nothing is called for an empty range.
+ *
+ * If fn throws for any chunk the exception is rethrown on the calling thread
+ * once every chunk has finished, the one from the lowest chunk if several
+ * throw.
+ *
+ * @param begin Index of the first element
+ * @param end Index after the last element
+ * @param minPerThread Fewest elements worth giving to a thread
+ * @param alignment Chunks are a multiple of this many elements
+ * @param maxThreads Maximum number of threads
+ * @param fn Function to process a chunk
+ */
+void parallelFor(const size_t begin, const size_t end,
+                 const size_t minPerThread, const size_t alignment,
+                 const unsigned int maxThreads, const ParallelRange &fn)
+{
+  if (end <= begin)
+    return;
+
+  const size_t count = end - begin;
+  const size_t chunk = chunkSize(count, minPerThread, alignment, maxThreads);
+  if (chunk >= count)
+  {
+    fn(0, begin, end);
+    return;
+  }
+
+  const size_t numChunks = (count + chunk - 1) / chunk;
+  std::vector<std::exception_ptr> errors(numChunks);
+  std::vector<std::thread> threads;
+  threads.reserve(numChunks - 1);
+
+  /* Threads already started must be joined before anything propagates,
+   * including a failure to start the next one */
+  try
+  {
+    for (size_t c = 1; c < numChunks; c++)
+    {
+      const size_t first = begin + c * chunk;
+      threads.push_back(std::thread(runChunk, std::cref(fn), c, first,
+                                    std::min(end, first + chunk),
+                                    std::ref(errors[c])));
+    }
+  }
+  catch (...)
+  {
+    for (size_t n = 0; n < threads.size(); n++)
+      threads[n].join();
+    throw;
+  }
+
+  /* The calling thread does the first chunk */
+  runChunk(fn, 0, begin, std::min(end, begin + chunk), errors[0]);
+
+  for (size_t n = 0; n < threads.size(); n++)
+    threads[n].join();
+
+  for (size_t c = 0; c < numChunks; c++)
+  {
+    if (errors[c])
+      std::rethrow_exception(errors[c]);
+  }
+}
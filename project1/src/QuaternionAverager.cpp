@@ -0,0 +1,548 @@
+#include "QuaternionAverager.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "Parallel.h"
+#include "Simd.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Averaging
+ *
+ * q and -q are the same rotation, so quaternions cannot simply be summed.
+ * AVERAGE_EIGEN sums the outer products q q^T, which are the same for q and
+ * -q, and takes the average as the eigenvector of the largest eigenvalue of
+ * that 4x4 matrix (Markley et al., "Averaging Quaternions", 2007). This
+ * minimises the weighted sum of squared chordal distances to the samples.
+ * AVERAGE_SIGN_ALIGNED negates each sample that lies in the opposite
+ * hemisphere to the first sample and normalises the sum, which approximates
+ * the same average when all samples are close together.
+ *
+ * Both reduce a stream of samples to a fixed size accumulator, so samples can
+ * be added in pieces, e.g. chunks read from a file, without holding them all
+ * in memory, and accumulators filled separately can be merged.
+ *
+ * Optimisation notes
+ *
+ * Only the accumulator needed by the method is updated. Bulk adds over
+ * component arrays use an SSE2 kernel accumulating two samples per iteration
+ * in separate lanes, and large bulk adds are split into chunks accumulated on
+ * separate threads and then merged. The scalar/SIMD choice follows
+ * useSimdKernels().
+ *
+ * The eigenvector is found with cyclic Jacobi rotations, which for a 4x4
+ * symmetric matrix converge in a few sweeps and need no special handling of
+ * repeated eigenvalues.
+ */
+
+/* Fewest samples worth giving to a thread */
+static const size_t MIN_THREAD_SAMPLES = 1 << 16;
+
+/* Most Jacobi sweeps before giving up on convergence */
+static const int MAX_JACOBI_SWEEPS = 50;
+
+/**
+ * Finds the eigenvector of the largest eigenvalue of a symmetric 4x4 matrix.
+ *
+ * @param a Matrix, destroyed
+ * @param vector Filled with the unit eigenvector
+ */
+static void largestEigenvector(double a[4][4], double vector[4])
+{
+  double v[4][4];
+  for (int r = 0; r < 4; r++)
+    for (int c = 0; c < 4; c++)
+      v[r][c] = (r == c) ? 1.0 : 0.0;
+
+  double scale = 0.0;
+  for (int r = 0; r < 4; r++)
+    for (int c = 0; c < 4; c++)
+      scale += a[r][c] * a[r][c];
+
+  for (int sweep = 0; sweep < MAX_JACOBI_SWEEPS; sweep++)
+  {
+    double off = 0.0;
+    for (int p = 0; p < 3; p++)
+      for (int q = p + 1; q < 4; q++)
+        off += a[p][q] * a[p][q];
+
+    if (off <= DBL_EPSILON * DBL_EPSILON * scale)
+      break;
+
+    for (int p = 0; p < 3; p++)
+    {
+      for (int q = p + 1; q < 4; q++)
+      {
+        if (a[p][q] == 0.0)
+          continue;
+
+        /* Rotation zeroing a[p][q] */
+        const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+        const double t = (theta >= 0.0 ? 1.0 : -1.0) /
+                         (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+        const double c = 1.0 / std::sqrt(t * t + 1.0);
+        const double s = t * c;
+
+        for (int k = 0; k < 4; k++)
+        {
+          const double akp = a[k][p];
+          const double akq = a[k][q];
+          a[k][p] = c * akp - s * akq;
+          a[k][q] = s * akp + c * akq;
+        }
+        for (int k = 0; k < 4; k++)
+        {
+          const double apk = a[p][k];
+          const double aqk = a[q][k];
+          a[p][k] = c * apk - s * aqk;
+          a[q][k] = s * apk + c * aqk;
+        }
+        for (int k = 0; k < 4; k++)
+        {
+          const double vkp = v[k][p];
+          const double vkq = v[k][q];
+          v[k][p] = c * vkp - s * vkq;
+          v[k][q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+
+  int largest = 0;
+  for (int n = 1; n < 4; n++)
+  {
+    if (a[n][n] > a[largest][largest])
+      largest = n;
+  }
+
+  for (int n = 0; n < 4; n++)
+    vector[n] = v[n][largest];
+}
+
+/**
+ * Construct an empty accumulator.
+ *
+ * @param method Averaging method
+ * @param numThreads Maximum number of threads used by bulk adds, zero to use
+ *                   one per core
+ */
+QuaternionAverager::QuaternionAverager(const AverageMethod method,
+                                       const unsigned int numThreads)
+    : m_method(method)
+{
+  setNumThreads(numThreads);
+  clear();
+}
+
+/**
+ * Construct an accumulator taking values from another.
+ *
+ * @param other Accumulator to copy
+ */
+QuaternionAverager::QuaternionAverager(const QuaternionAverager &other)
+{
+  operator=(other);
+}
+
+/**
+ * Destructor
+ */
+QuaternionAverager::~QuaternionAverager()
+{
+}
+
+/**
+ * Set the values of this accumulator to the values of another.
+ *
+ * @param other Accumulator to copy
+ */
+void QuaternionAverager::operator=(const QuaternionAverager &other)
+{
+  m_method = other.m_method;
+  m_numThreads = other.m_numThreads;
+  for (int n = 0; n < 10; n++)
+    m_products[n] = other.m_products[n];
+  for (int n = 0; n < 4; n++)
+  {
+    m_sum[n] = other.m_sum[n];
+    m_reference[n] = other.m_reference[n];
+  }
+  m_hasReference = other.m_hasReference;
+  m_count = other.m_count;
+  m_weight = other.m_weight;
+}
+
+/**
+ * Returns the averaging method.
+ *
+ * @return Method
+ */
+AverageMethod QuaternionAverager::getMethod() const
+{
+  return m_method;
+}
+
+/**
+ * Sets the maximum number of threads used by bulk adds.
+ *
+ * @param numThreads Maximum number of threads, zero to use one per core
+ */
+void QuaternionAverager::setNumThreads(const unsigned int numThreads)
+{
+  m_numThreads = resolveNumThreads(numThreads);
+}
+
+/**
+ * Returns the maximum number of threads used by bulk adds.
+ *
+ * @return Number of threads
+ */
+unsigned int QuaternionAverager::getNumThreads() const
+{
+  return m_numThreads;
+}
+
+/**
+ * Removes all samples.
+ */
+void QuaternionAverager::clear()
+{
+  for (int n = 0; n < 10; n++)
+    m_products[n] = 0.0;
+  for (int n = 0; n < 4; n++)
+  {
+    m_sum[n] = 0.0;
+    m_reference[n] = 0.0;
+  }
+  m_hasReference = false;
+  m_count = 0;
+  m_weight = 0.0;
+}
+
+/**
+ * Adds a sample.
+ *
+ * @param q Orientation, normalised if not of unit length
+ * @param weight Weight of the sample
+ */
+void QuaternionAverager::add(const Quaternion &q, const double weight)
+{
+  if (weight < 0.0)
+    throw std::runtime_error("Negative sample weight");
+
+  const Quaternion u = q.isUnit() ? q : q.getUnitQuaternion();
+  const double c[] = {u.getReal(), u.getI(), u.getJ(), u.getK()};
+
+  if (!m_hasReference)
+    setReference(c[0], c[1], c[2], c[3]);
+
+  if (m_method == AVERAGE_EIGEN)
+  {
+    int n = 0;
+    for (int r = 0; r < 4; r++)
+      for (int col = r; col < 4; col++)
+        m_products[n++] += weight * c[r] * c[col];
+  }
+  else
+  {
+    const double d = c[0] * m_reference[0] + c[1] * m_reference[1] +
+                     c[2] * m_reference[2] + c[3] * m_reference[3];
+    const double s = d < 0.0 ? -weight : weight;
+    for (int n = 0; n < 4; n++)
+      m_sum[n] += s * c[n];
+  }
+
+  m_count++;
+  m_weight += weight;
+}
+
+/**
+ * Adds samples, each with weight 1.
+ *
+ * @param samples Pointer to first orientation, each normalised if not of
+ *                unit length
+ * @param count Number of samples
+ */
+void QuaternionAverager::add(const Quaternion *samples, const size_t count)
+{
+  for (size_t n = 0; n < count; n++)
+    add(samples[n]);
+}
+
+/**
+ * Adds samples stored as component arrays, e.g. those of a RigidBodySet,
+ * each with weight 1.
+ *
+ * Samples must be of unit length.
+ *
+ * @param w Pointer to w component of first sample
+ * @param i Pointer to i component of first sample
+ * @param j Pointer to j component of first sample
+ * @param k Pointer to k component of first sample
+ * @param count Number of samples
+ */
+void QuaternionAverager::add(const double *w, const double *i,
+                             const double *j, const double *k,
+                             const size_t count)
+{
+  if (count == 0)
+    return;
+
+  if (!m_hasReference)
+    setReference(w[0], i[0], j[0], k[0]);
+
+  const size_t numChunks =
+      parallelChunks(count, MIN_THREAD_SAMPLES, 1, m_numThreads);
+
+  if (numChunks == 1)
+  {
+    addRange(w, i, j, k, 0, count);
+    return;
+  }
+
+  /* Each chunk is accumulated separately, with the same reference, then
+   * merged */
+  QuaternionAverager empty(m_method, 1);
+  empty.setReference(m_reference[0], m_reference[1], m_reference[2],
+                     m_reference[3]);
+  std::vector<QuaternionAverager> partial(numChunks, empty);
+
+  parallelFor(0, count, MIN_THREAD_SAMPLES, 1, m_numThreads,
+              [&](size_t c, size_t begin, size_t end) {
+                partial[c].addRange(w, i, j, k, begin, end);
+              });
+
+  for (size_t c = 0; c < numChunks; c++)
+    merge(partial[c]);
+}
+
+/**
+ * Adds the samples of another accumulator to this one.
+ *
+ * For AVERAGE_SIGN_ALIGNED the samples of the other accumulator were aligned
+ * with its own first sample, so its sum is negated as a whole if that sample
+ * is in the opposite hemisphere to the first sample of this one.
+ *
+ * @param other Accumulator using the same method
+ */
+void QuaternionAverager::merge(const QuaternionAverager &other)
+{
+  if (other.m_method != m_method)
+    throw std::runtime_error("QuaternionAverager method mismatch");
+
+  if (!other.m_hasReference)
+    return;
+
+  if (!m_hasReference)
+    setReference(other.m_reference[0], other.m_reference[1],
+                 other.m_reference[2], other.m_reference[3]);
+
+  for (int n = 0; n < 10; n++)
+    m_products[n] += other.m_products[n];
+
+  const double d = m_reference[0] * other.m_reference[0] +
+                   m_reference[1] * other.m_reference[1] +
+                   m_reference[2] * other.m_reference[2] +
+                   m_reference[3] * other.m_reference[3];
+  const double s = d < 0.0 ? -1.0 : 1.0;
+  for (int n = 0; n < 4; n++)
+    m_sum[n] += s * other.m_sum[n];
+
+  m_count += other.m_count;
+  m_weight += other.m_weight;
+}
+
+/**
+ * Returns the number of samples added.
+ *
+ * @return Number of samples
+ */
+size_t QuaternionAverager::count() const
+{
+  return m_count;
+}
+
+/**
+ * Returns the total weight of the samples added.
+ *
+ * @return Sum of weights
+ */
+double QuaternionAverager::totalWeight() const
+{
+  return m_weight;
+}
+
+/**
+ * Returns the average of the samples added so far.
+ *
+ * @return Unit quaternion, with a non negative real part
+ */
+Quaternion QuaternionAverager::average() const
+{
+  if (m_weight <= 0.0)
+    throw std::runtime_error("No samples to average");
+
+  double q[4];
+
+  if (m_method == AVERAGE_EIGEN)
+  {
+    double a[4][4];
+    int n = 0;
+    for (int r = 0; r < 4; r++)
+    {
+      for (int c = r; c < 4; c++)
+      {
+        a[r][c] = m_products[n] / m_weight;
+        a[c][r] = a[r][c];
+        n++;
+      }
+    }
+    largestEigenvector(a, q);
+  }
+  else
+  {
+    for (int n = 0; n < 4; n++)
+      q[n] = m_sum[n];
+  }
+
+  const double magnitude =
+      std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+  if (magnitude < DBL_EPSILON)
+    throw std::runtime_error("Samples have no defined average");
+
+  const double s = (q[0] < 0.0 ? -1.0 : 1.0) / magnitude;
+  return Quaternion(s * q[0], s * q[1], s * q[2], s * q[3]);
+}
+
+/**
+ * Sets the sample the signs of others are aligned with.
+ *
+ * @param w, i, j, k Components of the sample
+ */
+void QuaternionAverager::setReference(const double w, const double i,
+                                      const double j, const double k)
+{
+  m_reference[0] = w;
+  m_reference[1] = i;
+  m_reference[2] = j;
+  m_reference[3] = k;
+  m_hasReference = true;
+}
+
+/**
+ * Adds a range of samples stored as component arrays.
+ *
+ * @param w, i, j, k Pointers to the components of the first sample
+ * @param begin Index of first sample
+ * @param end Index after last sample
+ */
+void QuaternionAverager::addRange(const double *w, const double *i,
+                                  const double *j, const double *k,
+                                  const size_t begin, const size_t end)
+{
+  size_t n = begin;
+
+  double p[10] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  double sum[4] = {0.0, 0.0, 0.0, 0.0};
+  const double *r = m_reference;
+
+#ifdef __SSE2__
+  if (useSimdKernels())
+  {
+    if (m_method == AVERAGE_EIGEN)
+    {
+      __m128d acc[10];
+      for (int a = 0; a < 10; a++)
+        acc[a] = _mm_setzero_pd();
+
+      for (; n + 2 <= end; n += 2)
+      {
+        const __m128d c[] = {_mm_loadu_pd(w + n), _mm_loadu_pd(i + n),
+                             _mm_loadu_pd(j + n), _mm_loadu_pd(k + n)};
+        int a = 0;
+        for (int row = 0; row < 4; row++)
+        {
+          for (int col = row; col < 4; col++)
+          {
+            acc[a] = _mm_add_pd(acc[a], _mm_mul_pd(c[row], c[col]));
+            a++;
+          }
+        }
+      }
+
+      for (int a = 0; a < 10; a++)
+      {
+        double lanes[2];
+        _mm_storeu_pd(lanes, acc[a]);
+        p[a] = lanes[0] + lanes[1];
+      }
+    }
+    else
+    {
+      const __m128d rw = _mm_set1_pd(r[0]);
+      const __m128d ri = _mm_set1_pd(r[1]);
+      const __m128d rj = _mm_set1_pd(r[2]);
+      const __m128d rk = _mm_set1_pd(r[3]);
+      const __m128d signBit = _mm_set1_pd(-0.0);
+      const __m128d zero = _mm_setzero_pd();
+      __m128d acc[4];
+      for (int a = 0; a < 4; a++)
+        acc[a] = _mm_setzero_pd();
+
+      for (; n + 2 <= end; n += 2)
+      {
+        const __m128d c[] = {_mm_loadu_pd(w + n), _mm_loadu_pd(i + n),
+                             _mm_loadu_pd(j + n), _mm_loadu_pd(k + n)};
+        const __m128d d = _mm_add_pd(
+            _mm_add_pd(_mm_mul_pd(c[0], rw), _mm_mul_pd(c[1], ri)),
+            _mm_add_pd(_mm_mul_pd(c[2], rj), _mm_mul_pd(c[3], rk)));
+
+        /* Flip the sign of samples in the opposite hemisphere */
+        const __m128d flip = _mm_and_pd(_mm_cmplt_pd(d, zero), signBit);
+        for (int a = 0; a < 4; a++)
+          acc[a] = _mm_add_pd(acc[a], _mm_xor_pd(c[a], flip));
+      }
+
+      for (int a = 0; a < 4; a++)
+      {
+        double lanes[2];
+        _mm_storeu_pd(lanes, acc[a]);
+        sum[a] = lanes[0] + lanes[1];
+      }
+    }
+  }
+#endif
+
+  for (; n < end; n++)
+  {
+    const double c[] = {w[n], i[n], j[n], k[n]};
+    if (m_method == AVERAGE_EIGEN)
+    {
+      int a = 0;
+      for (int row = 0; row < 4; row++)
+        for (int col = row; col < 4; col++)
+          p[a++] += c[row] * c[col];
+    }
+    else
+    {
+      const double d = c[0] * r[0] + c[1] * r[1] + c[2] * r[2] + c[3] * r[3];
+      const double s = d < 0.0 ? -1.0 : 1.0;
+      for (int a = 0; a < 4; a++)
+        sum[a] += s * c[a];
+    }
+  }
+
+  for (int a = 0; a < 10; a++)
+    m_products[a] += p[a];
+  for (int a = 0; a < 4; a++)
+    m_sum[a] += sum[a];
+
+  m_count += end - begin;
+  m_weight += (double)(end - begin);
+}
@@ -0,0 +1,322 @@
+#include "QuaternionCodec.h"
+
+#include <cmath>
+#include "Quaternion.h"
+#include "Simd.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Smallest three encoding
+ *
+ * q and -q represent the same rotation, so the largest magnitude component of
+ * a unit quaternion can always be made positive and then recovered from the
+ * other three as sqrt(1 - a^2 - b^2 - c^2). Only the index of the largest
+ * component (2 bits) and the other three components are stored.
+ *
+ * As the largest component is at least 1/2, the other three lie within
+ * +/-1/sqrt(2) and are quantised uniformly over that range. An odd number of
+ * levels (the largest code is unused) is used so zero is exact and the
+ * identity round trips unchanged:
+ *
+ *   32 bit: 2 bit index, 3 x 10 bit components
+ *   48 bit: 2 bit index, 3 x 15 bit components (1 bit unused)
+ *
+ * Error bounds
+ *
+ * With a quantisation step of s = sqrt(2) / (2^bits - 2) each stored
+ * component is within h = s / 2 of its true value. The three stored
+ * components sum to at most 1.5 in magnitude, so the recovered d^2 is within
+ * 3h + 3h^2; as d and its estimate are both about 1/2 or more, the error in d
+ * is at most that divided by their sum (at least 1), giving a bound of
+ * 3h(1 + h) on every component:
+ *
+ *   32 bit: h = 6.9e-4, bound 2.1e-3 (rotation error below 0.25 degrees)
+ *   48 bit: h = 2.2e-5, bound 6.5e-5 (rotation error below 0.01 degrees)
+ *
+ * These bounds are checked against random quaternions in the unit tests.
+ */
+
+const double QuaternionCodec::MAX_ERROR_32 = 2.1e-3;
+const double QuaternionCodec::MAX_ERROR_48 = 6.5e-5;
+
+const size_t QuaternionCodec::PACKED48_BYTES;
+
+/* Range of the three smallest components of a unit quaternion */
+static const double RANGE = 0.70710678118654752440;
+
+/**
+ * Packs a quaternion into the smallest three format.
+ *
+ * @param q Quaternion to pack, normalised if not of unit length
+ * @param bits Number of bits per stored component
+ * @return Packed quaternion in the lowest 2 + 3 * bits bits
+ */
+static uint64_t pack(const Quaternion &q, const int bits)
+{
+  const Quaternion u = q.isUnit() ? q : q.getUnitQuaternion();
+  const double v[] = {u.getReal(), u.getI(), u.getJ(), u.getK()};
+
+  int largest = 0;
+  for (int c = 1; c < 4; c++)
+  {
+    if (std::abs(v[c]) > std::abs(v[largest]))
+      largest = c;
+  }
+
+  const double sign = v[largest] < 0.0 ? -1.0 : 1.0;
+  const double maxValue = (double)((1 << bits) - 2);
+  const double scale = maxValue / (2.0 * RANGE);
+
+  uint64_t packed = (uint64_t)largest;
+  for (int c = 0; c < 4; c++)
+  {
+    if (c == largest)
+      continue;
+
+    double x = (v[c] * sign + RANGE) * scale + 0.5;
+    if (x < 0.0)
+      x = 0.0;
+    else if (x > maxValue)
+      x = maxValue;
+
+    packed = (packed << bits) | (uint64_t)x;
+  }
+
+  return packed;
+}
+
+/**
+ * Builds a quaternion from the three stored components and the recovered
+ * largest component.
+ *
+ * @param largest Index of the largest component
+ * @param a First stored component
+ * @param b Second stored component
+ * @param c Third stored component
+ * @param d Largest component
+ * @return Unpacked quaternion
+ */
+static Quaternion place(const int largest, const double a, const double b,
+                        const double c, const double d)
+{
+  switch (largest)
+  {
+  case 0:
+    return Quaternion(d, a, b, c);
+  case 1:
+    return Quaternion(a, d, b, c);
+  case 2:
+    return Quaternion(a, b, d, c);
+  default:
+    return Quaternion(a, b, c, d);
+  }
+}
+
+/**
+ * Unpacks a quaternion from the smallest three format.
+ *
+ * @param packed Packed quaternion
+ * @param bits Number of bits per stored component
+ * @return Unit quaternion
+ */
+static Quaternion unpack(const uint64_t packed, const int bits)
+{
+  const uint64_t mask = (1 << bits) - 1;
+  const double scale = (2.0 * RANGE) / (double)(mask - 1);
+
+  const double a = (double)((packed >> (2 * bits)) & mask) * scale - RANGE;
+  const double b = (double)((packed >> bits) & mask) * scale - RANGE;
+  const double c = (double)(packed & mask) * scale - RANGE;
+  const double d2 = 1.0 - a * a - b * b - c * c;
+
+  return place((int)((packed >> (3 * bits)) & 3), a, b, c,
+               d2 > 0.0 ? sqrt(d2) : 0.0);
+}
+
+/**
+ * Unpacks an array of quaternions from the smallest three format.
+ *
+ * Unpacks two at a time with SSE2 where available.
+ *
+ * @param packed Function returning the packed value of a given index
+ * @param bits Number of bits per stored component
+ * @param out Array to store quaternions in
+ * @param count Number of quaternions
+ */
+template <typename Packed>
+static void unpackArray(Packed packed, const int bits, Quaternion *out,
+                        const size_t count)
+{
+  size_t n = 0;
+#ifdef __SSE2__
+  if (useSimdKernels())
+  {
+    const uint64_t mask = (1 << bits) - 1;
+    const __m128d scale = _mm_set1_pd((2.0 * RANGE) / (double)(mask - 1));
+    const __m128d range = _mm_set1_pd(RANGE);
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d zero = _mm_setzero_pd();
+
+    for (; n + 2 <= count; n += 2)
+    {
+      const uint64_t p0 = packed(n);
+      const uint64_t p1 = packed(n + 1);
+
+      const __m128d a = _mm_sub_pd(
+          _mm_mul_pd(_mm_set_pd((double)((p1 >> (2 * bits)) & mask),
+                                (double)((p0 >> (2 * bits)) & mask)),
+                     scale),
+          range);
+      const __m128d b = _mm_sub_pd(
+          _mm_mul_pd(_mm_set_pd((double)((p1 >> bits) & mask),
+                                (double)((p0 >> bits) & mask)),
+                     scale),
+          range);
+      const __m128d c = _mm_sub_pd(
+          _mm_mul_pd(_mm_set_pd((double)(p1 & mask), (double)(p0 & mask)),
+                     scale),
+          range);
+
+      __m128d d = _mm_sub_pd(one, _mm_mul_pd(a, a));
+      d = _mm_sub_pd(d, _mm_mul_pd(b, b));
+      d = _mm_sub_pd(d, _mm_mul_pd(c, c));
+      d = _mm_sqrt_pd(_mm_max_pd(d, zero));
+
+      double r[4][2];
+      _mm_storeu_pd(r[0], a);
+      _mm_storeu_pd(r[1], b);
+      _mm_storeu_pd(r[2], c);
+      _mm_storeu_pd(r[3], d);
+
+      out[n] = place((int)((p0 >> (3 * bits)) & 3), r[0][0], r[1][0], r[2][0],
+                     r[3][0]);
+      out[n + 1] = place((int)((p1 >> (3 * bits)) & 3), r[0][1], r[1][1],
+                         r[2][1], r[3][1]);
+    }
+  }
+#endif
+  for (; n < count; n++)
+    out[n] = unpack(packed(n), bits);
+}
+
+/**
+ * Encodes a quaternion into 32 bits.
+ *
+ * @param q Quaternion, normalised if not of unit length
+ * @return Encoded quaternion
+ */
+uint32_t QuaternionCodec::encode32(const Quaternion &q)
+{
+  return (uint32_t)pack(q, 10);
+}
+
+/**
+ * Decodes a quaternion encoded by encode32().
+ *
+ * The result is the same rotation as the encoded quaternion but may be its
+ * negation.
+ *
+ * @param packed Encoded quaternion
+ * @return Unit quaternion
+ */
+Quaternion QuaternionCodec::decode32(const uint32_t packed)
+{
+  return unpack(packed, 10);
+}
+
+/**
+ * Encodes a quaternion into 48 bits.
+ *
+ * @param q Quaternion, normalised if not of unit length
+ * @return Encoded quaternion in the lowest 48 bits
+ */
+uint64_t QuaternionCodec::encode48(const Quaternion &q)
+{
+  return pack(q, 15);
+}
+
+/**
+ * Decodes a quaternion encoded by encode48().
+ *
+ * The result is the same rotation as the encoded quaternion but may be its
+ * negation.
+ *
+ * @param packed Encoded quaternion
+ * @return Unit quaternion
+ */
+Quaternion QuaternionCodec::decode48(const uint64_t packed)
+{
+  return unpack(packed, 15);
+}
+
+/**
+ * Encodes an array of quaternions into 32 bits each.
+ *
+ * @param in Quaternions to encode
+ * @param out Array to store encoded quaternions in
+ * @param count Number of quaternions
+ */
+void QuaternionCodec::encode32(const Quaternion *in, uint32_t *out,
+                               const size_t count)
+{
+  for (size_t n = 0; n < count; n++)
+    out[n] = (uint32_t)pack(in[n], 10);
+}
+
+/**
+ * Decodes an array of quaternions encoded by encode32().
+ *
+ * @param in Encoded quaternions
+ * @param out Array to store quaternions in
+ * @param count Number of quaternions
+ */
+void QuaternionCodec::decode32(const uint32_t *in, Quaternion *out,
+                               const size_t count)
+{
+  unpackArray([in](size_t n) { return (uint64_t)in[n]; }, 10, out, count);
+}
+
+/**
+ * Encodes an array of quaternions into 48 bits each.
+ *
+ * Each quaternion takes PACKED48_BYTES bytes, stored little endian so files
+ * are portable.
+ *
+ * @param in Quaternions to encode
+ * @param out Array of count * PACKED48_BYTES bytes to store encoded
+ *            quaternions in
+ * @param count Number of quaternions
+ */
+void QuaternionCodec::encode48(const Quaternion *in, uint8_t *out,
+                               const size_t count)
+{
+  for (size_t n = 0; n < count; n++)
+  {
+    const uint64_t packed = pack(in[n], 15);
+    for (size_t b = 0; b < PACKED48_BYTES; b++)
+      out[n * PACKED48_BYTES + b] = (uint8_t)(packed >> (8 * b));
+  }
+}
+
+/**
+ * Decodes an array of quaternions encoded by the bulk encode48().
+ *
+ * @param in Array of count * PACKED48_BYTES bytes of encoded quaternions
+ * @param out Array to store quaternions in
+ * @param count Number of quaternions
+ */
+void QuaternionCodec::decode48(const uint8_t *in, Quaternion *out,
+                               const size_t count)
+{
+  unpackArray(
+      [in](size_t n) {
+        uint64_t packed = 0;
+        for (size_t b = 0; b < PACKED48_BYTES; b++)
+          packed |= (uint64_t)in[n * PACKED48_BYTES + b] << (8 * b);
+        return packed;
+      },
+      15, out, count);
+}
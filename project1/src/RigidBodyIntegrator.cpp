@@ -0,0 +1,225 @@
+#include "RigidBodyIntegrator.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "Parallel.h"
+#include "RigidBodySet.h"
+#include "Simd.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Integration
+ *
+ * Semi-implicit Euler: velocity is advanced by gravity first and the new
+ * velocity is used to advance position. Orientation is advanced using the
+ * quaternion derivative dq/dt = (0, w) q / 2 for world space angular
+ * velocity w, then renormalised so error does not accumulate.
+ *
+ * Optimisation notes
+ *
+ * A step is a single pass over the SoA state, with the SSE2 kernel advancing
+ * two bodies per iteration. Large sets are split into cache line aligned
+ * chunks across threads; the scalar/SIMD choice follows useSimdKernels().
+ */
+
+/* Fewest bodies worth giving to a thread */
+static const size_t MIN_THREAD_BODIES = 1 << 14;
+
+/* Threaded chunks are a multiple of this many bodies */
+static const size_t CHUNK_ALIGNMENT = 8;
+
+/**
+ * Construct an integrator with no gravity.
+ *
+ * @param numThreads Maximum number of threads, zero to use one per core
+ */
+RigidBodyIntegrator::RigidBodyIntegrator(const unsigned int numThreads)
+    : m_gravity(0.0, 0.0, 0.0)
+{
+  setNumThreads(numThreads);
+}
+
+/**
+ * Destructor
+ */
+RigidBodyIntegrator::~RigidBodyIntegrator()
+{
+}
+
+/**
+ * Sets the acceleration applied to every body.
+ *
+ * @param gravity Acceleration
+ */
+void RigidBodyIntegrator::setGravity(const Vector3DStack &gravity)
+{
+  m_gravity = gravity;
+}
+
+/**
+ * Returns the acceleration applied to every body.
+ *
+ * @return Acceleration
+ */
+Vector3DStack RigidBodyIntegrator::getGravity() const
+{
+  return m_gravity;
+}
+
+/**
+ * Sets the maximum number of threads used by step().
+ *
+ * @param numThreads Maximum number of threads, zero to use one per core
+ */
+void RigidBodyIntegrator::setNumThreads(const unsigned int numThreads)
+{
+  m_numThreads = resolveNumThreads(numThreads);
+}
+
+/**
+ * Returns the maximum number of threads used by step().
+ *
+ * @return Number of threads
+ */
+unsigned int RigidBodyIntegrator::getNumThreads() const
+{
+  return m_numThreads;
+}
+
+/**
+ * Advances every body by one time step.
+ *
+ * @param bodies Bodies to advance
+ * @param dt Time step
+ */
+void RigidBodyIntegrator::step(RigidBodySet &bodies, const double dt) const
+{
+  parallelFor(0, bodies.size(), MIN_THREAD_BODIES, CHUNK_ALIGNMENT,
+              m_numThreads, [&](size_t, size_t begin, size_t end) {
+                stepRange(bodies, dt, begin, end);
+              });
+}
+
+/**
+ * Advances part of a set of bodies by one time step.
+ *
+ * @param bodies Bodies to advance
+ * @param dt Time step
+ * @param begin Index of first body, must be even
+ * @param end Index after the last body
+ */
+void RigidBodyIntegrator::stepRange(RigidBodySet &bodies, const double dt,
+                                    const size_t begin, const size_t end) const
+{
+  double *px = bodies.positions().x();
+  double *py = bodies.positions().y();
+  double *pz = bodies.positions().z();
+  double *vx = bodies.velocities().x();
+  double *vy = bodies.velocities().y();
+  double *vz = bodies.velocities().z();
+  const double *wx = bodies.angularVelocities().x();
+  const double *wy = bodies.angularVelocities().y();
+  const double *wz = bodies.angularVelocities().z();
+  double *qw = bodies.orientation(0);
+  double *qi = bodies.orientation(1);
+  double *qj = bodies.orientation(2);
+  double *qk = bodies.orientation(3);
+
+  const double gx = m_gravity.getX() * dt;
+  const double gy = m_gravity.getY() * dt;
+  const double gz = m_gravity.getZ() * dt;
+  const double h = 0.5 * dt;
+
+  size_t n = begin;
+#ifdef __SSE2__
+  if (useSimdKernels())
+  {
+    const __m128d vgx = _mm_set1_pd(gx);
+    const __m128d vgy = _mm_set1_pd(gy);
+    const __m128d vgz = _mm_set1_pd(gz);
+    const __m128d vdt = _mm_set1_pd(dt);
+    const __m128d vh = _mm_set1_pd(h);
+    const __m128d one = _mm_set1_pd(1.0);
+
+    for (; n + 2 <= end; n += 2)
+    {
+      /* Linear */
+      const __m128d nvx = _mm_add_pd(_mm_load_pd(vx + n), vgx);
+      const __m128d nvy = _mm_add_pd(_mm_load_pd(vy + n), vgy);
+      const __m128d nvz = _mm_add_pd(_mm_load_pd(vz + n), vgz);
+      _mm_store_pd(vx + n, nvx);
+      _mm_store_pd(vy + n, nvy);
+      _mm_store_pd(vz + n, nvz);
+      _mm_store_pd(px + n, _mm_add_pd(_mm_load_pd(px + n), _mm_mul_pd(nvx, vdt)));
+      _mm_store_pd(py + n, _mm_add_pd(_mm_load_pd(py + n), _mm_mul_pd(nvy, vdt)));
+      _mm_store_pd(pz + n, _mm_add_pd(_mm_load_pd(pz + n), _mm_mul_pd(nvz, vdt)));
+
+      /* Angular */
+      const __m128d x = _mm_mul_pd(_mm_load_pd(wx + n), vh);
+      const __m128d y = _mm_mul_pd(_mm_load_pd(wy + n), vh);
+      const __m128d z = _mm_mul_pd(_mm_load_pd(wz + n), vh);
+      const __m128d w = _mm_loadu_pd(qw + n);
+      const __m128d i = _mm_loadu_pd(qi + n);
+      const __m128d j = _mm_loadu_pd(qj + n);
+      const __m128d k = _mm_loadu_pd(qk + n);
+
+      __m128d dw = _mm_mul_pd(x, i);
+      dw = _mm_add_pd(dw, _mm_mul_pd(y, j));
+      dw = _mm_add_pd(dw, _mm_mul_pd(z, k));
+      __m128d nw = _mm_sub_pd(w, dw);
+      __m128d ni = _mm_add_pd(
+          i, _mm_add_pd(_mm_mul_pd(w, x),
+                        _mm_sub_pd(_mm_mul_pd(y, k), _mm_mul_pd(z, j))));
+      __m128d nj = _mm_add_pd(
+          j, _mm_add_pd(_mm_mul_pd(w, y),
+                        _mm_sub_pd(_mm_mul_pd(z, i), _mm_mul_pd(x, k))));
+      __m128d nk = _mm_add_pd(
+          k, _mm_add_pd(_mm_mul_pd(w, z),
+                        _mm_sub_pd(_mm_mul_pd(x, j), _mm_mul_pd(y, i))));
+
+      __m128d m = _mm_mul_pd(nw, nw);
+      m = _mm_add_pd(m, _mm_mul_pd(ni, ni));
+      m = _mm_add_pd(m, _mm_mul_pd(nj, nj));
+      m = _mm_add_pd(m, _mm_mul_pd(nk, nk));
+      const __m128d s = _mm_div_pd(one, _mm_sqrt_pd(m));
+
+      _mm_storeu_pd(qw + n, _mm_mul_pd(nw, s));
+      _mm_storeu_pd(qi + n, _mm_mul_pd(ni, s));
+      _mm_storeu_pd(qj + n, _mm_mul_pd(nj, s));
+      _mm_storeu_pd(qk + n, _mm_mul_pd(nk, s));
+    }
+  }
+#endif
+  for (; n < end; n++)
+  {
+    vx[n] += gx;
+    vy[n] += gy;
+    vz[n] += gz;
+    px[n] += vx[n] * dt;
+    py[n] += vy[n] * dt;
+    pz[n] += vz[n] * dt;
+
+    const double x = wx[n] * h;
+    const double y = wy[n] * h;
+    const double z = wz[n] * h;
+    const double w = qw[n];
+    const double i = qi[n];
+    const double j = qj[n];
+    const double k = qk[n];
+
+    const double nw = w - (x * i + y * j + z * k);
+    const double ni = i + w * x + (y * k - z * j);
+    const double nj = j + w * y + (z * i - x * k);
+    const double nk = k + w * z + (x * j - y * i);
+
+    const double s = 1.0 / sqrt(nw * nw + ni * ni + nj * nj + nk * nk);
+    qw[n] = nw * s;
+    qi[n] = ni * s;
+    qj[n] = nj * s;
+    qk[n] = nk * s;
+  }
+}
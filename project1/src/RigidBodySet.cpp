@@ -0,0 +1,295 @@
+#include "RigidBodySet.h"
+
+#include <stdexcept>
+#include "Quaternion.h"
+#include "Vector3DStack.h"
+
+/*
+ * Optimisation notes
+ *
+ * Body state is stored as a structure of arrays so the integrator can load
+ * the same component of several bodies into one SIMD register. Per body
+ * accessors are provided for setup and inspection, bulk updates should use
+ * the array accessors.
+ */
+
+/**
+ * Construct an empty set of bodies.
+ */
+RigidBodySet::RigidBodySet()
+{
+}
+
+/**
+ * Construct a set of bodies at the origin, at rest and with no rotation.
+ *
+ * @param size Number of bodies
+ */
+RigidBodySet::RigidBodySet(const size_t size)
+{
+  resize(size);
+}
+
+/**
+ * Destructor
+ */
+RigidBodySet::~RigidBodySet()
+{
+}
+
+/**
+ * Returns the number of bodies.
+ *
+ * @return Number of bodies
+ */
+size_t RigidBodySet::size() const
+{
+  return m_positions.size();
+}
+
+/**
+ * Changes the number of bodies.
+ *
+ * Existing bodies are kept, new bodies are at the origin, at rest and with no
+ * rotation.
+ *
+ * @param size New number of bodies
+ */
+void RigidBodySet::resize(const size_t size)
+{
+  m_positions.resize(size);
+  m_velocities.resize(size);
+  m_angularVelocities.resize(size);
+
+  m_orientation[0].resize(size, 1.0);
+  for (int c = 1; c < 4; c++)
+    m_orientation[c].resize(size, 0.0);
+}
+
+/**
+ * Adds a body to the end of the set.
+ *
+ * @param position Position
+ * @param velocity Linear velocity
+ * @param orientation Orientation, normalised if not of unit length
+ * @param angularVelocity Angular velocity in radians per unit time, in world
+ *                        space
+ * @return Index of the new body
+ */
+size_t RigidBodySet::addBody(const Vector3DStack &position,
+                             const Vector3DStack &velocity,
+                             const Quaternion &orientation,
+                             const Vector3DStack &angularVelocity)
+{
+  const size_t index = size();
+  resize(index + 1);
+
+  setPosition(index, position);
+  setVelocity(index, velocity);
+  setOrientation(index, orientation);
+  setAngularVelocity(index, angularVelocity);
+
+  return index;
+}
+
+/**
+ * Returns the position of a body.
+ *
+ * @param index Body index
+ * @return Position
+ */
+Vector3DStack RigidBodySet::getPosition(const size_t index) const
+{
+  return m_positions.get(index);
+}
+
+/**
+ * Sets the position of a body.
+ *
+ * @param index Body index
+ * @param position Position
+ */
+void RigidBodySet::setPosition(const size_t index,
+                               const Vector3DStack &position)
+{
+  m_positions.set(index, position);
+}
+
+/**
+ * Returns the linear velocity of a body.
+ *
+ * @param index Body index
+ * @return Velocity
+ */
+Vector3DStack RigidBodySet::getVelocity(const size_t index) const
+{
+  return m_velocities.get(index);
+}
+
+/**
+ * Sets the linear velocity of a body.
+ *
+ * @param index Body index
+ * @param velocity Velocity
+ */
+void RigidBodySet::setVelocity(const size_t index,
+                               const Vector3DStack &velocity)
+{
+  m_velocities.set(index, velocity);
+}
+
+/**
+ * Returns the orientation of a body.
+ *
+ * @param index Body index
+ * @return Orientation
+ */
+Quaternion RigidBodySet::getOrientation(const size_t index) const
+{
+  checkIndex(index);
+  return Quaternion(m_orientation[0][index], m_orientation[1][index],
+                    m_orientation[2][index], m_orientation[3][index]);
+}
+
+/**
+ * Sets the orientation of a body.
+ *
+ * @param index Body index
+ * @param orientation Orientation, normalised if not of unit length
+ */
+void RigidBodySet::setOrientation(const size_t index,
+                                  const Quaternion &orientation)
+{
+  checkIndex(index);
+  const Quaternion q =
+      orientation.isUnit() ? orientation : orientation.getUnitQuaternion();
+  m_orientation[0][index] = q.getReal();
+  m_orientation[1][index] = q.getI();
+  m_orientation[2][index] = q.getJ();
+  m_orientation[3][index] = q.getK();
+}
+
+/**
+ * Returns the angular velocity of a body.
+ *
+ * @param index Body index
+ * @return Angular velocity
+ */
+Vector3DStack RigidBodySet::getAngularVelocity(const size_t index) const
+{
+  return m_angularVelocities.get(index);
+}
+
+/**
+ * Sets the angular velocity of a body.
+ *
+ * @param index Body index
+ * @param angularVelocity Angular velocity in radians per unit time, in world
+ *                        space
+ */
+void RigidBodySet::setAngularVelocity(const size_t index,
+                                      const Vector3DStack &angularVelocity)
+{
+  m_angularVelocities.set(index, angularVelocity);
+}
+
+/**
+ * Returns the positions of all bodies.
+ *
+ * @return Positions
+ */
+Vector3DArray &RigidBodySet::positions()
+{
+  return m_positions;
+}
+
+/**
+ * Returns the linear velocities of all bodies.
+ *
+ * @return Velocities
+ */
+Vector3DArray &RigidBodySet::velocities()
+{
+  return m_velocities;
+}
+
+/**
+ * Returns the angular velocities of all bodies.
+ *
+ * @return Angular velocities
+ */
+Vector3DArray &RigidBodySet::angularVelocities()
+{
+  return m_angularVelocities;
+}
+
+/**
+ * Returns the positions of all bodies.
+ *
+ * @return Positions
+ */
+const Vector3DArray &RigidBodySet::positions() const
+{
+  return m_positions;
+}
+
+/**
+ * Returns the linear velocities of all bodies.
+ *
+ * @return Velocities
+ */
+const Vector3DArray &RigidBodySet::velocities() const
+{
+  return m_velocities;
+}
+
+/**
+ * Returns the angular velocities of all bodies.
+ *
+ * @return Angular velocities
+ */
+const Vector3DArray &RigidBodySet::angularVelocities() const
+{
+  return m_angularVelocities;
+}
+
+/**
+ * Returns one component of the orientations of all bodies.
+ *
+ * Orientations must be left of unit length.
+ *
+ * @param component Component index (0 = w, 1 = i, 2 = j, 3 = k)
+ * @return Pointer to the component of each body
+ */
+double *RigidBodySet::orientation(const int component)
+{
+  if (component < 0 || component > 3)
+    throw std::runtime_error("Quaternion index out of range");
+
+  return m_orientation[component].data();
+}
+
+/**
+ * Returns one component of the orientations of all bodies.
+ *
+ * @param component Component index (0 = w, 1 = i, 2 = j, 3 = k)
+ * @return Pointer to the component of each body
+ */
+const double *RigidBodySet::orientation(const int component) const
+{
+  if (component < 0 || component > 3)
+    throw std::runtime_error("Quaternion index out of range");
+
+  return m_orientation[component].data();
+}
+
+/**
+ * Checks that a body index is valid.
+ *
+ * @param index Body index
+ */
+void RigidBodySet::checkIndex(const size_t index) const
+{
+  if (index >= size())
+    throw std::runtime_error("RigidBodySet index out of range");
+}
@@ -0,0 +1,335 @@
+#include "RotationMatrix.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include "Parallel.h"
+#include "Quaternion.h"
+#include "Simd.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+/*
+ * Optimisation notes
+ *
+ * Converting a quaternion to a matrix costs about the same as rotating a
+ * single vector, after which each vector costs nine multiplies and six adds
+ * with no dependency on the quaternion, so it pays off for anything more than
+ * a handful of vectors sharing an orientation.
+ *
+ * The matrix is stored row major. The SoA kernel broadcasts each element into
+ * a SIMD register once and, through SimdOps<T>, processes two double or four
+ * float vectors per iteration.
+ */
+
+/* Fewest vectors worth giving to a thread in the threaded apply */
+static const size_t MIN_THREAD_VECTORS = 1 << 16;
+
+/* Threaded chunks are a multiple of this many vectors, so each starts on a
+ * cache line in all three component arrays for float as well as double */
+static const size_t CHUNK_ALIGNMENT = 16;
+
+/**
+ * Construct an identity matrix.
+ */
+template <typename T> RotationMatrixT<T>::RotationMatrixT()
+{
+  for (int n = 0; n < 9; n++)
+    m_m[n] = (n % 4 == 0) ? 1 : 0;
+}
+
+/**
+ * Construct the matrix performing the same rotation as a quaternion.
+ *
+ * The quaternion is normalised first if it is not of unit length. As with
+ * Quaternion::rotateVector(), a zero quaternion gives a zero matrix.
+ *
+ * @param q Quaternion defining the rotation
+ */
+template <typename T>
+RotationMatrixT<T>::RotationMatrixT(const QuaternionT<T> &q)
+{
+  if (q.magnitude() < std::numeric_limits<T>::epsilon())
+  {
+    for (int n = 0; n < 9; n++)
+      m_m[n] = 0;
+    return;
+  }
+
+  const QuaternionT<T> u = q.isUnit() ? q : q.getUnitQuaternion();
+  const T w = u.getReal();
+  const T i = u.getI();
+  const T j = u.getJ();
+  const T k = u.getK();
+
+  m_m[0] = 1 - 2 * (j * j + k * k);
+  m_m[1] = 2 * (i * j - w * k);
+  m_m[2] = 2 * (i * k + w * j);
+
+  m_m[3] = 2 * (i * j + w * k);
+  m_m[4] = 1 - 2 * (i * i + k * k);
+  m_m[5] = 2 * (j * k - w * i);
+
+  m_m[6] = 2 * (i * k - w * j);
+  m_m[7] = 2 * (j * k + w * i);
+  m_m[8] = 1 - 2 * (i * i + j * j);
+}
+
+/**
+ * Construct a matrix using the values of another.
+ *
+ * @param other Matrix from which to take values
+ */
+template <typename T>
+RotationMatrixT<T>::RotationMatrixT(const RotationMatrixT &other)
+{
+  operator=(other);
+}
+
+/**
+ * Destructor
+ */
+template <typename T> RotationMatrixT<T>::~RotationMatrixT()
+{
+}
+
+/**
+ * Assign this matrix the values of another.
+ *
+ * @param rhs Matrix from which to take values
+ */
+template <typename T>
+void RotationMatrixT<T>::operator=(const RotationMatrixT &rhs)
+{
+  for (int n = 0; n < 9; n++)
+    m_m[n] = rhs.m_m[n];
+}
+
+/**
+ * Check for equality between this matrix and another.
+ *
+ * @param rhs Other matrix to compare to
+ * @return True if values are equal
+ */
+template <typename T>
+bool RotationMatrixT<T>::operator==(const RotationMatrixT &rhs) const
+{
+  for (int n = 0; n < 9; n++)
+  {
+    if (m_m[n] != rhs.m_m[n])
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Check for inequality between this matrix and another.
+ *
+ * @param rhs Other matrix to compare to
+ * @return True if values are not equal
+ */
+template <typename T>
+bool RotationMatrixT<T>::operator!=(const RotationMatrixT &rhs) const
+{
+  return !operator==(rhs);
+}
+
+/**
+ * Return an element of the matrix.
+ *
+ * @param row Row index
+ * @param column Column index
+ * @return Matrix element
+ */
+template <typename T>
+T RotationMatrixT<T>::operator()(const int row, const int column) const
+{
+  if (row < 0 || row > 2 || column < 0 || column > 2)
+    throw std::runtime_error("RotationMatrix index out of range");
+
+  return m_m[row * 3 + column];
+}
+
+/**
+ * Rotates a vector.
+ *
+ * @param rhs Vector to rotate
+ * @return Rotated vector
+ */
+template <typename T>
+Vector3DStackT<T>
+RotationMatrixT<T>::operator*(const Vector3DStackT<T> &rhs) const
+{
+  const T x = rhs.getX();
+  const T y = rhs.getY();
+  const T z = rhs.getZ();
+
+  return Vector3DStackT<T>(m_m[0] * x + m_m[1] * y + m_m[2] * z,
+                           m_m[3] * x + m_m[4] * y + m_m[5] * z,
+                           m_m[6] * x + m_m[7] * y + m_m[8] * z);
+}
+
+/**
+ * Rotates an array of vectors.
+ *
+ * in and out may be the same array.
+ *
+ * @param in Vectors to rotate
+ * @param out Array to store rotated vectors in
+ * @param count Number of vectors
+ */
+template <typename T>
+void RotationMatrixT<T>::apply(const Vector3DStackT<T> *in,
+                               Vector3DStackT<T> *out,
+                               const size_t count) const
+{
+  for (size_t n = 0; n < count; n++)
+    out[n] = operator*(in[n]);
+}
+
+/**
+ * Rotates an array of vectors stored as packed x, y, z triples, e.g. a
+ * mapped point file.
+ *
+ * in and out may be the same array.
+ *
+ * @param in Array of 3 * count values to rotate
+ * @param out Array of 3 * count values to store rotated vectors in
+ * @param count Number of vectors
+ */
+template <typename T>
+void RotationMatrixT<T>::apply(const T *in, T *out, const size_t count) const
+{
+  for (size_t n = 0; n < 3 * count; n += 3)
+  {
+    const T x = in[n];
+    const T y = in[n + 1];
+    const T z = in[n + 2];
+    out[n] = m_m[0] * x + m_m[1] * y + m_m[2] * z;
+    out[n + 1] = m_m[3] * x + m_m[4] * y + m_m[5] * z;
+    out[n + 2] = m_m[6] * x + m_m[7] * y + m_m[8] * z;
+  }
+}
+
+/**
+ * Rotates an array of vectors.
+ *
+ * @param in Vectors to rotate
+ * @param out Array to store rotated vectors in, may be in
+ */
+template <typename T>
+void RotationMatrixT<T>::apply(const Vector3DArrayT<T> &in,
+                               Vector3DArrayT<T> &out) const
+{
+  out.resize(in.size());
+  applyRange(in, out, 0, in.size());
+}
+
+/**
+ * Rotates an array of vectors, splitting the array between several threads.
+ *
+ * Threads are only used when each would have a reasonable amount of work,
+ * small arrays are rotated on the calling thread.
+ *
+ * @param in Vectors to rotate
+ * @param out Array to store rotated vectors in, may be in
+ * @param numThreads Maximum number of threads, zero to use one per core
+ */
+template <typename T>
+void RotationMatrixT<T>::apply(const Vector3DArrayT<T> &in,
+                               Vector3DArrayT<T> &out,
+                               unsigned int numThreads) const
+{
+  out.resize(in.size());
+  const size_t size = in.size();
+
+  parallelFor(0, size, MIN_THREAD_VECTORS, CHUNK_ALIGNMENT,
+              resolveNumThreads(numThreads),
+              [&](size_t, size_t begin, size_t end) {
+                applyRange(in, out, begin, end);
+              });
+}
+
+/**
+ * Rotates part of an array of vectors.
+ *
+ * out must already be the size of in.
+ *
+ * @param in Vectors to rotate
+ * @param out Array to store rotated vectors in
+ * @param begin Index of first vector, must be a multiple of 4
+ * @param end Index after the last vector
+ */
+template <typename T>
+void RotationMatrixT<T>::applyRange(const Vector3DArrayT<T> &in,
+                                    Vector3DArrayT<T> &out, const size_t begin,
+                                    const size_t end) const
+{
+  const T *ix = in.x(), *iy = in.y(), *iz = in.z();
+  T *ox = out.x(), *oy = out.y(), *oz = out.z();
+
+  size_t i = begin;
+#ifdef __SSE2__
+  if (useSimdKernels())
+  {
+    typedef SimdOps<T> S;
+    typename S::Vec m[9];
+    for (int n = 0; n < 9; n++)
+      m[n] = S::set1(m_m[n]);
+
+    for (; i + S::WIDTH <= end; i += S::WIDTH)
+    {
+      const typename S::Vec x = S::load(ix + i);
+      const typename S::Vec y = S::load(iy + i);
+      const typename S::Vec z = S::load(iz + i);
+
+      typename S::Vec r = S::mul(m[0], x);
+      r = S::add(r, S::mul(m[1], y));
+      S::store(ox + i, S::add(r, S::mul(m[2], z)));
+
+      r = S::mul(m[3], x);
+      r = S::add(r, S::mul(m[4], y));
+      S::store(oy + i, S::add(r, S::mul(m[5], z)));
+
+      r = S::mul(m[6], x);
+      r = S::add(r, S::mul(m[7], y));
+      S::store(oz + i, S::add(r, S::mul(m[8], z)));
+    }
+  }
+#endif
+  for (; i < end; i++)
+  {
+    const T x = ix[i];
+    const T y = iy[i];
+    const T z = iz[i];
+    ox[i] = m_m[0] * x + m_m[1] * y + m_m[2] * z;
+    oy[i] = m_m[3] * x + m_m[4] * y + m_m[5] * z;
+    oz[i] = m_m[6] * x + m_m[7] * y + m_m[8] * z;
+  }
+}
+
+/**
+ * Outputs the elements of a matrix to a stream in the format
+ * "[[a,b,c],[d,e,f],[g,h,i]]".
+ *
+ * @param stream The stream to output to
+ * @param m The matrix to output
+ */
+template <typename T>
+std::ostream &operator<<(std::ostream &stream, const RotationMatrixT<T> &m)
+{
+  stream << "[";
+  for (int row = 0; row < 3; row++)
+  {
+    stream << (row > 0 ? ",[" : "[") << m(row, 0) << "," << m(row, 1) << ","
+           << m(row, 2) << "]";
+  }
+  stream << "]";
+  return stream;
+}
+
+template class RotationMatrixT<float>;
+template class RotationMatrixT<double>;
+
+template std::ostream &operator<<(std::ostream &, const RotationMatrixF &);
+template std::ostream &operator<<(std::ostream &, const RotationMatrix &);
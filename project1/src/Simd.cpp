@@ -0,0 +1,50 @@
+#include "Simd.h"
+
+#include <atomic>
+
+/* Read by every batch kernel call, possibly from several threads, so
+ * atomic; relaxed is enough as nothing else is published through it */
+#ifdef __SSE2__
+static std::atomic<bool> g_useSimd(true);
+#else
+static std::atomic<bool> g_useSimd(false);
+#endif
+
+/**
+ * Checks if SIMD kernels were compiled in.
+ *
+ * @return True if SIMD kernels are available
+ */
+bool simdKernelsAvailable()
+{
+#ifdef __SSE2__
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Selects between the SIMD and scalar kernels, for testing and benchmarking.
+ *
+ * Has no effect if SIMD kernels are not available. Safe to call while other
+ * threads are using the kernels, though calls already running may use either
+ * set of kernels.
+ *
+ * @param useSimd True to use SIMD kernels
+ */
+void setUseSimdKernels(const bool useSimd)
+{
+  g_useSimd.store(useSimd && simdKernelsAvailable(),
+                  std::memory_order_relaxed);
+}
+
+/**
+ * Checks if the SIMD kernels are in use.
+ *
+ * @return True if SIMD kernels are used
+ */
+bool useSimdKernels()
+{
+  return g_useSimd.load(std::memory_order_relaxed);
+}
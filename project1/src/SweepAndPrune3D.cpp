@@ -0,0 +1,215 @@
+#include "SweepAndPrune3D.h"
+
+#include <algorithm>
+
+/*
+ * Optimisation notes
+ *
+ * Colliders are sorted by the minimum of their bounding box along the axis on
+ * which their centres are most spread out, then swept in that order: each
+ * collider is only compared against the following colliders whose minimum is
+ * not beyond its maximum. Choosing the axis with the largest variance keeps
+ * the number of these overlaps on the sweep axis as small as possible.
+ *
+ * The sorted order is kept between calls. Colliders that move a little each
+ * tick leave it nearly sorted, so it is repaired with an insertion sort in
+ * close to linear time; if that finds too much out of order, or the axis
+ * changes, the order is rebuilt with a full sort instead. The axis only
+ * changes when another is clearly better, so that spreads that are close to
+ * equal on two axes do not cause a full sort every tick.
+ *
+ * Before sweeping, the bounds of every collider are copied into arrays in
+ * sorted order so the sweep reads memory sequentially rather than jumping
+ * around the ColliderSet.
+ *
+ * All working arrays are members that keep their capacity, so once they have
+ * grown to fit the set no allocation is done other than for new pairs.
+ */
+
+/* Average number of insertion sort moves per collider before a full sort is
+ * used instead */
+static const size_t MAX_SORT_MOVES_PER_COLLIDER = 8;
+
+/* Factor by which the variance on another axis must exceed that on the
+ * current sweep axis for the sweep axis to change */
+static const double AXIS_CHANGE_RATIO = 1.25;
+
+/**
+ * Construct a sweep and prune broad phase.
+ */
+SweepAndPrune3D::SweepAndPrune3D()
+    : m_axis(-1)
+{
+}
+
+/**
+ * Destructor
+ */
+SweepAndPrune3D::~SweepAndPrune3D()
+{
+}
+
+/**
+ * Returns the axis used by the last call to findPairs().
+ *
+ * @return 0, 1 or 2 for x, y or z, or -1 if findPairs() has not been called
+ */
+int SweepAndPrune3D::getAxis() const
+{
+  return m_axis;
+}
+
+/**
+ * Finds all pairs of colliders whose bounding boxes intersect.
+ *
+ * The result should be passed to Collision3D::filterPairs() to remove pairs
+ * whose shapes do not intersect.
+ *
+ * @param colliders Colliders
+ * @param pairs Filled with candidate pairs, lower index first
+ */
+void SweepAndPrune3D::findPairs(const ColliderSet &colliders,
+                                std::vector<ColliderPair> &pairs)
+{
+  pairs.clear();
+  sortOrder(colliders);
+
+  const size_t count = colliders.size();
+  const double *c[] = {colliders.centres().x(), colliders.centres().y(),
+                       colliders.centres().z()};
+  const double *h[] = {colliders.halfExtents().x(),
+                       colliders.halfExtents().y(),
+                       colliders.halfExtents().z()};
+
+  /* Sweep axis first so the sweep loop reads m_bounds[0] and [1] */
+  const int axes[] = {m_axis, (m_axis + 1) % 3, (m_axis + 2) % 3};
+  for (int a = 0; a < 3; a++)
+  {
+    std::vector<double> &lo = m_bounds[2 * a];
+    std::vector<double> &hi = m_bounds[2 * a + 1];
+    lo.resize(count);
+    hi.resize(count);
+    const double *ca = c[axes[a]];
+    const double *ha = h[axes[a]];
+    for (size_t n = 0; n < count; n++)
+    {
+      const size_t index = m_order[n];
+      lo[n] = ca[index] - ha[index];
+      hi[n] = ca[index] + ha[index];
+    }
+  }
+
+  if (count == 0)
+    return;
+
+  const double *min0 = &m_bounds[0][0];
+  const double *max0 = &m_bounds[1][0];
+  const double *min1 = &m_bounds[2][0];
+  const double *max1 = &m_bounds[3][0];
+  const double *min2 = &m_bounds[4][0];
+  const double *max2 = &m_bounds[5][0];
+
+  for (size_t i = 0; i < count; i++)
+  {
+    const double end = max0[i];
+    for (size_t j = i + 1; j < count && min0[j] <= end; j++)
+    {
+      if (min1[j] <= max1[i] && min1[i] <= max1[j] && min2[j] <= max2[i] &&
+          min2[i] <= max2[j])
+      {
+        const size_t a = m_order[i];
+        const size_t b = m_order[j];
+        pairs.push_back(a < b ? ColliderPair(a, b) : ColliderPair(b, a));
+      }
+    }
+  }
+}
+
+/**
+ * Chooses the sweep axis and brings m_order up to date with the current
+ * collider positions.
+ *
+ * @param colliders Colliders
+ */
+void SweepAndPrune3D::sortOrder(const ColliderSet &colliders)
+{
+  const size_t count = colliders.size();
+  const double *c[] = {colliders.centres().x(), colliders.centres().y(),
+                       colliders.centres().z()};
+
+  /* Axis with the largest variance of centres */
+  double variance[3];
+  int axis = 0;
+  for (int a = 0; a < 3; a++)
+  {
+    double sum = 0.0;
+    double sumSq = 0.0;
+    for (size_t n = 0; n < count; n++)
+    {
+      sum += c[a][n];
+      sumSq += c[a][n] * c[a][n];
+    }
+    const double mean = count > 0 ? sum / count : 0.0;
+    variance[a] = count > 0 ? sumSq / count - mean * mean : 0.0;
+    if (variance[a] > variance[axis])
+      axis = a;
+  }
+
+  /* Only change axis, and so pay for a full sort, for a clear improvement */
+  if (m_axis >= 0 && variance[axis] <= AXIS_CHANGE_RATIO * variance[m_axis])
+    axis = m_axis;
+
+  const double *centre = c[axis];
+  const double *half = colliders.halfExtents().x();
+  if (axis == 1)
+    half = colliders.halfExtents().y();
+  else if (axis == 2)
+    half = colliders.halfExtents().z();
+
+  m_keys.resize(count);
+  for (size_t n = 0; n < count; n++)
+    m_keys[n] = centre[n] - half[n];
+
+  bool sorted = false;
+
+  if (axis == m_axis && m_order.size() == count)
+  {
+    /* Repair the previous order with an insertion sort */
+    const size_t maxMoves = MAX_SORT_MOVES_PER_COLLIDER * count;
+    size_t moves = 0;
+    sorted = true;
+
+    for (size_t i = 1; i < count && sorted; i++)
+    {
+      const size_t index = m_order[i];
+      const double key = m_keys[index];
+      size_t j = i;
+      while (j > 0 && m_keys[m_order[j - 1]] > key)
+      {
+        m_order[j] = m_order[j - 1];
+        j--;
+        if (++moves > maxMoves)
+        {
+          sorted = false;
+          break;
+        }
+      }
+      m_order[j] = index;
+    }
+  }
+
+  if (!sorted)
+  {
+    m_order.resize(count);
+    for (size_t n = 0; n < count; n++)
+      m_order[n] = n;
+
+    const std::vector<double> &keys = m_keys;
+    std::sort(m_order.begin(), m_order.end(),
+              [&keys](const size_t a, const size_t b) {
+                return keys[a] < keys[b];
+              });
+  }
+
+  m_axis = axis;
+}
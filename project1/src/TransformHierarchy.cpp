@@ -0,0 +1,484 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <limits>
+#include <stdexcept>
+#include "DualQuaternion.h"
+#include "Parallel.h"
+#include "Quaternion.h"
+#include "Vector3DStack.h"
+
+/*
+ * Each node has a local rotation and translation relative to its parent; its
+ * world transform rotates by the world rotation of the parent and then
+ * translates by the parent world translation, i.e. world = parent * local.
+ *
+ * Optimisation notes
+ *
+ * Transforms are kept in flat arrays rather than node objects, with the
+ * rotation and translation of a node packed into 8 doubles so that reading
+ * the world transform of a parent touches a single 64 byte block. The
+ * arrays are ordered by depth (a breadth first order) rather than by node
+ * index: each level is then a contiguous run that is streamed through, and
+ * the parents it reads all lie in the run before it. The order is rebuilt
+ * by the first update() after nodes are added, moving the transforms once;
+ * nodes added level by level are not moved at all.
+ *
+ * Every node of a level only reads world transforms of the level above, so
+ * a level can be split across threads with no locking; small levels are
+ * done on the calling thread.
+ *
+ * Setting a local transform only marks the node as dirty. During update() a
+ * node is recomputed if it or its parent is dirty, and is then marked dirty
+ * itself, so the flag spreads down the level order to exactly the subtrees
+ * that changed. If nothing was set since the last update() it returns at
+ * once. Checking a flag is much cheaper than the quaternion product and
+ * rotation it avoids, so a frame in which few nodes move costs little more
+ * than a pass over the flags and parent indices.
+ */
+
+/* Parent of a root node */
+const size_t TransformHierarchy::NO_PARENT = std::numeric_limits<size_t>::max();
+
+/* Parent of a root node as stored */
+static const uint32_t ROOT = std::numeric_limits<uint32_t>::max();
+
+/* Fewest nodes of a level worth giving to a thread */
+static const size_t MIN_THREAD_NODES = 1 << 14;
+
+/**
+ * Construct an empty hierarchy.
+ *
+ * @param numThreads Maximum number of threads, zero to use one per core
+ */
+TransformHierarchy::TransformHierarchy(const unsigned int numThreads)
+    : m_anyDirty(false)
+    , m_numLevels(0)
+    , m_levelsValid(true)
+{
+  setNumThreads(numThreads);
+}
+
+/**
+ * Destructor
+ */
+TransformHierarchy::~TransformHierarchy()
+{
+}
+
+/**
+ * Sets the maximum number of threads used by update().
+ *
+ * @param numThreads Maximum number of threads, zero to use one per core
+ */
+void TransformHierarchy::setNumThreads(const unsigned int numThreads)
+{
+  m_numThreads = resolveNumThreads(numThreads);
+}
+
+/**
+ * Returns the maximum number of threads used by update().
+ *
+ * @return Number of threads
+ */
+unsigned int TransformHierarchy::getNumThreads() const
+{
+  return m_numThreads;
+}
+
+/**
+ * Returns the number of nodes.
+ *
+ * @return Number of nodes
+ */
+size_t TransformHierarchy::size() const
+{
+  return m_parents.size();
+}
+
+/**
+ * Allocates storage for a number of nodes, so that adding them does not
+ * reallocate.
+ *
+ * @param size Number of nodes
+ */
+void TransformHierarchy::reserve(const size_t size)
+{
+  m_parents.reserve(size);
+  m_depths.reserve(size);
+  m_slots.reserve(size);
+  m_slotParents.reserve(size);
+  m_local.reserve(8 * size);
+  m_world.reserve(8 * size);
+  m_dirty.reserve(size);
+}
+
+/**
+ * Removes all nodes.
+ */
+void TransformHierarchy::clear()
+{
+  m_parents.clear();
+  m_depths.clear();
+  m_slots.clear();
+  m_slotParents.clear();
+  m_local.clear();
+  m_world.clear();
+  m_dirty.clear();
+  m_anyDirty = false;
+  m_levelOffsets.clear();
+  m_numLevels = 0;
+  m_levelsValid = true;
+}
+
+/**
+ * Adds a node. Its world transform is valid after the next update().
+ *
+ * @param parent Index of the parent node, which must already have been
+ *               added, or NO_PARENT for a root
+ * @param rotation Rotation relative to the parent, normalised if not of unit
+ *                 length
+ * @param translation Translation relative to the parent
+ * @return Index of the new node
+ */
+size_t TransformHierarchy::addNode(const size_t parent,
+                                   const Quaternion &rotation,
+                                   const Vector3DStack &translation)
+{
+  const size_t index = size();
+  if (parent != NO_PARENT && parent >= index)
+    throw std::runtime_error("Parent must be added before child");
+  if (index >= ROOT)
+    throw std::runtime_error("Too many nodes in TransformHierarchy");
+
+  /* New nodes go in the next slot until the levels are rebuilt */
+  const uint32_t depth = parent == NO_PARENT ? 0 : m_depths[parent] + 1;
+  m_parents.push_back(parent == NO_PARENT ? ROOT : (uint32_t)parent);
+  m_depths.push_back(depth);
+  m_slots.push_back((uint32_t)index);
+  m_slotParents.push_back(parent == NO_PARENT ? ROOT : m_slots[parent]);
+  m_local.resize(8 * (index + 1), 0.0);
+  m_world.resize(8 * (index + 1), 0.0);
+  m_dirty.push_back(1);
+
+  /* Still in level order unless a deeper node has been added */
+  if (depth + 1 < m_numLevels)
+    m_levelsValid = false;
+  m_numLevels = std::max<size_t>(m_numLevels, depth + 1);
+
+  setLocal(index, rotation, translation);
+
+  return index;
+}
+
+/**
+ * Returns the parent of a node.
+ *
+ * @param index Index of node
+ * @return Index of parent, NO_PARENT for a root
+ */
+size_t TransformHierarchy::getParent(const size_t index) const
+{
+  checkIndex(index);
+  return m_parents[index] == ROOT ? NO_PARENT : m_parents[index];
+}
+
+/**
+ * Returns the number of ancestors of a node.
+ *
+ * @param index Index of node
+ * @return Depth, 0 for a root
+ */
+size_t TransformHierarchy::getDepth(const size_t index) const
+{
+  checkIndex(index);
+  return m_depths[index];
+}
+
+/**
+ * Returns the number of levels, one more than the greatest depth.
+ *
+ * @return Number of levels
+ */
+size_t TransformHierarchy::numLevels() const
+{
+  return m_numLevels;
+}
+
+/**
+ * Returns the rotation of a node relative to its parent.
+ *
+ * @param index Index of node
+ * @return Local rotation
+ */
+Quaternion TransformHierarchy::getLocalRotation(const size_t index) const
+{
+  checkIndex(index);
+  const double *t = &m_local[8 * m_slots[index]];
+  return Quaternion(t[0], t[1], t[2], t[3]);
+}
+
+/**
+ * Sets the rotation of a node relative to its parent.
+ *
+ * @param index Index of node
+ * @param rotation Local rotation, normalised if not of unit length
+ */
+void TransformHierarchy::setLocalRotation(const size_t index,
+                                          const Quaternion &rotation)
+{
+  checkIndex(index);
+  if (rotation.magnitude() < DBL_EPSILON)
+    throw std::runtime_error("Zero quaternion rotation");
+
+  const Quaternion q =
+      rotation.isUnit() ? rotation : rotation.getUnitQuaternion();
+  const uint32_t slot = m_slots[index];
+  double *t = &m_local[8 * slot];
+  t[0] = q.getReal();
+  t[1] = q.getI();
+  t[2] = q.getJ();
+  t[3] = q.getK();
+
+  m_dirty[slot] = 1;
+  m_anyDirty = true;
+}
+
+/**
+ * Returns the translation of a node relative to its parent.
+ *
+ * @param index Index of node
+ * @return Local translation
+ */
+Vector3DStack TransformHierarchy::getLocalTranslation(const size_t index) const
+{
+  checkIndex(index);
+  const double *t = &m_local[8 * m_slots[index]];
+  return Vector3DStack(t[4], t[5], t[6]);
+}
+
+/**
+ * Sets the translation of a node relative to its parent.
+ *
+ * @param index Index of node
+ * @param translation Local translation
+ */
+void TransformHierarchy::setLocalTranslation(const size_t index,
+                                             const Vector3DStack &translation)
+{
+  checkIndex(index);
+  const uint32_t slot = m_slots[index];
+  double *t = &m_local[8 * slot];
+  t[4] = translation.getX();
+  t[5] = translation.getY();
+  t[6] = translation.getZ();
+
+  m_dirty[slot] = 1;
+  m_anyDirty = true;
+}
+
+/**
+ * Sets the rotation and translation of a node relative to its parent.
+ *
+ * @param index Index of node
+ * @param rotation Local rotation, normalised if not of unit length
+ * @param translation Local translation
+ */
+void TransformHierarchy::setLocal(const size_t index,
+                                  const Quaternion &rotation,
+                                  const Vector3DStack &translation)
+{
+  setLocalRotation(index, rotation);
+  setLocalTranslation(index, translation);
+}
+
+/**
+ * Checks if the local transform of a node has been set since the last
+ * update(). The world transform of a node is also out of date if any of its
+ * ancestors are dirty.
+ *
+ * @param index Index of node
+ * @return True if dirty
+ */
+bool TransformHierarchy::isDirty(const size_t index) const
+{
+  checkIndex(index);
+  return m_dirty[m_slots[index]] != 0;
+}
+
+/**
+ * Recomputes the world transforms of all dirty nodes and their descendants.
+ */
+void TransformHierarchy::update()
+{
+  if (!m_anyDirty)
+    return;
+
+  if (!m_levelsValid || m_levelOffsets.empty() ||
+      m_levelOffsets.back() != size())
+    buildLevels();
+
+  for (size_t level = 0; level + 1 < m_levelOffsets.size(); level++)
+  {
+    parallelFor(m_levelOffsets[level], m_levelOffsets[level + 1],
+                MIN_THREAD_NODES, 1, m_numThreads,
+                [this](size_t, size_t begin, size_t end) {
+                  updateRange(begin, end);
+                });
+  }
+
+  std::fill(m_dirty.begin(), m_dirty.end(), 0);
+  m_anyDirty = false;
+}
+
+/**
+ * Returns the rotation of a node relative to the world, as of the last
+ * update().
+ *
+ * @param index Index of node
+ * @return World rotation
+ */
+Quaternion TransformHierarchy::getWorldRotation(const size_t index) const
+{
+  checkIndex(index);
+  const double *t = &m_world[8 * m_slots[index]];
+  return Quaternion(t[0], t[1], t[2], t[3]);
+}
+
+/**
+ * Returns the position of a node relative to the world, as of the last
+ * update().
+ *
+ * @param index Index of node
+ * @return World translation
+ */
+Vector3DStack TransformHierarchy::getWorldTranslation(const size_t index) const
+{
+  checkIndex(index);
+  const double *t = &m_world[8 * m_slots[index]];
+  return Vector3DStack(t[4], t[5], t[6]);
+}
+
+/**
+ * Returns the transform from the space of a node to the world, as of the
+ * last update().
+ *
+ * @param index Index of node
+ * @return World transform
+ */
+DualQuaternion TransformHierarchy::getWorldTransform(const size_t index) const
+{
+  return DualQuaternion(getWorldRotation(index), getWorldTranslation(index));
+}
+
+/**
+ * Checks that an index refers to a node.
+ *
+ * @param index Index to check
+ */
+void TransformHierarchy::checkIndex(const size_t index) const
+{
+  if (index >= size())
+    throw std::runtime_error("TransformHierarchy index out of range");
+}
+
+/**
+ * Finds where each level starts and, if nodes have not been added in level
+ * order, moves the transforms so that the slots hold the nodes grouped by
+ * depth, keeping them in the order they were added within each level.
+ */
+void TransformHierarchy::buildLevels()
+{
+  const size_t count = size();
+  const size_t levels = m_numLevels;
+
+  m_levelOffsets.assign(levels + 1, 0);
+  for (size_t n = 0; n < count; n++)
+    m_levelOffsets[m_depths[n] + 1]++;
+  for (size_t level = 0; level < levels; level++)
+    m_levelOffsets[level + 1] += m_levelOffsets[level];
+
+  if (m_levelsValid)
+    return;
+
+  std::vector<size_t> next(m_levelOffsets.begin(), m_levelOffsets.end() - 1);
+  std::vector<uint32_t> slots(count);
+  for (size_t n = 0; n < count; n++)
+    slots[n] = (uint32_t)next[m_depths[n]]++;
+
+  std::vector<double> local(m_local.size());
+  std::vector<double> world(m_world.size());
+  std::vector<unsigned char> dirty(count);
+  for (size_t n = 0; n < count; n++)
+  {
+    const size_t from = m_slots[n];
+    const size_t to = slots[n];
+    std::copy(&m_local[8 * from], &m_local[8 * from] + 8, &local[8 * to]);
+    std::copy(&m_world[8 * from], &m_world[8 * from] + 8, &world[8 * to]);
+    dirty[to] = m_dirty[from];
+    m_slotParents[to] = m_parents[n] == ROOT ? ROOT : slots[m_parents[n]];
+  }
+
+  m_slots.swap(slots);
+  m_local.swap(local);
+  m_world.swap(world);
+  m_dirty.swap(dirty);
+  m_levelsValid = true;
+}
+
+/**
+ * Recomputes the world transforms of dirty nodes within part of a level.
+ *
+ * @param begin First slot
+ * @param end Slot after the last
+ */
+void TransformHierarchy::updateRange(const size_t begin, const size_t end)
+{
+  const double *local = &m_local[0];
+  double *world = &m_world[0];
+  const uint32_t *parents = &m_slotParents[0];
+  unsigned char *dirty = &m_dirty[0];
+
+  for (size_t n = begin; n < end; n++)
+  {
+    const uint32_t p = parents[n];
+    const double *l = local + 8 * n;
+    double *w = world + 8 * n;
+
+    if (p == ROOT)
+    {
+      if (dirty[n])
+        std::copy(l, l + 7, w);
+      continue;
+    }
+
+    if (!(dirty[n] | dirty[p]))
+      continue;
+    dirty[n] = 1;
+
+    const double *parent = world + 8 * p;
+    const double pw = parent[0];
+    const double pi = parent[1];
+    const double pj = parent[2];
+    const double pk = parent[3];
+
+    /* Rotation, parent * local */
+    w[0] = pw * l[0] - pi * l[1] - pj * l[2] - pk * l[3];
+    w[1] = pw * l[1] + pi * l[0] + pj * l[3] - pk * l[2];
+    w[2] = pw * l[2] - pi * l[3] + pj * l[0] + pk * l[1];
+    w[3] = pw * l[3] + pi * l[2] - pj * l[1] + pk * l[0];
+
+    /* Translation, parent translation plus local translation rotated by the
+     * parent, using v + 2w(q x v) + 2q x (q x v) */
+    const double x = l[4];
+    const double y = l[5];
+    const double z = l[6];
+    const double tx = 2.0 * (pj * z - pk * y);
+    const double ty = 2.0 * (pk * x - pi * z);
+    const double tz = 2.0 * (pi * y - pj * x);
+    w[4] = parent[4] + x + pw * tx + (pj * tz - pk * ty);
+    w[5] = parent[5] + y + pw * ty + (pk * tx - pi * tz);
+    w[6] = parent[6] + z + pw * tz + (pi * ty - pj * tx);
+  }
+}
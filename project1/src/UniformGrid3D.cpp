@@ -0,0 +1,447 @@
+#include "UniformGrid3D.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/*
+ * Optimisation notes
+ *
+ * Every collider is entered into each grid cell its bounding box covers, and
+ * only colliders that share a cell are compared. The cells are bucketed with
+ * counting sorts (count per bucket, prefix sum, scatter) into flat arrays, so
+ * there are no per cell containers and, once the arrays have grown to fit,
+ * no allocation.
+ *
+ * When the occupied cells form a block small enough to index directly each
+ * cell is its own bucket, numbered along x then y then z. Otherwise, such as
+ * for a few colliders far from the rest, cells are hashed into a table sized
+ * to the number of entries and entries from different cells that share a
+ * bucket are told apart by their cell keys.
+ *
+ * Colliders are usually stored in no spatial order, so the work is not done
+ * in collider order: colliders are first sorted by their minimum cell and
+ * their bounds copied into arrays in that order. Colliders in neighbouring
+ * cells are then close together in memory, which keeps the scatter and the
+ * pair tests in cache for large sets. Only that copy reads the ColliderSet
+ * out of order.
+ *
+ * A pair whose boxes overlap can share several cells, so it is only reported
+ * from the cell holding the minimum corner of the overlap, which needs no set
+ * of reported pairs to remove duplicates.
+ *
+ * The grid works best with cells a little larger than the colliders: much
+ * smaller cells enter each collider many times, much larger cells put many
+ * non overlapping colliders in the same cell. With no cell size set, four
+ * times the mean of the largest half extent of each collider is used.
+ *
+ * A collider covering more than MAX_COLLIDER_CELLS cells, such as a floor or
+ * a wall among small bodies, is not entered into the grid at all, as the
+ * number of entries grows with the cube of its size. Each such collider is
+ * instead tested against every other collider, which costs one bounds test
+ * per collider rather than an entry per covered cell.
+ */
+
+/* Bits per axis in a packed cell, cell coordinates are clamped to fit */
+static const int CELL_BITS = 21;
+static const int32_t CELL_LIMIT = (1 << (CELL_BITS - 1)) - 1;
+static const uint64_t CELL_MASK = (1ULL << CELL_BITS) - 1;
+
+/* Most cells a collider is entered into, larger colliders are tested against
+ * all others instead */
+static const size_t MAX_COLLIDER_CELLS = 64;
+
+/**
+ * Gets the cell coordinate on one axis of a position.
+ *
+ * @param p Position
+ * @param inverseCellSize 1 / cell size
+ * @return Cell coordinate
+ */
+static inline int32_t cellCoordinate(const double p,
+                                     const double inverseCellSize)
+{
+  const double cell = std::floor(p * inverseCellSize);
+  if (!(cell > -CELL_LIMIT))
+    return -CELL_LIMIT;
+  if (cell > CELL_LIMIT)
+    return CELL_LIMIT;
+  return (int32_t)cell;
+}
+
+/**
+ * Packs cell coordinates into one value.
+ *
+ * @param x, y, z Cell coordinates
+ * @return Packed cell
+ */
+static inline uint64_t packCell(const int32_t x, const int32_t y,
+                                const int32_t z)
+{
+  return ((uint64_t)(x + CELL_LIMIT) & CELL_MASK) |
+         (((uint64_t)(y + CELL_LIMIT) & CELL_MASK) << CELL_BITS) |
+         (((uint64_t)(z + CELL_LIMIT) & CELL_MASK) << (2 * CELL_BITS));
+}
+
+/**
+ * Construct a uniform grid broad phase.
+ *
+ * @param cellSize Size of a cell on each axis, 0 to choose one from the
+ *                 colliders on each call to findPairs()
+ */
+UniformGrid3D::UniformGrid3D(const double cellSize)
+    : m_cellSize(0.0)
+    , m_dense(false)
+    , m_numBuckets(0)
+    , m_hashShift(0)
+{
+  setCellSize(cellSize);
+}
+
+/**
+ * Destructor
+ */
+UniformGrid3D::~UniformGrid3D()
+{
+}
+
+/**
+ * Sets the size of a grid cell.
+ *
+ * @param cellSize Size of a cell on each axis, 0 to choose one from the
+ *                 colliders on each call to findPairs()
+ */
+void UniformGrid3D::setCellSize(const double cellSize)
+{
+  if (!(cellSize >= 0.0))
+    throw std::runtime_error("Invalid grid cell size");
+
+  m_cellSize = cellSize;
+}
+
+/**
+ * Returns the size of a grid cell.
+ *
+ * @return Cell size, 0 if chosen from the colliders
+ */
+double UniformGrid3D::getCellSize() const
+{
+  return m_cellSize;
+}
+
+/**
+ * Finds all pairs of colliders whose bounding boxes intersect.
+ *
+ * The result should be passed to Collision3D::filterPairs() to remove pairs
+ * whose shapes do not intersect.
+ *
+ * @param colliders Colliders
+ * @param pairs Filled with candidate pairs, lower index first
+ */
+void UniformGrid3D::findPairs(const ColliderSet &colliders,
+                              std::vector<ColliderPair> &pairs)
+{
+  pairs.clear();
+
+  const size_t count = colliders.size();
+  if (count < 2)
+    return;
+
+  const double cellSize =
+      m_cellSize > 0.0 ? m_cellSize : chooseCellSize(colliders);
+  const double inverseCellSize = 1.0 / cellSize;
+
+  const double *c[] = {colliders.centres().x(), colliders.centres().y(),
+                       colliders.centres().z()};
+  const double *h[] = {colliders.halfExtents().x(),
+                       colliders.halfExtents().y(),
+                       colliders.halfExtents().z()};
+
+  /* Occupied extent and number of entries of the colliders entered into
+   * the grid, picking out the large ones */
+  int32_t cellMax[3];
+  size_t numEntries = 0;
+  size_t numLarge = 0;
+  for (int a = 0; a < 3; a++)
+  {
+    m_cellMin[a] = CELL_LIMIT;
+    cellMax[a] = -CELL_LIMIT;
+  }
+
+  m_isLarge.resize(count);
+  for (size_t n = 0; n < count; n++)
+  {
+    int32_t lo[3], hi[3];
+    size_t cells = 1;
+    for (int a = 0; a < 3; a++)
+    {
+      lo[a] = cellCoordinate(c[a][n] - h[a][n], inverseCellSize);
+      hi[a] = cellCoordinate(c[a][n] + h[a][n], inverseCellSize);
+      cells *= (size_t)(hi[a] - lo[a] + 1);
+    }
+
+    m_isLarge[n] = cells > MAX_COLLIDER_CELLS;
+    if (m_isLarge[n])
+    {
+      numLarge++;
+      continue;
+    }
+
+    for (int a = 0; a < 3; a++)
+    {
+      m_cellMin[a] = std::min(m_cellMin[a], lo[a]);
+      cellMax[a] = std::max(cellMax[a], hi[a]);
+    }
+    numEntries += cells;
+  }
+
+  /* With no colliders in the grid, use a single cell */
+  if (numLarge == count)
+  {
+    for (int a = 0; a < 3; a++)
+    {
+      m_cellMin[a] = 0;
+      cellMax[a] = 0;
+    }
+  }
+
+  /* Index cells directly if that takes no more than a few buckets per
+   * entry, otherwise hash them */
+  const size_t maxDenseBuckets = 4 * numEntries + 64;
+  uint64_t denseBuckets = 1;
+  m_dense = true;
+  for (int a = 0; a < 3; a++)
+  {
+    m_cellCount[a] = (uint64_t)(cellMax[a] - m_cellMin[a]) + 1;
+    denseBuckets *= m_cellCount[a];
+    if (denseBuckets > maxDenseBuckets)
+      m_dense = false;
+  }
+
+  if (m_dense)
+  {
+    m_numBuckets = (size_t)denseBuckets;
+  }
+  else
+  {
+    /* About one entry per bucket */
+    m_hashShift = 63;
+    m_numBuckets = 2;
+    while (m_numBuckets < numEntries)
+    {
+      m_numBuckets *= 2;
+      m_hashShift--;
+    }
+  }
+
+  /* Sort colliders by their minimum cell, large colliders first as their
+   * cells may be outside the grid */
+  m_bucketStart.assign(m_numBuckets + 1, 0);
+  m_entries.resize(std::max(count, numEntries));
+  for (size_t n = 0; n < count; n++)
+  {
+    const size_t bucket =
+        m_isLarge[n]
+            ? 0
+            : bucketOf(cellKey(
+                  cellCoordinate(c[0][n] - h[0][n], inverseCellSize),
+                  cellCoordinate(c[1][n] - h[1][n], inverseCellSize),
+                  cellCoordinate(c[2][n] - h[2][n], inverseCellSize)));
+    m_entries[n] = bucket;
+    m_bucketStart[bucket + 1]++;
+  }
+
+  for (size_t b = 0; b < m_numBuckets; b++)
+    m_bucketStart[b + 1] += m_bucketStart[b];
+
+  m_order.resize(count);
+  for (size_t n = 0; n < count; n++)
+    m_order[m_bucketStart[m_entries[n]]++] = n;
+
+  /* Copy bounds into sorted order */
+  for (int a = 0; a < 6; a++)
+  {
+    m_bounds[a].resize(count);
+    m_cellRange[a].resize(count);
+  }
+
+  for (int a = 0; a < 3; a++)
+  {
+    double *lo = &m_bounds[2 * a][0];
+    double *hi = &m_bounds[2 * a + 1][0];
+    int32_t *cellLo = &m_cellRange[2 * a][0];
+    int32_t *cellHi = &m_cellRange[2 * a + 1][0];
+    for (size_t k = 0; k < count; k++)
+    {
+      const size_t n = m_order[k];
+      lo[k] = c[a][n] - h[a][n];
+      hi[k] = c[a][n] + h[a][n];
+      cellLo[k] = cellCoordinate(lo[k], inverseCellSize);
+      cellHi[k] = cellCoordinate(hi[k], inverseCellSize);
+    }
+  }
+
+  const double *minX = &m_bounds[0][0];
+  const double *maxX = &m_bounds[1][0];
+  const double *minY = &m_bounds[2][0];
+  const double *maxY = &m_bounds[3][0];
+  const double *minZ = &m_bounds[4][0];
+  const double *maxZ = &m_bounds[5][0];
+  const int32_t *cellMinX = &m_cellRange[0][0];
+  const int32_t *cellMaxX = &m_cellRange[1][0];
+  const int32_t *cellMinY = &m_cellRange[2][0];
+  const int32_t *cellMaxY = &m_cellRange[3][0];
+  const int32_t *cellMinZ = &m_cellRange[4][0];
+  const int32_t *cellMaxZ = &m_cellRange[5][0];
+
+  /* Count entries per bucket */
+  m_bucketStart.assign(m_numBuckets + 1, 0);
+  for (size_t k = 0; k < count; k++)
+  {
+    if (m_isLarge[m_order[k]])
+      continue;
+
+    for (int32_t z = cellMinZ[k]; z <= cellMaxZ[k]; z++)
+      for (int32_t y = cellMinY[k]; y <= cellMaxY[k]; y++)
+        for (int32_t x = cellMinX[k]; x <= cellMaxX[k]; x++)
+          m_bucketStart[bucketOf(cellKey(x, y, z)) + 1]++;
+  }
+
+  for (size_t b = 0; b < m_numBuckets; b++)
+    m_bucketStart[b + 1] += m_bucketStart[b];
+
+  /* Scatter entries, leaving each bucket start at the end of its bucket */
+  m_entries.resize(numEntries);
+  m_entryCells.resize(numEntries);
+  for (size_t k = 0; k < count; k++)
+  {
+    if (m_isLarge[m_order[k]])
+      continue;
+
+    for (int32_t z = cellMinZ[k]; z <= cellMaxZ[k]; z++)
+    {
+      for (int32_t y = cellMinY[k]; y <= cellMaxY[k]; y++)
+      {
+        for (int32_t x = cellMinX[k]; x <= cellMaxX[k]; x++)
+        {
+          const uint64_t key = cellKey(x, y, z);
+          const size_t entry = m_bucketStart[bucketOf(key)]++;
+          m_entries[entry] = k;
+          m_entryCells[entry] = key;
+        }
+      }
+    }
+  }
+
+  for (size_t b = m_numBuckets; b > 0; b--)
+    m_bucketStart[b] = m_bucketStart[b - 1];
+  m_bucketStart[0] = 0;
+
+  /* Compare colliders sharing a cell */
+  for (size_t bucket = 0; bucket < m_numBuckets; bucket++)
+  {
+    const size_t end = m_bucketStart[bucket + 1];
+    for (size_t i = m_bucketStart[bucket]; i < end; i++)
+    {
+      const size_t a = m_entries[i];
+      const uint64_t key = m_entryCells[i];
+
+      for (size_t j = i + 1; j < end; j++)
+      {
+        const size_t b = m_entries[j];
+
+        if (m_entryCells[j] != key || minX[a] > maxX[b] || minX[b] > maxX[a] ||
+            minY[a] > maxY[b] || minY[b] > maxY[a] || minZ[a] > maxZ[b] ||
+            minZ[b] > maxZ[a])
+          continue;
+
+        /* Report from the cell holding the minimum corner of the overlap */
+        if (cellKey(std::max(cellMinX[a], cellMinX[b]),
+                    std::max(cellMinY[a], cellMinY[b]),
+                    std::max(cellMinZ[a], cellMinZ[b])) != key)
+          continue;
+
+        const size_t first = m_order[a];
+        const size_t second = m_order[b];
+        pairs.push_back(first < second ? ColliderPair(first, second)
+                                       : ColliderPair(second, first));
+      }
+    }
+  }
+
+  /* Compare each large collider with every collider that is not large, and
+   * with the large colliders after it in sorted order */
+  for (size_t a = 0; a < count; a++)
+  {
+    if (!m_isLarge[m_order[a]])
+      continue;
+
+    for (size_t b = 0; b < count; b++)
+    {
+      if (b == a || (b < a && m_isLarge[m_order[b]]))
+        continue;
+
+      if (minX[a] > maxX[b] || minX[b] > maxX[a] || minY[a] > maxY[b] ||
+          minY[b] > maxY[a] || minZ[a] > maxZ[b] || minZ[b] > maxZ[a])
+        continue;
+
+      const size_t first = m_order[a];
+      const size_t second = m_order[b];
+      pairs.push_back(first < second ? ColliderPair(first, second)
+                                     : ColliderPair(second, first));
+    }
+  }
+}
+
+/**
+ * Gets the key identifying a cell.
+ *
+ * @param x, y, z Cell coordinates
+ * @return Cell key, the bucket index when cells are indexed directly
+ */
+uint64_t UniformGrid3D::cellKey(const int32_t x, const int32_t y,
+                                const int32_t z) const
+{
+  if (m_dense)
+    return (uint64_t)(x - m_cellMin[0]) +
+           m_cellCount[0] * ((uint64_t)(y - m_cellMin[1]) +
+                             m_cellCount[1] * (uint64_t)(z - m_cellMin[2]));
+
+  return packCell(x, y, z);
+}
+
+/**
+ * Gets the bucket of a cell.
+ *
+ * @param key Cell key
+ * @return Bucket index
+ */
+size_t UniformGrid3D::bucketOf(const uint64_t key) const
+{
+  if (m_dense)
+    return (size_t)key;
+
+  return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> m_hashShift);
+}
+
+/**
+ * Chooses a cell size to suit a set of colliders.
+ *
+ * @param colliders Colliders
+ * @return Four times the mean of the largest half extent of each collider,
+ *         or 1 if all colliders are points
+ */
+double UniformGrid3D::chooseCellSize(const ColliderSet &colliders) const
+{
+  const size_t count = colliders.size();
+  const double *hx = colliders.halfExtents().x();
+  const double *hy = colliders.halfExtents().y();
+  const double *hz = colliders.halfExtents().z();
+
+  double sum = 0.0;
+  for (size_t n = 0; n < count; n++)
+    sum += std::max(hx[n], std::max(hy[n], hz[n]));
+
+  const double size = count > 0 ? 4.0 * sum / count : 0.0;
+  return size > 0.0 ? size : 1.0;
+}
@@ -0,0 +1,608 @@
+#include "Vector3DArray.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "Aligned.h"
+#include "Simd.h"
+#include "Vector3DStack.h"
+
+/*
+ * Optimisation notes
+ *
+ * Components are stored as three separate arrays (structure of arrays) in a
+ * single aligned allocation, so whole SIMD registers of x, y or z components
+ * can be loaded directly rather than shuffling {x,y,z} triples.
+ *
+ * Each array is padded to a multiple of GEOMETRY_ALIGNMENT so that all three
+ * start on an aligned boundary.
+ *
+ * The SSE2 kernels are written once against SimdOps<T>, so they process two
+ * double or four float vectors per iteration, and finish any remainder with
+ * the scalar code. The scalar code is kept for platforms without SSE2 and so
+ * the two can be compared.
+ */
+
+/**
+ * Returns the number of scalars in one aligned block.
+ *
+ * @return Scalars per block
+ */
+template <typename T> static size_t block()
+{
+  return GEOMETRY_ALIGNMENT / sizeof(T);
+}
+
+/**
+ * Checks that two arrays are of equal size.
+ *
+ * @param a First array
+ * @param b Second array
+ */
+template <typename T>
+static void checkSize(const Vector3DArrayT<T> &a, const Vector3DArrayT<T> &b)
+{
+  if (a.size() != b.size())
+    throw std::runtime_error("Vector3DArray size mismatch");
+}
+
+/**
+ * Construct an empty array.
+ */
+template <typename T>
+Vector3DArrayT<T>::Vector3DArrayT()
+    : m_size(0)
+    , m_capacity(0)
+    , m_data(NULL)
+{
+}
+
+/**
+ * Construct an array of zero vectors.
+ *
+ * @param size Number of vectors
+ */
+template <typename T>
+Vector3DArrayT<T>::Vector3DArrayT(const size_t size)
+    : m_size(0)
+    , m_capacity(0)
+    , m_data(NULL)
+{
+  resize(size);
+}
+
+/**
+ * Construct an array holding copies of existing vectors.
+ *
+ * @param vectors Pointer to first vector
+ * @param size Number of vectors
+ */
+template <typename T>
+Vector3DArrayT<T>::Vector3DArrayT(const Vector3DStackT<T> *vectors,
+                                  const size_t size)
+    : m_size(0)
+    , m_capacity(0)
+    , m_data(NULL)
+{
+  resize(size);
+  for (size_t i = 0; i < size; i++)
+    set(i, vectors[i]);
+}
+
+/**
+ * Construct an array taking values from another.
+ *
+ * @param other Array to copy values from
+ */
+template <typename T>
+Vector3DArrayT<T>::Vector3DArrayT(const Vector3DArrayT &other)
+    : m_size(0)
+    , m_capacity(0)
+    , m_data(NULL)
+{
+  operator=(other);
+}
+
+/**
+ * Destructor
+ */
+template <typename T> Vector3DArrayT<T>::~Vector3DArrayT()
+{
+  alignedFree(m_data);
+}
+
+/**
+ * Set the values of this array to the values of another.
+ *
+ * @param other Array to copy values from
+ */
+template <typename T>
+void Vector3DArrayT<T>::operator=(const Vector3DArrayT &other)
+{
+  if (this == &other)
+    return;
+
+  resize(other.m_size);
+
+  /* An empty array may have no storage, and memcpy needs valid pointers */
+  if (m_size == 0)
+    return;
+
+  memcpy(x(), other.x(), m_size * sizeof(T));
+  memcpy(y(), other.y(), m_size * sizeof(T));
+  memcpy(z(), other.z(), m_size * sizeof(T));
+}
+
+/**
+ * Returns the number of vectors in the array.
+ *
+ * @return Number of vectors
+ */
+template <typename T> size_t Vector3DArrayT<T>::size() const
+{
+  return m_size;
+}
+
+/**
+ * Changes the number of vectors in the array.
+ *
+ * Existing vectors are kept, new vectors are zero.
+ *
+ * @param size New number of vectors
+ */
+template <typename T> void Vector3DArrayT<T>::resize(const size_t size)
+{
+  if (size > m_capacity)
+  {
+    /* Grow geometrically so that adding vectors one at a time is cheap */
+    reallocate(std::max(size, std::min(2 * m_capacity, maxCapacity())));
+  }
+
+  for (size_t i = m_size; i < size; i++)
+  {
+    x()[i] = 0;
+    y()[i] = 0;
+    z()[i] = 0;
+  }
+
+  m_size = size;
+}
+
+/**
+ * Returns a vector in the array.
+ *
+ * @param index Index of vector
+ * @return Copy of the vector
+ */
+template <typename T>
+Vector3DStackT<T> Vector3DArrayT<T>::get(const size_t index) const
+{
+  if (index >= m_size)
+    throw std::runtime_error("Vector3DArray index out of range");
+
+  return Vector3DStackT<T>(x()[index], y()[index], z()[index]);
+}
+
+/**
+ * Sets a vector in the array.
+ *
+ * @param index Index of vector
+ * @param v Vector to store
+ */
+template <typename T>
+void Vector3DArrayT<T>::set(const size_t index, const Vector3DStackT<T> &v)
+{
+  if (index >= m_size)
+    throw std::runtime_error("Vector3DArray index out of range");
+
+  x()[index] = v.getX();
+  y()[index] = v.getY();
+  z()[index] = v.getZ();
+}
+
+/**
+ * Returns the array of X components.
+ *
+ * @return Pointer to X components, aligned to GEOMETRY_ALIGNMENT
+ */
+template <typename T> T *Vector3DArrayT<T>::x()
+{
+  return m_data;
+}
+
+/**
+ * Returns the array of Y components.
+ *
+ * @return Pointer to Y components, aligned to GEOMETRY_ALIGNMENT
+ */
+template <typename T> T *Vector3DArrayT<T>::y()
+{
+  return m_data + m_capacity;
+}
+
+/**
+ * Returns the array of Z components.
+ *
+ * @return Pointer to Z components, aligned to GEOMETRY_ALIGNMENT
+ */
+template <typename T> T *Vector3DArrayT<T>::z()
+{
+  return m_data + 2 * m_capacity;
+}
+
+/**
+ * Returns the array of X components.
+ *
+ * @return Pointer to X components, aligned to GEOMETRY_ALIGNMENT
+ */
+template <typename T> const T *Vector3DArrayT<T>::x() const
+{
+  return m_data;
+}
+
+/**
+ * Returns the array of Y components.
+ *
+ * @return Pointer to Y components, aligned to GEOMETRY_ALIGNMENT
+ */
+template <typename T> const T *Vector3DArrayT<T>::y() const
+{
+  return m_data + m_capacity;
+}
+
+/**
+ * Returns the array of Z components.
+ *
+ * @return Pointer to Z components, aligned to GEOMETRY_ALIGNMENT
+ */
+template <typename T> const T *Vector3DArrayT<T>::z() const
+{
+  return m_data + 2 * m_capacity;
+}
+
+/**
+ * Adds two arrays element wise.
+ *
+ * @param a Left hand side array
+ * @param b Right hand side array
+ * @param out Array to store sums in, may be a or b
+ */
+template <typename T>
+void Vector3DArrayT<T>::add(const Vector3DArrayT &a, const Vector3DArrayT &b,
+                            Vector3DArrayT &out)
+{
+  checkSize(a, b);
+  out.resize(a.m_size);
+
+  const T *ac[] = {a.x(), a.y(), a.z()};
+  const T *bc[] = {b.x(), b.y(), b.z()};
+  T *oc[] = {out.x(), out.y(), out.z()};
+
+  for (int c = 0; c < 3; c++)
+  {
+    size_t i = 0;
+#ifdef __SSE2__
+    if (useSimdKernels())
+    {
+      typedef SimdOps<T> S;
+      for (; i + S::WIDTH <= a.m_size; i += S::WIDTH)
+        S::store(oc[c] + i, S::add(S::load(ac[c] + i), S::load(bc[c] + i)));
+    }
+#endif
+    for (; i < a.m_size; i++)
+      oc[c][i] = ac[c][i] + bc[c][i];
+  }
+}
+
+/**
+ * Subtracts two arrays element wise.
+ *
+ * @param a Left hand side array
+ * @param b Right hand side array
+ * @param out Array to store differences in, may be a or b
+ */
+template <typename T>
+void Vector3DArrayT<T>::subtract(const Vector3DArrayT &a,
+                                 const Vector3DArrayT &b, Vector3DArrayT &out)
+{
+  checkSize(a, b);
+  out.resize(a.m_size);
+
+  const T *ac[] = {a.x(), a.y(), a.z()};
+  const T *bc[] = {b.x(), b.y(), b.z()};
+  T *oc[] = {out.x(), out.y(), out.z()};
+
+  for (int c = 0; c < 3; c++)
+  {
+    size_t i = 0;
+#ifdef __SSE2__
+    if (useSimdKernels())
+    {
+      typedef SimdOps<T> S;
+      for (; i + S::WIDTH <= a.m_size; i += S::WIDTH)
+        S::store(oc[c] + i, S::sub(S::load(ac[c] + i), S::load(bc[c] + i)));
+    }
+#endif
+    for (; i < a.m_size; i++)
+      oc[c][i] = ac[c][i] - bc[c][i];
+  }
+}
+
+/**
+ * Multiplies every vector in an array by a scalar.
+ *
+ * @param a Array of vectors
+ * @param s Scalar to multiply by
+ * @param out Array to store products in, may be a
+ */
+template <typename T>
+void Vector3DArrayT<T>::scale(const Vector3DArrayT &a, const T s,
+                              Vector3DArrayT &out)
+{
+  out.resize(a.m_size);
+
+  const T *ac[] = {a.x(), a.y(), a.z()};
+  T *oc[] = {out.x(), out.y(), out.z()};
+
+  for (int c = 0; c < 3; c++)
+  {
+    size_t i = 0;
+#ifdef __SSE2__
+    if (useSimdKernels())
+    {
+      typedef SimdOps<T> S;
+      const typename S::Vec vs = S::set1(s);
+      for (; i + S::WIDTH <= a.m_size; i += S::WIDTH)
+        S::store(oc[c] + i, S::mul(S::load(ac[c] + i), vs));
+    }
+#endif
+    for (; i < a.m_size; i++)
+      oc[c][i] = ac[c][i] * s;
+  }
+}
+
+/**
+ * Calculates the dot products of two arrays element wise.
+ *
+ * @param a Left hand side array
+ * @param b Right hand side array
+ * @param out Array of at least a.size() scalars to store products in
+ */
+template <typename T>
+void Vector3DArrayT<T>::dot(const Vector3DArrayT &a, const Vector3DArrayT &b,
+                            T *out)
+{
+  checkSize(a, b);
+
+  const T *ax = a.x(), *ay = a.y(), *az = a.z();
+  const T *bx = b.x(), *by = b.y(), *bz = b.z();
+
+  size_t i = 0;
+#ifdef __SSE2__
+  if (useSimdKernels())
+  {
+    typedef SimdOps<T> S;
+    for (; i + S::WIDTH <= a.m_size; i += S::WIDTH)
+    {
+      typename S::Vec d = S::mul(S::load(ax + i), S::load(bx + i));
+      d = S::add(d, S::mul(S::load(ay + i), S::load(by + i)));
+      d = S::add(d, S::mul(S::load(az + i), S::load(bz + i)));
+      S::storeu(out + i, d);
+    }
+  }
+#endif
+  for (; i < a.m_size; i++)
+    out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+}
+
+/**
+ * Calculates the cross products of two arrays element wise.
+ *
+ * @param a Left hand side array
+ * @param b Right hand side array
+ * @param out Array to store products in, may be a or b
+ */
+template <typename T>
+void Vector3DArrayT<T>::cross(const Vector3DArrayT &a, const Vector3DArrayT &b,
+                              Vector3DArrayT &out)
+{
+  checkSize(a, b);
+  out.resize(a.m_size);
+
+  const T *ax = a.x(), *ay = a.y(), *az = a.z();
+  const T *bx = b.x(), *by = b.y(), *bz = b.z();
+  T *ox = out.x(), *oy = out.y(), *oz = out.z();
+
+  size_t i = 0;
+#ifdef __SSE2__
+  if (useSimdKernels())
+  {
+    typedef SimdOps<T> S;
+    for (; i + S::WIDTH <= a.m_size; i += S::WIDTH)
+    {
+      const typename S::Vec vax = S::load(ax + i);
+      const typename S::Vec vay = S::load(ay + i);
+      const typename S::Vec vaz = S::load(az + i);
+      const typename S::Vec vbx = S::load(bx + i);
+      const typename S::Vec vby = S::load(by + i);
+      const typename S::Vec vbz = S::load(bz + i);
+
+      S::store(ox + i, S::sub(S::mul(vay, vbz), S::mul(vaz, vby)));
+      S::store(oy + i, S::sub(S::mul(vaz, vbx), S::mul(vax, vbz)));
+      S::store(oz + i, S::sub(S::mul(vax, vby), S::mul(vay, vbx)));
+    }
+  }
+#endif
+  for (; i < a.m_size; i++)
+  {
+    const T cx = ay[i] * bz[i] - az[i] * by[i];
+    const T cy = az[i] * bx[i] - ax[i] * bz[i];
+    const T cz = ax[i] * by[i] - ay[i] * bx[i];
+    ox[i] = cx;
+    oy[i] = cy;
+    oz[i] = cz;
+  }
+}
+
+/**
+ * Calculates the magnitude of every vector in the array.
+ *
+ * @param out Array of at least size() scalars to store magnitudes in
+ */
+template <typename T> void Vector3DArrayT<T>::magnitude(T *out) const
+{
+  const T *vx = x(), *vy = y(), *vz = z();
+
+  size_t i = 0;
+#ifdef __SSE2__
+  if (useSimdKernels())
+  {
+    typedef SimdOps<T> S;
+    for (; i + S::WIDTH <= m_size; i += S::WIDTH)
+    {
+      const typename S::Vec px = S::load(vx + i);
+      const typename S::Vec py = S::load(vy + i);
+      const typename S::Vec pz = S::load(vz + i);
+      typename S::Vec m = S::mul(px, px);
+      m = S::add(m, S::mul(py, py));
+      m = S::add(m, S::mul(pz, pz));
+      S::storeu(out + i, S::sqrt(m));
+    }
+  }
+#endif
+  for (; i < m_size; i++)
+    out[i] = std::sqrt(vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]);
+}
+
+/**
+ * Scales every vector in the array to unit length.
+ *
+ * Unlike Vector3DStack::getUnitVector() this does not throw for vectors of
+ * (near) zero length, as checking each vector would prevent vectorisation;
+ * such vectors are left unchanged instead.
+ */
+template <typename T> void Vector3DArrayT<T>::normalise()
+{
+  const T epsilon = std::numeric_limits<T>::epsilon();
+  T *vx = x(), *vy = y(), *vz = z();
+
+  size_t i = 0;
+#ifdef __SSE2__
+  if (useSimdKernels())
+  {
+    typedef SimdOps<T> S;
+    const typename S::Vec eps = S::set1(epsilon);
+    const typename S::Vec one = S::set1(1);
+    for (; i + S::WIDTH <= m_size; i += S::WIDTH)
+    {
+      const typename S::Vec px = S::load(vx + i);
+      const typename S::Vec py = S::load(vy + i);
+      const typename S::Vec pz = S::load(vz + i);
+      typename S::Vec m = S::mul(px, px);
+      m = S::add(m, S::mul(py, py));
+      m = S::add(m, S::mul(pz, pz));
+      m = S::sqrt(m);
+
+      /* Scale by 1/m, or by 1 where m is too small */
+      const typename S::Vec s =
+          S::select(S::cmpge(m, eps), S::div(one, m), one);
+
+      S::store(vx + i, S::mul(px, s));
+      S::store(vy + i, S::mul(py, s));
+      S::store(vz + i, S::mul(pz, s));
+    }
+  }
+#endif
+  for (; i < m_size; i++)
+  {
+    const T m = std::sqrt(vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]);
+    if (m < epsilon)
+      continue;
+
+    const T s = 1 / m;
+    vx[i] *= s;
+    vy[i] *= s;
+    vz[i] *= s;
+  }
+}
+
+/**
+ * Checks if SIMD kernels were compiled in.
+ *
+ * Same as simdKernelsAvailable().
+ *
+ * @return True if SIMD kernels are available
+ */
+template <typename T> bool Vector3DArrayT<T>::simdAvailable()
+{
+  return simdKernelsAvailable();
+}
+
+/**
+ * Selects between the SIMD and scalar kernels of every batch class, for
+ * testing and benchmarking.
+ *
+ * Same as setUseSimdKernels().
+ *
+ * @param useSimd True to use SIMD kernels
+ */
+template <typename T> void Vector3DArrayT<T>::setUseSimd(const bool useSimd)
+{
+  setUseSimdKernels(useSimd);
+}
+
+/**
+ * Checks if the SIMD kernels are in use.
+ *
+ * Same as useSimdKernels().
+ *
+ * @return True if SIMD kernels are used
+ */
+template <typename T> bool Vector3DArrayT<T>::useSimd()
+{
+  return useSimdKernels();
+}
+
+/**
+ * Returns the largest capacity, in vectors, whose storage size in bytes does
+ * not overflow size_t.
+ *
+ * @return Maximum capacity, a multiple of block<T>()
+ */
+template <typename T> size_t Vector3DArrayT<T>::maxCapacity()
+{
+  return (SIZE_MAX / (3 * sizeof(T))) / block<T>() * block<T>();
+}
+
+/**
+ * Moves the existing values to new storage for a given number of vectors.
+ *
+ * Either succeeds or throws leaving the array unchanged.
+ *
+ * @param size Number of vectors, at least the current size
+ */
+template <typename T> void Vector3DArrayT<T>::reallocate(const size_t size)
+{
+  if (size > maxCapacity())
+    throw std::runtime_error("Vector3DArray size too large");
+
+  const size_t capacity = ((size + block<T>() - 1) / block<T>()) * block<T>();
+  T *data = (T *)alignedAlloc(3 * capacity * sizeof(T));
+
+  if (m_data != NULL)
+  {
+    memcpy(data, x(), m_size * sizeof(T));
+    memcpy(data + capacity, y(), m_size * sizeof(T));
+    memcpy(data + 2 * capacity, z(), m_size * sizeof(T));
+    alignedFree(m_data);
+  }
+
+  m_data = data;
+  m_capacity = capacity;
+}
+
+template class Vector3DArrayT<float>;
+template class Vector3DArrayT<double>;
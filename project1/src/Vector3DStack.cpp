@@ -1,7 +1,7 @@
 #include "Vector3DStack.h"
 
-#include <cfloat>
 #include <cmath>
+#include <limits>
 #include <stdexcept>
 
 /*
@@ -13,154 +13,12 @@
  * Passing by reference is not done for primitive types as this causes aliasing
  * which prevents the compiler optimisation doing the full extent of
  * optimisation.
- */
-
-/**
- * Instantiate a new vector will all components set to zero.
- */
-Vector3DStack::Vector3DStack()
-    : m_x(0.0)
-    , m_y(0.0)
-    , m_z(0.0)
-{
-}
-
-/**
- * Instantiate a new vector taking values from another.
- *
- * @param other Vector to copy values from
- */
-Vector3DStack::Vector3DStack(const Vector3DStack &other)
-    : m_x(other.m_x)
-    , m_y(other.m_y)
-    , m_z(other.m_z)
-{
-}
-
-/**
- * Instantiate a new vector with given values.
- *
- * @param x Value of X component
- * @param y Value of Y component
- * @param z Value of Z component
- */
-Vector3DStack::Vector3DStack(const double x, const double y, const double z)
-    : m_x(x)
-    , m_y(y)
-    , m_z(z)
-{
-}
-
-/**
- * Destructor
- */
-Vector3DStack::~Vector3DStack()
-{
-}
-
-/**
- * Set the values of this vector to the values of another.
- *
- * @param other Vector to copy values from
- */
-void Vector3DStack::operator=(const Vector3DStack &other)
-{
-  m_x = other.m_x;
-  m_y = other.m_y;
-  m_z = other.m_z;
-}
-
-/**
- * Check for equality between this vector and another.
  *
- * @param other Other vector
- * @return True if all component values are equal
+ * The class is a template on the scalar type so that batch code can work in
+ * float, with twice the SIMD width and half the memory of double. Only float
+ * and double are instantiated, at the end of this file, so the definitions
+ * stay out of the header.
  */
-bool Vector3DStack::operator==(const Vector3DStack &other) const
-{
-  return (m_x == other.m_x && m_y == other.m_y && m_z == other.m_z);
-}
-
-/**
- * Check for inequality between this vector and another.
- *
- * @param other Other vector
- * @return True if at least one component value differs
- */
-bool Vector3DStack::operator!=(const Vector3DStack &other) const
-{
-  return !operator==(other);
-}
-
-/**
- * Sets the X componen of the vector.
- *
- * @param x X component
- */
-void Vector3DStack::setX(double x)
-{
-  m_x = x;
-}
-
-/**
- * Returns the X component of the vector.
- *
- * @return X component
- */
-double Vector3DStack::getX() const
-{
-  return m_x;
-}
-
-/**
- * Sets the Y componen of the vector.
- *
- * @param y Y component
- */
-void Vector3DStack::setY(double y)
-{
-  m_y = y;
-}
-
-/**
- * Returns the Y component of the vector.
- *
- * @return Y component
- */
-double Vector3DStack::getY() const
-{
-  return m_y;
-}
-
-/**
- * Sets the Z componen of the vector.
- *
- * @param z Z component
- */
-void Vector3DStack::setZ(double z)
-{
-  m_z = z;
-}
-
-/**
- * Returns the Z component of the vector.
- *
- * @return Z component
- */
-double Vector3DStack::getZ() const
-{
-  return m_z;
-}
-
-/**
- * Calculates the magnitude of the vector.
- *
- * @return Magnitude
- */
-double Vector3DStack::magnitude() const
-{
-  return sqrt(m_x * m_x + m_y * m_y + m_z * m_z);
-}
 
 /**
  * Calculates the unit vector of this vector through scalar division by the
@@ -168,9 +26,10 @@ double Vector3DStack::magnitude() const
  *
  * @return Unit vector
  */
-Vector3DStack Vector3DStack::getUnitVector() const
+template <typename T>
+Vector3DStackT<T> Vector3DStackT<T>::getUnitVector() const
 {
-  return Vector3DStack(*this) / magnitude();
+  return Vector3DStackT(*this) / magnitude();
 }
 
 /**
@@ -180,86 +39,32 @@ Vector3DStack Vector3DStack::getUnitVector() const
  * @param other Other vector
  * @returns Orthogonal unit vector
  */
-Vector3DStack
-Vector3DStack::getOrthogonalUnitVector(const Vector3DStack &other) const
+template <typename T>
+Vector3DStackT<T>
+Vector3DStackT<T>::getOrthogonalUnitVector(const Vector3DStackT &other) const
 {
-  Vector3DStack v = (*this) % other;
+  Vector3DStackT v = (*this) % other;
   return v.getUnitVector();
 }
 
-/**
- * Adds two vectors.
- *
- * @param rhs Right hand side vector
- * @return This vector plus the RHS
- */
-Vector3DStack Vector3DStack::operator+(const Vector3DStack &rhs) const
-{
-  return Vector3DStack(m_x + rhs.m_x, m_y + rhs.m_y, m_z + rhs.m_z);
-}
-
-/**
- * Subtract a vector from this vector.
- *
- * @param rhs Right hand side vector
- * @return This vector minus the RHS
- */
-Vector3DStack Vector3DStack::operator-(const Vector3DStack &rhs) const
-{
-  return Vector3DStack(m_x - rhs.m_x, m_y - rhs.m_y, m_z - rhs.m_z);
-}
-
-/**
- * Performs multiplication by a scalar.
- *
- * @param rhs Scalar to multiply by
- * @return Product vector
- */
-Vector3DStack Vector3DStack::operator*(const double rhs) const
-{
-  return Vector3DStack(m_x * rhs, m_y * rhs, m_z * rhs);
-}
-
 /**
  * Performs division by a scalar.
  *
  * Note that this could be heavily optimised by removing the division by zero
  * checking, and in any real world application I would do this, but previous
- * students tell me they lost marks by omitting it.
+ * students tell me they lost marks by omitting it. divideUnchecked() is
+ * that optimised version, for inner loops.
  *
  * @param rhs Scalar to divide by
  * @return Quotient vector
  */
-Vector3DStack Vector3DStack::operator/(const double rhs) const
+template <typename T>
+Vector3DStackT<T> Vector3DStackT<T>::operator/(const T rhs) const
 {
-  if (std::abs(rhs) < DBL_EPSILON)
+  if (std::abs(rhs) < std::numeric_limits<T>::epsilon())
     throw std::runtime_error("Division by zero");
 
-  return Vector3DStack(m_x / rhs, m_y / rhs, m_z / rhs);
-}
-
-/**
- * Calculates dot (scalar) product of two vectors.
- *
- * @param rhs Right hand side vector
- * @return Dot product
- */
-double Vector3DStack::operator*(const Vector3DStack &rhs) const
-{
-  return (m_x * rhs.m_x + m_y * rhs.m_y + m_z * rhs.m_z);
-}
-
-/**
- * Calculates the cross (vector) product of two vectors.
- *
- * @param rhs Right hand side vector
- * @return Cross product
- */
-Vector3DStack Vector3DStack::operator%(const Vector3DStack &rhs) const
-{
-  return Vector3DStack(m_y * rhs.m_z - m_z * rhs.m_y,
-                       m_z * rhs.m_x - m_x * rhs.m_z,
-                       m_x * rhs.m_y - m_y * rhs.m_x);
+  return Vector3DStackT(m_x / rhs, m_y / rhs, m_z / rhs);
 }
 
 /**
@@ -270,7 +75,7 @@ Vector3DStack Vector3DStack::operator%(const Vector3DStack &rhs) const
  * @param index Index accessed
  * @param Vector component
  */
-double Vector3DStack::operator[](const int index) const
+template <typename T> T Vector3DStackT<T>::operator[](const int index) const
 {
   switch(index)
   {
@@ -293,7 +98,7 @@ double Vector3DStack::operator[](const int index) const
  * @param index Index accessed
  * @param Vector component
  */
-double &Vector3DStack::operator[](const int index)
+template <typename T> T &Vector3DStackT<T>::operator[](const int index)
 {
   switch(index)
   {
@@ -314,9 +119,10 @@ double &Vector3DStack::operator[](const int index)
  * @param stream The stream to output to
  * @param v The vector to output
  */
-std::ostream &operator<<(std::ostream &stream, const Vector3DStack &v)
+template <typename T>
+std::ostream &operator<<(std::ostream &stream, const Vector3DStackT<T> &v)
 {
-  stream << "[" << v.m_x << "," << v.m_y << "," << v.m_z << "]";
+  stream << "[" << v.getX() << "," << v.getY() << "," << v.getZ() << "]";
   return stream;
 }
 
@@ -326,11 +132,20 @@ std::ostream &operator<<(std::ostream &stream, const Vector3DStack &v)
  * @param stream Stream to read from
  * @param v Vector to store values in
  */
-std::istream &operator>>(std::istream &stream, Vector3DStack &v)
+template <typename T>
+std::istream &operator>>(std::istream &stream, Vector3DStackT<T> &v)
 {
-  double x, y, z;
+  T x, y, z;
   char delim;
   stream >> delim >> x >> delim >> y >> delim >> z >> delim;
-  v = Vector3DStack(x, y, z);
+  v = Vector3DStackT<T>(x, y, z);
   return stream;
 }
+
+template class Vector3DStackT<float>;
+template class Vector3DStackT<double>;
+
+template std::ostream &operator<<(std::ostream &, const Vector3DStackF &);
+template std::ostream &operator<<(std::ostream &, const Vector3DStack &);
+template std::istream &operator>>(std::istream &, Vector3DStackF &);
+template std::istream &operator>>(std::istream &, Vector3DStack &);
@@ -0,0 +1,213 @@
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ChunkedIO.h"
+
+class ChunkedIOTest : public CxxTest::TestSuite
+{
+public:
+  void test_ChunkedReader_ReadsAll(void)
+  {
+    const std::string data = makeData(1000);
+    FILE *file = makeFile(data);
+
+    std::string read;
+    size_t chunks = 0;
+    {
+      ChunkedReader reader(file, 64);
+      const char *chunk;
+      size_t size;
+      while (reader.next(chunk, size))
+      {
+        TS_ASSERT_LESS_THAN_EQUALS(size, 64);
+        read.append(chunk, size);
+        chunks++;
+      }
+
+      /* Stays at the end */
+      TS_ASSERT(!reader.next(chunk, size));
+    }
+
+    TS_ASSERT_EQUALS(read, data);
+    TS_ASSERT_EQUALS(chunks, 16);
+    fclose(file);
+  }
+
+  void test_ChunkedReader_ExactMultiple(void)
+  {
+    const std::string data = makeData(128);
+    FILE *file = makeFile(data);
+
+    std::string read;
+    {
+      ChunkedReader reader(file, 64);
+      const char *chunk;
+      size_t size;
+      while (reader.next(chunk, size))
+        read.append(chunk, size);
+    }
+
+    TS_ASSERT_EQUALS(read, data);
+    fclose(file);
+  }
+
+  void test_ChunkedReader_Empty(void)
+  {
+    FILE *file = makeFile("");
+    ChunkedReader reader(file, 64);
+    const char *chunk;
+    size_t size;
+    TS_ASSERT(!reader.next(chunk, size));
+    fclose(file);
+  }
+
+  void test_ChunkedReader_StopEarly(void)
+  {
+    FILE *file = makeFile(makeData(10000));
+    {
+      ChunkedReader reader(file, 16);
+      const char *chunk;
+      size_t size;
+      TS_ASSERT(reader.next(chunk, size));
+    }
+    fclose(file);
+  }
+
+  void test_ChunkedSplitter_Lines(void)
+  {
+    /* Lines of every length up to a few chunks, split at every offset */
+    std::string data;
+    std::vector<std::string> lines;
+    for (size_t n = 0; n < 40; n++)
+    {
+      lines.push_back(makeData(n * 5) + "\n");
+      data += lines.back();
+    }
+    lines.push_back("end");
+    data += lines.back();
+
+    FILE *file = makeFile(data);
+    {
+      ChunkedReader reader(file, 16);
+      ChunkedSplitter splitter(reader, '\n', 256);
+      const char *begin;
+      const char *end;
+      for (size_t n = 0; n < lines.size(); n++)
+      {
+        TS_ASSERT(splitter.next(begin, end));
+        TS_ASSERT_EQUALS(std::string(begin, end), lines[n]);
+        TS_ASSERT_EQUALS(splitter.terminated(), n + 1 < lines.size());
+      }
+
+      /* Stays at the end */
+      TS_ASSERT(!splitter.next(begin, end));
+      TS_ASSERT(!splitter.next(begin, end));
+    }
+    fclose(file);
+  }
+
+  void test_ChunkedSplitter_Empty(void)
+  {
+    FILE *file = makeFile("");
+    {
+      ChunkedReader reader(file, 16);
+      ChunkedSplitter splitter(reader, '\n', 256);
+      const char *begin;
+      const char *end;
+      TS_ASSERT(!splitter.next(begin, end));
+    }
+    fclose(file);
+  }
+
+  void test_ChunkedSplitter_RecordTooLong(void)
+  {
+    FILE *file = makeFile("ab\n" + makeData(100) + "\n");
+    {
+      ChunkedReader reader(file, 16);
+      ChunkedSplitter splitter(reader, '\n', 50);
+      const char *begin;
+      const char *end;
+      TS_ASSERT(splitter.next(begin, end));
+      TS_ASSERT_THROWS(splitter.next(begin, end), std::runtime_error);
+    }
+    fclose(file);
+  }
+
+  void test_ChunkedWriter_WritesAll(void)
+  {
+    const std::string data = makeData(1000);
+    FILE *file = tmpfile();
+
+    {
+      ChunkedWriter writer(file, 64);
+      TS_ASSERT_EQUALS(writer.chunkSize(), 64);
+
+      /* Varying amounts of each buffer */
+      size_t offset = 0;
+      for (size_t n = 1; offset < data.size(); n = n % 57 + 7)
+      {
+        TS_ASSERT(n <= writer.chunkSize());
+        const size_t size = std::min(n, data.size() - offset);
+        memcpy(writer.buffer(), data.data() + offset, size);
+        writer.submit(size);
+        offset += size;
+      }
+      TS_ASSERT(writer.finish());
+    }
+
+    TS_ASSERT_EQUALS(readFile(file), data);
+    fclose(file);
+  }
+
+  void test_ChunkedWriter_SubmitTooLarge(void)
+  {
+    FILE *file = tmpfile();
+
+    {
+      ChunkedWriter writer(file, 64);
+      memcpy(writer.buffer(), "abc", 3);
+      TS_ASSERT_THROWS(writer.submit(65), std::runtime_error);
+
+      /* The buffer is still current */
+      writer.submit(3);
+      TS_ASSERT(writer.finish());
+    }
+
+    TS_ASSERT_EQUALS(readFile(file), "abc");
+    fclose(file);
+  }
+
+private:
+  std::string makeData(size_t size)
+  {
+    std::string data;
+    for (size_t n = 0; n < size; n++)
+      data += (char)('a' + n % 26);
+    return data;
+  }
+
+  FILE *makeFile(const std::string &data)
+  {
+    FILE *file = tmpfile();
+    fwrite(data.data(), 1, data.size(), file);
+    rewind(file);
+    return file;
+  }
+
+  std::string readFile(FILE *file)
+  {
+    rewind(file);
+    std::string data;
+    char buffer[256];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+      data.append(buffer, size);
+    return data;
+  }
+};
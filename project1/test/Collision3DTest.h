@@ -0,0 +1,284 @@
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "ColliderSet.h"
+#include "Collision3D.h"
+#include "SweepAndPrune3D.h"
+#include "UniformGrid3D.h"
+#include "Vector3DStack.h"
+
+class Collision3DTest : public CxxTest::TestSuite
+{
+public:
+  /**
+   * Fills a set with random spheres and boxes in a cube.
+   */
+  void randomColliders(ColliderSet &colliders, const size_t count,
+                       const double worldSize, const double maxSize)
+  {
+    colliders.clear();
+    for (size_t n = 0; n < count; n++)
+    {
+      const Vector3DStack centre(rand() / (double)RAND_MAX * worldSize,
+                                 rand() / (double)RAND_MAX * worldSize,
+                                 rand() / (double)RAND_MAX * worldSize);
+      if (n % 2 == 0)
+        colliders.addSphere(centre, rand() / (double)RAND_MAX * maxSize);
+      else
+        colliders.addBox(centre,
+                         Vector3DStack(rand() / (double)RAND_MAX * maxSize,
+                                       rand() / (double)RAND_MAX * maxSize,
+                                       rand() / (double)RAND_MAX * maxSize));
+    }
+  }
+
+  /**
+   * Filters candidate pairs and compares them with brute force.
+   */
+  void assertMatchesBruteForce(const ColliderSet &colliders,
+                               std::vector<ColliderPair> pairs)
+  {
+    const size_t candidates = pairs.size();
+    Collision3D::filterPairs(colliders, pairs);
+    std::sort(pairs.begin(), pairs.end());
+
+    std::vector<ColliderPair> expected;
+    Collision3D::findPairsBruteForce(colliders, expected);
+
+    TS_ASSERT(candidates >= expected.size());
+    TS_ASSERT_EQUALS(pairs.size(), expected.size());
+    TS_ASSERT(pairs == expected);
+  }
+
+  void test_Collision3D_SphereSphere(void)
+  {
+    TS_ASSERT(Collision3D::sphereSphere(Vector3DStack(0.0, 0.0, 0.0), 1.0,
+                                        Vector3DStack(1.5, 0.0, 0.0), 0.5));
+    TS_ASSERT(Collision3D::sphereSphere(Vector3DStack(0.0, 0.0, 0.0), 1.0,
+                                        Vector3DStack(1.0, 1.0, 0.0), 0.5));
+    TS_ASSERT(!Collision3D::sphereSphere(Vector3DStack(0.0, 0.0, 0.0), 1.0,
+                                         Vector3DStack(1.1, 1.1, 0.0), 0.5));
+  }
+
+  void test_Collision3D_SphereBox(void)
+  {
+    const Vector3DStack boxCentre(0.0, 0.0, 0.0);
+    const Vector3DStack half(1.0, 2.0, 3.0);
+
+    /* Inside, beside a face and past a corner */
+    TS_ASSERT(Collision3D::sphereBox(Vector3DStack(0.5, 0.5, 0.5), 0.1,
+                                     boxCentre, half));
+    TS_ASSERT(Collision3D::sphereBox(Vector3DStack(0.0, 0.0, 3.5), 0.5,
+                                     boxCentre, half));
+    TS_ASSERT(!Collision3D::sphereBox(Vector3DStack(0.0, 0.0, 3.6), 0.5,
+                                      boxCentre, half));
+    TS_ASSERT(!Collision3D::sphereBox(Vector3DStack(1.4, 2.4, 0.0), 0.5,
+                                      boxCentre, half));
+    TS_ASSERT(Collision3D::sphereBox(Vector3DStack(1.3, 2.3, 0.0), 0.5,
+                                     boxCentre, half));
+  }
+
+  void test_Collision3D_BoxBox(void)
+  {
+    const Vector3DStack half(1.0, 1.0, 1.0);
+    TS_ASSERT(Collision3D::boxBox(Vector3DStack(0.0, 0.0, 0.0), half,
+                                  Vector3DStack(2.0, 1.0, -1.0), half));
+    TS_ASSERT(!Collision3D::boxBox(Vector3DStack(0.0, 0.0, 0.0), half,
+                                   Vector3DStack(2.0, 2.5, 0.0), half));
+  }
+
+  void test_ColliderSet_Add(void)
+  {
+    ColliderSet colliders;
+    colliders.addSphere(Vector3DStack(1.0, 2.0, 3.0), 0.5);
+    size_t index = colliders.addBox(Vector3DStack(4.0, 5.0, 6.0),
+                                    Vector3DStack(1.0, 2.0, 3.0));
+
+    TS_ASSERT_EQUALS(index, 1);
+    TS_ASSERT_EQUALS(colliders.size(), 2);
+    TS_ASSERT_EQUALS(colliders.getShape(0), COLLIDER_SPHERE);
+    TS_ASSERT_EQUALS(colliders.getShape(1), COLLIDER_BOX);
+    TS_ASSERT_EQUALS(colliders.getRadius(0), 0.5);
+    TS_ASSERT_EQUALS(colliders.getMin(1), Vector3DStack(3.0, 3.0, 3.0));
+    TS_ASSERT_EQUALS(colliders.getMax(1), Vector3DStack(5.0, 7.0, 9.0));
+
+    colliders.setCentre(0, Vector3DStack(0.0, 0.0, 0.0));
+    TS_ASSERT_EQUALS(colliders.getMax(0), Vector3DStack(0.5, 0.5, 0.5));
+
+    TS_ASSERT_THROWS(colliders.getRadius(1), std::runtime_error);
+    TS_ASSERT_THROWS(colliders.getShape(2), std::runtime_error);
+    TS_ASSERT_THROWS(colliders.addSphere(Vector3DStack(), -1.0),
+                     std::runtime_error);
+    TS_ASSERT_THROWS(Collision3D::intersects(colliders, 0, 2),
+                     std::runtime_error);
+  }
+
+  void test_Collision3D_Intersects(void)
+  {
+    ColliderSet colliders;
+    colliders.addSphere(Vector3DStack(0.0, 0.0, 0.0), 1.0);
+    colliders.addBox(Vector3DStack(1.5, 0.0, 0.0),
+                     Vector3DStack(0.5, 0.5, 0.5));
+    colliders.addSphere(Vector3DStack(1.9, 0.9, 0.0), 0.5);
+
+    TS_ASSERT(Collision3D::intersects(colliders, 0, 1));
+    TS_ASSERT(Collision3D::intersects(colliders, 1, 0));
+    TS_ASSERT(Collision3D::intersects(colliders, 1, 2));
+    TS_ASSERT(!Collision3D::intersects(colliders, 0, 2));
+
+    std::vector<ColliderPair> pairs;
+    pairs.push_back(ColliderPair(0, 1));
+    pairs.push_back(ColliderPair(0, 2));
+    pairs.push_back(ColliderPair(1, 2));
+    Collision3D::filterPairs(colliders, pairs);
+    TS_ASSERT_EQUALS(pairs.size(), 2);
+    TS_ASSERT(pairs[0] == ColliderPair(0, 1));
+    TS_ASSERT(pairs[1] == ColliderPair(1, 2));
+  }
+
+  void test_SweepAndPrune3D_Empty(void)
+  {
+    ColliderSet colliders;
+    SweepAndPrune3D sap;
+    std::vector<ColliderPair> pairs(1);
+    sap.findPairs(colliders, pairs);
+    TS_ASSERT(pairs.empty());
+  }
+
+  void test_SweepAndPrune3D_MatchesBruteForce(void)
+  {
+    srand(1);
+    ColliderSet colliders;
+    randomColliders(colliders, 2000, 100.0, 2.0);
+
+    SweepAndPrune3D sap;
+    std::vector<ColliderPair> pairs;
+    sap.findPairs(colliders, pairs);
+    TS_ASSERT(!pairs.empty());
+    assertMatchesBruteForce(colliders, pairs);
+  }
+
+  void test_SweepAndPrune3D_Moving(void)
+  {
+    srand(2);
+    ColliderSet colliders;
+    randomColliders(colliders, 1000, 50.0, 1.5);
+
+    SweepAndPrune3D sap;
+    std::vector<ColliderPair> pairs;
+
+    /* Small moves reuse the previous order, a large move re-sorts */
+    for (int tick = 0; tick < 5; tick++)
+    {
+      const double step = tick == 3 ? 20.0 : 0.2;
+      double *x = colliders.centres().x();
+      double *z = colliders.centres().z();
+      for (size_t n = 0; n < colliders.size(); n++)
+      {
+        x[n] += step * (rand() / (double)RAND_MAX - 0.5);
+        z[n] += step * (rand() / (double)RAND_MAX - 0.5);
+      }
+
+      sap.findPairs(colliders, pairs);
+      assertMatchesBruteForce(colliders, pairs);
+    }
+  }
+
+  void test_SweepAndPrune3D_Axis(void)
+  {
+    ColliderSet colliders;
+    for (int n = 0; n < 10; n++)
+      colliders.addSphere(Vector3DStack(0.0, n * 10.0, n % 2), 1.0);
+
+    SweepAndPrune3D sap;
+    TS_ASSERT_EQUALS(sap.getAxis(), -1);
+    std::vector<ColliderPair> pairs;
+    sap.findPairs(colliders, pairs);
+    TS_ASSERT_EQUALS(sap.getAxis(), 1);
+    TS_ASSERT(pairs.empty());
+  }
+
+  void test_UniformGrid3D_CellSize(void)
+  {
+    UniformGrid3D grid;
+    TS_ASSERT_EQUALS(grid.getCellSize(), 0.0);
+    grid.setCellSize(2.5);
+    TS_ASSERT_EQUALS(grid.getCellSize(), 2.5);
+    TS_ASSERT_THROWS(grid.setCellSize(-1.0), std::runtime_error);
+  }
+
+  void test_UniformGrid3D_MatchesBruteForce(void)
+  {
+    srand(3);
+    ColliderSet colliders;
+    randomColliders(colliders, 2000, 100.0, 2.0);
+
+    UniformGrid3D grid;
+    std::vector<ColliderPair> pairs;
+    grid.findPairs(colliders, pairs);
+    TS_ASSERT(!pairs.empty());
+    assertMatchesBruteForce(colliders, pairs);
+  }
+
+  void test_UniformGrid3D_SpanningCells(void)
+  {
+    /* Colliders much larger than a cell, and negative coordinates */
+    srand(4);
+    ColliderSet colliders;
+    randomColliders(colliders, 500, 40.0, 4.0);
+    for (size_t n = 0; n < colliders.size(); n += 3)
+      colliders.setCentre(n, colliders.getCentre(n) * -1.0);
+
+    UniformGrid3D grid(0.75);
+    std::vector<ColliderPair> pairs;
+    grid.findPairs(colliders, pairs);
+
+    /* Each pair is reported once */
+    std::vector<ColliderPair> sorted = pairs;
+    std::sort(sorted.begin(), sorted.end());
+    TS_ASSERT(std::unique(sorted.begin(), sorted.end()) == sorted.end());
+
+    assertMatchesBruteForce(colliders, pairs);
+  }
+
+  void test_UniformGrid3D_LargeColliders(void)
+  {
+    /* A floor and walls far larger than the cells, touching each other and
+     * many of the small colliders */
+    srand(5);
+    ColliderSet colliders;
+    randomColliders(colliders, 1000, 100.0, 1.0);
+    colliders.addBox(Vector3DStack(50.0, 0.0, 50.0),
+                     Vector3DStack(5000.0, 2.0, 5000.0));
+    colliders.addBox(Vector3DStack(0.0, 50.0, 50.0),
+                     Vector3DStack(2.0, 50.0, 50.0));
+    colliders.addBox(Vector3DStack(100.0, 50.0, 50.0),
+                     Vector3DStack(2.0, 50.0, 50.0));
+
+    UniformGrid3D grid;
+    std::vector<ColliderPair> pairs;
+    grid.findPairs(colliders, pairs);
+
+    std::vector<ColliderPair> sorted = pairs;
+    std::sort(sorted.begin(), sorted.end());
+    TS_ASSERT(std::unique(sorted.begin(), sorted.end()) == sorted.end());
+    TS_ASSERT(std::find(sorted.begin(), sorted.end(),
+                        ColliderPair(1000, 1001)) != sorted.end());
+
+    assertMatchesBruteForce(colliders, pairs);
+
+    /* Only large colliders */
+    ColliderSet walls;
+    walls.addBox(Vector3DStack(0.0, 0.0, 0.0), Vector3DStack(9.0, 9.0, 9.0));
+    walls.addBox(Vector3DStack(5.0, 0.0, 0.0), Vector3DStack(9.0, 9.0, 9.0));
+    walls.addBox(Vector3DStack(50.0, 0.0, 0.0), Vector3DStack(9.0, 9.0, 9.0));
+    UniformGrid3D small(1.0);
+    small.findPairs(walls, pairs);
+    TS_ASSERT_EQUALS(pairs.size(), 1);
+    assertMatchesBruteForce(walls, pairs);
+  }
+};
@@ -0,0 +1,225 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "DualQuaternion.h"
+#include "DualQuaternionSkinner.h"
+#include "Quaternion.h"
+#include "TestCommon.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+class DualQuaternionTest : public CxxTest::TestSuite
+{
+public:
+  /**
+   * Creates a random rigid transform.
+   */
+  DualQuaternion randomTransform()
+  {
+    return DualQuaternion(
+        Quaternion(rand() % 360, Vector3DStack(rand() % 5 - 2.0,
+                                               rand() % 5 - 2.0, 1.0)),
+        Vector3DStack(rand() % 21 - 10.0, rand() % 21 - 10.0,
+                      rand() % 21 - 10.0));
+  }
+
+  void assertVectorDelta(const Vector3DStack &a, const Vector3DStack &b,
+                         const double tolerance)
+  {
+    TS_ASSERT_DELTA(a.getX(), b.getX(), tolerance);
+    TS_ASSERT_DELTA(a.getY(), b.getY(), tolerance);
+    TS_ASSERT_DELTA(a.getZ(), b.getZ(), tolerance);
+  }
+
+  void test_DualQuaternion_Identity(void)
+  {
+    DualQuaternion dq;
+    TS_ASSERT(dq.isUnit());
+    TS_ASSERT_EQUALS(dq.getReal(), Quaternion(1.0));
+    TS_ASSERT_EQUALS(dq.getDual(), Quaternion(0.0));
+
+    Vector3DStack p(1.0, -2.0, 3.0);
+    TS_ASSERT_EQUALS(dq.transformPoint(p), p);
+  }
+
+  void test_DualQuaternion_RotationTranslation(void)
+  {
+    /* 90 degrees about z, then move along x */
+    DualQuaternion dq(Quaternion(90.0, Vector3DStack(0.0, 0.0, 1.0)),
+                      Vector3DStack(10.0, 0.0, 0.0));
+    TS_ASSERT(dq.isUnit());
+
+    assertVectorDelta(dq.getTranslation(), Vector3DStack(10.0, 0.0, 0.0), TH);
+    TS_ASSERT_DELTA(dq.getRotation().dot(
+                        Quaternion(90.0, Vector3DStack(0.0, 0.0, 1.0))),
+                    1.0, TH);
+    assertVectorDelta(dq.transformPoint(Vector3DStack(1.0, 0.0, 0.0)),
+                      Vector3DStack(10.0, 1.0, 0.0), TH);
+
+    TS_ASSERT_THROWS(DualQuaternion(Quaternion(0.0), Vector3DStack()),
+                     std::runtime_error);
+  }
+
+  void test_DualQuaternion_Compose(void)
+  {
+    srand(1);
+    for (int n = 0; n < 50; n++)
+    {
+      DualQuaternion a = randomTransform();
+      DualQuaternion b = randomTransform();
+      Vector3DStack p(rand() % 11 - 5.0, rand() % 11 - 5.0, rand() % 11 - 5.0);
+
+      /* a * b applies b first */
+      assertVectorDelta((a * b).transformPoint(p),
+                        a.transformPoint(b.transformPoint(p)), 1e-9);
+      TS_ASSERT((a * b).isUnit(1e-9));
+    }
+  }
+
+  void test_DualQuaternion_Inverse(void)
+  {
+    srand(2);
+    for (int n = 0; n < 50; n++)
+    {
+      DualQuaternion a = randomTransform();
+      Vector3DStack p(rand() % 11 - 5.0, rand() % 11 - 5.0, rand() % 11 - 5.0);
+
+      assertVectorDelta(a.inverse().transformPoint(a.transformPoint(p)), p,
+                        1e-9);
+      assertVectorDelta(a.conjugate().transformPoint(a.transformPoint(p)), p,
+                        1e-9);
+    }
+
+    DualQuaternion zero(Quaternion(0.0), Quaternion(0.0));
+    TS_ASSERT_THROWS(zero.inverse(), std::runtime_error);
+    TS_ASSERT_THROWS(zero.getUnitDualQuaternion(), std::runtime_error);
+  }
+
+  void test_DualQuaternion_Normalise(void)
+  {
+    /* Scaled transforms are the same transform */
+    DualQuaternion a(Quaternion(30.0, Vector3DStack(1.0, 1.0, 0.0)),
+                     Vector3DStack(1.0, 2.0, 3.0));
+    DualQuaternion scaled = a * 3.0;
+    TS_ASSERT(!scaled.isUnit());
+
+    Vector3DStack p(4.0, 5.0, 6.0);
+    assertVectorDelta(scaled.transformPoint(p), a.transformPoint(p), 1e-9);
+    assertVectorDelta(scaled.getTranslation(), a.getTranslation(), 1e-9);
+    TS_ASSERT(scaled.getUnitDualQuaternion().isUnit(1e-12));
+
+    std::vector<Vector3DStack> points(3, p);
+    scaled.transformPoints(&points[0], &points[0], points.size());
+    for (size_t n = 0; n < points.size(); n++)
+      assertVectorDelta(points[n], a.transformPoint(p), 1e-9);
+  }
+
+  void test_DualQuaternion_Blend(void)
+  {
+    DualQuaternion a(Quaternion(0.0, Vector3DStack(0.0, 0.0, 1.0)),
+                     Vector3DStack(0.0, 0.0, 0.0));
+    DualQuaternion b(Quaternion(90.0, Vector3DStack(0.0, 0.0, 1.0)),
+                     Vector3DStack(2.0, 0.0, 0.0));
+
+    /* Halfway between is a rotation of 45 degrees, and a negated transform
+     * blends the same */
+    DualQuaternion transforms[] = {a, b * -1.0};
+    double weights[] = {0.5, 0.5};
+    DualQuaternion mid = DualQuaternion::blend(transforms, weights, 2);
+    TS_ASSERT(mid.isUnit(1e-12));
+    TS_ASSERT_DELTA(std::fabs(mid.getRotation().dot(
+                        Quaternion(45.0, Vector3DStack(0.0, 0.0, 1.0)))),
+                    1.0, 1e-12);
+
+    /* Full weight on one transform gives that transform */
+    weights[0] = 0.0;
+    weights[1] = 1.0;
+    Vector3DStack p(1.0, 2.0, 3.0);
+    assertVectorDelta(
+        DualQuaternion::blend(transforms, weights, 2).transformPoint(p),
+        b.transformPoint(p), 1e-9);
+
+    TS_ASSERT_THROWS(DualQuaternion::blend(transforms, weights, 0),
+                     std::runtime_error);
+  }
+
+  void test_DualQuaternionSkinner_Skin(void)
+  {
+    srand(3);
+    std::vector<DualQuaternion> bones;
+    for (int n = 0; n < 20; n++)
+      bones.push_back(randomTransform());
+    /* Not normalised, setBones() does that */
+    bones[3] = bones[3] * -2.0;
+
+    const size_t size = 40001;
+    Vector3DArray in(size);
+    std::vector<unsigned int> indices(size * 4);
+    std::vector<double> weights(size * 4);
+    for (size_t n = 0; n < size; n++)
+    {
+      in.set(n, Vector3DStack(rand() % 21 - 10.0, rand() % 21 - 10.0,
+                              rand() % 21 - 10.0));
+      for (size_t k = 0; k < 4; k++)
+      {
+        indices[4 * n + k] = rand() % bones.size();
+        weights[4 * n + k] = rand() % 4;
+      }
+      weights[4 * n] += 1.0;
+    }
+
+    for (int simd = 0; simd < 2; simd++)
+    {
+      const ScopedSimdKernels kernels(simd == 1);
+
+      DualQuaternionSkinner skinner;
+      skinner.setBones(&bones[0], bones.size());
+      TS_ASSERT_EQUALS(skinner.numBones(), bones.size());
+
+      Vector3DArray out;
+      skinner.skin(in, &indices[0], &weights[0], out);
+      TS_ASSERT_EQUALS(out.size(), size);
+
+      for (size_t n = 0; n < size; n++)
+      {
+        DualQuaternion influences[4];
+        for (size_t k = 0; k < 4; k++)
+          influences[k] = bones[indices[4 * n + k]].getUnitDualQuaternion();
+        DualQuaternion blended =
+            DualQuaternion::blend(influences, &weights[4 * n], 4);
+        assertVectorDelta(out.get(n), blended.transformPoint(in.get(n)),
+                          1e-9);
+      }
+
+      /* Threaded and in place give the same result */
+      DualQuaternionSkinner threaded(4);
+      threaded.setBones(&bones[0], bones.size());
+      Vector3DArray inPlace(in);
+      threaded.skin(inPlace, &indices[0], &weights[0], inPlace);
+      for (size_t n = 0; n < size; n++)
+        TS_ASSERT_EQUALS(inPlace.get(n), out.get(n));
+    }
+  }
+
+  void test_DualQuaternionSkinner_Invalid(void)
+  {
+    DualQuaternion bone;
+    DualQuaternionSkinner skinner;
+    skinner.setBones(&bone, 1);
+
+    Vector3DArray in(1);
+    Vector3DArray out;
+    unsigned int indices[] = {0, 0, 1, 0};
+    double weights[] = {1.0, 0.0, 0.0, 0.0};
+    TS_ASSERT_THROWS(skinner.skin(in, indices, weights, out),
+                     std::runtime_error);
+
+    indices[2] = 0;
+    skinner.skin(in, indices, weights, out);
+    TS_ASSERT_EQUALS(out.get(0), in.get(0));
+  }
+};
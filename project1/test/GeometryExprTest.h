@@ -0,0 +1,125 @@
+#include <cxxtest/TestSuite.h>
+
+#include <stdexcept>
+
+#include "GeometryExpr.h"
+#include "Quaternion.h"
+#include "TestCommon.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+class GeometryExprTest : public CxxTest::TestSuite
+{
+public:
+  void test_GeometryExpr_VectorArithmetic(void)
+  {
+    Vector3DStack a(1.0, 6.0, 3.0);
+    Vector3DStack b(3.0, -2.0, 8.0);
+    Vector3DStack c(0.5, 0.25, -1.0);
+
+    TS_ASSERT_EQUALS(eval(lazy(a) + lazy(b) * 2.0 - lazy(c)),
+                     a + b * 2.0 - c);
+    TS_ASSERT_EQUALS(eval(3.0 * lazy(a) / 2.0), a * 3.0 / 2.0);
+    TS_ASSERT_EQUALS(eval(lazy(a) % (lazy(b) + lazy(c))), a % (b + c));
+  }
+
+  void test_GeometryExpr_VectorEvalOfArray(void)
+  {
+    Vector3DArray a(2);
+    TS_ASSERT_THROWS(eval(lazy(a) * 2.0), std::runtime_error);
+
+    /* An empty array is still an array */
+    Vector3DArray empty;
+    TS_ASSERT_THROWS(eval(lazy(empty) * 2.0), std::runtime_error);
+  }
+
+  void test_GeometryExpr_DivideByZero(void)
+  {
+    Vector3DStack a(1.0, 6.0, 3.0);
+    TS_ASSERT_THROWS(lazy(a) / 0.0, std::runtime_error);
+  }
+
+  void test_GeometryExpr_ArrayAssignOfVector(void)
+  {
+    Vector3DArray out = makeArray(3, 1.0);
+    Vector3DStack a(1.0, 6.0, 3.0);
+
+    TS_ASSERT_THROWS(assign(out, lazy(a) * 2.0), std::runtime_error);
+    TS_ASSERT_EQUALS(out.size(), 3);
+  }
+
+  void test_GeometryExpr_ArrayAssign(void)
+  {
+    Vector3DArray p = makeArray(7, 1.0);
+    Vector3DArray v = makeArray(7, 2.0);
+    Vector3DStack g(0.0, -9.81, 0.0);
+    const double dt = 0.1;
+
+    Vector3DArray out;
+    assign(out, lazy(p) + (lazy(v) + lazy(g) * dt) * dt);
+
+    TS_ASSERT_EQUALS(out.size(), 7);
+    for (size_t i = 0; i < out.size(); i++)
+    {
+      const Vector3DStack expected = p.get(i) + (v.get(i) + g * dt) * dt;
+      TS_ASSERT_DELTA(out.get(i).getX(), expected.getX(), TH);
+      TS_ASSERT_DELTA(out.get(i).getY(), expected.getY(), TH);
+      TS_ASSERT_DELTA(out.get(i).getZ(), expected.getZ(), TH);
+    }
+  }
+
+  void test_GeometryExpr_ArrayAssignInPlace(void)
+  {
+    Vector3DArray p = makeArray(5, 1.0);
+    Vector3DArray w = makeArray(5, 2.0);
+    Vector3DArray expected = p;
+    Vector3DArray cross;
+    Vector3DArray::cross(w, p, cross);
+    Vector3DArray::add(expected, cross, expected);
+
+    assign(p, lazy(p) + lazy(w) % lazy(p));
+
+    for (size_t i = 0; i < p.size(); i++)
+      TS_ASSERT_EQUALS(p.get(i), expected.get(i));
+  }
+
+  void test_GeometryExpr_ArraySizeMismatch(void)
+  {
+    Vector3DArray a(2);
+    Vector3DArray b(3);
+    TS_ASSERT_THROWS(lazy(a) + lazy(b), std::runtime_error);
+
+    Vector3DArray empty;
+    TS_ASSERT_THROWS(lazy(empty) + lazy(b), std::runtime_error);
+  }
+
+  void test_GeometryExpr_QuaternionArithmetic(void)
+  {
+    Quaternion q1(5.0, 2.0, 4.5, 8.9);
+    Quaternion q2(1.0, -1.0, 2.0, 0.5);
+    Quaternion q3(0.0, 1.0, 0.0, 0.0);
+
+    assertClose(eval(lazy(q1) * lazy(q2) * lazy(q3)), q1 * q2 * q3);
+    assertClose(eval(lazy(q1) + lazy(q2) - lazy(q3)), q1 + q2 - q3);
+    assertClose(eval(lazy(q1) * 0.5 + 2.0 * lazy(q2)),
+                q1 * Quaternion(0.5) + q2 * Quaternion(2.0));
+    assertClose(eval((lazy(q1) + lazy(q2)) * lazy(q3)), (q1 + q2) * q3);
+  }
+
+private:
+  Vector3DArray makeArray(size_t n, double seed)
+  {
+    Vector3DArray a(n);
+    for (size_t i = 0; i < n; i++)
+      a.set(i, Vector3DStack(seed + i, seed * 2.0 - i, 3.0 + seed * i));
+    return a;
+  }
+
+  void assertClose(const Quaternion &a, const Quaternion &b)
+  {
+    TS_ASSERT_DELTA(a.getReal(), b.getReal(), TH);
+    TS_ASSERT_DELTA(a.getI(), b.getI(), TH);
+    TS_ASSERT_DELTA(a.getJ(), b.getJ(), TH);
+    TS_ASSERT_DELTA(a.getK(), b.getK(), TH);
+  }
+};
@@ -0,0 +1,320 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "GeometryIO.h"
+#include "Quaternion.h"
+#include "Vector3DStack.h"
+
+class GeometryIOTest : public CxxTest::TestSuite
+{
+public:
+  void test_FormatDouble_MatchesPrintf(void)
+  {
+    std::vector<double> values = specialValues();
+    srand(1);
+    for (int n = 0; n < 20000; n++)
+      values.push_back(randomValue());
+
+    char expected[64];
+    char formatted[64];
+    for (size_t n = 0; n < values.size(); n++)
+    {
+      for (int precision = 1; precision <= 17; precision++)
+      {
+        snprintf(expected, sizeof(expected), "%.*g", precision, values[n]);
+        const size_t length = formatDouble(values[n], precision, formatted);
+        TS_ASSERT_EQUALS(std::string(formatted), std::string(expected));
+        TS_ASSERT_EQUALS(length, strlen(expected));
+      }
+    }
+  }
+
+  void test_ParseDouble_MatchesStrtod(void)
+  {
+    std::vector<double> values = specialValues();
+    srand(2);
+    for (int n = 0; n < 20000; n++)
+      values.push_back(randomValue());
+
+    const int precisions[] = {3, 6, 9, 15, 16, 17};
+    char text[64];
+    for (size_t n = 0; n < values.size(); n++)
+    {
+      for (int p = 0; p < 6; p++)
+      {
+        snprintf(text, sizeof(text), "%.*g", precisions[p], values[n]);
+        assertParsesLikeStrtod(text);
+      }
+    }
+
+    /* Other forms accepted by strtod */
+    const char *others[] = {"+1.5",
+                            "-0",
+                            "000123.4500",
+                            ".5",
+                            "5.",
+                            "1E5",
+                            "2.5e+03",
+                            "1234567890123456789012345",
+                            "0.1234567890123456789012345",
+                            "1e-300",
+                            "4.9e-324",
+                            "1.7976931348623157e308",
+                            "1e400",
+                            "inf",
+                            "-nan",
+                            "9007199254740993",
+                            "9007199254740993.0000001",
+                            "123456789012345678e-30"};
+    for (size_t n = 0; n < sizeof(others) / sizeof(others[0]); n++)
+      assertParsesLikeStrtod(others[n]);
+
+    /* Stops at the end of the number */
+    double value;
+    const char *text2 = "1.5e,2";
+    TS_ASSERT_EQUALS(parseDouble(text2, text2 + 6, value), text2 + 3);
+    TS_ASSERT_EQUALS(value, 1.5);
+    const char *text3 = "12345";
+    TS_ASSERT_EQUALS(parseDouble(text3, text3 + 2, value), text3 + 2);
+    TS_ASSERT_EQUALS(value, 12.0);
+
+    /* No number */
+    const char *text4 = "x1";
+    TS_ASSERT(parseDouble(text4, text4 + 2, value) == NULL);
+    TS_ASSERT(parseDouble(text4, text4, value) == NULL);
+  }
+
+  void test_GeometryIO_QuaternionText(void)
+  {
+    srand(3);
+    std::vector<Quaternion> quaternions;
+    for (int n = 0; n < 5000; n++)
+      quaternions.push_back(Quaternion(randomValue(), randomValue(),
+                                       randomValue(), randomValue()));
+
+    FILE *file = tmpfile();
+    {
+      GeometryWriter writer(file, GEOMETRY_TEXT, 17, 256);
+      writer.write(&quaternions[0], 1000);
+      writer.write(&quaternions[1000], quaternions.size() - 1000);
+      TS_ASSERT(writer.finish());
+      TS_ASSERT_THROWS(writer.write(&quaternions[0], 1), std::runtime_error);
+    }
+
+    /* One record per line in the format of operator<< */
+    std::stringstream line;
+    line.precision(17);
+    line << quaternions[0] << "\n";
+    TS_ASSERT_EQUALS(readFile(file).substr(0, line.str().size()),
+                     line.str());
+
+    /* Small chunks and uneven batches, so records are split */
+    rewind(file);
+    std::vector<Quaternion> read(quaternions.size() + 10);
+    {
+      GeometryReader reader(file, GEOMETRY_TEXT, 64);
+      size_t count = 0;
+      size_t batch;
+      while ((batch = reader.read(&read[count], 7)) > 0)
+        count += batch;
+      TS_ASSERT_EQUALS(count, quaternions.size());
+      TS_ASSERT_EQUALS(reader.recordsRead(), quaternions.size());
+      TS_ASSERT_EQUALS(reader.read(&read[0], 1), 0);
+    }
+
+    for (size_t n = 0; n < quaternions.size(); n++)
+      TS_ASSERT_EQUALS(read[n], quaternions[n]);
+    fclose(file);
+  }
+
+  void test_GeometryIO_VectorText(void)
+  {
+    /* Written with operator<<, with extra whitespace */
+    FILE *file = makeFile(" [1,2,3]\n\n[ -4.5 , 5e-3,\t6 ]\r\n[7,8,9]");
+    GeometryReader reader(file, GEOMETRY_TEXT, 5);
+    Vector3DStack read[4];
+    TS_ASSERT_EQUALS(reader.read(read, 4), 3);
+    TS_ASSERT_EQUALS(read[0], Vector3DStack(1.0, 2.0, 3.0));
+    TS_ASSERT_EQUALS(read[1], Vector3DStack(-4.5, 5e-3, 6.0));
+    TS_ASSERT_EQUALS(read[2], Vector3DStack(7.0, 8.0, 9.0));
+    fclose(file);
+
+    /* Fewer digits */
+    file = tmpfile();
+    Vector3DStack v(1.0 / 3.0, 2.0, -1e-10);
+    {
+      GeometryWriter writer(file, GEOMETRY_TEXT, 6);
+      writer.write(&v, 1);
+    }
+    TS_ASSERT_EQUALS(readFile(file), "[0.333333,2,-1e-10]\n");
+    fclose(file);
+  }
+
+  void test_GeometryIO_Binary(void)
+  {
+    srand(4);
+    std::vector<Vector3DStack> vectors;
+    for (int n = 0; n < 1001; n++)
+      vectors.push_back(Vector3DStack(randomValue(), randomValue(),
+                                      randomValue()));
+    vectors[0] = Vector3DStack(1.0, -2.0, 0.5);
+
+    FILE *file = tmpfile();
+    {
+      GeometryWriter writer(file, GEOMETRY_BINARY, 17, 100);
+      writer.write(&vectors[0], vectors.size());
+    }
+
+    /* Little endian doubles */
+    const std::string data = readFile(file);
+    TS_ASSERT_EQUALS(data.size(), vectors.size() * 3 * sizeof(double));
+    const unsigned char one[] = {0, 0, 0, 0, 0, 0, 0xf0, 0x3f};
+    TS_ASSERT_EQUALS(memcmp(data.data(), one, 8), 0);
+
+    rewind(file);
+    std::vector<Vector3DStack> read(vectors.size());
+    {
+      GeometryReader reader(file, GEOMETRY_BINARY, 100);
+      TS_ASSERT_EQUALS(reader.read(&read[0], 10), 10);
+      TS_ASSERT_EQUALS(reader.read(&read[10], read.size()), read.size() - 10);
+    }
+
+    for (size_t n = 0; n < vectors.size(); n++)
+      TS_ASSERT_EQUALS(read[n], vectors[n]);
+    fclose(file);
+  }
+
+  void test_GeometryIO_Invalid(void)
+  {
+    const char *invalid[] = {"[1,2]", "[1,2,3,4]", "[1,2,3", "[1,,3]",
+                             "1,2,3]", "[1,2,3]x", "[1,2,3]]"};
+    for (size_t n = 0; n < sizeof(invalid) / sizeof(invalid[0]); n++)
+    {
+      FILE *file = makeFile(invalid[n]);
+      GeometryReader reader(file, GEOMETRY_TEXT, 4);
+      Vector3DStack read[2];
+      TS_ASSERT_THROWS(reader.read(read, 2), std::runtime_error);
+      fclose(file);
+    }
+
+    FILE *file = makeFile(std::string(3 * sizeof(double) + 5, '\0'));
+    GeometryReader reader(file, GEOMETRY_BINARY, 8);
+    Vector3DStack read[2];
+    TS_ASSERT_THROWS(reader.read(read, 2), std::runtime_error);
+    fclose(file);
+
+    FILE *out = tmpfile();
+    TS_ASSERT_THROWS(GeometryWriter(out, GEOMETRY_TEXT, 0),
+                     std::runtime_error);
+    fclose(out);
+  }
+
+private:
+  /**
+   * Values at the edges of the fast paths.
+   */
+  std::vector<double> specialValues()
+  {
+    const double values[] = {0.0,
+                             -0.0,
+                             1.0,
+                             -1.0,
+                             0.5,
+                             2.5,
+                             0.125,
+                             9.5,
+                             99.5,
+                             999.9999,
+                             1e-5,
+                             1e-4,
+                             0.0001234,
+                             1e15,
+                             1e16,
+                             1e17,
+                             123456789012345678.0,
+                             1e22,
+                             1e23,
+                             1e-22,
+                             1e-23,
+                             1.0 / 3.0,
+                             0.1,
+                             0.7071067811865476,
+                             9007199254740993.0,
+                             std::numeric_limits<double>::max(),
+                             std::numeric_limits<double>::min(),
+                             std::numeric_limits<double>::denorm_min(),
+                             std::numeric_limits<double>::infinity(),
+                             -std::numeric_limits<double>::infinity(),
+                             std::numeric_limits<double>::quiet_NaN()};
+    return std::vector<double>(values,
+                               values + sizeof(values) / sizeof(values[0]));
+  }
+
+  /**
+   * Creates a random value, of any sign and of magnitude from about 1e-30 to
+   * 1e30, or a random bit pattern.
+   */
+  double randomValue()
+  {
+    if (rand() % 8 == 0)
+    {
+      unsigned long long bits = 0;
+      for (int n = 0; n < 4; n++)
+        bits = (bits << 16) ^ (unsigned long long)(rand() & 0xffff);
+      double value;
+      memcpy(&value, &bits, sizeof(value));
+      return std::isfinite(value) ? value : 1.0;
+    }
+
+    const double mantissa = rand() / (double)RAND_MAX * 2.0 - 1.0;
+    return mantissa * std::pow(10.0, rand() % 61 - 30);
+  }
+
+  /**
+   * Checks parseDouble() reads the whole text and gives the same value as
+   * strtod().
+   */
+  void assertParsesLikeStrtod(const char *text)
+  {
+    const size_t length = strlen(text);
+    char *expectedEnd;
+    const double expected = strtod(text, &expectedEnd);
+
+    double value;
+    const char *end = parseDouble(text, text + length, value);
+    TS_ASSERT_EQUALS(end, (const char *)expectedEnd);
+    if (std::isnan(expected))
+      TS_ASSERT(std::isnan(value));
+    else
+      TS_ASSERT_EQUALS(memcmp(&value, &expected, sizeof(double)), 0);
+  }
+
+  FILE *makeFile(const std::string &data)
+  {
+    FILE *file = tmpfile();
+    fwrite(data.data(), 1, data.size(), file);
+    rewind(file);
+    return file;
+  }
+
+  std::string readFile(FILE *file)
+  {
+    fflush(file);
+    rewind(file);
+    std::string data;
+    char buffer[256];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+      data.append(buffer, size);
+    return data;
+  }
+};
@@ -0,0 +1,193 @@
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "KdTree.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+class KdTreeTest : public CxxTest::TestSuite
+{
+public:
+  /**
+   * Creates random points in a cube.
+   */
+  std::vector<Vector3DStack> randomPoints(const size_t count)
+  {
+    std::vector<Vector3DStack> points(count);
+    for (size_t n = 0; n < count; n++)
+      points[n] = Vector3DStack(rand() / (double)RAND_MAX * 10.0,
+                                rand() / (double)RAND_MAX * 10.0,
+                                rand() / (double)RAND_MAX * 10.0);
+    return points;
+  }
+
+  /**
+   * Gets the squared distances from a point to every point, sorted.
+   */
+  std::vector<double> sortedDistances(const std::vector<Vector3DStack> &points,
+                                      const Vector3DStack &p)
+  {
+    std::vector<double> d(points.size());
+    for (size_t n = 0; n < points.size(); n++)
+    {
+      const Vector3DStack diff = points[n] - p;
+      d[n] = diff * diff;
+    }
+    std::sort(d.begin(), d.end());
+    return d;
+  }
+
+  void test_KdTree_Empty(void)
+  {
+    KdTree tree;
+    tree.build(NULL, 0);
+    TS_ASSERT_EQUALS(tree.size(), 0);
+
+    std::vector<KdNeighbour> result(1);
+    tree.nearest(Vector3DStack(), 3, result);
+    TS_ASSERT(result.empty());
+    tree.radiusSearch(Vector3DStack(), 1.0, result);
+    TS_ASSERT(result.empty());
+  }
+
+  void test_KdTree_Small(void)
+  {
+    std::vector<Vector3DStack> points;
+    points.push_back(Vector3DStack(0.0, 0.0, 0.0));
+    points.push_back(Vector3DStack(1.0, 0.0, 0.0));
+    points.push_back(Vector3DStack(0.0, 3.0, 0.0));
+
+    KdTree tree;
+    tree.build(&points[0], points.size());
+    TS_ASSERT_EQUALS(tree.size(), 3);
+
+    std::vector<KdNeighbour> result;
+    tree.nearest(Vector3DStack(0.9, 0.1, 0.0), 2, result);
+    TS_ASSERT_EQUALS(result.size(), 2);
+    TS_ASSERT_EQUALS(result[0].index, 1);
+    TS_ASSERT_EQUALS(result[1].index, 0);
+    TS_ASSERT_DELTA(result[0].distanceSquared, 0.02, 1e-12);
+
+    /* k larger than the number of points */
+    tree.nearest(Vector3DStack(), 10, result);
+    TS_ASSERT_EQUALS(result.size(), 3);
+    TS_ASSERT_EQUALS(result[2].index, 2);
+
+    /* Radius includes points at exactly the radius */
+    tree.radiusSearch(Vector3DStack(), 1.0, result);
+    TS_ASSERT_EQUALS(result.size(), 2);
+  }
+
+  void test_KdTree_NearestMatchesBruteForce(void)
+  {
+    srand(1);
+    std::vector<Vector3DStack> points = randomPoints(5000);
+    KdTree tree;
+    tree.build(&points[0], points.size());
+
+    std::vector<KdNeighbour> result;
+    for (int q = 0; q < 50; q++)
+    {
+      const Vector3DStack p = randomPoints(1)[0];
+      tree.nearest(p, 8, result);
+      std::vector<double> expected = sortedDistances(points, p);
+
+      TS_ASSERT_EQUALS(result.size(), 8);
+      for (size_t n = 0; n < result.size(); n++)
+      {
+        TS_ASSERT_EQUALS(result[n].distanceSquared, expected[n]);
+        const Vector3DStack diff = points[result[n].index] - p;
+        TS_ASSERT_EQUALS(result[n].distanceSquared, diff * diff);
+      }
+    }
+  }
+
+  void test_KdTree_RadiusMatchesBruteForce(void)
+  {
+    srand(2);
+    std::vector<Vector3DStack> points = randomPoints(5000);
+    KdTree tree;
+    tree.build(Vector3DArray(&points[0], points.size()));
+
+    std::vector<KdNeighbour> result;
+    for (int q = 0; q < 50; q++)
+    {
+      const Vector3DStack p = randomPoints(1)[0];
+      tree.radiusSearch(p, 0.8, result);
+
+      std::vector<size_t> found;
+      for (size_t n = 0; n < result.size(); n++)
+        found.push_back(result[n].index);
+      std::sort(found.begin(), found.end());
+
+      std::vector<size_t> expected;
+      for (size_t n = 0; n < points.size(); n++)
+      {
+        const Vector3DStack diff = points[n] - p;
+        if (diff * diff <= 0.64)
+          expected.push_back(n);
+      }
+
+      TS_ASSERT(found == expected);
+    }
+  }
+
+  void test_KdTree_Duplicates(void)
+  {
+    std::vector<Vector3DStack> points(100, Vector3DStack(1.0, 1.0, 1.0));
+    points.push_back(Vector3DStack(2.0, 1.0, 1.0));
+
+    KdTree tree;
+    tree.build(&points[0], points.size());
+
+    std::vector<KdNeighbour> result;
+    tree.nearest(Vector3DStack(2.0, 1.0, 1.0), 2, result);
+    TS_ASSERT_EQUALS(result[0].index, 100);
+    TS_ASSERT_EQUALS(result[1].distanceSquared, 1.0);
+
+    tree.radiusSearch(Vector3DStack(1.0, 1.0, 1.0), 0.5, result);
+    TS_ASSERT_EQUALS(result.size(), 100);
+  }
+
+  void test_KdTree_Batched(void)
+  {
+    srand(3);
+    std::vector<Vector3DStack> points = randomPoints(200000);
+    std::vector<Vector3DStack> queries = randomPoints(3000);
+
+    /* Threaded build gives the same answers as a single thread */
+    KdTree single(1);
+    KdTree threaded(4);
+    single.build(&points[0], points.size());
+    threaded.build(&points[0], points.size());
+    TS_ASSERT_EQUALS(threaded.getNumThreads(), 4);
+
+    std::vector<KdNeighbour> batch;
+    threaded.nearest(&queries[0], queries.size(), 3, batch);
+    TS_ASSERT_EQUALS(batch.size(), 3 * queries.size());
+
+    std::vector<size_t> offsets;
+    std::vector<KdNeighbour> radiusBatch;
+    threaded.radiusSearch(&queries[0], queries.size(), 0.1, offsets,
+                          radiusBatch);
+    TS_ASSERT_EQUALS(offsets.size(), queries.size() + 1);
+    TS_ASSERT_EQUALS(offsets.back(), radiusBatch.size());
+
+    std::vector<KdNeighbour> result;
+    for (size_t q = 0; q < queries.size(); q += 97)
+    {
+      single.nearest(queries[q], 3, result);
+      for (size_t n = 0; n < 3; n++)
+        TS_ASSERT_EQUALS(batch[3 * q + n].distanceSquared,
+                         result[n].distanceSquared);
+
+      single.radiusSearch(queries[q], 0.1, result);
+      TS_ASSERT_EQUALS(offsets[q + 1] - offsets[q], result.size());
+      for (size_t n = 0; n < result.size(); n++)
+        TS_ASSERT_EQUALS(radiusBatch[offsets[q] + n].index, result[n].index);
+    }
+  }
+};
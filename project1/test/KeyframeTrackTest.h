@@ -0,0 +1,157 @@
+#include <cxxtest/TestSuite.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "KeyframeSampler.h"
+#include "KeyframeTrack.h"
+#include "Quaternion.h"
+#include "TestCommon.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+class KeyframeTrackTest : public CxxTest::TestSuite
+{
+public:
+  void test_KeyframeTrack_AddKey(void)
+  {
+    KeyframeTrack track;
+    track.addKey(0.0, Quaternion());
+    track.addKey(2.0, Quaternion(2.0, 0.0, 0.0, 0.0));
+
+    TS_ASSERT_EQUALS(track.size(), 2);
+    TS_ASSERT_EQUALS(track.startTime(), 0.0);
+    TS_ASSERT_EQUALS(track.endTime(), 2.0);
+    TS_ASSERT_EQUALS(track.keyTime(1), 2.0);
+
+    /* Keys are normalised */
+    TS_ASSERT_EQUALS(track.key(1), Quaternion());
+  }
+
+  void test_KeyframeTrack_KeysMustIncrease(void)
+  {
+    KeyframeTrack track;
+    track.addKey(1.0, Quaternion());
+    TS_ASSERT_THROWS(track.addKey(1.0, Quaternion()), std::runtime_error);
+    TS_ASSERT_THROWS(track.addKey(0.5, Quaternion()), std::runtime_error);
+    TS_ASSERT_EQUALS(track.size(), 1);
+  }
+
+  void test_KeyframeTrack_IndexOutOfRange(void)
+  {
+    KeyframeTrack track;
+    TS_ASSERT_THROWS(track.key(0), std::runtime_error);
+    TS_ASSERT_THROWS(track.keyTime(0), std::runtime_error);
+  }
+
+  void test_KeyframeTrack_SampleEmpty(void)
+  {
+    KeyframeTrack track;
+    size_t cursor = 0;
+    TS_ASSERT_THROWS(track.sample(0.0, cursor), std::runtime_error);
+  }
+
+  void test_KeyframeTrack_SampleSingleKey(void)
+  {
+    KeyframeTrack track;
+    Quaternion q(30.0, Vector3DStack(0.0, 1.0, 0.0));
+    track.addKey(1.0, q);
+
+    size_t cursor = 0;
+    TS_ASSERT_EQUALS(track.sample(0.0, cursor), q);
+    TS_ASSERT_EQUALS(track.sample(5.0, cursor), q);
+  }
+
+  void test_KeyframeTrack_Seek(void)
+  {
+    KeyframeTrack track = makeTrack(0.0);
+
+    TS_ASSERT_EQUALS(track.seek(-1.0, 0), 0);
+    TS_ASSERT_EQUALS(track.seek(0.5, 0), 0);
+    TS_ASSERT_EQUALS(track.seek(1.0, 0), 1);
+    TS_ASSERT_EQUALS(track.seek(2.5, 0), 2);
+    TS_ASSERT_EQUALS(track.seek(100.0, 0), 3);
+
+    /* Seeking backwards and from an invalid cursor */
+    TS_ASSERT_EQUALS(track.seek(0.5, 3), 0);
+    TS_ASSERT_EQUALS(track.seek(2.5, 100), 2);
+  }
+
+  void test_KeyframeTrack_Sample(void)
+  {
+    KeyframeTrack track = makeTrack(0.0);
+    size_t cursor = 0;
+
+    /* Keys at 0, 1, 2, 3, 4 rotate 0, 20, 40, 60, 80 degrees about z */
+    for (double time = -0.5; time < 4.5; time += 0.25)
+    {
+      double clamped = time < 0.0 ? 0.0 : (time > 4.0 ? 4.0 : time);
+      Quaternion expected(clamped * 20.0, Vector3DStack(0.0, 0.0, 1.0));
+
+      TS_ASSERT_DELTA(track.sample(time, cursor, INTERP_SLERP).dot(expected),
+                      1.0, TH);
+      TS_ASSERT_DELTA(track.sample(time, cursor, INTERP_NLERP).dot(expected),
+                      1.0, TH);
+    }
+  }
+
+  void test_KeyframeSampler_EmptyTrack(void)
+  {
+    KeyframeTrack tracks[2];
+    tracks[0].addKey(0.0, Quaternion());
+    TS_ASSERT_THROWS(KeyframeSampler(tracks, 2), std::runtime_error);
+  }
+
+  void test_KeyframeSampler_MatchesTracks(void)
+  {
+    for (int simd = 0; simd < 2; simd++)
+    {
+      const ScopedSimdKernels kernels(simd == 1);
+      checkSampler(INTERP_NLERP);
+      checkSampler(INTERP_SLERP);
+    }
+  }
+
+private:
+  KeyframeTrack makeTrack(double offset)
+  {
+    KeyframeTrack track;
+    for (int n = 0; n < 5; n++)
+    {
+      track.addKey(n + offset,
+                   Quaternion(n * 20.0, Vector3DStack(0.0, 0.0, 1.0)));
+    }
+    return track;
+  }
+
+  void checkSampler(Interpolation interp)
+  {
+    /* Odd number of tracks to cover the SIMD remainder */
+    std::vector<KeyframeTrack> tracks;
+    for (int n = 0; n < 5; n++)
+      tracks.push_back(makeTrack(n * 0.3));
+
+    /* One key, and opposite hemisphere keys */
+    tracks.push_back(KeyframeTrack());
+    tracks.back().addKey(0.0, Quaternion(30.0, Vector3DStack(1.0, 0.0, 0.0)));
+    tracks.push_back(KeyframeTrack());
+    tracks.back().addKey(0.0, Quaternion(0.5, 0.5, 0.5, 0.5));
+    tracks.back().addKey(4.0, Quaternion(0.5, -0.5, -0.5, -0.5));
+
+    KeyframeSampler sampler(&tracks[0], tracks.size());
+    TS_ASSERT_EQUALS(sampler.size(), tracks.size());
+
+    std::vector<Quaternion> out(tracks.size());
+    std::vector<size_t> cursors(tracks.size(), 0);
+
+    for (double time = -1.0; time < 6.0; time += 0.35)
+    {
+      sampler.sample(time, &out[0], interp);
+      for (size_t n = 0; n < tracks.size(); n++)
+      {
+        Quaternion expected = tracks[n].sample(time, cursors[n], interp);
+        TS_ASSERT_DELTA(out[n].dot(expected), 1.0, TH);
+      }
+    }
+  }
+};
@@ -0,0 +1,195 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "OrientedBox.h"
+#include "OrientedBoxSet.h"
+#include "Quaternion.h"
+#include "TestCommon.h"
+#include "Vector3DStack.h"
+
+class OrientedBoxTest : public CxxTest::TestSuite
+{
+public:
+  /**
+   * Creates a random box.
+   */
+  OrientedBox randomBox(const double worldSize)
+  {
+    return OrientedBox(
+        Vector3DStack(rand() / (double)RAND_MAX * worldSize,
+                      rand() / (double)RAND_MAX * worldSize,
+                      rand() / (double)RAND_MAX * worldSize),
+        Vector3DStack(0.1 + rand() / (double)RAND_MAX,
+                      0.1 + rand() / (double)RAND_MAX,
+                      0.1 + rand() / (double)RAND_MAX),
+        Quaternion(rand() % 360, Vector3DStack(rand() % 5 - 2.0,
+                                               rand() % 5 - 2.0, 1.0)));
+  }
+
+  void test_OrientedBox_Axes(void)
+  {
+    OrientedBox box(Vector3DStack(1.0, 2.0, 3.0), Vector3DStack(1.0, 2.0, 3.0),
+                    Quaternion(0.0, 0.0, 0.0, 1.0));
+
+    /* 180 degrees about z */
+    TS_ASSERT_DELTA(box.getAxis(0).getX(), -1.0, TH);
+    TS_ASSERT_DELTA(box.getAxis(1).getY(), -1.0, TH);
+    TS_ASSERT_DELTA(box.getAxis(2).getZ(), 1.0, TH);
+    TS_ASSERT_THROWS(box.getAxis(3), std::runtime_error);
+
+    /* Axes match rotated unit vectors */
+    Quaternion q(37.0, Vector3DStack(1.0, -2.0, 0.5));
+    box.setOrientation(q);
+    Vector3DStack rotated = q.rotateVector(Vector3DStack(0.0, 1.0, 0.0));
+    TS_ASSERT_DELTA(box.getAxis(1).getX(), rotated.getX(), TH);
+    TS_ASSERT_DELTA(box.getAxis(1).getY(), rotated.getY(), TH);
+    TS_ASSERT_DELTA(box.getAxis(1).getZ(), rotated.getZ(), TH);
+  }
+
+  void test_OrientedBox_Invalid(void)
+  {
+    OrientedBox box;
+    TS_ASSERT_THROWS(box.setOrientation(Quaternion(0.0, 0.0, 0.0, 0.0)),
+                     std::runtime_error);
+    TS_ASSERT_THROWS(box.setHalfExtents(Vector3DStack(1.0, -1.0, 1.0)),
+                     std::runtime_error);
+  }
+
+  void test_OrientedBox_BoundingHalfExtents(void)
+  {
+    OrientedBox box(Vector3DStack(), Vector3DStack(1.0, 1.0, 1.0),
+                    Quaternion(45.0, Vector3DStack(0.0, 0.0, 1.0)));
+    Vector3DStack bounds = box.getBoundingHalfExtents();
+    TS_ASSERT_DELTA(bounds.getX(), std::sqrt(2.0), TH);
+    TS_ASSERT_DELTA(bounds.getY(), std::sqrt(2.0), TH);
+    TS_ASSERT_DELTA(bounds.getZ(), 1.0, TH);
+  }
+
+  void test_OrientedBox_Aligned(void)
+  {
+    OrientedBox a(Vector3DStack(), Vector3DStack(1.0, 1.0, 1.0), Quaternion());
+    OrientedBox b(Vector3DStack(1.9, 0.0, 0.0), Vector3DStack(1.0, 1.0, 1.0),
+                  Quaternion());
+    TS_ASSERT(a.intersects(b));
+
+    b.setCentre(Vector3DStack(2.1, 0.0, 0.0));
+    TS_ASSERT(!a.intersects(b));
+    TS_ASSERT(!b.intersects(a));
+  }
+
+  void test_OrientedBox_Rotated(void)
+  {
+    /* The corner of a box rotated 45 degrees reaches 1.414 along x */
+    OrientedBox a(Vector3DStack(), Vector3DStack(1.0, 1.0, 1.0),
+                  Quaternion(45.0, Vector3DStack(0.0, 0.0, 1.0)));
+    OrientedBox b(Vector3DStack(2.3, 0.0, 0.0), Vector3DStack(1.0, 1.0, 1.0),
+                  Quaternion());
+    TS_ASSERT(a.intersects(b));
+
+    b.setCentre(Vector3DStack(2.5, 0.0, 0.0));
+    TS_ASSERT(!a.intersects(b));
+
+    /* Bounding boxes overlap but the boxes do not */
+    b.setCentre(Vector3DStack(2.2, 2.2, 0.0));
+    TS_ASSERT(!a.intersects(b));
+  }
+
+  void test_OrientedBox_EdgeEdge(void)
+  {
+    /* Two long thin boxes crossed at right angles, one above the other */
+    OrientedBox a(Vector3DStack(), Vector3DStack(5.0, 0.1, 0.1),
+                  Quaternion(45.0, Vector3DStack(0.0, 0.0, 1.0)));
+    OrientedBox b(Vector3DStack(0.0, 0.0, 0.3), Vector3DStack(5.0, 0.1, 0.1),
+                  Quaternion(-45.0, Vector3DStack(0.0, 0.0, 1.0)));
+    TS_ASSERT(!a.intersects(b));
+
+    b.setCentre(Vector3DStack(0.0, 0.0, 0.15));
+    TS_ASSERT(a.intersects(b));
+  }
+
+  void test_OrientedBoxSet_AddGet(void)
+  {
+    OrientedBoxSet boxes;
+    OrientedBox box(Vector3DStack(1.0, 2.0, 3.0), Vector3DStack(1.0, 2.0, 3.0),
+                    Quaternion(30.0, Vector3DStack(0.0, 1.0, 0.0)));
+    TS_ASSERT_EQUALS(boxes.addBox(OrientedBox()), 0);
+    TS_ASSERT_EQUALS(boxes.addBox(box), 1);
+    TS_ASSERT_EQUALS(boxes.size(), 2);
+
+    OrientedBox copy = boxes.getBox(1);
+    TS_ASSERT_EQUALS(copy.getCentre(), box.getCentre());
+    TS_ASSERT_EQUALS(copy.getHalfExtents(), box.getHalfExtents());
+    TS_ASSERT_EQUALS(copy.getOrientation(), box.getOrientation());
+    TS_ASSERT_DELTA(boxes.axis(0, 2)[1], box.getAxis(0).getZ(), TH);
+    TS_ASSERT_DELTA(boxes.boundingHalfExtents().x()[1],
+                    box.getBoundingHalfExtents().getX(), TH);
+
+    TS_ASSERT_THROWS(boxes.getBox(2), std::runtime_error);
+    TS_ASSERT_THROWS(boxes.axis(3, 0), std::runtime_error);
+    TS_ASSERT_THROWS(boxes.orientation(4), std::runtime_error);
+  }
+
+  void test_OrientedBoxSet_UpdateAxes(void)
+  {
+    OrientedBoxSet boxes;
+    boxes.addBox(OrientedBox(Vector3DStack(), Vector3DStack(1.0, 1.0, 1.0),
+                             Quaternion()));
+    boxes.addBox(OrientedBox(Vector3DStack(2.3, 0.0, 0.0),
+                             Vector3DStack(1.0, 1.0, 1.0), Quaternion()));
+    TS_ASSERT(!boxes.intersects(0, 1));
+
+    /* Rotate the first box in place */
+    Quaternion q(45.0, Vector3DStack(0.0, 0.0, 1.0));
+    boxes.orientation(0)[0] = q.getReal();
+    boxes.orientation(3)[0] = q.getK();
+    boxes.updateAxes();
+
+    TS_ASSERT(boxes.intersects(0, 1));
+    TS_ASSERT(boxes.intersects(1, 0));
+    TS_ASSERT_DELTA(boxes.axis(0, 1)[0], std::sqrt(0.5), TH);
+  }
+
+  void test_OrientedBoxSet_FindIntersecting(void)
+  {
+    srand(1);
+    OrientedBoxSet boxes;
+    std::vector<OrientedBox> list;
+    for (int n = 0; n < 500; n++)
+    {
+      list.push_back(randomBox(20.0));
+      boxes.addBox(list.back());
+    }
+
+    size_t total = 0;
+    std::vector<size_t> hits;
+    for (int q = 0; q < 20; q++)
+    {
+      OrientedBox query = randomBox(20.0);
+      boxes.findIntersecting(query, hits);
+
+      std::vector<size_t> expected;
+      for (size_t n = 0; n < list.size(); n++)
+      {
+        if (query.intersects(list[n]))
+          expected.push_back(n);
+      }
+
+      TS_ASSERT(hits == expected);
+      total += hits.size();
+
+      /* Candidate list gives the same result for the candidates */
+      std::vector<size_t> candidates;
+      for (size_t n = 0; n < list.size(); n += 2)
+        candidates.push_back(n);
+      boxes.findIntersecting(query, &candidates[0], candidates.size(), hits);
+      for (size_t n = 0; n < hits.size(); n++)
+        TS_ASSERT(hits[n] % 2 == 0 && query.intersects(list[hits[n]]));
+    }
+
+    TS_ASSERT(total > 0);
+  }
+};
@@ -0,0 +1,120 @@
+#include <cxxtest/TestSuite.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "Parallel.h"
+
+class ParallelTest : public CxxTest::TestSuite
+{
+public:
+  void test_Parallel_ResolveNumThreads(void)
+  {
+    TS_ASSERT_EQUALS(resolveNumThreads(3), 3);
+    TS_ASSERT(resolveNumThreads(0) >= 1);
+  }
+
+  void test_Parallel_Threads(void)
+  {
+    TS_ASSERT_EQUALS(parallelThreads(0, 100, 4), 1);
+    TS_ASSERT_EQUALS(parallelThreads(199, 100, 4), 1);
+    TS_ASSERT_EQUALS(parallelThreads(200, 100, 4), 2);
+    TS_ASSERT_EQUALS(parallelThreads(1000, 100, 4), 4);
+    TS_ASSERT_EQUALS(parallelThreads(1000, 0, 4), 4);
+    TS_ASSERT_EQUALS(parallelThreads(1000, 100, 0), 1);
+  }
+
+  void test_Parallel_EmptyRange(void)
+  {
+    int calls = 0;
+    parallelFor(5, 5, 1, 1, 4, [&](size_t, size_t, size_t) { calls++; });
+    TS_ASSERT_EQUALS(calls, 0);
+    TS_ASSERT_EQUALS(parallelChunks(0, 1, 1, 4), 0);
+  }
+
+  void test_Parallel_SingleThread(void)
+  {
+    std::vector<size_t> ranges;
+    parallelFor(3, 50, 100, 8, 4, [&](size_t c, size_t begin, size_t end) {
+      ranges.push_back(c);
+      ranges.push_back(begin);
+      ranges.push_back(end);
+    });
+
+    TS_ASSERT_EQUALS(ranges.size(), 3);
+    TS_ASSERT_EQUALS(ranges[0], 0);
+    TS_ASSERT_EQUALS(ranges[1], 3);
+    TS_ASSERT_EQUALS(ranges[2], 50);
+    TS_ASSERT_EQUALS(parallelChunks(47, 100, 8, 4), 1);
+  }
+
+  void test_Parallel_Chunks(void)
+  {
+    checkChunks(0, 1000, 10, 1, 4);
+    checkChunks(0, 1001, 10, 8, 3);
+    checkChunks(17, 1000, 10, 1, 7);
+    checkChunks(0, 100, 1, 64, 10);
+  }
+
+  void test_Parallel_Exception(void)
+  {
+    TS_ASSERT_THROWS(parallelFor(0, 100, 1, 1, 4,
+                                 [](size_t c, size_t, size_t) {
+                                   if (c == 0)
+                                     throw std::runtime_error("chunk");
+                                 }),
+                     std::runtime_error);
+  }
+
+  void test_Parallel_WorkerException(void)
+  {
+    /* Every chunk runs to completion even though a worker throws */
+    std::atomic<int> calls(0);
+    TS_ASSERT_THROWS(parallelFor(0, 100, 1, 1, 4,
+                                 [&](size_t c, size_t, size_t) {
+                                   calls++;
+                                   if (c == 3)
+                                     throw std::runtime_error("chunk");
+                                 }),
+                     std::runtime_error);
+    TS_ASSERT_EQUALS(calls, 4);
+  }
+
+private:
+  /* Checks every element is processed once, by the expected chunks */
+  void checkChunks(const size_t begin, const size_t end,
+                   const size_t minPerThread, const size_t alignment,
+                   const unsigned int maxThreads)
+  {
+    const size_t numChunks =
+        parallelChunks(end - begin, minPerThread, alignment, maxThreads);
+    std::vector<std::atomic<int> > visits(end);
+    std::vector<size_t> chunkBegin(numChunks, 0);
+    std::vector<size_t> chunkEnd(numChunks, 0);
+    for (size_t n = 0; n < end; n++)
+      visits[n] = 0;
+
+    parallelFor(begin, end, minPerThread, alignment, maxThreads,
+                [&](size_t c, size_t b, size_t e) {
+                  chunkBegin[c] = b;
+                  chunkEnd[c] = e;
+                  for (size_t n = b; n < e; n++)
+                    visits[n]++;
+                });
+
+    for (size_t n = 0; n < end; n++)
+      TS_ASSERT_EQUALS(visits[n], n < begin ? 0 : 1);
+
+    TS_ASSERT(numChunks <= maxThreads);
+    TS_ASSERT_EQUALS(chunkBegin[0], begin);
+    TS_ASSERT_EQUALS(chunkEnd[numChunks - 1], end);
+    for (size_t c = 0; c < numChunks; c++)
+    {
+      TS_ASSERT_EQUALS((chunkBegin[c] - begin) % alignment, 0);
+      TS_ASSERT(chunkBegin[c] < chunkEnd[c]);
+      if (c > 0)
+        TS_ASSERT_EQUALS(chunkBegin[c], chunkEnd[c - 1]);
+    }
+  }
+};
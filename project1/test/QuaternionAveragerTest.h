@@ -0,0 +1,178 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "Quaternion.h"
+#include "QuaternionAverager.h"
+#include "TestCommon.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+class QuaternionAveragerTest : public CxxTest::TestSuite
+{
+public:
+  /**
+   * Asserts two quaternions are the same rotation.
+   */
+  void assertSameRotation(const Quaternion &a, const Quaternion &b,
+                          const double tolerance)
+  {
+    TS_ASSERT_DELTA(std::fabs(a.dot(b)), 1.0, tolerance);
+  }
+
+  /**
+   * Creates samples scattered about an orientation, split into component
+   * arrays, with random signs.
+   */
+  void scatteredSamples(const Quaternion &centre, const size_t count,
+                        const double spread, std::vector<double> c[4])
+  {
+    for (int n = 0; n < 4; n++)
+      c[n].resize(count);
+
+    for (size_t n = 0; n < count; n++)
+    {
+      Quaternion q =
+          centre * Quaternion((rand() / (double)RAND_MAX - 0.5) * spread,
+                              Vector3DStack(rand() % 5 - 2.0, rand() % 5 - 2.0,
+                                            1.0));
+      const double s = rand() % 2 ? 1.0 : -1.0;
+      c[0][n] = s * q.getReal();
+      c[1][n] = s * q.getI();
+      c[2][n] = s * q.getJ();
+      c[3][n] = s * q.getK();
+    }
+  }
+
+  void test_QuaternionAverager_Empty(void)
+  {
+    QuaternionAverager averager;
+    TS_ASSERT_EQUALS(averager.count(), 0);
+    TS_ASSERT_THROWS(averager.average(), std::runtime_error);
+    TS_ASSERT_THROWS(averager.add(Quaternion(), -1.0), std::runtime_error);
+  }
+
+  void test_QuaternionAverager_Single(void)
+  {
+    Quaternion q(120.0, Vector3DStack(1.0, 2.0, 3.0));
+    QuaternionAverager eigen;
+    QuaternionAverager aligned(AVERAGE_SIGN_ALIGNED);
+
+    /* Negated and unnormalised samples are the same rotation */
+    eigen.add(Quaternion(-2.0 * q.getReal(), -2.0 * q.getI(), -2.0 * q.getJ(),
+                         -2.0 * q.getK()));
+    aligned.add(q);
+
+    assertSameRotation(eigen.average(), q, 1e-12);
+    assertSameRotation(aligned.average(), q, 1e-12);
+    TS_ASSERT(eigen.average().getReal() >= 0.0);
+  }
+
+  void test_QuaternionAverager_Symmetric(void)
+  {
+    /* Samples rotated either way about one axis average to the centre */
+    Quaternion centre(40.0, Vector3DStack(0.0, 1.0, 1.0));
+    QuaternionAverager averager;
+    averager.add(centre * Quaternion(30.0, Vector3DStack(1.0, 0.0, 0.0)));
+    averager.add(centre * Quaternion(-30.0, Vector3DStack(1.0, 0.0, 0.0)));
+    averager.add(centre * Quaternion(10.0, Vector3DStack(0.0, 0.0, 1.0)), 2.0);
+    averager.add(centre * Quaternion(-10.0, Vector3DStack(0.0, 0.0, 1.0)), 2.0);
+
+    TS_ASSERT_EQUALS(averager.count(), 4);
+    TS_ASSERT_DELTA(averager.totalWeight(), 6.0, 1e-12);
+    assertSameRotation(averager.average(), centre, 1e-9);
+  }
+
+  void test_QuaternionAverager_Weighted(void)
+  {
+    /* Weights pull the average towards the heavier sample */
+    Quaternion a(0.0, Vector3DStack(0.0, 0.0, 1.0));
+    Quaternion b(90.0, Vector3DStack(0.0, 0.0, 1.0));
+    QuaternionAverager averager;
+    averager.add(a, 3.0);
+    averager.add(b, 1.0);
+
+    Quaternion mean = averager.average();
+    TS_ASSERT(std::fabs(mean.dot(a)) > std::fabs(mean.dot(b)));
+  }
+
+  void test_QuaternionAverager_Bulk(void)
+  {
+    srand(1);
+    Quaternion centre(75.0, Vector3DStack(1.0, -1.0, 0.5));
+    std::vector<double> c[4];
+    scatteredSamples(centre, 200001, 20.0, c);
+
+    for (int method = 0; method < 2; method++)
+    {
+      for (int simd = 0; simd < 2; simd++)
+      {
+        const ScopedSimdKernels kernels(simd == 1);
+
+        QuaternionAverager single((AverageMethod)method, 1);
+        single.add(&c[0][0], &c[1][0], &c[2][0], &c[3][0], c[0].size());
+
+        QuaternionAverager threaded((AverageMethod)method, 4);
+        threaded.add(&c[0][0], &c[1][0], &c[2][0], &c[3][0], c[0].size());
+
+        /* One at a time gives the same result */
+        QuaternionAverager each((AverageMethod)method);
+        for (size_t n = 0; n < c[0].size(); n++)
+          each.add(Quaternion(c[0][n], c[1][n], c[2][n], c[3][n]));
+
+        TS_ASSERT_EQUALS(single.count(), c[0].size());
+        TS_ASSERT_EQUALS(threaded.count(), c[0].size());
+        assertSameRotation(single.average(), centre, 1e-4);
+        assertSameRotation(threaded.average(), single.average(), 1e-12);
+        assertSameRotation(each.average(), single.average(), 1e-12);
+      }
+    }
+  }
+
+  void test_QuaternionAverager_Streaming(void)
+  {
+    /* Accumulators filled separately merge to the same result as one */
+    srand(2);
+    Quaternion centre(200.0, Vector3DStack(0.0, 1.0, 0.0));
+    std::vector<double> c[4];
+    scatteredSamples(centre, 10000, 30.0, c);
+
+    for (int method = 0; method < 2; method++)
+    {
+      QuaternionAverager whole((AverageMethod)method);
+      whole.add(&c[0][0], &c[1][0], &c[2][0], &c[3][0], c[0].size());
+
+      QuaternionAverager merged((AverageMethod)method);
+      for (size_t begin = 0; begin < c[0].size(); begin += 999)
+      {
+        const size_t count = std::min<size_t>(999, c[0].size() - begin);
+        QuaternionAverager part((AverageMethod)method);
+        part.add(&c[0][begin], &c[1][begin], &c[2][begin], &c[3][begin],
+                 count);
+        merged.merge(part);
+      }
+
+      TS_ASSERT_EQUALS(merged.count(), whole.count());
+      assertSameRotation(merged.average(), whole.average(), 1e-12);
+    }
+
+    QuaternionAverager eigen(AVERAGE_EIGEN);
+    QuaternionAverager aligned(AVERAGE_SIGN_ALIGNED);
+    TS_ASSERT_THROWS(eigen.merge(aligned), std::runtime_error);
+  }
+
+  void test_QuaternionAverager_Spread(void)
+  {
+    /* Samples far apart, where aligning signs with the first sample is not
+     * enough but the eigen method still finds the centre */
+    Quaternion centre(10.0, Vector3DStack(0.0, 0.0, 1.0));
+    QuaternionAverager averager;
+    for (int n = -4; n <= 4; n++)
+      averager.add(centre * Quaternion(n * 40.0, Vector3DStack(1.0, 0.0, 0.0)));
+
+    assertSameRotation(averager.average(), centre, 1e-9);
+  }
+};
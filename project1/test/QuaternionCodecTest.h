@@ -0,0 +1,154 @@
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "Quaternion.h"
+#include "QuaternionCodec.h"
+#include "TestCommon.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+class QuaternionCodecTest : public CxxTest::TestSuite
+{
+public:
+  void test_QuaternionCodec_Identity(void)
+  {
+    TS_ASSERT_EQUALS(QuaternionCodec::decode32(
+                         QuaternionCodec::encode32(Quaternion())),
+                     Quaternion());
+    TS_ASSERT_EQUALS(QuaternionCodec::decode48(
+                         QuaternionCodec::encode48(Quaternion())),
+                     Quaternion());
+  }
+
+  void test_QuaternionCodec_48BitsUsed(void)
+  {
+    Quaternion q(0.5, -0.5, 0.5, -0.5);
+    TS_ASSERT_EQUALS(QuaternionCodec::encode48(q) >> 48, 0);
+  }
+
+  void test_QuaternionCodec_NegatedLargest(void)
+  {
+    /* -q is the same rotation, so decodes to q */
+    Quaternion q(-0.9, 0.1, -0.3, 0.2);
+    q = q.getUnitQuaternion();
+    Quaternion d = QuaternionCodec::decode48(QuaternionCodec::encode48(q));
+
+    TS_ASSERT_DELTA(d.getReal(), -q.getReal(), TH);
+    TS_ASSERT_DELTA(d.getI(), -q.getI(), TH);
+    TS_ASSERT_DELTA(d.getJ(), -q.getJ(), TH);
+    TS_ASSERT_DELTA(d.getK(), -q.getK(), TH);
+  }
+
+  void test_QuaternionCodec_NotUnit(void)
+  {
+    Quaternion q(5.0, 2.0, 4.5, 8.9);
+    Quaternion d = QuaternionCodec::decode48(QuaternionCodec::encode48(q));
+    TS_ASSERT_DELTA(d.dot(q.getUnitQuaternion()), 1.0, TH);
+
+    TS_ASSERT_THROWS(QuaternionCodec::encode32(Quaternion(0.0)),
+                     std::runtime_error);
+  }
+
+  void test_QuaternionCodec_ErrorBound32(void)
+  {
+    std::vector<Quaternion> q = randomQuaternions(20000);
+    for (size_t n = 0; n < q.size(); n++)
+    {
+      const Quaternion d =
+          QuaternionCodec::decode32(QuaternionCodec::encode32(q[n]));
+      TS_ASSERT_LESS_THAN_EQUALS(error(q[n], d), QuaternionCodec::MAX_ERROR_32);
+    }
+  }
+
+  void test_QuaternionCodec_ErrorBound48(void)
+  {
+    std::vector<Quaternion> q = randomQuaternions(20000);
+    for (size_t n = 0; n < q.size(); n++)
+    {
+      const Quaternion d =
+          QuaternionCodec::decode48(QuaternionCodec::encode48(q[n]));
+      TS_ASSERT_LESS_THAN_EQUALS(error(q[n], d), QuaternionCodec::MAX_ERROR_48);
+    }
+  }
+
+  void test_QuaternionCodec_Bulk32(void)
+  {
+    std::vector<Quaternion> q = randomQuaternions(101);
+    std::vector<uint32_t> packed(q.size());
+    QuaternionCodec::encode32(&q[0], &packed[0], q.size());
+
+    for (int simd = 0; simd < 2; simd++)
+    {
+      const ScopedSimdKernels kernels(simd == 1);
+      std::vector<Quaternion> d(q.size());
+      QuaternionCodec::decode32(&packed[0], &d[0], q.size());
+
+      for (size_t n = 0; n < q.size(); n++)
+      {
+        TS_ASSERT_EQUALS(packed[n], QuaternionCodec::encode32(q[n]));
+        assertClose(d[n], QuaternionCodec::decode32(packed[n]));
+      }
+    }
+  }
+
+  void test_QuaternionCodec_Bulk48(void)
+  {
+    std::vector<Quaternion> q = randomQuaternions(101);
+    std::vector<uint8_t> packed(q.size() * QuaternionCodec::PACKED48_BYTES);
+    QuaternionCodec::encode48(&q[0], &packed[0], q.size());
+
+    /* Little endian */
+    const uint64_t first = QuaternionCodec::encode48(q[0]);
+    TS_ASSERT_EQUALS(packed[0], first & 0xFF);
+    TS_ASSERT_EQUALS(packed[5], (first >> 40) & 0xFF);
+
+    for (int simd = 0; simd < 2; simd++)
+    {
+      const ScopedSimdKernels kernels(simd == 1);
+      std::vector<Quaternion> d(q.size());
+      QuaternionCodec::decode48(&packed[0], &d[0], q.size());
+
+      for (size_t n = 0; n < q.size(); n++)
+        assertClose(d[n], QuaternionCodec::decode48(
+                              QuaternionCodec::encode48(q[n])));
+    }
+  }
+
+private:
+  std::vector<Quaternion> randomQuaternions(size_t count)
+  {
+    srand(3);
+    std::vector<Quaternion> q;
+    while (q.size() < count)
+    {
+      Quaternion r(rand() / (double)RAND_MAX * 2.0 - 1.0,
+                   rand() / (double)RAND_MAX * 2.0 - 1.0,
+                   rand() / (double)RAND_MAX * 2.0 - 1.0,
+                   rand() / (double)RAND_MAX * 2.0 - 1.0);
+      if (r.magnitude() > 0.1)
+        q.push_back(r.getUnitQuaternion());
+    }
+    return q;
+  }
+
+  /* Largest component error, allowing for the decoded value being -q */
+  double error(const Quaternion &q, const Quaternion &d)
+  {
+    const double sign = q.dot(d) < 0.0 ? -1.0 : 1.0;
+    double e = 0.0;
+    for (int c = 0; c < 4; c++)
+      e = std::max(e, std::abs(q[c] - sign * d[c]));
+    return e;
+  }
+
+  void assertClose(const Quaternion &a, const Quaternion &b)
+  {
+    for (int c = 0; c < 4; c++)
+      TS_ASSERT_DELTA(a[c], b[c], 1e-12);
+  }
+};
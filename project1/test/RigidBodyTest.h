@@ -0,0 +1,161 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cmath>
+#include <stdexcept>
+
+#include "Quaternion.h"
+#include "RigidBodyIntegrator.h"
+#include "RigidBodySet.h"
+#include "TestCommon.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+class RigidBodyTest : public CxxTest::TestSuite
+{
+public:
+  void test_RigidBodySet_Default(void)
+  {
+    RigidBodySet bodies(3);
+    TS_ASSERT_EQUALS(bodies.size(), 3);
+    TS_ASSERT_EQUALS(bodies.getPosition(2), Vector3DStack());
+    TS_ASSERT_EQUALS(bodies.getVelocity(2), Vector3DStack());
+    TS_ASSERT_EQUALS(bodies.getOrientation(2), Quaternion());
+    TS_ASSERT_EQUALS(bodies.getAngularVelocity(2), Vector3DStack());
+  }
+
+  void test_RigidBodySet_AddBody(void)
+  {
+    RigidBodySet bodies;
+    bodies.addBody(Vector3DStack(1.0, 2.0, 3.0), Vector3DStack(),
+                   Quaternion(), Vector3DStack());
+    size_t index =
+        bodies.addBody(Vector3DStack(4.0, 5.0, 6.0), Vector3DStack(0.0, 1.0, 0.0),
+                       Quaternion(2.0, 0.0, 0.0, 0.0),
+                       Vector3DStack(0.0, 0.0, 1.0));
+
+    TS_ASSERT_EQUALS(index, 1);
+    TS_ASSERT_EQUALS(bodies.size(), 2);
+    TS_ASSERT_EQUALS(bodies.getPosition(0), Vector3DStack(1.0, 2.0, 3.0));
+    TS_ASSERT_EQUALS(bodies.getPosition(1), Vector3DStack(4.0, 5.0, 6.0));
+    TS_ASSERT_EQUALS(bodies.getVelocity(1), Vector3DStack(0.0, 1.0, 0.0));
+    TS_ASSERT_EQUALS(bodies.getAngularVelocity(1), Vector3DStack(0.0, 0.0, 1.0));
+
+    /* Orientation is normalised */
+    TS_ASSERT_EQUALS(bodies.getOrientation(1), Quaternion());
+  }
+
+  void test_RigidBodySet_IndexOutOfRange(void)
+  {
+    RigidBodySet bodies(1);
+    TS_ASSERT_THROWS(bodies.getOrientation(1), std::runtime_error);
+    TS_ASSERT_THROWS(bodies.setPosition(1, Vector3DStack()),
+                     std::runtime_error);
+    TS_ASSERT_THROWS(bodies.orientation(4), std::runtime_error);
+  }
+
+  void test_RigidBodyIntegrator_Linear(void)
+  {
+    RigidBodySet bodies;
+    bodies.addBody(Vector3DStack(1.0, 2.0, 3.0), Vector3DStack(1.0, 0.0, 0.0),
+                   Quaternion(), Vector3DStack());
+
+    RigidBodyIntegrator integrator;
+    integrator.setGravity(Vector3DStack(0.0, -10.0, 0.0));
+    integrator.step(bodies, 0.5);
+
+    /* Semi-implicit Euler uses the new velocity */
+    TS_ASSERT_EQUALS(bodies.getVelocity(0), Vector3DStack(1.0, -5.0, 0.0));
+    TS_ASSERT_EQUALS(bodies.getPosition(0), Vector3DStack(1.5, -0.5, 3.0));
+  }
+
+  void test_RigidBodyIntegrator_Angular(void)
+  {
+    for (int simd = 0; simd < 2; simd++)
+    {
+      const ScopedSimdKernels kernels(simd == 1);
+
+      /* Quarter turn about z per unit time, odd count for the remainder */
+      RigidBodySet bodies;
+      for (int n = 0; n < 3; n++)
+      {
+        bodies.addBody(Vector3DStack(), Vector3DStack(), Quaternion(),
+                       Vector3DStack(0.0, 0.0, M_PI / 2.0));
+      }
+
+      RigidBodyIntegrator integrator;
+      for (int n = 0; n < 1000; n++)
+        integrator.step(bodies, 0.001);
+
+      for (size_t n = 0; n < bodies.size(); n++)
+      {
+        Quaternion q = bodies.getOrientation(n);
+        TS_ASSERT_DELTA(q.magnitude(), 1.0, 1e-12);
+
+        Vector3DStack v = q.rotateVector(Vector3DStack(1.0, 0.0, 0.0));
+        TS_ASSERT_DELTA(v.getX(), 0.0, 0.001);
+        TS_ASSERT_DELTA(v.getY(), 1.0, 0.001);
+        TS_ASSERT_DELTA(v.getZ(), 0.0, 0.001);
+      }
+    }
+  }
+
+  void test_RigidBodyIntegrator_KernelsAgree(void)
+  {
+    RigidBodySet scalar = makeBodies(101);
+    RigidBodySet simd = makeBodies(101);
+    RigidBodyIntegrator integrator;
+    integrator.setGravity(Vector3DStack(0.0, -9.81, 0.0));
+
+    {
+      const ScopedSimdKernels kernels(false);
+      integrator.step(scalar, 0.01);
+    }
+    {
+      const ScopedSimdKernels kernels(true);
+      integrator.step(simd, 0.01);
+    }
+
+    assertSame(scalar, simd);
+  }
+
+  void test_RigidBodyIntegrator_Threaded(void)
+  {
+    RigidBodySet single = makeBodies(100003);
+    RigidBodySet threaded = makeBodies(100003);
+
+    RigidBodyIntegrator integrator;
+    TS_ASSERT_EQUALS(integrator.getNumThreads(), 1);
+    integrator.step(single, 0.01);
+
+    integrator.setNumThreads(4);
+    TS_ASSERT_EQUALS(integrator.getNumThreads(), 4);
+    integrator.step(threaded, 0.01);
+
+    assertSame(single, threaded);
+  }
+
+private:
+  RigidBodySet makeBodies(size_t count)
+  {
+    RigidBodySet bodies(count);
+    for (size_t n = 0; n < count; n++)
+    {
+      bodies.setPosition(n, Vector3DStack(n, 2.0 * n, -1.0 * n));
+      bodies.setVelocity(n, Vector3DStack(1.0, n % 7, 0.5));
+      bodies.setOrientation(n, Quaternion(n % 360, Vector3DStack(1.0, 2.0, 3.0)));
+      bodies.setAngularVelocity(n, Vector3DStack(0.1 * (n % 5), 1.0, -0.5));
+    }
+    return bodies;
+  }
+
+  void assertSame(const RigidBodySet &a, const RigidBodySet &b)
+  {
+    const size_t step = a.size() > 1000 ? 997 : 1;
+    for (size_t n = 0; n < a.size(); n += step)
+    {
+      TS_ASSERT_EQUALS(a.getPosition(n), b.getPosition(n));
+      TS_ASSERT_EQUALS(a.getVelocity(n), b.getVelocity(n));
+      TS_ASSERT_DELTA(a.getOrientation(n).dot(b.getOrientation(n)), 1.0, 1e-12);
+    }
+  }
+};
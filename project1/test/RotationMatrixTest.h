@@ -0,0 +1,213 @@
+#include <cxxtest/TestSuite.h>
+
+#include <sstream>
+#include <stdexcept>
+
+#include "Quaternion.h"
+#include "RotationMatrix.h"
+#include "TestCommon.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+class RotationMatrixTest : public CxxTest::TestSuite
+{
+public:
+  void test_RotationMatrix_Default(void)
+  {
+    RotationMatrix m;
+    for (int row = 0; row < 3; row++)
+    {
+      for (int col = 0; col < 3; col++)
+        TS_ASSERT_EQUALS(m(row, col), row == col ? 1.0 : 0.0);
+    }
+  }
+
+  void test_RotationMatrix_FromIdentityQuaternion(void)
+  {
+    TS_ASSERT_EQUALS(RotationMatrix(Quaternion()), RotationMatrix());
+  }
+
+  void test_RotationMatrix_FromZeroQuaternion(void)
+  {
+    RotationMatrix m(Quaternion(0.0, 0.0, 0.0, 0.0));
+    TS_ASSERT_EQUALS(m * Vector3DStack(1.0, 2.0, 3.0),
+                     Vector3DStack(0.0, 0.0, 0.0));
+  }
+
+  void test_RotationMatrix_IndexOutOfRange(void)
+  {
+    RotationMatrix m;
+    TS_ASSERT_THROWS(m(3, 0), std::runtime_error);
+    TS_ASSERT_THROWS(m(0, -1), std::runtime_error);
+  }
+
+  void test_RotationMatrix_CopyAndEquality(void)
+  {
+    RotationMatrix m1(Quaternion(30.0, Vector3DStack(1.0, 0.0, 0.0)));
+    RotationMatrix m2(m1);
+    RotationMatrix m3;
+
+    TS_ASSERT(m1 == m2);
+    TS_ASSERT(m1 != m3);
+
+    m3 = m1;
+    TS_ASSERT(m1 == m3);
+  }
+
+  void test_RotationMatrix_Rotation90DegY(void)
+  {
+    RotationMatrix m(Quaternion(90.0, Vector3DStack(0.0, 1.0, 0.0)));
+    Vector3DStack v = m * Vector3DStack(1.0, 0.0, 0.0);
+    TS_ASSERT_DELTA(v.getX(), 0.0, TH);
+    TS_ASSERT_DELTA(v.getY(), 0.0, TH);
+    TS_ASSERT_DELTA(v.getZ(), -1.0, TH);
+  }
+
+  void test_RotationMatrix_MatchesQuaternion(void)
+  {
+    /* Not of unit length */
+    Quaternion q(5.0, 2.0, 4.5, 8.9);
+    RotationMatrix m(q);
+    Vector3DStack v(3.0, 1.5, -7.0);
+
+    assertClose(m * v, q.rotateVector(v));
+  }
+
+  void test_RotationMatrix_ApplyVector3DStack(void)
+  {
+    Quaternion q(37.0, Vector3DStack(1.0, -2.0, 0.5));
+    RotationMatrix m(q);
+    Vector3DStack v[] = {Vector3DStack(1.0, 0.0, 0.0),
+                         Vector3DStack(3.0, 1.5, -7.0)};
+    Vector3DStack out[2];
+    m.apply(v, out, 2);
+
+    assertClose(out[0], q.rotateVector(v[0]));
+    assertClose(out[1], q.rotateVector(v[1]));
+  }
+
+  void test_RotationMatrix_ApplyPacked(void)
+  {
+    Quaternion q(37.0, Vector3DStack(1.0, -2.0, 0.5));
+    RotationMatrix m(q);
+    double v[] = {1.0, 0.0, 0.0, 3.0, 1.5, -7.0};
+    m.apply(v, v, 2);
+
+    assertClose(Vector3DStack(v[0], v[1], v[2]),
+                q.rotateVector(Vector3DStack(1.0, 0.0, 0.0)));
+    assertClose(Vector3DStack(v[3], v[4], v[5]),
+                q.rotateVector(Vector3DStack(3.0, 1.5, -7.0)));
+  }
+
+  void test_RotationMatrix_ApplyArray(void)
+  {
+    for (int simd = 0; simd < 2; simd++)
+    {
+      const ScopedSimdKernels kernels(simd == 1);
+      for (size_t n = 0; n < 6; n++)
+        checkApply(n, 1);
+    }
+  }
+
+  void test_RotationMatrix_ApplyArrayInPlace(void)
+  {
+    Quaternion q(37.0, Vector3DStack(1.0, -2.0, 0.5));
+    Vector3DArray a = makeArray(5);
+    Vector3DArray expected;
+    RotationMatrix(q).apply(a, expected);
+
+    RotationMatrix(q).apply(a, a);
+
+    for (size_t i = 0; i < a.size(); i++)
+      TS_ASSERT_EQUALS(a.get(i), expected.get(i));
+  }
+
+  void test_RotationMatrix_ApplyArrayThreaded(void)
+  {
+    /* Large enough to be split, with a remainder */
+    checkApply(300001, 4);
+    checkApply(1000, 4);
+    checkApply(300001, 0);
+  }
+
+  void test_RotationMatrix_Float(void)
+  {
+    const Quaternion q(37.0, Vector3DStack(1.0, -2.0, 0.5));
+    const RotationMatrix m(q);
+    const QuaternionF qf(q);
+    const RotationMatrixF mf(qf);
+
+    for (int row = 0; row < 3; row++)
+    {
+      for (int column = 0; column < 3; column++)
+      {
+        TS_ASSERT_DELTA(mf(row, column), m(row, column), TH);
+        TS_ASSERT_EQUALS(RotationMatrixF(m)(row, column),
+                         (float)m(row, column));
+      }
+    }
+
+    /* Sizes covering the four float SIMD remainders, and threading */
+    const size_t sizes[] = {0, 1, 2, 3, 4, 5, 6, 7, 300001};
+    for (int simd = 0; simd < 2; simd++)
+    {
+      const ScopedSimdKernels kernels(simd == 1);
+      for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+      {
+        const Vector3DArray in = makeArray(sizes[s]);
+        Vector3DArray out;
+        Vector3DArrayF outF;
+        m.apply(in, out);
+        mf.apply(Vector3DArrayF(in), outF, 4);
+
+        TS_ASSERT_EQUALS(outF.size(), sizes[s]);
+        const size_t step = sizes[s] > 1000 ? 997 : 1;
+        for (size_t i = 0; i < sizes[s]; i += step)
+        {
+          const double th = TH * (1.0 + out.get(i).magnitude());
+          TS_ASSERT_DELTA(outF.get(i).getX(), out.get(i).getX(), th);
+          TS_ASSERT_DELTA(outF.get(i).getY(), out.get(i).getY(), th);
+          TS_ASSERT_DELTA(outF.get(i).getZ(), out.get(i).getZ(), th);
+        }
+      }
+    }
+
+    std::stringstream stream;
+    stream << RotationMatrixF();
+    TS_ASSERT_EQUALS(stream.str(), "[[1,0,0],[0,1,0],[0,0,1]]");
+  }
+
+private:
+  Vector3DArray makeArray(size_t n)
+  {
+    Vector3DArray a(n);
+    for (size_t i = 0; i < n; i++)
+      a.set(i, Vector3DStack(1.0 + i, 2.0 - i * 0.5, 3.0 + i * 0.25));
+    return a;
+  }
+
+  void assertClose(const Vector3DStack &a, const Vector3DStack &b)
+  {
+    TS_ASSERT_DELTA(a.getX(), b.getX(), TH);
+    TS_ASSERT_DELTA(a.getY(), b.getY(), TH);
+    TS_ASSERT_DELTA(a.getZ(), b.getZ(), TH);
+  }
+
+  void checkApply(size_t n, unsigned int numThreads)
+  {
+    Quaternion q(37.0, Vector3DStack(1.0, -2.0, 0.5));
+    RotationMatrix m(q);
+    Vector3DArray in = makeArray(n);
+    Vector3DArray out;
+    m.apply(in, out, numThreads);
+
+    TS_ASSERT_EQUALS(out.size(), n);
+
+    /* Check a spread of elements rather than all of them */
+    const size_t step = n > 1000 ? 997 : 1;
+    for (size_t i = 0; i < n; i += step)
+      assertClose(out.get(i), q.rotateVector(in.get(i)));
+    if (n > 0)
+      assertClose(out.get(n - 1), q.rotateVector(in.get(n - 1)));
+  }
+};
@@ -7,8 +7,8 @@
 
 #include "Vector3DStack.h"
 #include "Quaternion.h"
-
-#define TH 0.0001
+#include "Vector3DArray.h"
+#include "TestCommon.h"
 
 size_t g_testsCount = 0;
 size_t g_assertionCount = 0;
@@ -46,7 +46,7 @@ size_t g_assertionPassed = 0;
 #define TS_ASSERT_DELTA(a, b, th)                                              \
   {                                                                            \
     g_assertionCount++;                                                        \
-    if (abs(a - b) <= th)                                                      \
+    if (std::fabs((a) - (b)) <= (th))                                          \
       g_assertionPassed++;                                                     \
   }
 
@@ -326,6 +326,46 @@ void test_Vector3DStack_IndexOperatorSetOutOfRange(void)
   TS_ASSERT_DELTA(v.getZ(), 3.0, TH);
 }
 
+void test_Vector3DStack_Unchecked(void)
+{
+  TEST_FUNC
+
+  Vector3DStack v(1.0, 6.0, 3.0);
+  const double *d = v.data();
+  TS_ASSERT_EQUALS(d[0], 1.0);
+  TS_ASSERT_EQUALS(d[1], 6.0);
+  TS_ASSERT_EQUALS(d[2], 3.0);
+  TS_ASSERT_EQUALS(v.unchecked(2), 3.0);
+
+  v.unchecked(1) = 12.0;
+  v.data()[2] = 4.0;
+  TS_ASSERT_EQUALS(v, Vector3DStack(1.0, 12.0, 4.0));
+
+  /* Only the checked operations can throw */
+  TS_ASSERT(noexcept(v.unchecked(0)));
+  TS_ASSERT(noexcept(v + v));
+  TS_ASSERT(noexcept(v % v));
+  TS_ASSERT(!noexcept(v[0]));
+  TS_ASSERT(!noexcept(v / 2.0));
+}
+
+void test_Vector3DStack_DivideUnchecked(void)
+{
+  TEST_FUNC
+
+  Vector3DStack v1(1.0, 6.0, 3.0);
+  Vector3DStack v2 = v1.divideUnchecked(3.0);
+  TS_ASSERT_DELTA(v2.getX(), 1.0 / 3.0, TH);
+  TS_ASSERT_DELTA(v2.getY(), 2.0, TH);
+  TS_ASSERT_DELTA(v2.getZ(), 1.0, TH);
+
+  Vector3DStack u = v1.getUnitVectorUnchecked();
+  Vector3DStack expected = v1.getUnitVector();
+  TS_ASSERT_DELTA(u.getX(), expected.getX(), 1e-15);
+  TS_ASSERT_DELTA(u.getY(), expected.getY(), 1e-15);
+  TS_ASSERT_DELTA(u.getZ(), expected.getZ(), 1e-15);
+}
+
 void test_Vector3DStack_StreamOutput(void)
 {
   TEST_FUNC
@@ -354,6 +394,28 @@ void test_Vector3DStack_StreamInput(void)
   TS_ASSERT_EQUALS(v.getZ(), 3.0);
 }
 
+void test_Vector3DStack_Float(void)
+{
+  TEST_FUNC
+
+  Vector3DStackF v1(1.0f, 6.0f, 3.0f);
+  Vector3DStackF v2(3.0f, 6.0f, 8.0f);
+  TS_ASSERT_EQUALS(sizeof(Vector3DStackF), 3 * sizeof(float));
+  TS_ASSERT_EQUALS(v1 + v2, Vector3DStackF(4.0f, 12.0f, 11.0f));
+  TS_ASSERT_EQUALS(v1 * v2, 63.0f);
+  TS_ASSERT_EQUALS(v1 % v2, Vector3DStackF(30.0f, 1.0f, -12.0f));
+  TS_ASSERT_DELTA(v1.getUnitVector().magnitude(), 1.0f, 1e-6f);
+
+  /* Near zero for float */
+  TS_ASSERT_THROWS(v1 / 1e-8f, std::runtime_error);
+
+  /* Conversion from double rounds each component */
+  const Vector3DStack d(0.1, 1.0 / 3.0, -2.5);
+  const Vector3DStackF f(d);
+  TS_ASSERT_EQUALS(f, Vector3DStackF(0.1f, 1.0f / 3.0f, -2.5f));
+  TS_ASSERT_DELTA(Vector3DStack(f).getX(), 0.1, 1e-8);
+}
+
 void test_Quaternion_Default(void)
 {
   TEST_FUNC
@@ -597,6 +659,214 @@ void test_Quaternion_Rotation45DegZ(void)
   TS_ASSERT_DELTA(v.getZ(), 0.0, TH);
 }
 
+void test_Quaternion_IsUnit(void)
+{
+  TEST_FUNC
+
+  TS_ASSERT(Quaternion().isUnit());
+  TS_ASSERT(Quaternion(30.0, Vector3DStack(1.0, 2.0, 3.0)).isUnit());
+  TS_ASSERT(!Quaternion(5.0, 2.0, 4.5, 8.9).isUnit());
+  TS_ASSERT(Quaternion(1.001, 0.0, 0.0, 0.0).isUnit(0.01));
+}
+
+void test_Quaternion_UnitQuaternion(void)
+{
+  TEST_FUNC
+
+  Quaternion q(5.0, 2.0, 4.5, 8.9);
+  Quaternion u = q.getUnitQuaternion();
+  const double m = q.magnitude();
+  TS_ASSERT_DELTA(u.magnitude(), 1.0, TH);
+  TS_ASSERT_DELTA(u.getReal(), 5.0 / m, TH);
+  TS_ASSERT_DELTA(u.getI(), 2.0 / m, TH);
+  TS_ASSERT_DELTA(u.getJ(), 4.5 / m, TH);
+  TS_ASSERT_DELTA(u.getK(), 8.9 / m, TH);
+}
+
+void test_Quaternion_UnitQuaternionOfZero(void)
+{
+  TEST_FUNC
+
+  Quaternion q(0.0, 0.0, 0.0, 0.0);
+  TS_ASSERT_THROWS(q.getUnitQuaternion(), std::runtime_error);
+}
+
+void test_Quaternion_UnitQuaternionUnchecked(void)
+{
+  TEST_FUNC
+
+  Quaternion q(5.0, 2.0, 4.5, 8.9);
+  Quaternion u = q.getUnitQuaternionUnchecked();
+  Quaternion expected = q.getUnitQuaternion();
+  TS_ASSERT_DELTA(u.getReal(), expected.getReal(), 1e-15);
+  TS_ASSERT_DELTA(u.getI(), expected.getI(), 1e-15);
+  TS_ASSERT_DELTA(u.getJ(), expected.getJ(), 1e-15);
+  TS_ASSERT_DELTA(u.getK(), expected.getK(), 1e-15);
+}
+
+void test_Quaternion_RotationNormalised(void)
+{
+  TEST_FUNC
+
+  Quaternion q(37.0, Vector3DStack(1.0, -2.0, 0.5));
+  Vector3DStack v(3.0, 1.5, -7.0);
+  Vector3DStack expected = q.rotateVector(v);
+  v = q.rotateVectorNormalised(v);
+  TS_ASSERT_DELTA(v.getX(), expected.getX(), TH);
+  TS_ASSERT_DELTA(v.getY(), expected.getY(), TH);
+  TS_ASSERT_DELTA(v.getZ(), expected.getZ(), TH);
+}
+
+void test_Quaternion_RotateVectors(void)
+{
+  TEST_FUNC
+
+  /* Not of unit length */
+  Quaternion q(5.0, 2.0, 4.5, 8.9);
+  Vector3DStack in[] = {Vector3DStack(1.0, 0.0, 0.0),
+                        Vector3DStack(3.0, 1.5, -7.0),
+                        Vector3DStack(0.0, 0.0, 0.0)};
+  Vector3DStack out[3];
+  q.rotateVectors(in, out, 3);
+  for (size_t n = 0; n < 3; n++)
+  {
+    Vector3DStack expected = q.rotateVector(in[n]);
+    TS_ASSERT_DELTA(out[n].getX(), expected.getX(), TH);
+    TS_ASSERT_DELTA(out[n].getY(), expected.getY(), TH);
+    TS_ASSERT_DELTA(out[n].getZ(), expected.getZ(), TH);
+  }
+}
+
+void test_Quaternion_RotateVectorsInPlace(void)
+{
+  TEST_FUNC
+
+  Quaternion q(90.0, Vector3DStack(0.0, 1.0, 0.0));
+  Vector3DStack v[] = {Vector3DStack(1.0, 0.0, 0.0),
+                       Vector3DStack(0.0, 0.0, 1.0)};
+  q.rotateVectors(v, v, 2);
+  TS_ASSERT_DELTA(v[0].getX(), 0.0, TH);
+  TS_ASSERT_DELTA(v[0].getY(), 0.0, TH);
+  TS_ASSERT_DELTA(v[0].getZ(), -1.0, TH);
+  TS_ASSERT_DELTA(v[1].getX(), 1.0, TH);
+  TS_ASSERT_DELTA(v[1].getY(), 0.0, TH);
+  TS_ASSERT_DELTA(v[1].getZ(), 0.0, TH);
+}
+
+void test_Quaternion_RotateVectorsZeroQuaternion(void)
+{
+  TEST_FUNC
+
+  Quaternion q(0.0, 0.0, 0.0, 0.0);
+  Vector3DStack v[] = {Vector3DStack(1.0, 2.0, 3.0)};
+  q.rotateVectors(v, v, 1);
+  TS_ASSERT_EQUALS(v[0], q.rotateVector(Vector3DStack(1.0, 2.0, 3.0)));
+}
+
+void test_Quaternion_Dot(void)
+{
+  TEST_FUNC
+
+  Quaternion q1(5.0, 2.0, 4.5, 8.9);
+  Quaternion q2(1.0, -1.0, 2.0, 0.5);
+  TS_ASSERT_DELTA(q1.dot(q2), 16.45, TH);
+}
+
+void test_Quaternion_Nlerp(void)
+{
+  TEST_FUNC
+
+  Quaternion a;
+  Quaternion b(90.0, Vector3DStack(0.0, 0.0, 1.0));
+
+  Quaternion q = Quaternion::nlerp(a, b, 0.0);
+  TS_ASSERT_DELTA(q.dot(a), 1.0, TH);
+  q = Quaternion::nlerp(a, b, 1.0);
+  TS_ASSERT_DELTA(q.dot(b), 1.0, TH);
+
+  /* Halfway is symmetric so matches the 45 degree rotation */
+  q = Quaternion::nlerp(a, b, 0.5);
+  TS_ASSERT_DELTA(q.magnitude(), 1.0, TH);
+  TS_ASSERT_DELTA(q.dot(Quaternion(45.0, Vector3DStack(0.0, 0.0, 1.0))), 1.0,
+                  TH);
+}
+
+void test_Quaternion_NlerpShortestPath(void)
+{
+  TEST_FUNC
+
+  Quaternion a;
+  Quaternion b(-1.0, 0.0, 0.0, 0.0);
+  Quaternion q = Quaternion::nlerp(a, b, 0.5);
+  TS_ASSERT_DELTA(q.getReal(), 1.0, TH);
+}
+
+void test_Quaternion_Slerp(void)
+{
+  TEST_FUNC
+
+  Quaternion a;
+  Quaternion b(90.0, Vector3DStack(0.0, 0.0, 1.0));
+
+  Quaternion q = Quaternion::slerp(a, b, 0.0);
+  TS_ASSERT_DELTA(q.dot(a), 1.0, TH);
+  q = Quaternion::slerp(a, b, 1.0);
+  TS_ASSERT_DELTA(q.dot(b), 1.0, TH);
+
+  /* Constant angular velocity */
+  q = Quaternion::slerp(a, b, 1.0 / 3.0);
+  TS_ASSERT_DELTA(q.magnitude(), 1.0, TH);
+  TS_ASSERT_DELTA(q.dot(Quaternion(30.0, Vector3DStack(0.0, 0.0, 1.0))), 1.0,
+                  TH);
+}
+
+void test_Quaternion_SlerpShortestPath(void)
+{
+  TEST_FUNC
+
+  Quaternion a(10.0, Vector3DStack(1.0, 0.0, 0.0));
+  Quaternion b = Quaternion(30.0, Vector3DStack(1.0, 0.0, 0.0));
+  Quaternion negB(-b.getReal(), -b.getI(), -b.getJ(), -b.getK());
+  Quaternion q1 = Quaternion::slerp(a, b, 0.5);
+  Quaternion q2 = Quaternion::slerp(a, negB, 0.5);
+  TS_ASSERT_DELTA(std::abs(q1.dot(q2)), 1.0, TH);
+}
+
+void test_Quaternion_SlerpSmallAngle(void)
+{
+  TEST_FUNC
+
+  Quaternion a(10.0, Vector3DStack(1.0, 0.0, 0.0));
+  Quaternion b(10.0001, Vector3DStack(1.0, 0.0, 0.0));
+  Quaternion q = Quaternion::slerp(a, b, 0.5);
+  TS_ASSERT_DELTA(q.magnitude(), 1.0, TH);
+  TS_ASSERT_DELTA(q.dot(a), 1.0, TH);
+}
+
+void test_Quaternion_FromRotationVector(void)
+{
+  TEST_FUNC
+
+  Vector3DStack axis(1.0, -2.0, 0.5);
+  Quaternion q = Quaternion::fromRotationVector(axis.getUnitVector() * 0.6);
+  Quaternion expected(0.6 * 180.0 / 3.1415, axis);
+  TS_ASSERT_DELTA(q.magnitude(), 1.0, TH);
+  TS_ASSERT_DELTA(q.dot(expected), 1.0, TH);
+}
+
+void test_Quaternion_FromRotationVectorSmall(void)
+{
+  TEST_FUNC
+
+  Quaternion q =
+      Quaternion::fromRotationVector(Vector3DStack(1e-9, 0.0, 0.0));
+  TS_ASSERT_DELTA(q.getReal(), 1.0, 1e-15);
+  TS_ASSERT_DELTA(q.getI(), 0.5e-9, 1e-15);
+
+  q = Quaternion::fromRotationVector(Vector3DStack(0.0, 0.0, 0.0));
+  TS_ASSERT_EQUALS(q, Quaternion());
+}
+
 void test_Quaternion_IndexOperator(void)
 {
   TEST_FUNC
@@ -644,6 +914,30 @@ void test_Quaternion_IndexOperatorSetOutOfRange(void)
   TS_ASSERT_DELTA(q.getK(), 8.9, TH);
 }
 
+void test_Quaternion_Unchecked(void)
+{
+  TEST_FUNC
+
+  Quaternion q(5.0, 2.0, 4.5, 8.9);
+  const double *d = q.data();
+  TS_ASSERT_EQUALS(d[0], 5.0);
+  TS_ASSERT_EQUALS(d[1], 2.0);
+  TS_ASSERT_EQUALS(d[2], 4.5);
+  TS_ASSERT_EQUALS(d[3], 8.9);
+  TS_ASSERT_EQUALS(q.unchecked(3), 8.9);
+
+  q.unchecked(0) = 1.0;
+  q.data()[3] = 6.0;
+  TS_ASSERT_EQUALS(q, Quaternion(1.0, 2.0, 4.5, 6.0));
+
+  /* Only the checked operations can throw */
+  TS_ASSERT(noexcept(q.unchecked(0)));
+  TS_ASSERT(noexcept(q * q));
+  TS_ASSERT(noexcept(q.getUnitQuaternionUnchecked()));
+  TS_ASSERT(!noexcept(q[0]));
+  TS_ASSERT(!noexcept(q.getUnitQuaternion()));
+}
+
 void test_Quaternion_StreamOutput(void)
 {
   TEST_FUNC
@@ -672,6 +966,79 @@ void test_Quaternion_StreamInput(void)
   TS_ASSERT_EQUALS(q.getJ(), 4.5);
   TS_ASSERT_EQUALS(q.getK(), 8.9);
 }
+
+void test_Quaternion_Float(void)
+{
+  TEST_FUNC
+
+  const Quaternion a(30.0, Vector3DStack(1.0, 2.0, 3.0));
+  const Quaternion b(-70.0, Vector3DStack(0.5, -1.0, 2.0));
+  const QuaternionF af(a);
+  const QuaternionF bf(b);
+  TS_ASSERT_EQUALS(sizeof(QuaternionF), 4 * sizeof(float));
+  TS_ASSERT(af.isUnit());
+  TS_ASSERT(QuaternionF::UNIT_TOLERANCE > (float)Quaternion::UNIT_TOLERANCE);
+
+  /* Float results match double to float precision */
+  const Quaternion results[] = {a * b, a.inverse(),
+                                Quaternion::slerp(a, b, 0.3),
+                                Quaternion::nlerp(a, b, 0.3)};
+  const QuaternionF resultsF[] = {af * bf, af.inverse(),
+                                  QuaternionF::slerp(af, bf, 0.3f),
+                                  QuaternionF::nlerp(af, bf, 0.3f)};
+  for (int n = 0; n < 4; n++)
+    for (int c = 0; c < 4; c++)
+      TS_ASSERT_DELTA(resultsF[n][c], results[n][c], 1e-6);
+
+  const QuaternionF r(90.0f, Vector3DStackF(0.0f, 1.0f, 0.0f));
+  const Vector3DStackF v = r.rotateVector(Vector3DStackF(1.0f, 0.0f, 0.0f));
+  TS_ASSERT_DELTA(v.getX(), 0.0f, TH);
+  TS_ASSERT_DELTA(v.getZ(), -1.0f, TH);
+}
+
+void test_Quaternion_RotateVectorsFloat(void)
+{
+  TEST_FUNC
+
+  const Quaternion q(-123.0, Vector3DStack(0.3, -1.0, 0.7));
+  const QuaternionF qf(q);
+  Vector3DStack in[11];
+  Vector3DStackF inF[11];
+  for (int n = 0; n < 11; n++)
+  {
+    in[n] = Vector3DStack(n - 5.0, 2.0 * n, 10.0 - n * n);
+    inF[n] = Vector3DStackF(in[n]);
+  }
+
+  /* Both kernels, with an odd count so the scalar tail is used */
+  for (int simd = 0; simd < 2; simd++)
+  {
+    const ScopedSimdKernels kernels(simd == 1);
+    Vector3DStack out[11];
+    Vector3DStackF outF[11];
+    q.rotateVectors(in, out, 11);
+    qf.rotateVectors(inF, outF, 11);
+
+    for (int n = 0; n < 11; n++)
+    {
+      const Vector3DStack expected = q.rotateVectorNormalised(in[n]);
+      const double tolerance = 1e-6 * expected.magnitude();
+      for (int c = 0; c < 3; c++)
+      {
+        TS_ASSERT_DELTA(out[n][c], expected[c], 1e-12);
+        TS_ASSERT_DELTA(outF[n][c], expected[c], tolerance);
+      }
+    }
+
+    /* In place */
+    Vector3DStackF inPlace[11];
+    for (int n = 0; n < 11; n++)
+      inPlace[n] = inF[n];
+    qf.rotateVectors(inPlace, inPlace, 11);
+    for (int n = 0; n < 11; n++)
+      TS_ASSERT_EQUALS(inPlace[n], outF[n]);
+  }
+}
 /* End of test functions */
 
 int main()
@@ -700,8 +1067,11 @@ int main()
   test_Vector3DStack_IndexOperatorOutOfRange();
   test_Vector3DStack_IndexOperatorSet();
   test_Vector3DStack_IndexOperatorSetOutOfRange();
+  test_Vector3DStack_Unchecked();
+  test_Vector3DStack_DivideUnchecked();
   test_Vector3DStack_StreamOutput();
   test_Vector3DStack_StreamInput();
+  test_Vector3DStack_Float();
   test_Quaternion_Default();
   test_Quaternion_ConstructReal();
   test_Quaternion_ConstructRealInt();
@@ -723,11 +1093,30 @@ int main()
   test_Quaternion_IndexOperatorOutOfRange();
   test_Quaternion_IndexOperatorSet();
   test_Quaternion_IndexOperatorSetOutOfRange();
+  test_Quaternion_Unchecked();
   test_Quaternion_Inverse();
   test_Quaternion_Rotation90DegY();
   test_Quaternion_Rotation45DegZ();
+  test_Quaternion_IsUnit();
+  test_Quaternion_UnitQuaternion();
+  test_Quaternion_UnitQuaternionOfZero();
+  test_Quaternion_UnitQuaternionUnchecked();
+  test_Quaternion_RotationNormalised();
+  test_Quaternion_RotateVectors();
+  test_Quaternion_RotateVectorsInPlace();
+  test_Quaternion_RotateVectorsZeroQuaternion();
+  test_Quaternion_Dot();
+  test_Quaternion_Nlerp();
+  test_Quaternion_NlerpShortestPath();
+  test_Quaternion_Slerp();
+  test_Quaternion_SlerpShortestPath();
+  test_Quaternion_SlerpSmallAngle();
+  test_Quaternion_FromRotationVector();
+  test_Quaternion_FromRotationVectorSmall();
   test_Quaternion_StreamOutput();
   test_Quaternion_StreamInput();
+  test_Quaternion_Float();
+  test_Quaternion_RotateVectorsFloat();
 
   /* Output the test results */
   std::cout << "Number of test functions: " << g_testsCount << std::endl
@@ -0,0 +1,43 @@
+#ifndef _TESTCOMMON_H_
+#define _TESTCOMMON_H_
+
+#include "Simd.h"
+
+/* Tolerance for comparing floating point results */
+#define TH 0.0001
+
+/**
+ * Selects the SIMD or scalar kernels for as long as it exists, then restores
+ * the previous selection, so a test comparing the two cannot leave the
+ * scalar kernels selected for the tests after it.
+ */
+class ScopedSimdKernels
+{
+public:
+  /**
+   * Selects a set of kernels.
+   *
+   * @param useSimd True to use SIMD kernels, if they are available
+   */
+  explicit ScopedSimdKernels(const bool useSimd)
+      : m_previous(useSimdKernels())
+  {
+    setUseSimdKernels(useSimd);
+  }
+
+  /**
+   * Restores the previous selection.
+   */
+  ~ScopedSimdKernels()
+  {
+    setUseSimdKernels(m_previous);
+  }
+
+private:
+  ScopedSimdKernels(const ScopedSimdKernels &other);
+  void operator=(const ScopedSimdKernels &other);
+
+  const bool m_previous;
+};
+
+#endif
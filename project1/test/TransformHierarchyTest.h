@@ -0,0 +1,177 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "DualQuaternion.h"
+#include "Quaternion.h"
+#include "TestCommon.h"
+#include "TransformHierarchy.h"
+#include "Vector3DStack.h"
+
+class TransformHierarchyTest : public CxxTest::TestSuite
+{
+public:
+  /**
+   * Creates a random rotation.
+   */
+  Quaternion randomRotation()
+  {
+    return Quaternion(rand() % 360, Vector3DStack(rand() % 5 - 2.0,
+                                                  rand() % 5 - 2.0, 1.0));
+  }
+
+  /**
+   * Creates a random translation.
+   */
+  Vector3DStack randomTranslation()
+  {
+    return Vector3DStack(rand() % 21 - 10.0, rand() % 21 - 10.0,
+                         rand() % 21 - 10.0);
+  }
+
+  /**
+   * Checks every world transform against composing local transforms up to
+   * the root with DualQuaternion.
+   */
+  void assertWorldTransforms(const TransformHierarchy &hierarchy)
+  {
+    for (size_t n = 0; n < hierarchy.size(); n++)
+    {
+      DualQuaternion expected(hierarchy.getLocalRotation(n),
+                              hierarchy.getLocalTranslation(n));
+      for (size_t p = hierarchy.getParent(n);
+           p != TransformHierarchy::NO_PARENT; p = hierarchy.getParent(p))
+      {
+        expected = DualQuaternion(hierarchy.getLocalRotation(p),
+                                  hierarchy.getLocalTranslation(p)) *
+                   expected;
+      }
+
+      const Vector3DStack t = hierarchy.getWorldTranslation(n);
+      const Vector3DStack e = expected.getTranslation();
+      TS_ASSERT_DELTA(t.getX(), e.getX(), 1e-9);
+      TS_ASSERT_DELTA(t.getY(), e.getY(), 1e-9);
+      TS_ASSERT_DELTA(t.getZ(), e.getZ(), 1e-9);
+      TS_ASSERT_DELTA(std::fabs(hierarchy.getWorldRotation(n).dot(
+                          expected.getRotation())),
+                      1.0, 1e-9);
+    }
+  }
+
+  void test_TransformHierarchy_Chain(void)
+  {
+    TransformHierarchy hierarchy;
+    const size_t root =
+        hierarchy.addNode(TransformHierarchy::NO_PARENT,
+                          Quaternion(90.0, Vector3DStack(0.0, 0.0, 1.0)),
+                          Vector3DStack(1.0, 0.0, 0.0));
+    const size_t child = hierarchy.addNode(root, Quaternion(),
+                                           Vector3DStack(1.0, 0.0, 0.0));
+
+    TS_ASSERT_EQUALS(hierarchy.size(), 2);
+    TS_ASSERT_EQUALS(hierarchy.getParent(root), TransformHierarchy::NO_PARENT);
+    TS_ASSERT_EQUALS(hierarchy.getParent(child), root);
+    TS_ASSERT_EQUALS(hierarchy.getDepth(child), 1);
+    TS_ASSERT_EQUALS(hierarchy.numLevels(), 2);
+    TS_ASSERT(hierarchy.isDirty(child));
+
+    hierarchy.update();
+    TS_ASSERT(!hierarchy.isDirty(child));
+
+    /* Child offset is rotated by the parent, from x to y */
+    const Vector3DStack t = hierarchy.getWorldTranslation(child);
+    TS_ASSERT_DELTA(t.getX(), 1.0, TH);
+    TS_ASSERT_DELTA(t.getY(), 1.0, TH);
+    TS_ASSERT_DELTA(t.getZ(), 0.0, TH);
+
+    Vector3DStack p =
+        hierarchy.getWorldTransform(child).transformPoint(Vector3DStack(
+            1.0, 0.0, 0.0));
+    TS_ASSERT_DELTA(p.getX(), 1.0, TH);
+    TS_ASSERT_DELTA(p.getY(), 2.0, TH);
+  }
+
+  void test_TransformHierarchy_Invalid(void)
+  {
+    TransformHierarchy hierarchy;
+    TS_ASSERT_THROWS(hierarchy.addNode(0, Quaternion(), Vector3DStack()),
+                     std::runtime_error);
+    hierarchy.addNode(TransformHierarchy::NO_PARENT, Quaternion(),
+                      Vector3DStack());
+    TS_ASSERT_THROWS(hierarchy.addNode(1, Quaternion(), Vector3DStack()),
+                     std::runtime_error);
+    TS_ASSERT_THROWS(hierarchy.setLocalRotation(0, Quaternion(0.0)),
+                     std::runtime_error);
+    TS_ASSERT_THROWS(hierarchy.getWorldRotation(1), std::runtime_error);
+  }
+
+  void test_TransformHierarchy_Random(void)
+  {
+    srand(1);
+    for (unsigned int numThreads = 1; numThreads <= 4; numThreads += 3)
+    {
+      TransformHierarchy hierarchy(numThreads);
+      hierarchy.reserve(60000);
+      for (size_t n = 0; n < 60000; n++)
+      {
+        /* A few roots, wide levels and some long chains */
+        const size_t parent =
+            n < 3 ? TransformHierarchy::NO_PARENT
+                  : (rand() % 4 ? n / 3 : n - 1 - rand() % 2);
+        hierarchy.addNode(parent, randomRotation(), randomTranslation());
+      }
+      hierarchy.update();
+      assertWorldTransforms(hierarchy);
+
+      /* Changing a few nodes updates their subtrees only */
+      std::vector<Vector3DStack> before(hierarchy.size());
+      for (size_t n = 0; n < hierarchy.size(); n++)
+        before[n] = hierarchy.getWorldTranslation(n);
+
+      const size_t changed = 20000;
+      hierarchy.setLocalTranslation(changed, Vector3DStack(100.0, 0.0, 0.0));
+      hierarchy.setLocalRotation(30000, randomRotation());
+      hierarchy.update();
+      assertWorldTransforms(hierarchy);
+
+      for (size_t n = 0; n < changed; n++)
+        TS_ASSERT_EQUALS(hierarchy.getWorldTranslation(n), before[n]);
+      TS_ASSERT_DIFFERS(hierarchy.getWorldTranslation(changed),
+                        before[changed]);
+
+      /* Nothing dirty leaves everything as it was */
+      hierarchy.update();
+      assertWorldTransforms(hierarchy);
+
+      /* Nodes added after an update, at any depth */
+      for (size_t n = 0; n < 1000; n++)
+        hierarchy.addNode(rand() % hierarchy.size(), randomRotation(),
+                          randomTranslation());
+      hierarchy.setLocalTranslation(1, randomTranslation());
+      hierarchy.update();
+      assertWorldTransforms(hierarchy);
+    }
+  }
+
+  void test_TransformHierarchy_Clear(void)
+  {
+    TransformHierarchy hierarchy;
+    hierarchy.addNode(TransformHierarchy::NO_PARENT, Quaternion(),
+                      Vector3DStack(1.0, 2.0, 3.0));
+    hierarchy.update();
+    hierarchy.clear();
+    TS_ASSERT_EQUALS(hierarchy.size(), 0);
+    TS_ASSERT_EQUALS(hierarchy.numLevels(), 0);
+    hierarchy.update();
+
+    hierarchy.addNode(TransformHierarchy::NO_PARENT, Quaternion(),
+                      Vector3DStack(4.0, 5.0, 6.0));
+    hierarchy.update();
+    TS_ASSERT_EQUALS(hierarchy.getWorldTranslation(0),
+                     Vector3DStack(4.0, 5.0, 6.0));
+    TS_ASSERT_EQUALS(hierarchy.getWorldRotation(0), Quaternion());
+  }
+};
@@ -0,0 +1,342 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cmath>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include "TestCommon.h"
+#include "Vector3DArray.h"
+#include "Vector3DStack.h"
+
+class Vector3DArrayTest : public CxxTest::TestSuite
+{
+public:
+  void test_Vector3DArray_Default(void)
+  {
+    Vector3DArray a;
+    TS_ASSERT_EQUALS(a.size(), 0);
+  }
+
+  void test_Vector3DArray_CreateWithSize(void)
+  {
+    Vector3DArray a(5);
+    TS_ASSERT_EQUALS(a.size(), 5);
+    for (size_t i = 0; i < a.size(); i++)
+      TS_ASSERT_EQUALS(a.get(i), Vector3DStack(0.0, 0.0, 0.0));
+  }
+
+  void test_Vector3DArray_CreateFromVectors(void)
+  {
+    Vector3DStack v[] = {Vector3DStack(1.0, 6.0, 3.0),
+                         Vector3DStack(5.0, 2.0, 9.0)};
+    Vector3DArray a(v, 2);
+
+    TS_ASSERT_EQUALS(a.size(), 2);
+    TS_ASSERT_EQUALS(a.get(0), v[0]);
+    TS_ASSERT_EQUALS(a.get(1), v[1]);
+  }
+
+  void test_Vector3DArray_Alignment(void)
+  {
+    Vector3DArray a(7);
+    TS_ASSERT_EQUALS((size_t)a.x() % 32, 0);
+    TS_ASSERT_EQUALS((size_t)a.y() % 32, 0);
+    TS_ASSERT_EQUALS((size_t)a.z() % 32, 0);
+  }
+
+  void test_Vector3DArray_CopyAndAssignment(void)
+  {
+    Vector3DArray a = makeArray(9, 1.0);
+    Vector3DArray b(a);
+    Vector3DArray c(2);
+    c = a;
+
+    for (size_t i = 0; i < a.size(); i++)
+    {
+      TS_ASSERT_EQUALS(b.get(i), a.get(i));
+      TS_ASSERT_EQUALS(c.get(i), a.get(i));
+    }
+  }
+
+  void test_Vector3DArray_CopyEmpty(void)
+  {
+    const Vector3DArray empty;
+    Vector3DArray a(empty);
+    Vector3DArray b = makeArray(3, 1.0);
+    b = empty;
+
+    TS_ASSERT_EQUALS(a.size(), 0);
+    TS_ASSERT_EQUALS(b.size(), 0);
+  }
+
+  void test_Vector3DArray_ResizeKeepsValues(void)
+  {
+    Vector3DArray a = makeArray(3, 1.0);
+    a.resize(100);
+
+    TS_ASSERT_EQUALS(a.size(), 100);
+    TS_ASSERT_EQUALS(a.get(2), makeArray(3, 1.0).get(2));
+    TS_ASSERT_EQUALS(a.get(99), Vector3DStack(0.0, 0.0, 0.0));
+  }
+
+  void test_Vector3DArray_FailedResizeKeepsArray(void)
+  {
+    Vector3DArray a = makeArray(3, 1.0);
+    const double *x = a.x();
+
+    /* Too large to size in bytes, then too large to allocate */
+    TS_ASSERT_THROWS(a.resize(SIZE_MAX), std::runtime_error);
+    TS_ASSERT_THROWS(a.resize(SIZE_MAX / (3 * sizeof(double)) / 4),
+                     std::bad_alloc);
+
+    TS_ASSERT_EQUALS(a.size(), 3);
+    TS_ASSERT_EQUALS(a.x(), x);
+    for (size_t i = 0; i < a.size(); i++)
+      TS_ASSERT_EQUALS(a.get(i), makeArray(3, 1.0).get(i));
+
+    a.resize(100);
+    TS_ASSERT_EQUALS(a.get(2), makeArray(3, 1.0).get(2));
+    TS_ASSERT_EQUALS(a.get(99), Vector3DStack(0.0, 0.0, 0.0));
+  }
+
+  void test_Vector3DArray_IndexOutOfRange(void)
+  {
+    Vector3DArray a(2);
+    TS_ASSERT_THROWS(a.get(2), std::runtime_error);
+    TS_ASSERT_THROWS(a.set(2, Vector3DStack()), std::runtime_error);
+  }
+
+  void test_Vector3DArray_SizeMismatch(void)
+  {
+    Vector3DArray a(2);
+    Vector3DArray b(3);
+    Vector3DArray out;
+    TS_ASSERT_THROWS(Vector3DArray::add(a, b, out), std::runtime_error);
+  }
+
+  void test_Vector3DArray_Add(void)
+  {
+    forEachKernel(&Vector3DArrayTest::checkAdd);
+  }
+
+  void test_Vector3DArray_Subtract(void)
+  {
+    forEachKernel(&Vector3DArrayTest::checkSubtract);
+  }
+
+  void test_Vector3DArray_Scale(void)
+  {
+    forEachKernel(&Vector3DArrayTest::checkScale);
+  }
+
+  void test_Vector3DArray_Dot(void)
+  {
+    forEachKernel(&Vector3DArrayTest::checkDot);
+  }
+
+  void test_Vector3DArray_Cross(void)
+  {
+    forEachKernel(&Vector3DArrayTest::checkCross);
+  }
+
+  void test_Vector3DArray_CrossInPlace(void)
+  {
+    Vector3DArray a = makeArray(5, 1.0);
+    Vector3DArray b = makeArray(5, 2.0);
+    Vector3DArray expected;
+    Vector3DArray::cross(a, b, expected);
+
+    Vector3DArray::cross(a, b, a);
+
+    for (size_t i = 0; i < a.size(); i++)
+      TS_ASSERT_EQUALS(a.get(i), expected.get(i));
+  }
+
+  void test_Vector3DArray_Magnitude(void)
+  {
+    forEachKernel(&Vector3DArrayTest::checkMagnitude);
+  }
+
+  void test_Vector3DArray_Normalise(void)
+  {
+    forEachKernel(&Vector3DArrayTest::checkNormalise);
+  }
+
+  void test_Vector3DArray_Float(void)
+  {
+    for (int simd = 0; simd < 2; simd++)
+    {
+      const ScopedSimdKernels kernels(simd == 1);
+
+      /* Sizes covering the four float SIMD remainders */
+      for (size_t n = 0; n < 10; n++)
+        checkFloat(n);
+      checkFloat(101);
+    }
+  }
+
+private:
+  typedef void (Vector3DArrayTest::*Check)(size_t);
+
+  /* Run a check with both kernels, for sizes covering the SIMD remainder */
+  void forEachKernel(Check check)
+  {
+    for (int simd = 0; simd < 2; simd++)
+    {
+      const ScopedSimdKernels kernels(simd == 1);
+      for (size_t n = 0; n < 6; n++)
+        (this->*check)(n);
+      (this->*check)(101);
+    }
+  }
+
+  Vector3DArray makeArray(size_t n, double seed)
+  {
+    Vector3DArray a(n);
+    for (size_t i = 0; i < n; i++)
+      a.set(i, Vector3DStack(seed + i, seed * 2.0 - i, 3.0 + seed * i));
+    return a;
+  }
+
+  void checkAdd(size_t n)
+  {
+    Vector3DArray a = makeArray(n, 1.0);
+    Vector3DArray b = makeArray(n, 2.5);
+    Vector3DArray out;
+    Vector3DArray::add(a, b, out);
+
+    TS_ASSERT_EQUALS(out.size(), n);
+    for (size_t i = 0; i < n; i++)
+      TS_ASSERT_EQUALS(out.get(i), a.get(i) + b.get(i));
+  }
+
+  void checkSubtract(size_t n)
+  {
+    Vector3DArray a = makeArray(n, 1.0);
+    Vector3DArray b = makeArray(n, 2.5);
+    Vector3DArray out;
+    Vector3DArray::subtract(a, b, out);
+
+    for (size_t i = 0; i < n; i++)
+      TS_ASSERT_EQUALS(out.get(i), a.get(i) - b.get(i));
+  }
+
+  void checkScale(size_t n)
+  {
+    Vector3DArray a = makeArray(n, 1.0);
+    Vector3DArray out;
+    Vector3DArray::scale(a, 6.0, out);
+
+    for (size_t i = 0; i < n; i++)
+      TS_ASSERT_EQUALS(out.get(i), a.get(i) * 6.0);
+  }
+
+  void checkDot(size_t n)
+  {
+    Vector3DArray a = makeArray(n, 1.0);
+    Vector3DArray b = makeArray(n, 2.5);
+    std::vector<double> out(n + 1, -1.0);
+    Vector3DArray::dot(a, b, &out[0]);
+
+    for (size_t i = 0; i < n; i++)
+      TS_ASSERT_DELTA(out[i], a.get(i) * b.get(i), TH);
+
+    /* Must not write past the end */
+    TS_ASSERT_EQUALS(out[n], -1.0);
+  }
+
+  void checkCross(size_t n)
+  {
+    Vector3DArray a = makeArray(n, 1.0);
+    Vector3DArray b = makeArray(n, 2.5);
+    Vector3DArray out;
+    Vector3DArray::cross(a, b, out);
+
+    for (size_t i = 0; i < n; i++)
+      TS_ASSERT_EQUALS(out.get(i), a.get(i) % b.get(i));
+  }
+
+  void checkMagnitude(size_t n)
+  {
+    Vector3DArray a = makeArray(n, 1.0);
+    std::vector<double> out(n + 1, -1.0);
+    a.magnitude(&out[0]);
+
+    for (size_t i = 0; i < n; i++)
+      TS_ASSERT_DELTA(out[i], a.get(i).magnitude(), TH);
+    TS_ASSERT_EQUALS(out[n], -1.0);
+  }
+
+  void checkNormalise(size_t n)
+  {
+    Vector3DArray a = makeArray(n, 1.0);
+    if (n > 0)
+      a.set(0, Vector3DStack(0.0, 0.0, 0.0));
+    Vector3DArray expected(a);
+    a.normalise();
+
+    /* Zero vectors are left unchanged */
+    if (n > 0)
+      TS_ASSERT_EQUALS(a.get(0), Vector3DStack(0.0, 0.0, 0.0));
+
+    for (size_t i = 1; i < n; i++)
+    {
+      const Vector3DStack unit = expected.get(i).getUnitVector();
+      TS_ASSERT_DELTA(a.get(i).getX(), unit.getX(), TH);
+      TS_ASSERT_DELTA(a.get(i).getY(), unit.getY(), TH);
+      TS_ASSERT_DELTA(a.get(i).getZ(), unit.getZ(), TH);
+    }
+  }
+
+  /* Float results match double to float precision */
+  void checkFloat(size_t n)
+  {
+    const Vector3DArray a = makeArray(n, 0.1);
+    const Vector3DArray b = makeArray(n, 0.25);
+    const Vector3DArrayF af(a);
+    const Vector3DArrayF bf(b);
+
+    TS_ASSERT_EQUALS(af.size(), n);
+    TS_ASSERT_EQUALS((size_t)af.y() % 32, 0);
+    TS_ASSERT_EQUALS((size_t)af.z() % 32, 0);
+
+    Vector3DArray sum, cross;
+    Vector3DArrayF sumF, crossF;
+    Vector3DArray::add(a, b, sum);
+    Vector3DArrayF::add(af, bf, sumF);
+    Vector3DArray::cross(a, b, cross);
+    Vector3DArrayF::cross(af, bf, crossF);
+
+    std::vector<double> dot(n + 1);
+    std::vector<float> dotF(n + 1, -1.0f);
+    Vector3DArray::dot(a, b, &dot[0]);
+    Vector3DArrayF::dot(af, bf, &dotF[0]);
+
+    Vector3DArrayF unitF(af);
+    unitF.normalise();
+
+    for (size_t i = 0; i < n; i++)
+    {
+      assertCloseF(sumF.get(i), sum.get(i));
+      assertCloseF(crossF.get(i), cross.get(i));
+      assertCloseF(unitF.get(i), a.get(i).getUnitVector());
+      TS_ASSERT_DELTA(dotF[i], dot[i], TH * std::fabs(dot[i]));
+    }
+    TS_ASSERT_EQUALS(dotF[n], -1.0f);
+
+    /* Converting back gives the float values exactly */
+    const Vector3DArray back(sumF);
+    for (size_t i = 0; i < n; i++)
+      TS_ASSERT_EQUALS(back.get(i), Vector3DStack(sumF.get(i)));
+  }
+
+  void assertCloseF(const Vector3DStackF &f, const Vector3DStack &d)
+  {
+    const double th = TH * (1.0 + d.magnitude());
+    TS_ASSERT_DELTA(f.getX(), d.getX(), th);
+    TS_ASSERT_DELTA(f.getY(), d.getY(), th);
+    TS_ASSERT_DELTA(f.getZ(), d.getZ(), th);
+  }
+};
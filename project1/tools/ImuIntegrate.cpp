@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "ChunkedIO.h"
+#include "Quaternion.h"
+#include "Vector3DStack.h"
+
+/*
+ * Integrates gyroscope samples into orientations.
+ *
+ * Usage: ImuIntegrate [--binary-in] [--binary-out] [--chunk-size bytes]
+ *                     [input] [output]
+ *
+ * Input and output default to (or may be given as "-" for) stdin and stdout,
+ * and must not be the same file.
+ *
+ * Text input has one sample per line, "timestamp,wx,wy,wz" with angular
+ * velocity in radians per unit time in the sensor frame; blank lines and
+ * lines starting with '#' are skipped. Lines may be up to 4096 characters
+ * long. Binary input is four doubles per sample in the same order.
+ *
+ * Text output has one line per sample, "timestamp,w,i,j,k". Binary output is
+ * five doubles per sample in the same order. Binary data uses the native
+ * double layout (little endian IEEE 754 on supported platforms).
+ *
+ * The orientation starts at the identity and, for each sample, is advanced by
+ * the angular velocity of the previous sample over the time between them.
+ *
+ * Input is read and output written on background threads a chunk at a time,
+ * so memory use is fixed regardless of input size.
+ */
+
+/* Longest formatted output line */
+static const size_t MAX_LINE = 5 * 32;
+
+/* Longest input line */
+static const size_t MAX_INPUT_LINE = 4096;
+
+/**
+ * Orientation integration state and output.
+ */
+struct Integrator
+{
+  Integrator(ChunkedWriter &output, const bool binary)
+      : writer(output)
+      , binaryOut(binary)
+      , used(0)
+      , samples(0)
+      , lastTime(0.0)
+  {
+  }
+
+  /**
+   * Advances the orientation to a sample and outputs it.
+   *
+   * @param sample Timestamp and angular velocity
+   */
+  void add(const double *sample)
+  {
+    if (samples > 0)
+    {
+      const double dt = sample[0] - lastTime;
+      q = q * Quaternion::fromRotationVector(lastRate * dt);
+      q = q.getUnitQuaternion();
+    }
+
+    lastTime = sample[0];
+    lastRate = Vector3DStack(sample[1], sample[2], sample[3]);
+    samples++;
+
+    if (writer.chunkSize() - used < MAX_LINE)
+    {
+      writer.submit(used);
+      used = 0;
+    }
+
+    char *out = writer.buffer() + used;
+    if (binaryOut)
+    {
+      const double values[] = {sample[0], q.getReal(), q.getI(), q.getJ(),
+                               q.getK()};
+      memcpy(out, values, sizeof(values));
+      used += sizeof(values);
+    }
+    else
+    {
+      used += snprintf(out, MAX_LINE, "%.17g,%.17g,%.17g,%.17g,%.17g\n",
+                       sample[0], q.getReal(), q.getI(), q.getJ(), q.getK());
+    }
+  }
+
+  /**
+   * Submits any remaining output.
+   */
+  void flush()
+  {
+    if (used > 0)
+      writer.submit(used);
+    used = 0;
+  }
+
+  ChunkedWriter &writer;
+  const bool binaryOut;
+  size_t used;
+
+  size_t samples;
+  double lastTime;
+  Vector3DStack lastRate;
+  Quaternion q;
+};
+
+/**
+ * Parses one line of text input.
+ *
+ * @param begin Start of the line
+ * @param end End of the line (excluding any newline)
+ * @param sample Array of four values to store the sample in
+ * @return 1 if a sample was parsed, 0 if the line was skipped, -1 if it is
+ *         invalid
+ */
+static int parseLine(const char *begin, const char *end, double *sample)
+{
+  const char *p = begin;
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+    p++;
+  if (p == end || *p == '#')
+    return 0;
+
+  for (int n = 0; n < 4; n++)
+  {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == ','))
+      p++;
+    if (p == end)
+      return -1;
+
+    char *valueEnd;
+    sample[n] = strtod(p, &valueEnd);
+    if (valueEnd == p || valueEnd > end)
+      return -1;
+    p = valueEnd;
+  }
+
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+    p++;
+  return p == end ? 1 : -1;
+}
+
+/**
+ * Integrates text input.
+ *
+ * @param reader Input
+ * @param integrator Integration state
+ * @return True on success
+ */
+static bool integrateText(ChunkedReader &reader, Integrator &integrator)
+{
+  ChunkedSplitter lines(reader, '\n', MAX_INPUT_LINE);
+  double sample[4];
+
+  for (size_t lineNumber = 1;; lineNumber++)
+  {
+    const char *begin;
+    const char *end;
+    try
+    {
+      if (!lines.next(begin, end))
+        return true;
+    }
+    catch (const std::runtime_error &)
+    {
+      fprintf(stderr, "Line %lu is too long\n", (unsigned long)lineNumber);
+      return false;
+    }
+
+    if (lines.terminated())
+      end--;
+
+    const int result = parseLine(begin, end, sample);
+    if (result > 0)
+      integrator.add(sample);
+    else if (result < 0)
+    {
+      fprintf(stderr, "Invalid sample on line %lu\n",
+              (unsigned long)lineNumber);
+      return false;
+    }
+  }
+}
+
+/**
+ * Integrates binary input.
+ *
+ * @param reader Input
+ * @param integrator Integration state
+ * @return True on success
+ */
+static bool integrateBinary(ChunkedReader &reader, Integrator &integrator)
+{
+  const size_t RECORD = 4 * sizeof(double);
+
+  char carry[RECORD];
+  size_t carried = 0;
+  double sample[4];
+
+  const char *data;
+  size_t size;
+
+  while (reader.next(data, size))
+  {
+    const char *p = data;
+    const char *end = data + size;
+
+    /* Complete a record split between chunks */
+    if (carried > 0)
+    {
+      const size_t n = std::min(RECORD - carried, size);
+      memcpy(carry + carried, p, n);
+      carried += n;
+      p += n;
+      if (carried < RECORD)
+        continue;
+
+      memcpy(sample, carry, RECORD);
+      integrator.add(sample);
+      carried = 0;
+    }
+
+    for (; end - p >= (ptrdiff_t)RECORD; p += RECORD)
+    {
+      memcpy(sample, p, RECORD);
+      integrator.add(sample);
+    }
+
+    carried = end - p;
+    memcpy(carry, p, carried);
+  }
+
+  if (carried > 0)
+  {
+    fprintf(stderr, "Input ends with a partial sample\n");
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Tells whether an open input file and an output path name the same file,
+ * which opening the output would truncate.
+ *
+ * @param in Input file
+ * @param inPath Input path
+ * @param outPath Output path
+ * @return True if both are the same file
+ */
+static bool sameFile(FILE *in, const char *inPath, const char *outPath)
+{
+#ifdef _WIN32
+  /* Inode numbers are not available, compare the paths */
+  (void)in;
+  return strcmp(inPath, outPath) == 0;
+#else
+  (void)inPath;
+  struct stat inStat;
+  struct stat outStat;
+  return fstat(fileno(in), &inStat) == 0 && stat(outPath, &outStat) == 0 &&
+         inStat.st_dev == outStat.st_dev && inStat.st_ino == outStat.st_ino;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+  bool binaryIn = false;
+  bool binaryOut = false;
+  size_t chunkSize = 1 << 20;
+  const char *paths[] = {"-", "-"};
+  int numPaths = 0;
+
+  for (int n = 1; n < argc; n++)
+  {
+    if (strcmp(argv[n], "--binary-in") == 0)
+      binaryIn = true;
+    else if (strcmp(argv[n], "--binary-out") == 0)
+      binaryOut = true;
+    else if (strcmp(argv[n], "--chunk-size") == 0 && n + 1 < argc)
+      chunkSize = strtoul(argv[++n], NULL, 10);
+    else if (numPaths < 2)
+      paths[numPaths++] = argv[n];
+    else
+    {
+      fprintf(stderr, "Usage: %s [--binary-in] [--binary-out] "
+                      "[--chunk-size bytes] [input] [output]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  if (chunkSize < MAX_LINE)
+    chunkSize = MAX_LINE;
+
+  FILE *in = strcmp(paths[0], "-") == 0 ? stdin : fopen(paths[0], "rb");
+  if (in == NULL)
+  {
+    fprintf(stderr, "Cannot open %s\n", paths[0]);
+    return 1;
+  }
+
+  if (strcmp(paths[1], "-") != 0 && sameFile(in, paths[0], paths[1]))
+  {
+    fprintf(stderr, "Input and output are the same file\n");
+    if (in != stdin)
+      fclose(in);
+    return 1;
+  }
+
+  FILE *out = strcmp(paths[1], "-") == 0 ? stdout : fopen(paths[1], "wb");
+  if (out == NULL)
+  {
+    fprintf(stderr, "Cannot open %s\n", paths[1]);
+    return 1;
+  }
+
+  bool ok;
+  {
+    ChunkedReader reader(in, chunkSize);
+    ChunkedWriter writer(out, chunkSize);
+    Integrator integrator(writer, binaryOut);
+
+    ok = binaryIn ? integrateBinary(reader, integrator)
+                  : integrateText(reader, integrator);
+
+    integrator.flush();
+    if (!writer.finish())
+    {
+      fprintf(stderr, "Failed to write output\n");
+      ok = false;
+    }
+  }
+
+  if (ferror(in))
+  {
+    fprintf(stderr, "Failed to read input\n");
+    ok = false;
+  }
+
+  if (in != stdin)
+    fclose(in);
+  if (out != stdout && fclose(out) != 0)
+    ok = false;
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Parallel.h"
+#include "Quaternion.h"
+#include "RotationMatrix.h"
+#include "Vector3DStack.h"
+
+/*
+ * Rotates a binary point cloud file.
+ *
+ * Usage: PointCloudRotate input output angle axisX axisY axisZ [num threads]
+ *
+ * The input and output must be different files.
+ *
+ * Points are stored as three doubles (x, y, z) each in the native layout
+ * (little endian IEEE 754 on supported platforms). The rotation is given in
+ * degrees about an axis, as for Quaternion(angle, axis).
+ *
+ * Both files are memory mapped and points are rotated straight from the input
+ * mapping into the output mapping. Threads take fixed size windows of the
+ * file in order; once a window is done its input pages are dropped and write
+ * back of its output pages is started, so files larger than memory stream
+ * through the page cache rather than filling it.
+ */
+
+/* Points per window, a multiple of the page size so windows are page aligned */
+static const size_t WINDOW_POINTS = 4096 * 256;
+
+/* Bytes per point */
+static const size_t POINT_BYTES = 3 * sizeof(double);
+
+/**
+ * Rotates windows of points until none are left.
+ *
+ * @param m Rotation
+ * @param in Input mapping
+ * @param out Output mapping
+ * @param numPoints Number of points in the file
+ * @param nextWindow Index of the next window to process
+ */
+static void rotateWindows(const RotationMatrix &m, const char *in, char *out,
+                          const size_t numPoints,
+                          std::atomic<size_t> &nextWindow)
+{
+  for (;;)
+  {
+    const size_t begin = nextWindow.fetch_add(1) * WINDOW_POINTS;
+    if (begin >= numPoints)
+      return;
+
+    const size_t count = std::min(WINDOW_POINTS, numPoints - begin);
+    const size_t offset = begin * POINT_BYTES;
+    const size_t bytes = count * POINT_BYTES;
+
+    m.apply((const double *)(in + offset), (double *)(out + offset), count);
+
+    madvise((void *)(in + offset), bytes, MADV_DONTNEED);
+    msync(out + offset, bytes, MS_ASYNC);
+  }
+}
+
+/**
+ * Prints the usage line.
+ *
+ * @param name Name of the program
+ * @return Exit status
+ */
+static int usage(const char *name)
+{
+  fprintf(stderr, "Usage: %s input output angle axisX axisY axisZ "
+                  "[num threads]\n",
+          name);
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 7 || argc > 8)
+    return usage(argv[0]);
+
+  Quaternion q;
+  try
+  {
+    q = Quaternion(atof(argv[3]), Vector3DStack(atof(argv[4]), atof(argv[5]),
+                                                atof(argv[6])));
+  }
+  catch (const std::runtime_error &)
+  {
+    /* Zero length axis */
+    return usage(argv[0]);
+  }
+  const RotationMatrix m(q);
+
+  const unsigned int numThreads = resolveNumThreads(
+      argc > 7 ? (unsigned int)strtoul(argv[7], NULL, 10) : 0);
+
+  const int inFd = open(argv[1], O_RDONLY);
+  if (inFd < 0)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  struct stat st;
+  if (fstat(inFd, &st) != 0)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  const size_t bytes = (size_t)st.st_size;
+  if (bytes % POINT_BYTES != 0)
+  {
+    fprintf(stderr, "%s is not a whole number of points\n", argv[1]);
+    return 1;
+  }
+  const size_t numPoints = bytes / POINT_BYTES;
+
+  /* Not truncated on opening, in case it is the input */
+  const int outFd = open(argv[2], O_RDWR | O_CREAT, 0644);
+  struct stat outSt;
+  if (outFd < 0 || fstat(outFd, &outSt) != 0)
+  {
+    perror(argv[2]);
+    return 1;
+  }
+
+  if (outSt.st_dev == st.st_dev && outSt.st_ino == st.st_ino)
+  {
+    fprintf(stderr, "Input and output are the same file\n");
+    close(inFd);
+    close(outFd);
+    return 1;
+  }
+
+  /* Emptied first so that none of its old contents are read back in */
+  if (ftruncate(outFd, 0) != 0)
+  {
+    perror(argv[2]);
+    return 1;
+  }
+
+  /* Disk space is reserved rather than left sparse, as running out of space
+   * while writing back the mapping would raise SIGBUS instead of an error */
+  if (st.st_size > 0)
+  {
+    const int error = posix_fallocate(outFd, 0, st.st_size);
+    if (error != 0)
+    {
+      fprintf(stderr, "%s: %s\n", argv[2], strerror(error));
+      close(inFd);
+      close(outFd);
+      return 1;
+    }
+  }
+
+  if (numPoints == 0)
+  {
+    close(inFd);
+    close(outFd);
+    return 0;
+  }
+
+  void *in = mmap(NULL, bytes, PROT_READ, MAP_SHARED, inFd, 0);
+  void *out = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, outFd, 0);
+  if (in == MAP_FAILED || out == MAP_FAILED)
+  {
+    perror("mmap");
+    return 1;
+  }
+
+  madvise(in, bytes, MADV_SEQUENTIAL);
+  madvise(out, bytes, MADV_SEQUENTIAL);
+
+  std::atomic<size_t> nextWindow(0);
+  std::vector<std::thread> threads;
+  for (unsigned int n = 1; n < numThreads; n++)
+  {
+    threads.push_back(std::thread(rotateWindows, std::cref(m),
+                                  (const char *)in, (char *)out, numPoints,
+                                  std::ref(nextWindow)));
+  }
+  rotateWindows(m, (const char *)in, (char *)out, numPoints, nextWindow);
+
+  for (size_t n = 0; n < threads.size(); n++)
+    threads[n].join();
+
+  bool ok = msync(out, bytes, MS_SYNC) == 0;
+  if (!ok)
+    perror("msync");
+
+  munmap(in, bytes);
+  munmap(out, bytes);
+  close(inFd);
+  if (close(outFd) != 0)
+    ok = false;
+
+  return ok ? 0 : 1;
+}
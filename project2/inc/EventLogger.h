@@ -0,0 +1,120 @@
+/** \file */
+
+#ifndef __EVENTLOGGER_H_
+#define __EVENTLOGGER_H_
+
+#include <atomic>
+#include <ostream>
+#include <thread>
+
+#include "ShapeTable.h"
+#include "SpscRingBuffer.h"
+
+class Shape;
+
+/**
+ * \enum BackpressurePolicy
+ * \brief Action taken when an event is logged while the buffer is full.
+ */
+enum BackpressurePolicy
+{
+  BP_BLOCK, //!< Wait until the output thread has made space
+  BP_DROP,  //!< Discard the event
+  BP_COUNT  //!< Discard the event and report the number discarded in the output
+};
+
+/**
+ * \enum EventType
+ * \brief Type of an EventRecord.
+ */
+enum EventType
+{
+  E_INTERSECTION, //!< Two shapes intersected
+  E_DROPPED       //!< Events were discarded due to backpressure
+};
+
+/**
+ * \enum ShapeType
+ * \brief Type of shape described by a ShapeRecord.
+ */
+enum ShapeType
+{
+  S_UNKNOWN,
+  S_CIRCLE,
+  S_SQUARE
+};
+
+/**
+ * \struct ShapeRecord
+ * \brief Compact description of a shape at the time of an event.
+ */
+struct ShapeRecord
+{
+  ShapeID id;     //!< ID of the shape in the game
+  ShapeType type; //!< Type of shape
+  double x;       //!< X position
+  double y;       //!< Y position
+  double a;       //!< Radius of a Circle or width of a Square
+  double b;       //!< Height of a Square
+};
+
+/**
+ * \struct EventRecord
+ * \brief Compact binary record of an event produced by the game.
+ */
+struct EventRecord
+{
+  EventType type;     //!< Type of event
+  unsigned int tick;  //!< Tick on which the event occurred
+  unsigned int count; //!< Number of events dropped (E_DROPPED only)
+  ShapeRecord first;  //!< First shape involved
+  ShapeRecord second; //!< Second shape involved
+};
+
+/**
+ * \class EventLogger
+ * \brief Formats events to a stream on a background thread.
+ *
+ * The simulation thread logs compact EventRecord objects into a lock-free
+ * single producer, single consumer ring buffer; a background thread formats
+ * them in the same text format as writing the shapes directly to the stream.
+ *
+ * Only one thread may log events.
+ */
+class EventLogger
+{
+public:
+  EventLogger(std::ostream &stream, size_t capacity = 4096,
+              BackpressurePolicy policy = BP_BLOCK);
+  ~EventLogger();
+
+  void logIntersection(unsigned int tick, ShapeID firstId, const Shape &first,
+                       ShapeID secondId, const Shape &second);
+  void flush();
+
+  BackpressurePolicy policy() const;
+  unsigned long droppedCount() const;
+
+  static ShapeRecord recordShape(ShapeID id, const Shape &shape);
+  static void formatEvent(std::ostream &stream, const EventRecord &event);
+
+private:
+  EventLogger(const EventLogger &);
+  EventLogger &operator=(const EventLogger &);
+
+  void push(const EventRecord &event);
+  void run();
+
+  std::ostream &m_stream;              //!< Stream events are formatted to
+  const BackpressurePolicy m_policy;   //!< Action taken when buffer is full
+  SpscRingBuffer<EventRecord> m_buffer; //!< Events awaiting output
+
+  unsigned long m_pushed;                //!< Events added to the buffer
+  unsigned int m_pendingDrops;           //!< Drops yet to be reported
+  std::atomic<unsigned long> m_dropped;  //!< Total events discarded
+  std::atomic<unsigned long> m_written;  //!< Events formatted to the stream
+  std::atomic<bool> m_stop;              //!< Flag to stop the output thread
+  std::thread m_thread;                  //!< Output thread
+};
+
+#endif
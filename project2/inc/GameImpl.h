@@ -6,19 +6,25 @@
 #include <cstdlib>
 #include <ostream>
 #include <list>
+#include <random>
+
+#include "ShapeTable.h"
 
 class BoundingBox;
+class EventLogger;
+class PhaseProfiler;
 class Shape;
+class Tracer;
 
 /**
- * \brief A list containing pointers to Shape objects.
+ * \brief A list containing the IDs of Shape objects.
  */
-typedef std::list<Shape *> ShapeList;
+typedef std::list<ShapeID> ShapeList;
 
 /**
- * \brief An iterator over a list containing pointers to Shape objects.
+ * \brief An iterator over a list containing the IDs of Shape objects.
  */
-typedef std::list<Shape *>::iterator ShapeListIt;
+typedef std::list<ShapeID>::iterator ShapeListIt;
 
 /**
  * \class GameImpl
@@ -29,20 +35,38 @@ class GameImpl
 {
   public:
     GameImpl(const BoundingBox &clamp, std::ostream &stream);
+    GameImpl(const BoundingBox &clamp, std::ostream &stream,
+             unsigned int seed);
     ~GameImpl();
 
     void generateInitialShapes(int numShapes, double maxDimension);
     void applyRandomOffsets(double maxOffset);
     bool cullOverlapping();
 
+    unsigned int collisionFreeTicks(double maxOffset) const;
+    unsigned int fastForward(double maxOffset);
+
+    void setEventLogger(EventLogger *logger);
+    void setTracer(Tracer *tracer);
+    void setPhaseProfiler(PhaseProfiler *profiler);
+
     void printAllShapes();
     double random(double lower, double upper) const;
     size_t numShapes() const;
+    const ShapeList &shapeIds() const;
+    Shape *getShape(ShapeID id) const;
+    unsigned int tick() const;
 
   private:
-    ShapeList m_shapes;
+    ShapeList m_shapes;  //!< IDs of shapes in the game, in order of creation
+    ShapeTable m_table;  //!< Owns the shapes in the game
     const BoundingBox &m_clamp;
     std::ostream &m_stream;
+    EventLogger *m_logger; //!< Logger for events, NULL to write to m_stream
+    Tracer *m_tracer;      //!< Tracer recording phases, NULL to disable
+    PhaseProfiler *m_profiler; //!< Profiler measuring phases, NULL to disable
+    unsigned int m_tick;   //!< Number of times offsets have been applied
+    mutable std::mt19937 m_generator; //!< Random number generator
 };
 
 #endif
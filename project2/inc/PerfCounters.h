@@ -0,0 +1,63 @@
+/** \file */
+
+#ifndef __PERFCOUNTERS_H_
+#define __PERFCOUNTERS_H_
+
+#include <cstdint>
+
+/**
+ * \enum PerfCounter
+ * \brief Hardware events counted by PerfCounters.
+ */
+enum PerfCounter
+{
+  PC_CYCLES,        //!< CPU cycles
+  PC_INSTRUCTIONS,  //!< Instructions retired
+  PC_L1D_MISSES,    //!< L1 data cache read misses
+  PC_LLC_MISSES,    //!< Last level cache misses
+  PC_BRANCH_MISSES, //!< Mispredicted branches
+  PC_NUM_COUNTERS
+};
+
+/**
+ * \struct PerfSample
+ * \brief Values of all counters at a point in time (or the difference between
+ *        two points in time).
+ */
+struct PerfSample
+{
+  uint64_t values[PC_NUM_COUNTERS]; //!< Counter values, indexed by PerfCounter
+};
+
+/**
+ * \class PerfCounters
+ * \brief A group of hardware performance counters measuring the thread that
+ *        created it.
+ *
+ * Uses perf_event_open on Linux. Counters that cannot be opened (unsupported
+ * hardware, virtual machines, restrictive perf_event_paranoid settings or
+ * other platforms) are reported as unavailable and read as zero.
+ */
+class PerfCounters
+{
+public:
+  PerfCounters();
+  ~PerfCounters();
+
+  bool available() const;
+  bool available(PerfCounter counter) const;
+
+  bool read(PerfSample &sample) const;
+
+  static const char *name(PerfCounter counter);
+
+private:
+  PerfCounters(const PerfCounters &);
+  PerfCounters &operator=(const PerfCounters &);
+
+  int m_fds[PC_NUM_COUNTERS]; //!< File descriptor of each counter, -1 if
+                              //!< unavailable
+  int m_numOpen;              //!< Number of counters open in the group
+};
+
+#endif
@@ -0,0 +1,114 @@
+/** \file */
+
+#ifndef __PHASEPROFILER_H_
+#define __PHASEPROFILER_H_
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "PerfCounters.h"
+#include "Tracer.h"
+
+/**
+ * \class PhaseProfiler
+ * \brief Accumulates the wall clock time and hardware counter values spent in
+ *        each named phase of the game.
+ *
+ * Counters measure the thread that created the profiler, so a profiler must
+ * only be used by that thread.
+ */
+class PhaseProfiler
+{
+public:
+  PhaseProfiler(bool useCounters = true);
+  ~PhaseProfiler();
+
+  bool countersAvailable() const;
+
+  uint64_t now() const;
+  void sample(PerfSample &sample) const;
+  void add(const char *phase, uint64_t duration, const PerfSample &start,
+           const PerfSample &end);
+
+  unsigned long calls(const char *phase) const;
+
+  void write(std::ostream &stream) const;
+
+private:
+  PhaseProfiler(const PhaseProfiler &);
+  PhaseProfiler &operator=(const PhaseProfiler &);
+
+  /**
+   * \struct PhaseTotals
+   * \brief Accumulated measurements of a phase.
+   */
+  struct PhaseTotals
+  {
+    const char *name;        //!< Name of the phase
+    unsigned long calls;     //!< Number of times the phase was run
+    uint64_t duration;       //!< Total wall clock time in ns
+    PerfSample counters;     //!< Total counter values
+  };
+
+  PhaseTotals &totals(const char *phase);
+
+  PerfCounters *m_counters;          //!< Counters, NULL if not used
+  std::vector<PhaseTotals> m_phases; //!< Totals, in order of first use
+};
+
+/**
+ * \class PhaseScope
+ * \brief Measures a phase of the game over the lifetime of the object.
+ *
+ * Records a span to a Tracer and adds the time and counter values to a
+ * PhaseProfiler; either may be NULL.
+ */
+class PhaseScope
+{
+public:
+  /**
+   * \brief Starts measuring a phase.
+   *
+   * \param tracer Tracer to record to, may be NULL
+   * \param profiler Profiler to add measurements to, may be NULL
+   * \param name Name of the phase, must be a string literal
+   */
+  PhaseScope(Tracer *tracer, PhaseProfiler *profiler, const char *name)
+      : m_trace(tracer, name)
+      , m_profiler(profiler)
+      , m_name(name)
+      , m_start(0)
+  {
+    if (m_profiler != NULL)
+    {
+      m_start = m_profiler->now();
+      m_profiler->sample(m_startSample);
+    }
+  }
+
+  /**
+   * \brief Stops measuring the phase.
+   */
+  ~PhaseScope()
+  {
+    if (m_profiler != NULL)
+    {
+      PerfSample end;
+      m_profiler->sample(end);
+      m_profiler->add(m_name, m_profiler->now() - m_start, m_startSample, end);
+    }
+  }
+
+private:
+  PhaseScope(const PhaseScope &);
+  PhaseScope &operator=(const PhaseScope &);
+
+  TraceScope m_trace;         //!< Span recorded to the tracer
+  PhaseProfiler *m_profiler;  //!< Profiler to add measurements to
+  const char *m_name;         //!< Name of the phase
+  uint64_t m_start;           //!< Start time
+  PerfSample m_startSample;   //!< Counter values at the start
+};
+
+#endif
@@ -0,0 +1,74 @@
+/** \file */
+
+#ifndef __SHAPETABLE_H_
+#define __SHAPETABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Shape;
+
+/**
+ * \brief Stable 32 bit identifier of a shape.
+ *
+ * The lower SHAPE_ID_SLOT_BITS bits index a slot in a ShapeTable, the upper
+ * bits hold the generation of the slot at the time the shape was added, so an
+ * ID is never reused for a different shape.
+ */
+typedef uint32_t ShapeID;
+
+/**
+ * \brief Number of bits of a ShapeID used for the slot index.
+ */
+const unsigned int SHAPE_ID_SLOT_BITS = 20;
+
+/**
+ * \brief ShapeID that never refers to a shape.
+ */
+const ShapeID INVALID_SHAPE_ID = 0xFFFFFFFF;
+
+/**
+ * \class ShapeTable
+ * \brief Generational handle table owning a set of shapes.
+ *
+ * Provides O(1) insertion, lookup and removal by ShapeID; removing a shape
+ * does not invalidate the IDs of any other shape, and looking up the ID of a
+ * removed shape safely returns NULL.
+ */
+class ShapeTable
+{
+public:
+  ShapeTable();
+  ~ShapeTable();
+
+  ShapeID insert(Shape *shape);
+  bool remove(ShapeID id);
+
+  Shape *get(ShapeID id) const;
+  bool contains(ShapeID id) const;
+  size_t size() const;
+
+  static uint32_t slotOf(ShapeID id);
+  static uint32_t generationOf(ShapeID id);
+
+private:
+  ShapeTable(const ShapeTable &);
+  ShapeTable &operator=(const ShapeTable &);
+
+  /**
+   * \struct Slot
+   * \brief Entry in the table.
+   */
+  struct Slot
+  {
+    Shape *shape;        //!< Shape in this slot, NULL if the slot is free
+    uint32_t generation; //!< Incremented each time the slot is freed
+  };
+
+  std::vector<Slot> m_slots;         //!< All slots, indexed by slot number
+  std::vector<uint32_t> m_freeSlots; //!< Slots available for reuse
+  size_t m_size;                     //!< Number of shapes in the table
+};
+
+#endif
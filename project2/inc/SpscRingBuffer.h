@@ -0,0 +1,132 @@
+/** \file */
+
+#ifndef __SPSCRINGBUFFER_H_
+#define __SPSCRINGBUFFER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * \class SpscRingBuffer
+ * \brief A lock-free, fixed capacity, first in first out queue for exactly one
+ *        producer thread and one consumer thread.
+ *
+ * The read and write positions increase monotonically and are wrapped into
+ * the storage by masking, hence the capacity is rounded up to a power of two.
+ * Each position is only ever written by one thread, which publishes it with
+ * release semantics after the slot has been written (or read).
+ */
+template <typename T> class SpscRingBuffer
+{
+public:
+  /**
+   * \brief Creates a new, empty ring buffer.
+   *
+   * \param capacity Minimum number of items that can be held
+   */
+  explicit SpscRingBuffer(size_t capacity)
+      : m_mask(roundUpCapacity(capacity) - 1)
+      , m_items(m_mask + 1)
+      , m_writePos(0)
+      , m_readPos(0)
+  {
+  }
+
+  /**
+   * \brief Returns the number of items the buffer can hold.
+   *
+   * \return Capacity
+   */
+  size_t capacity() const
+  {
+    return m_mask + 1;
+  }
+
+  /**
+   * \brief Returns the number of items currently in the buffer.
+   *
+   * Only exact when called from the producer or consumer thread while the
+   * other is idle.
+   *
+   * \return Number of items
+   */
+  size_t size() const
+  {
+    return m_writePos.load(std::memory_order_acquire) -
+           m_readPos.load(std::memory_order_acquire);
+  }
+
+  /**
+   * \brief Tests if the buffer is empty.
+   *
+   * \return True if there are no items in the buffer
+   */
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  /**
+   * \brief Adds an item to the buffer. Must only be called by the producer.
+   *
+   * \param item Item to add
+   * \return True if the item was added, false if the buffer was full
+   */
+  bool tryPush(const T &item)
+  {
+    const size_t write = m_writePos.load(std::memory_order_relaxed);
+    if (write - m_readPos.load(std::memory_order_acquire) > m_mask)
+      return false;
+
+    m_items[write & m_mask] = item;
+    m_writePos.store(write + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * \brief Removes the oldest item from the buffer. Must only be called by the
+   *        consumer.
+   *
+   * \param item Reference to store the removed item in
+   * \return True if an item was removed, false if the buffer was empty
+   */
+  bool tryPop(T &item)
+  {
+    const size_t read = m_readPos.load(std::memory_order_relaxed);
+    if (read == m_writePos.load(std::memory_order_acquire))
+      return false;
+
+    item = m_items[read & m_mask];
+    m_readPos.store(read + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  /**
+   * \brief Rounds a capacity up to the next power of two.
+   *
+   * \param capacity Requested capacity
+   * \return Capacity that is a power of two
+   */
+  static size_t roundUpCapacity(size_t capacity)
+  {
+    size_t c = 1;
+    while (c < capacity)
+      c <<= 1;
+    return c;
+  }
+
+  SpscRingBuffer(const SpscRingBuffer &);
+  SpscRingBuffer &operator=(const SpscRingBuffer &);
+
+  const size_t m_mask;  //!< Capacity - 1, used to wrap positions
+  std::vector<T> m_items; //!< Storage for items
+
+  /* Positions are on separate cache lines to avoid false sharing between the
+   * producer and consumer */
+  alignas(64) std::atomic<size_t> m_writePos; //!< Next position to write
+  alignas(64) std::atomic<size_t> m_readPos;  //!< Next position to read
+};
+
+#endif
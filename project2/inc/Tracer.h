@@ -0,0 +1,100 @@
+/** \file */
+
+#ifndef __TRACER_H_
+#define __TRACER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/**
+ * \struct TraceEvent
+ * \brief A named span of time on a thread.
+ */
+struct TraceEvent
+{
+  const char *name;    //!< Name of the span, must be a string literal
+  uint32_t threadId;   //!< Sequential ID of the thread that recorded the span
+  uint64_t start;      //!< Start time in ns since the Tracer was created
+  uint64_t duration;   //!< Duration in ns
+};
+
+/**
+ * \class Tracer
+ * \brief Records spans of time from any number of threads into a preallocated
+ *        buffer and outputs them in the Chrome trace event format.
+ *
+ * The output can be loaded into chrome://tracing or Perfetto. Recording only
+ * claims a slot in the buffer with an atomic increment; once the buffer is
+ * full further spans are counted but discarded.
+ */
+class Tracer
+{
+public:
+  Tracer(size_t capacity = 1 << 20);
+  ~Tracer();
+
+  uint64_t now() const;
+  void record(const char *name, uint64_t start, uint64_t end);
+
+  size_t size() const;
+  size_t droppedCount() const;
+
+  void writeJson(std::ostream &stream) const;
+  bool writeJsonFile(const char *filename) const;
+
+  static uint32_t currentThreadId();
+
+private:
+  Tracer(const Tracer &);
+  Tracer &operator=(const Tracer &);
+
+  const std::chrono::steady_clock::time_point m_epoch; //!< Time zero
+  std::vector<TraceEvent> m_events; //!< Preallocated event storage
+  std::atomic<size_t> m_next;       //!< Next free slot in m_events
+};
+
+/**
+ * \class TraceScope
+ * \brief Records a span covering the lifetime of the object.
+ *
+ * Does nothing if constructed with a NULL Tracer, so tracing can be left in
+ * place and enabled at runtime.
+ */
+class TraceScope
+{
+public:
+  /**
+   * \brief Starts a span.
+   *
+   * \param tracer Tracer to record to, may be NULL
+   * \param name Name of the span, must be a string literal
+   */
+  TraceScope(Tracer *tracer, const char *name)
+      : m_tracer(tracer)
+      , m_name(name)
+      , m_start(tracer != NULL ? tracer->now() : 0)
+  {
+  }
+
+  /**
+   * \brief Ends the span.
+   */
+  ~TraceScope()
+  {
+    if (m_tracer != NULL)
+      m_tracer->record(m_name, m_start, m_tracer->now());
+  }
+
+private:
+  TraceScope(const TraceScope &);
+  TraceScope &operator=(const TraceScope &);
+
+  Tracer *m_tracer;   //!< Tracer to record to
+  const char *m_name; //!< Name of the span
+  uint64_t m_start;   //!< Start time of the span
+};
+
+#endif
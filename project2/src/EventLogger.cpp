@@ -0,0 +1,272 @@
+/** \file */
+
+#include "EventLogger.h"
+
+#include <chrono>
+#include <typeinfo>
+
+#include "Shape.h"
+#include "Square.h"
+#include "Circle.h"
+
+/**
+ * \brief Creates a new logger and starts its output thread.
+ *
+ * Once created the stream must not be written to by other threads without
+ * first calling flush().
+ *
+ * \param stream Stream to format events to
+ * \param capacity Number of events that can be buffered
+ * \param policy Action taken when an event is logged while the buffer is full
+ */
+EventLogger::EventLogger(std::ostream &stream, size_t capacity,
+                         BackpressurePolicy policy)
+    : m_stream(stream)
+    , m_policy(policy)
+    , m_buffer(capacity)
+    , m_pushed(0)
+    , m_pendingDrops(0)
+    , m_dropped(0)
+    , m_written(0)
+    , m_stop(false)
+    , m_thread(&EventLogger::run, this)
+{
+}
+
+/**
+ * \brief Outputs all buffered events and stops the output thread.
+ */
+EventLogger::~EventLogger()
+{
+  flush();
+  m_stop = true;
+  m_thread.join();
+}
+
+/**
+ * \brief Logs the intersection of two shapes.
+ *
+ * \param tick Tick on which the shapes intersected
+ * \param firstId ID of the first shape
+ * \param first First shape
+ * \param secondId ID of the second shape
+ * \param second Second shape
+ */
+void EventLogger::logIntersection(unsigned int tick, ShapeID firstId,
+                                  const Shape &first, ShapeID secondId,
+                                  const Shape &second)
+{
+  EventRecord event;
+  event.type = E_INTERSECTION;
+  event.tick = tick;
+  event.count = 0;
+  event.first = recordShape(firstId, first);
+  event.second = recordShape(secondId, second);
+
+  push(event);
+}
+
+/**
+ * \brief Waits until all logged events have been written to the stream.
+ *
+ * After this returns the calling thread may write to the stream until the
+ * next event is logged.
+ */
+void EventLogger::flush()
+{
+  /* Report any outstanding drops, waiting for space if needed */
+  if (m_pendingDrops > 0)
+  {
+    EventRecord dropped = EventRecord();
+    dropped.type = E_DROPPED;
+    dropped.count = m_pendingDrops;
+
+    while (!m_buffer.tryPush(dropped))
+      std::this_thread::yield();
+
+    m_pushed++;
+    m_pendingDrops = 0;
+  }
+
+  while (m_written.load(std::memory_order_acquire) != m_pushed)
+    std::this_thread::yield();
+}
+
+/**
+ * \brief Returns the action taken when the buffer is full.
+ *
+ * \return Backpressure policy
+ */
+BackpressurePolicy EventLogger::policy() const
+{
+  return m_policy;
+}
+
+/**
+ * \brief Returns the number of events discarded because the buffer was full.
+ *
+ * \return Number of dropped events
+ */
+unsigned long EventLogger::droppedCount() const
+{
+  return m_dropped.load();
+}
+
+/**
+ * \brief Creates a compact description of a shape.
+ *
+ * \param id ID of the shape
+ * \param shape Shape to describe
+ * \return Record of the shape
+ */
+ShapeRecord EventLogger::recordShape(ShapeID id, const Shape &shape)
+{
+  const std::type_info &instanceType = typeid(shape);
+  const Vector2D &position = shape.getPosition();
+
+  ShapeRecord record;
+  record.id = id;
+  record.type = S_UNKNOWN;
+  record.x = position.getX();
+  record.y = position.getY();
+  record.a = 0.0;
+  record.b = 0.0;
+
+  if (instanceType == typeid(Circle))
+  {
+    record.type = S_CIRCLE;
+    record.a = static_cast<const Circle &>(shape).getRadius();
+  }
+  else if (instanceType == typeid(Square))
+  {
+    const Square &square = static_cast<const Square &>(shape);
+    record.type = S_SQUARE;
+    record.a = square.getWidth();
+    record.b = square.getHeight();
+  }
+
+  return record;
+}
+
+/**
+ * \brief Outputs a shape described by a ShapeRecord to a stream.
+ *
+ * Uses the stream operators of the shapes so that the output is identical to
+ * that of the original shape.
+ *
+ * \param stream Reference to the output stream
+ * \param record Shape to output
+ */
+static void formatShape(std::ostream &stream, const ShapeRecord &record)
+{
+  const Vector2D position(record.x, record.y);
+
+  if (record.type == S_CIRCLE)
+  {
+    Circle c(record.a);
+    c.setPosition(position);
+    stream << c;
+  }
+  else if (record.type == S_SQUARE)
+  {
+    Square s(record.a, record.b);
+    s.setPosition(position);
+    stream << s;
+  }
+}
+
+/**
+ * \brief Outputs an event as a line of text.
+ *
+ * \param stream Reference to the output stream
+ * \param event Event to output
+ */
+void EventLogger::formatEvent(std::ostream &stream, const EventRecord &event)
+{
+  switch (event.type)
+  {
+  case E_INTERSECTION:
+    formatShape(stream, event.first);
+    stream << " intersects ";
+    formatShape(stream, event.second);
+    stream << '\n';
+    break;
+  case E_DROPPED:
+    stream << "[" << event.count << " event(s) dropped]" << '\n';
+    break;
+  }
+}
+
+/**
+ * \brief Adds an event to the buffer, applying the backpressure policy if the
+ *        buffer is full.
+ *
+ * \param event Event to add
+ */
+void EventLogger::push(const EventRecord &event)
+{
+  /* Report events dropped since the last successful push before this one */
+  if (m_pendingDrops > 0)
+  {
+    EventRecord dropped = EventRecord();
+    dropped.type = E_DROPPED;
+    dropped.tick = event.tick;
+    dropped.count = m_pendingDrops;
+
+    if (m_buffer.tryPush(dropped))
+    {
+      m_pushed++;
+      m_pendingDrops = 0;
+    }
+  }
+
+  while (!m_buffer.tryPush(event))
+  {
+    if (m_policy == BP_BLOCK)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    m_dropped++;
+    if (m_policy == BP_COUNT)
+      m_pendingDrops++;
+
+    return;
+  }
+
+  m_pushed++;
+}
+
+/**
+ * \brief Output thread, formats buffered events until the logger is stopped.
+ */
+void EventLogger::run()
+{
+  EventRecord event;
+
+  while (true)
+  {
+    /* Format all available events, then flush the stream once */
+    unsigned long count = 0;
+    while (m_buffer.tryPop(event))
+    {
+      formatEvent(m_stream, event);
+      count++;
+    }
+
+    if (count > 0)
+    {
+      m_stream.flush();
+      m_written.fetch_add(count, std::memory_order_release);
+    }
+    else if (m_stop.load())
+    {
+      break;
+    }
+    else
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+}
@@ -1,13 +1,24 @@
 /** \file */
 
+#include <cstdlib>
 #include <sstream>
 #include "GameImpl.h"
 #include "BoundingBox.h"
+#include "EventLogger.h"
+#include "PhaseProfiler.h"
+#include "Tracer.h"
 
 /**
  * \brief Entry point.
  *
  * Usage: [num shapes]
+ *
+ * If the GAME_TRACE_FILE environment variable is set a timeline of the phases
+ * of the game is written to the named file in Chrome trace event format.
+ *
+ * If the GAME_PHASE_METRICS environment variable is set the time and hardware
+ * performance counter values (where available) of each phase of the game are
+ * output once the game finishes.
  */
 int main(int argc, char *argv[])
 {
@@ -32,7 +43,17 @@ int main(int argc, char *argv[])
   const BoundingBox box(0, 0, 100, 100);
   std::cout << "Game area: " << box << std::endl;
 
+  /* Optionally record a timeline of the game */
+  const char *traceFile = getenv("GAME_TRACE_FILE");
+  Tracer *tracer = (traceFile != NULL) ? new Tracer() : NULL;
+
+  /* Optionally measure each phase of the game */
+  PhaseProfiler *profiler =
+      (getenv("GAME_PHASE_METRICS") != NULL) ? new PhaseProfiler() : NULL;
+
   GameImpl game(box, std::cout);
+  game.setTracer(tracer);
+  game.setPhaseProfiler(profiler);
 
   /* Generate initial list of shapes */
   game.generateInitialShapes(numShapes, 5.0);
@@ -40,16 +61,33 @@ int main(int argc, char *argv[])
   game.printAllShapes();
 
   std::cout << std::endl;
+
+  /* Format intersections on a background thread */
+  EventLogger logger(std::cout, 4096, BP_BLOCK);
+  game.setEventLogger(&logger);
+
   unsigned int iteration = 1;
+  const double maxOffset = 2.0;
 
   /* Iterate while more than one shape remains */
   while (game.numShapes() > 1)
   {
-    game.applyRandomOffsets(2.0);
+    TraceScope trace(tracer, "iteration");
+
+    /* Skip over iterations in which no shapes can possibly intersect */
+    const unsigned int skipped = game.fastForward(maxOffset);
+    if (skipped > 0)
+    {
+      iteration += skipped;
+      continue;
+    }
+
+    game.applyRandomOffsets(maxOffset);
 
     if (game.cullOverlapping())
     {
       /* Output details if shapes were removed this iteration */
+      logger.flush();
       std::cout << "After iteration " << iteration
                 << ", " << game.numShapes() << " shape(s) remaining"
                 << std::endl << std::endl;
@@ -58,5 +96,26 @@ int main(int argc, char *argv[])
     iteration++;
   }
 
+  logger.flush();
+
+  if (profiler != NULL)
+  {
+    std::cout << std::endl << "PHASE METRICS:" << std::endl;
+    if (!profiler->countersAvailable())
+      std::cout << "(hardware performance counters unavailable)" << std::endl;
+    profiler->write(std::cout);
+    delete profiler;
+  }
+
+  if (tracer != NULL)
+  {
+    if (tracer->droppedCount() > 0)
+      std::cerr << "Trace buffer full, " << tracer->droppedCount()
+                << " span(s) dropped" << std::endl;
+    if (!tracer->writeJsonFile(traceFile))
+      std::cerr << "Failed to write trace to " << traceFile << std::endl;
+    delete tracer;
+  }
+
   return 0;
 }
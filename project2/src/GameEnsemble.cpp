@@ -0,0 +1,274 @@
+/** \file */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "GameImpl.h"
+#include "BoundingBox.h"
+#include "Tracer.h"
+
+/**
+ * \struct RunResult
+ * \brief Outcome of a single game in the ensemble.
+ */
+struct RunResult
+{
+  unsigned int iterations; //!< Iteration on which the last shape was removed
+  size_t survivors;        //!< Number of shapes remaining at the end
+  double seconds;          //!< Wall clock time taken by the run
+};
+
+/**
+ * \brief Parses a command line argument.
+ *
+ * \param str Argument string
+ * \param value Reference to store parsed value in
+ * \param name Name of the argument used in error output
+ * \return True if the argument was parsed
+ */
+template <typename T> bool parseArgument(const char *str, T &value,
+                                         const char *name)
+{
+  std::stringstream valueStr(str);
+  valueStr >> value;
+  if (!valueStr)
+  {
+    std::cerr << "Failed to parse " << name << ": " << str << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * \brief Runs a single game to completion without producing any output.
+ *
+ * \param numShapes Number of shapes to generate
+ * \param maxDimension Maximum dimension of shapes
+ * \param seed Seed for the random number generator of the game
+ * \param tracer Tracer to record phases of the game to, may be NULL
+ * \return Outcome of the game
+ */
+RunResult runGame(int numShapes, double maxDimension, unsigned int seed,
+                  Tracer *tracer)
+{
+  TraceScope trace(tracer, "run");
+
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  /* Stream with no buffer, discards all output */
+  std::ostream nullStream(NULL);
+
+  const BoundingBox box(0, 0, 100, 100);
+  GameImpl game(box, nullStream, seed);
+  game.setTracer(tracer);
+  game.generateInitialShapes(numShapes, maxDimension);
+
+  RunResult result;
+  result.iterations = 0;
+
+  unsigned int iteration = 1;
+  const double maxOffset = 2.0;
+
+  while (game.numShapes() > 1)
+  {
+    const unsigned int skipped = game.fastForward(maxOffset);
+    if (skipped > 0)
+    {
+      iteration += skipped;
+      continue;
+    }
+
+    game.applyRandomOffsets(maxOffset);
+
+    if (game.cullOverlapping())
+      result.iterations = iteration;
+
+    iteration++;
+  }
+
+  result.survivors = game.numShapes();
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start).count();
+
+  return result;
+}
+
+/**
+ * \brief Outputs aggregated statistics of all runs to a stream.
+ *
+ * \param stream Stream to output to
+ * \param results Results of each run
+ */
+void printStatistics(std::ostream &stream,
+                     const std::vector<RunResult> &results)
+{
+  unsigned int minIterations = results.front().iterations;
+  unsigned int maxIterations = results.front().iterations;
+  double sumIterations = 0.0;
+  double sumSeconds = 0.0;
+  double maxSeconds = 0.0;
+  std::vector<size_t> survivorCounts;
+
+  for (std::vector<RunResult>::const_iterator it = results.begin();
+       it != results.end(); ++it)
+  {
+    minIterations = std::min(minIterations, it->iterations);
+    maxIterations = std::max(maxIterations, it->iterations);
+    sumIterations += it->iterations;
+    sumSeconds += it->seconds;
+    maxSeconds = std::max(maxSeconds, it->seconds);
+
+    if (it->survivors >= survivorCounts.size())
+      survivorCounts.resize(it->survivors + 1, 0);
+    survivorCounts[it->survivors]++;
+  }
+
+  /* Sort iteration counts to find the median */
+  std::vector<unsigned int> iterations;
+  iterations.reserve(results.size());
+  for (std::vector<RunResult>::const_iterator it = results.begin();
+       it != results.end(); ++it)
+    iterations.push_back(it->iterations);
+  std::sort(iterations.begin(), iterations.end());
+
+  stream << "Iterations: min=" << minIterations
+         << " median=" << iterations[iterations.size() / 2]
+         << " mean=" << (sumIterations / results.size())
+         << " max=" << maxIterations << std::endl;
+
+  stream << "Run time (s): mean=" << (sumSeconds / results.size())
+         << " max=" << maxSeconds << std::endl;
+
+  stream << "Survivors:" << std::endl;
+  for (size_t i = 0; i < survivorCounts.size(); i++)
+  {
+    if (survivorCounts[i] > 0)
+      stream << "  " << i << ": " << survivorCounts[i] << std::endl;
+  }
+
+  /* Histogram of iteration counts, bin n covers [2^n, 2^(n+1)) (bin 0 also
+   * holds runs with no removals) as the distribution has a very long tail */
+  std::vector<size_t> bins;
+  for (std::vector<unsigned int>::const_iterator it = iterations.begin();
+       it != iterations.end(); ++it)
+  {
+    size_t bin = 0;
+    while ((*it >> (bin + 1)) > 0)
+      bin++;
+
+    if (bin >= bins.size())
+      bins.resize(bin + 1, 0);
+    bins[bin]++;
+  }
+
+  /* Skip leading empty bins */
+  size_t firstBin = 0;
+  while (bins[firstBin] == 0)
+    firstBin++;
+
+  stream << "Iterations histogram:" << std::endl;
+  for (size_t i = firstBin; i < bins.size(); i++)
+  {
+    stream << "  [" << std::setw(10) << (i == 0 ? 0ul : 1ul << i) << ", "
+           << std::setw(10) << (2ul << i) << "): " << bins[i] << std::endl;
+  }
+}
+
+/**
+ * \brief Entry point.
+ *
+ * Runs many independent games concurrently and outputs statistics of their
+ * outcomes. Game number n is seeded with [seed] + n, so results are
+ * reproducible regardless of the number of threads.
+ *
+ * Usage: [num runs] [num shapes] [max dimension] [num threads] [seed]
+ *
+ * If the GAME_TRACE_FILE environment variable is set a timeline of the runs on
+ * each thread is written to the named file in Chrome trace event format.
+ */
+int main(int argc, char *argv[])
+{
+  unsigned int numRuns = 1000;
+  int numShapes = 50;
+  double maxDimension = 5.0;
+  unsigned int numThreads = std::thread::hardware_concurrency();
+  unsigned int seed = 1;
+
+  /* Parse command line */
+  if ((argc > 1 && !parseArgument(argv[1], numRuns, "number of runs")) ||
+      (argc > 2 && !parseArgument(argv[2], numShapes, "number of shapes")) ||
+      (argc > 3 && !parseArgument(argv[3], maxDimension, "max dimension")) ||
+      (argc > 4 && !parseArgument(argv[4], numThreads, "number of threads")) ||
+      (argc > 5 && !parseArgument(argv[5], seed, "seed")))
+    return 1;
+
+  if (numRuns == 0)
+  {
+    std::cerr << "Number of runs must be at least 1" << std::endl;
+    return 1;
+  }
+
+  numThreads = std::max(1u, std::min(numThreads, numRuns));
+
+  std::cout << "Num. runs: " << numRuns << std::endl
+            << "Num. shapes: " << numShapes << std::endl
+            << "Max. dimension: " << maxDimension << std::endl
+            << "Num. threads: " << numThreads << std::endl
+            << "Seed: " << seed << std::endl;
+
+  /* Optionally record a timeline of the runs */
+  const char *traceFile = getenv("GAME_TRACE_FILE");
+  Tracer *tracer = (traceFile != NULL) ? new Tracer() : NULL;
+
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  /* Each worker takes the next run that has yet to be started */
+  std::vector<RunResult> results(numRuns);
+  std::atomic<unsigned int> nextRun(0);
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 0; i < numThreads; i++)
+  {
+    workers.push_back(std::thread([&]()
+    {
+      unsigned int run;
+      while ((run = nextRun++) < numRuns)
+        results[run] = runGame(numShapes, maxDimension, seed + run, tracer);
+    }));
+  }
+
+  for (std::vector<std::thread>::iterator it = workers.begin();
+       it != workers.end(); ++it)
+    it->join();
+
+  const double totalSeconds = std::chrono::duration<double>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count();
+
+  std::cout << "Total time (s): " << totalSeconds << std::endl
+            << "Runs per second: " << (numRuns / totalSeconds) << std::endl;
+
+  printStatistics(std::cout, results);
+
+  if (tracer != NULL)
+  {
+    if (tracer->droppedCount() > 0)
+      std::cerr << "Trace buffer full, " << tracer->droppedCount()
+                << " span(s) dropped" << std::endl;
+    if (!tracer->writeJsonFile(traceFile))
+      std::cerr << "Failed to write trace to " << traceFile << std::endl;
+    delete tracer;
+  }
+
+  return 0;
+}
@@ -3,12 +3,17 @@
 #include "GameImpl.h"
 
 #include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <ctime>
+#include <vector>
 
 #include "BoundingBox.h"
+#include "EventLogger.h"
 #include "Shape.h"
 #include "Square.h"
 #include "Circle.h"
+#include "PhaseProfiler.h"
 
 /**
  * \brief Creates a new instance of the game.
@@ -19,9 +24,35 @@
 GameImpl::GameImpl(const BoundingBox &clamp, std::ostream &stream)
     : m_clamp(clamp)
     , m_stream(stream)
+    , m_logger(NULL)
+    , m_tracer(NULL)
+    , m_profiler(NULL)
+    , m_tick(0)
+    , m_generator((unsigned int) time(NULL))
+{
+}
+
+/**
+ * \brief Creates a new instance of the game with a fixed random seed.
+ *
+ * Two games created with the same seed (and driven in the same way) produce
+ * identical results. Each game has its own random number generator, so games
+ * may be run concurrently on separate threads.
+ *
+ * \param clamp BoundingBox defining game area
+ * \param stream Stream to print output to
+ * \param seed Seed for the random number generator
+ */
+GameImpl::GameImpl(const BoundingBox &clamp, std::ostream &stream,
+                   unsigned int seed)
+    : m_clamp(clamp)
+    , m_stream(stream)
+    , m_logger(NULL)
+    , m_tracer(NULL)
+    , m_profiler(NULL)
+    , m_tick(0)
+    , m_generator(seed)
 {
-  // Seed random number generator
-  srand((unsigned int) time(NULL));
 }
 
 GameImpl::~GameImpl()
@@ -44,12 +75,14 @@ GameImpl::~GameImpl()
  */
 void GameImpl::generateInitialShapes(int numShapes, double maxDimension)
 {
+  PhaseScope phase(m_tracer, m_profiler, "generateInitialShapes");
+
   for (int i = 0; i < numShapes; i++)
   {
     Shape *s = NULL;
 
     /* Randomly choose shape type */
-    if (rand() % 2 == 0)
+    if (m_generator() % 2 == 0)
       s = new Square(random(0, maxDimension), random(0, maxDimension));
     else
       s = new Circle(random(0, maxDimension));
@@ -63,7 +96,7 @@ void GameImpl::generateInitialShapes(int numShapes, double maxDimension)
     }
     while(!s->setPosition(pos, m_clamp));
 
-    m_shapes.push_back(s);
+    m_shapes.push_back(m_table.insert(s));
   }
 }
 
@@ -77,8 +110,13 @@ void GameImpl::generateInitialShapes(int numShapes, double maxDimension)
  */
 void GameImpl::applyRandomOffsets(double maxOffset)
 {
+  PhaseScope phase(m_tracer, m_profiler, "applyRandomOffsets");
+  m_tick++;
+
   for (ShapeListIt it = m_shapes.begin(); it != m_shapes.end(); ++it)
   {
+    Shape *s = m_table.get(*it);
+
     /* Generate random offsets until a valid one is found */
     Vector2D offset;
     do
@@ -86,7 +124,7 @@ void GameImpl::applyRandomOffsets(double maxOffset)
       offset = Vector2D(random(-maxOffset, maxOffset),
                         random(-maxOffset, maxOffset));
     }
-    while(!(*it)->offsetPositionBy(offset, m_clamp));
+    while(!s->offsetPositionBy(offset, m_clamp));
   }
 }
 
@@ -102,11 +140,13 @@ void GameImpl::applyRandomOffsets(double maxOffset)
  */
 bool GameImpl::cullOverlapping()
 {
+  PhaseScope phase(m_tracer, m_profiler, "cullOverlapping");
   bool shapesRemoved = false;
 
   /* Iterate over all shapes */
   for (ShapeListIt outerIt = m_shapes.begin(); outerIt != m_shapes.end();)
   {
+    const Shape *outer = m_table.get(*outerIt);
     bool removeFlag = false;
 
     /* Iterate over all shapes (which are not the shape selected by outerIt) */
@@ -119,17 +159,28 @@ bool GameImpl::cullOverlapping()
         continue;
       }
 
+      const Shape *inner = m_table.get(*innerIt);
+
       /* Check for intersection */
-      if ((*outerIt)->intersects(*(*innerIt)))
+      if (outer->intersects(*inner))
       {
         /* Show details of intersection */
-        m_stream << *(*outerIt) << " intersects " << *(*innerIt) << std::endl;
+        {
+          PhaseScope phaseOutput(m_tracer, m_profiler, "output");
+          if (m_logger != NULL)
+            m_logger->logIntersection(m_tick, *outerIt, *outer, *innerIt,
+                                      *inner);
+          else
+            m_stream << *outer << " intersects " << *inner << std::endl;
+        }
         shapesRemoved = true;
 
         /* Mark the shape selected by outerIt for removal */
         removeFlag = true;
 
         /* Erase the intersecting shape selected by innerIt */
+        PhaseScope phaseRemoval(m_tracer, m_profiler, "removal");
+        m_table.remove(*innerIt);
         innerIt = m_shapes.erase(innerIt);
       }
       else
@@ -139,7 +190,11 @@ bool GameImpl::cullOverlapping()
     /* If the shape selected by outerIt intersected another shape then remove
      * it */
     if (removeFlag)
+    {
+      PhaseScope phaseRemoval(m_tracer, m_profiler, "removal");
+      m_table.remove(*outerIt);
       outerIt = m_shapes.erase(outerIt);
+    }
     else
       ++outerIt;
   }
@@ -148,16 +203,130 @@ bool GameImpl::cullOverlapping()
 }
 
 /**
- * \brief Prints a vector of shapes to a stream.
+ * \brief Calculates a lower bound on the number of ticks for which no pair of
+ *        shapes can possibly intersect.
+ *
+ * Each tick moves a shape by at most maxOffset along each axis, so the gap
+ * between the bounding boxes of two shapes along an axis shrinks by at most
+ * 2 * maxOffset per tick. Every intersection test starts with a bounding box
+ * test, hence a pair separated by a gap g on either axis cannot intersect
+ * within floor(g / (2 * maxOffset)) ticks.
+ *
+ * \param maxOffset Maximum offset applied per tick
+ * \return Number of ticks guaranteed to be free of intersections
  */
-void GameImpl::printAllShapes()
+unsigned int GameImpl::collisionFreeTicks(double maxOffset) const
 {
-  unsigned int i = 0;
-  for (ShapeListIt it = m_shapes.begin(); it != m_shapes.end(); ++it)
+  PhaseScope phase(m_tracer, m_profiler, "collisionFreeTicks");
+
+  /* Margin absorbing rounding error accumulated in shape positions */
+  const double GAP_MARGIN = 1e-9;
+
+  if (m_shapes.size() < 2 || maxOffset <= 0.0)
+    return 0;
+
+  /* Cache the extents of each shape to avoid recalculating bounding boxes for
+   * every pair */
+  std::vector<double> extents;
+  extents.reserve(m_shapes.size() * 4);
+  for (ShapeList::const_iterator it = m_shapes.begin(); it != m_shapes.end();
+       ++it)
   {
-    m_stream << i << ": " << *(*it) << std::endl;
-    i++;
+    const BoundingBox box = m_table.get(*it)->getBoundingBox();
+    extents.push_back(box.getLowerLeft().getX());
+    extents.push_back(box.getLowerLeft().getY());
+    extents.push_back(box.getUpperRight().getX());
+    extents.push_back(box.getUpperRight().getY());
   }
+
+  /* Find the smallest separation of any pair of bounding boxes */
+  double minGap = DBL_MAX;
+  for (size_t i = 0; i < extents.size(); i += 4)
+  {
+    for (size_t j = i + 4; j < extents.size(); j += 4)
+    {
+      const double gapX = std::max(extents[j] - extents[i + 2],
+                                   extents[i] - extents[j + 2]);
+      const double gapY = std::max(extents[j + 1] - extents[i + 3],
+                                   extents[i + 1] - extents[j + 3]);
+      minGap = std::min(minGap, std::max(gapX, gapY));
+
+      if (minGap <= GAP_MARGIN)
+        return 0;
+    }
+  }
+
+  return (unsigned int)std::floor((minGap - GAP_MARGIN) / (2.0 * maxOffset));
+}
+
+/**
+ * \brief Applies random offsets for as many ticks as no intersection is
+ *        possible, without testing for intersections.
+ *
+ * The random number generator is advanced exactly as it would be when calling
+ * applyRandomOffsets() and cullOverlapping() for each tick, so the outcome of
+ * the game is unchanged.
+ *
+ * \param maxOffset Maximum offset to apply per tick
+ * \return Number of ticks advanced
+ */
+unsigned int GameImpl::fastForward(double maxOffset)
+{
+  PhaseScope phase(m_tracer, m_profiler, "fastForward");
+  const unsigned int ticks = collisionFreeTicks(maxOffset);
+
+  for (unsigned int i = 0; i < ticks; i++)
+    applyRandomOffsets(maxOffset);
+
+  return ticks;
+}
+
+/**
+ * \brief Sets a logger to report intersections to instead of writing them to
+ *        the stream directly.
+ *
+ * The logger formats events on a background thread, keeping formatting and
+ * I/O off the thread running the game.
+ *
+ * \param logger Logger to use, NULL to write to the stream
+ */
+void GameImpl::setEventLogger(EventLogger *logger)
+{
+  m_logger = logger;
+}
+
+/**
+ * \brief Sets a tracer to record the time spent in each phase of the game.
+ *
+ * \param tracer Tracer to use, NULL to disable tracing
+ */
+void GameImpl::setTracer(Tracer *tracer)
+{
+  m_tracer = tracer;
+}
+
+/**
+ * \brief Sets a profiler to measure the time and hardware counter values of
+ *        each phase of the game.
+ *
+ * The profiler must have been created on the thread running the game.
+ *
+ * \param profiler Profiler to use, NULL to disable profiling
+ */
+void GameImpl::setPhaseProfiler(PhaseProfiler *profiler)
+{
+  m_profiler = profiler;
+}
+
+/**
+ * \brief Prints a vector of shapes to a stream, each prefixed with its ID.
+ */
+void GameImpl::printAllShapes()
+{
+  PhaseScope phase(m_tracer, m_profiler, "printAllShapes");
+
+  for (ShapeListIt it = m_shapes.begin(); it != m_shapes.end(); ++it)
+    m_stream << *it << ": " << *m_table.get(*it) << std::endl;
 }
 
 /**
@@ -169,7 +338,7 @@ void GameImpl::printAllShapes()
  */
 double GameImpl::random(double lower, double upper) const
 {
-  double v = (double)rand() / RAND_MAX;
+  double v = (double)m_generator() / std::mt19937::max();
   return lower + (v * (upper - lower));
 }
 
@@ -182,3 +351,35 @@ size_t GameImpl::numShapes() const
 {
   return m_shapes.size();
 }
+
+/**
+ * \brief Returns the IDs of all shapes in the game, in order of creation.
+ *
+ * \return List of shape IDs
+ */
+const ShapeList &GameImpl::shapeIds() const
+{
+  return m_shapes;
+}
+
+/**
+ * \brief Finds a shape in the game by its ID.
+ *
+ * \param id ID of the shape
+ * \return Pointer to the shape, NULL if it has been removed
+ */
+Shape *GameImpl::getShape(ShapeID id) const
+{
+  return m_table.get(id);
+}
+
+/**
+ * \brief Returns the number of ticks (applications of random offsets) that
+ *        have elapsed.
+ *
+ * \return Current tick
+ */
+unsigned int GameImpl::tick() const
+{
+  return m_tick;
+}
@@ -0,0 +1,186 @@
+/** \file */
+
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+/**
+ * \brief Opens a hardware counter for the calling thread.
+ *
+ * \param type Event type (PERF_TYPE_*)
+ * \param config Event configuration
+ * \param groupFd File descriptor of the group leader, -1 to create a group
+ * \return File descriptor, -1 on failure
+ */
+static int openCounter(uint32_t type, uint64_t config, int groupFd)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.disabled = (groupFd == -1) ? 1 : 0;
+
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+#endif
+
+/**
+ * \brief Opens and starts the counters for the calling thread.
+ *
+ * The first counter that can be opened leads the group so that all counters
+ * are scheduled onto the hardware together.
+ */
+PerfCounters::PerfCounters()
+    : m_numOpen(0)
+{
+  for (int i = 0; i < PC_NUM_COUNTERS; i++)
+    m_fds[i] = -1;
+
+#ifdef __linux__
+  const uint32_t types[PC_NUM_COUNTERS] = {
+      PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+      PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE};
+  const uint64_t configs[PC_NUM_COUNTERS] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+  int leader = -1;
+  for (int i = 0; i < PC_NUM_COUNTERS; i++)
+  {
+    m_fds[i] = openCounter(types[i], configs[i], leader);
+    if (m_fds[i] == -1)
+      continue;
+
+    if (leader == -1)
+      leader = m_fds[i];
+    m_numOpen++;
+  }
+
+  if (leader != -1)
+  {
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#endif
+}
+
+/**
+ * \brief Closes all counters.
+ */
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+  /* Close group members before the leader */
+  for (int i = PC_NUM_COUNTERS - 1; i >= 0; i--)
+  {
+    if (m_fds[i] != -1)
+      close(m_fds[i]);
+  }
+#endif
+}
+
+/**
+ * \brief Tests if any counter is available.
+ *
+ * \return True if at least one counter could be opened
+ */
+bool PerfCounters::available() const
+{
+  return m_numOpen > 0;
+}
+
+/**
+ * \brief Tests if a given counter is available.
+ *
+ * \param counter Counter to test
+ * \return True if the counter could be opened
+ */
+bool PerfCounters::available(PerfCounter counter) const
+{
+  return m_fds[counter] != -1;
+}
+
+/**
+ * \brief Reads the current value of all counters.
+ *
+ * Values are totals since the counters were created, scaled up if the kernel
+ * had to multiplex the group with other events. Take the difference of two
+ * samples to measure a section of code.
+ *
+ * \param sample Sample to store values in, unavailable counters are zero
+ * \return True if the counters were read
+ */
+bool PerfCounters::read(PerfSample &sample) const
+{
+  for (int i = 0; i < PC_NUM_COUNTERS; i++)
+    sample.values[i] = 0;
+
+  if (m_numOpen == 0)
+    return false;
+
+#ifdef __linux__
+  /* Layout of a group read: nr, time enabled, time running, values[nr] */
+  uint64_t buffer[3 + PC_NUM_COUNTERS];
+  int leader = -1;
+  for (int i = 0; i < PC_NUM_COUNTERS && leader == -1; i++)
+    leader = m_fds[i];
+
+  const ssize_t expected = (ssize_t)((3 + m_numOpen) * sizeof(uint64_t));
+  if (::read(leader, buffer, sizeof(buffer)) != expected)
+    return false;
+
+  const double scale =
+      (buffer[2] > 0) ? (double)buffer[1] / (double)buffer[2] : 0.0;
+
+  /* Values are in the order the counters were added to the group */
+  int value = 3;
+  for (int i = 0; i < PC_NUM_COUNTERS; i++)
+  {
+    if (m_fds[i] != -1)
+      sample.values[i] = (uint64_t)(buffer[value++] * scale);
+  }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * \brief Returns a short name of a counter.
+ *
+ * \param counter Counter
+ * \return Name
+ */
+const char *PerfCounters::name(PerfCounter counter)
+{
+  switch (counter)
+  {
+  case PC_CYCLES:
+    return "cycles";
+  case PC_INSTRUCTIONS:
+    return "instructions";
+  case PC_L1D_MISSES:
+    return "L1D misses";
+  case PC_LLC_MISSES:
+    return "LLC misses";
+  case PC_BRANCH_MISSES:
+    return "branch misses";
+  default:
+    return "unknown";
+  }
+}
@@ -0,0 +1,176 @@
+/** \file */
+
+#include "PhaseProfiler.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+
+/**
+ * \brief Creates a new profiler.
+ *
+ * \param useCounters If hardware counters should be measured in addition to
+ *                    time
+ */
+PhaseProfiler::PhaseProfiler(bool useCounters)
+    : m_counters(useCounters ? new PerfCounters() : NULL)
+{
+}
+
+PhaseProfiler::~PhaseProfiler()
+{
+  delete m_counters;
+}
+
+/**
+ * \brief Tests if any hardware counters are being measured.
+ *
+ * \return True if counters are available
+ */
+bool PhaseProfiler::countersAvailable() const
+{
+  return m_counters != NULL && m_counters->available();
+}
+
+/**
+ * \brief Returns the current wall clock time.
+ *
+ * \return Time in ns
+ */
+uint64_t PhaseProfiler::now() const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * \brief Reads the current value of the hardware counters.
+ *
+ * \param sample Sample to store values in, zero if counters are unavailable
+ */
+void PhaseProfiler::sample(PerfSample &sample) const
+{
+  if (m_counters != NULL)
+  {
+    m_counters->read(sample);
+  }
+  else
+  {
+    for (int i = 0; i < PC_NUM_COUNTERS; i++)
+      sample.values[i] = 0;
+  }
+}
+
+/**
+ * \brief Adds a measurement of a phase.
+ *
+ * \param phase Name of the phase, must be a string literal
+ * \param duration Wall clock time spent in the phase in ns
+ * \param start Counter values at the start of the phase
+ * \param end Counter values at the end of the phase
+ */
+void PhaseProfiler::add(const char *phase, uint64_t duration,
+                        const PerfSample &start, const PerfSample &end)
+{
+  PhaseTotals &t = totals(phase);
+  t.calls++;
+  t.duration += duration;
+
+  for (int i = 0; i < PC_NUM_COUNTERS; i++)
+  {
+    if (end.values[i] > start.values[i])
+      t.counters.values[i] += end.values[i] - start.values[i];
+  }
+}
+
+/**
+ * \brief Returns the number of times a phase has been measured.
+ *
+ * \param phase Name of the phase
+ * \return Number of calls
+ */
+unsigned long PhaseProfiler::calls(const char *phase) const
+{
+  for (std::vector<PhaseTotals>::const_iterator it = m_phases.begin();
+       it != m_phases.end(); ++it)
+  {
+    if (strcmp(it->name, phase) == 0)
+      return it->calls;
+  }
+
+  return 0;
+}
+
+/**
+ * \brief Outputs a table of the totals of each phase.
+ *
+ * Unavailable counters are shown as "n/a". Note that time and counters of a
+ * phase include those of any phases nested within it.
+ *
+ * \param stream Stream to output to
+ */
+void PhaseProfiler::write(std::ostream &stream) const
+{
+  stream << std::left << std::setw(22) << "phase" << std::right
+         << std::setw(10) << "calls" << std::setw(14) << "time (ms)";
+  for (int i = 0; i < PC_NUM_COUNTERS; i++)
+    stream << std::setw(16) << PerfCounters::name((PerfCounter)i);
+  stream << std::setw(8) << "IPC" << std::endl;
+
+  for (std::vector<PhaseTotals>::const_iterator it = m_phases.begin();
+       it != m_phases.end(); ++it)
+  {
+    stream << std::left << std::setw(22) << it->name << std::right
+           << std::setw(10) << it->calls << std::setw(14) << std::fixed
+           << std::setprecision(3) << (it->duration / 1e6);
+
+    for (int i = 0; i < PC_NUM_COUNTERS; i++)
+    {
+      stream << std::setw(16);
+      if (m_counters != NULL && m_counters->available((PerfCounter)i))
+        stream << it->counters.values[i];
+      else
+        stream << "n/a";
+    }
+
+    stream << std::setw(8);
+    if (it->counters.values[PC_CYCLES] > 0)
+      stream << std::setprecision(2)
+             << ((double)it->counters.values[PC_INSTRUCTIONS] /
+                 it->counters.values[PC_CYCLES]);
+    else
+      stream << "n/a";
+
+    stream << std::endl;
+  }
+
+  stream.unsetf(std::ios::floatfield);
+  stream << std::setprecision(6);
+}
+
+/**
+ * \brief Finds the totals of a phase, adding it if not yet measured.
+ *
+ * \param phase Name of the phase
+ * \return Reference to the totals
+ */
+PhaseProfiler::PhaseTotals &PhaseProfiler::totals(const char *phase)
+{
+  /* Phase names are string literals, so compare pointers first */
+  for (std::vector<PhaseTotals>::iterator it = m_phases.begin();
+       it != m_phases.end(); ++it)
+  {
+    if (it->name == phase || strcmp(it->name, phase) == 0)
+      return *it;
+  }
+
+  PhaseTotals t;
+  t.name = phase;
+  t.calls = 0;
+  t.duration = 0;
+  for (int i = 0; i < PC_NUM_COUNTERS; i++)
+    t.counters.values[i] = 0;
+  m_phases.push_back(t);
+
+  return m_phases.back();
+}
@@ -0,0 +1,155 @@
+/** \file */
+
+#include "ShapeTable.h"
+
+#include <stdexcept>
+
+#include "Shape.h"
+
+/**
+ * \brief Mask of the slot bits of a ShapeID.
+ */
+static const uint32_t SLOT_MASK = (1u << SHAPE_ID_SLOT_BITS) - 1;
+
+/**
+ * \brief Largest generation a slot may be assigned before it is retired.
+ */
+static const uint32_t MAX_GENERATION =
+    (INVALID_SHAPE_ID >> SHAPE_ID_SLOT_BITS) - 1;
+
+/**
+ * \brief Creates a new, empty table.
+ */
+ShapeTable::ShapeTable()
+    : m_size(0)
+{
+}
+
+/**
+ * \brief Deletes all shapes remaining in the table.
+ */
+ShapeTable::~ShapeTable()
+{
+  for (std::vector<Slot>::iterator it = m_slots.begin(); it != m_slots.end();
+       ++it)
+    delete it->shape;
+}
+
+/**
+ * \brief Adds a shape to the table, taking ownership of it.
+ *
+ * \param shape Shape to add
+ * \return ID of the shape
+ */
+ShapeID ShapeTable::insert(Shape *shape)
+{
+  uint32_t slot;
+
+  if (!m_freeSlots.empty())
+  {
+    slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+  }
+  else
+  {
+    if (m_slots.size() > SLOT_MASK)
+      throw std::runtime_error("ShapeTable is full");
+
+    slot = (uint32_t)m_slots.size();
+    Slot s;
+    s.shape = NULL;
+    s.generation = 0;
+    m_slots.push_back(s);
+  }
+
+  m_slots[slot].shape = shape;
+  m_size++;
+
+  return (m_slots[slot].generation << SHAPE_ID_SLOT_BITS) | slot;
+}
+
+/**
+ * \brief Removes and deletes a shape.
+ *
+ * The slot is reused by later insertions with a new generation; a slot whose
+ * generation is exhausted is retired so that IDs are never repeated.
+ *
+ * \param id ID of the shape to remove
+ * \return True if the shape was in the table
+ */
+bool ShapeTable::remove(ShapeID id)
+{
+  if (!contains(id))
+    return false;
+
+  Slot &s = m_slots[slotOf(id)];
+  delete s.shape;
+  s.shape = NULL;
+  m_size--;
+
+  if (s.generation < MAX_GENERATION)
+  {
+    s.generation++;
+    m_freeSlots.push_back(slotOf(id));
+  }
+
+  return true;
+}
+
+/**
+ * \brief Finds a shape by its ID.
+ *
+ * \param id ID of the shape
+ * \return Pointer to the shape, NULL if it is not in the table
+ */
+Shape *ShapeTable::get(ShapeID id) const
+{
+  const uint32_t slot = slotOf(id);
+  if (slot >= m_slots.size() || m_slots[slot].generation != generationOf(id))
+    return NULL;
+
+  return m_slots[slot].shape;
+}
+
+/**
+ * \brief Tests if a shape is in the table.
+ *
+ * \param id ID of the shape
+ * \return True if the shape is in the table
+ */
+bool ShapeTable::contains(ShapeID id) const
+{
+  return get(id) != NULL;
+}
+
+/**
+ * \brief Returns the number of shapes in the table.
+ *
+ * \return Number of shapes
+ */
+size_t ShapeTable::size() const
+{
+  return m_size;
+}
+
+/**
+ * \brief Returns the slot index of an ID.
+ *
+ * \param id Shape ID
+ * \return Slot index
+ */
+uint32_t ShapeTable::slotOf(ShapeID id)
+{
+  return id & SLOT_MASK;
+}
+
+/**
+ * \brief Returns the generation of an ID.
+ *
+ * \param id Shape ID
+ * \return Generation
+ */
+uint32_t ShapeTable::generationOf(ShapeID id)
+{
+  return id >> SHAPE_ID_SLOT_BITS;
+}
@@ -0,0 +1,151 @@
+/** \file */
+
+#include "Tracer.h"
+
+#include <cstdio>
+#include <fstream>
+
+/**
+ * \brief Outputs a time in ns as a decimal number of microseconds, the unit
+ *        used by the trace event format.
+ *
+ * \param stream Stream to output to
+ * \param ns Time in ns
+ */
+static void writeMicroseconds(std::ostream &stream, uint64_t ns)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%llu.%03u", (unsigned long long)(ns / 1000),
+           (unsigned int)(ns % 1000));
+  stream << buffer;
+}
+
+/**
+ * \brief Creates a new tracer, allocating storage for all spans up front.
+ *
+ * \param capacity Maximum number of spans that can be recorded
+ */
+Tracer::Tracer(size_t capacity)
+    : m_epoch(std::chrono::steady_clock::now())
+    , m_events(capacity)
+    , m_next(0)
+{
+}
+
+Tracer::~Tracer()
+{
+}
+
+/**
+ * \brief Returns the current time relative to the creation of the tracer.
+ *
+ * \return Time in ns
+ */
+uint64_t Tracer::now() const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - m_epoch).count();
+}
+
+/**
+ * \brief Records a span on the calling thread.
+ *
+ * Safe to call from multiple threads concurrently.
+ *
+ * \param name Name of the span, must be a string literal
+ * \param start Start time as returned by now()
+ * \param end End time as returned by now()
+ */
+void Tracer::record(const char *name, uint64_t start, uint64_t end)
+{
+  const size_t slot = m_next.fetch_add(1, std::memory_order_relaxed);
+  if (slot >= m_events.size())
+    return;
+
+  TraceEvent &e = m_events[slot];
+  e.name = name;
+  e.threadId = currentThreadId();
+  e.start = start;
+  e.duration = end - start;
+}
+
+/**
+ * \brief Returns the number of spans recorded.
+ *
+ * \return Number of spans
+ */
+size_t Tracer::size() const
+{
+  const size_t n = m_next.load();
+  return n < m_events.size() ? n : m_events.size();
+}
+
+/**
+ * \brief Returns the number of spans discarded as the buffer was full.
+ *
+ * \return Number of dropped spans
+ */
+size_t Tracer::droppedCount() const
+{
+  const size_t n = m_next.load();
+  return n > m_events.size() ? n - m_events.size() : 0;
+}
+
+/**
+ * \brief Outputs all recorded spans as Chrome trace event format JSON.
+ *
+ * Must not be called while other threads are recording.
+ *
+ * \param stream Stream to output to
+ */
+void Tracer::writeJson(std::ostream &stream) const
+{
+  const size_t n = size();
+
+  stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+  for (size_t i = 0; i < n; i++)
+  {
+    const TraceEvent &e = m_events[i];
+
+    stream << (i > 0 ? "," : "") << "\n{\"name\":\"" << e.name
+           << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.threadId
+           << ",\"ts\":";
+    writeMicroseconds(stream, e.start);
+    stream << ",\"dur\":";
+    writeMicroseconds(stream, e.duration);
+    stream << "}";
+  }
+
+  stream << "\n],\"otherData\":{\"droppedEvents\":" << droppedCount()
+         << "}}" << std::endl;
+}
+
+/**
+ * \brief Outputs all recorded spans as Chrome trace event format JSON to a
+ *        file.
+ *
+ * \param filename Name of file to write
+ * \return True if the file was written
+ */
+bool Tracer::writeJsonFile(const char *filename) const
+{
+  std::ofstream file(filename);
+  if (!file)
+    return false;
+
+  writeJson(file);
+  return (bool)file;
+}
+
+/**
+ * \brief Returns a small sequential ID for the calling thread.
+ *
+ * \return Thread ID
+ */
+uint32_t Tracer::currentThreadId()
+{
+  static std::atomic<uint32_t> nextId(0);
+  thread_local uint32_t id = nextId++;
+  return id;
+}
@@ -0,0 +1,130 @@
+#include <cxxtest/TestSuite.h>
+
+#include <sstream>
+
+#include "EventLogger.h"
+#include "Circle.h"
+#include "Square.h"
+
+class EventLoggerTest : public CxxTest::TestSuite
+{
+public:
+  void test_RecordCircle(void)
+  {
+    Circle c(2.5);
+    c.setPosition(Vector2D(10.0, 20.0));
+
+    ShapeRecord r = EventLogger::recordShape(3, c);
+
+    TS_ASSERT_EQUALS(r.id, 3);
+    TS_ASSERT_EQUALS(r.type, S_CIRCLE);
+    TS_ASSERT_EQUALS(r.x, 10.0);
+    TS_ASSERT_EQUALS(r.y, 20.0);
+    TS_ASSERT_EQUALS(r.a, 2.5);
+  }
+
+  void test_RecordSquare(void)
+  {
+    Square s(3.0, 4.0);
+    s.setPosition(Vector2D(5.0, 6.0));
+
+    ShapeRecord r = EventLogger::recordShape(4, s);
+
+    TS_ASSERT_EQUALS(r.id, 4);
+    TS_ASSERT_EQUALS(r.type, S_SQUARE);
+    TS_ASSERT_EQUALS(r.x, 5.0);
+    TS_ASSERT_EQUALS(r.y, 6.0);
+    TS_ASSERT_EQUALS(r.a, 3.0);
+    TS_ASSERT_EQUALS(r.b, 4.0);
+  }
+
+  void test_OutputMatchesDirectOutput(void)
+  {
+    Circle c(1.25);
+    c.setPosition(Vector2D(10.5, 20.75));
+    Square s(3.0, 4.5);
+    s.setPosition(Vector2D(12.0, 21.0));
+
+    std::stringstream expected;
+    expected << c << " intersects " << s << std::endl;
+    expected << s << " intersects " << c << std::endl;
+
+    std::stringstream out;
+    {
+      EventLogger logger(out);
+      logger.logIntersection(1, 0, c, 1, s);
+      logger.logIntersection(2, 1, s, 0, c);
+    }
+
+    TS_ASSERT_EQUALS(out.str(), expected.str());
+  }
+
+  void test_FlushWritesAllEvents(void)
+  {
+    Circle c(1.0);
+    std::stringstream out;
+    EventLogger logger(out, 2, BP_BLOCK);
+
+    for (int i = 0; i < 100; i++)
+      logger.logIntersection(i, 0, c, 1, c);
+    logger.flush();
+
+    TS_ASSERT_EQUALS(countLines(out.str()), 100);
+    TS_ASSERT_EQUALS(logger.droppedCount(), 0);
+  }
+
+  void test_DropPolicyDiscardsEvents(void)
+  {
+    Circle c(1.0);
+    std::stringstream out;
+    EventLogger logger(out, 2, BP_DROP);
+
+    for (int i = 0; i < 10000; i++)
+      logger.logIntersection(i, 0, c, 1, c);
+    logger.flush();
+
+    /* Every event is either written or counted as dropped */
+    const size_t lines = countLines(out.str());
+    TS_ASSERT_EQUALS(lines + logger.droppedCount(), 10000);
+    TS_ASSERT_EQUALS(out.str().find("dropped"), std::string::npos);
+  }
+
+  void test_CountPolicyReportsDrops(void)
+  {
+    Circle c(1.0);
+    std::stringstream out;
+    EventLogger logger(out, 2, BP_COUNT);
+
+    for (int i = 0; i < 10000; i++)
+      logger.logIntersection(i, 0, c, 1, c);
+    logger.flush();
+
+    /* Sum the counts reported in the output */
+    std::stringstream lines(out.str());
+    std::string line;
+    unsigned long intersections = 0;
+    unsigned long reported = 0;
+    while (std::getline(lines, line))
+    {
+      if (line[0] == '[')
+        reported += std::stoul(line.substr(1));
+      else
+        intersections++;
+    }
+
+    TS_ASSERT_EQUALS(reported, logger.droppedCount());
+    TS_ASSERT_EQUALS(intersections + reported, 10000);
+  }
+
+private:
+  size_t countLines(const std::string &str)
+  {
+    size_t n = 0;
+    for (size_t i = 0; i < str.size(); i++)
+    {
+      if (str[i] == '\n')
+        n++;
+    }
+    return n;
+  }
+};
@@ -1,11 +1,166 @@
 #include <cxxtest/TestSuite.h>
 
+#include <sstream>
+#include <vector>
+
 #include "GameImpl.h"
+#include "BoundingBox.h"
+#include "Shape.h"
 
 class GameImplTest : public CxxTest::TestSuite
 {
 public:
-  void test_(void)
+  void test_SameSeedGeneratesSameShapes(void)
+  {
+    BoundingBox box(0, 0, 100, 100);
+    std::stringstream out1;
+    std::stringstream out2;
+    GameImpl game1(box, out1, 5);
+    GameImpl game2(box, out2, 5);
+
+    /* Interleaving must not matter as each game has its own generator */
+    game1.generateInitialShapes(10, 5.0);
+    game2.generateInitialShapes(10, 5.0);
+    game1.applyRandomOffsets(2.0);
+    game2.applyRandomOffsets(2.0);
+
+    game1.printAllShapes();
+    game2.printAllShapes();
+
+    TS_ASSERT(!out1.str().empty());
+    TS_ASSERT_EQUALS(out1.str(), out2.str());
+  }
+
+  void test_PrintAllShapesUsesIds(void)
+  {
+    BoundingBox box(0, 0, 100, 100);
+    std::stringstream out;
+    GameImpl game(box, out, 3);
+    game.generateInitialShapes(3, 5.0);
+
+    game.printAllShapes();
+
+    std::stringstream expected;
+    for (ShapeList::const_iterator it = game.shapeIds().begin();
+         it != game.shapeIds().end(); ++it)
+      expected << *it << ": " << *game.getShape(*it) << std::endl;
+
+    TS_ASSERT_EQUALS(out.str(), expected.str());
+    TS_ASSERT_EQUALS(out.str().substr(0, 3), "0: ");
+  }
+
+  void test_IdsStableAfterRemoval(void)
+  {
+    BoundingBox box(0, 0, 100, 100);
+    std::stringstream out;
+    GameImpl game(box, out, 11);
+    game.generateInitialShapes(50, 5.0);
+
+    /* Remember every shape by ID */
+    std::vector<ShapeID> ids(game.shapeIds().begin(), game.shapeIds().end());
+    std::vector<Shape *> shapes;
+    for (size_t i = 0; i < ids.size(); i++)
+      shapes.push_back(game.getShape(ids[i]));
+
+    while (!game.cullOverlapping())
+      game.applyRandomOffsets(2.0);
+
+    /* Surviving IDs still refer to the same shape, removed IDs to nothing */
+    size_t found = 0;
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+      Shape *s = game.getShape(ids[i]);
+      TS_ASSERT(s == NULL || s == shapes[i]);
+      if (s != NULL)
+        found++;
+    }
+
+    TS_ASSERT_EQUALS(found, game.numShapes());
+    TS_ASSERT(found < ids.size());
+  }
+
+  void test_CollisionFreeTicksNoShapes(void)
   {
+    BoundingBox box(0, 0, 100, 100);
+    std::stringstream out;
+    GameImpl game(box, out, 1);
+
+    TS_ASSERT_EQUALS(game.collisionFreeTicks(2.0), 0);
+    TS_ASSERT_EQUALS(game.fastForward(2.0), 0);
+  }
+
+  void test_CollisionFreeTicksIsLowerBound(void)
+  {
+    BoundingBox box(0, 0, 100, 100);
+    std::stringstream out;
+    GameImpl game(box, out, 42);
+    game.generateInitialShapes(20, 5.0);
+
+    unsigned int checkedTicks = 0;
+    for (int i = 0; i < 5000 && game.numShapes() > 1; i++)
+    {
+      const unsigned int ticks = game.collisionFreeTicks(2.0);
+
+      /* No shapes may be removed within the predicted number of ticks */
+      for (unsigned int j = 0; j < ticks; j++)
+      {
+        game.applyRandomOffsets(2.0);
+        TS_ASSERT(!game.cullOverlapping());
+      }
+      checkedTicks += ticks;
+
+      game.applyRandomOffsets(2.0);
+      game.cullOverlapping();
+    }
+
+    TS_ASSERT(checkedTicks > 0);
+  }
+
+  void test_FastForwardMatchesTickByTick(void)
+  {
+    const std::string expected = runGame(false);
+    const std::string actual = runGame(true);
+
+    TS_ASSERT(!expected.empty());
+    TS_ASSERT_EQUALS(actual, expected);
+  }
+
+private:
+  /**
+   * \brief Runs a seeded game to completion, returning its output annotated
+   *        with the iteration on which shapes were removed.
+   *
+   * \param fastForward If ticks with no possible intersection are skipped
+   * \return Game output
+   */
+  std::string runGame(bool fastForward)
+  {
+    BoundingBox box(0, 0, 100, 100);
+    std::stringstream out;
+    GameImpl game(box, out, 7);
+    game.generateInitialShapes(15, 5.0);
+
+    unsigned int iteration = 1;
+    while (game.numShapes() > 1 && iteration < 100000)
+    {
+      if (fastForward)
+      {
+        const unsigned int skipped = game.fastForward(2.0);
+        if (skipped > 0)
+        {
+          iteration += skipped;
+          continue;
+        }
+      }
+
+      game.applyRandomOffsets(2.0);
+      if (game.cullOverlapping())
+        out << "iteration " << iteration << std::endl;
+
+      iteration++;
+    }
+
+    out << "finished " << iteration << std::endl;
+    return out.str();
   }
 };
@@ -0,0 +1,89 @@
+#include <cxxtest/TestSuite.h>
+
+#include <sstream>
+
+#include "PhaseProfiler.h"
+#include "PerfCounters.h"
+
+class PhaseProfilerTest : public CxxTest::TestSuite
+{
+public:
+  void test_PerfCountersDegradeGracefully(void)
+  {
+    PerfCounters c;
+    PerfSample s1;
+    PerfSample s2;
+
+    /* Reading must succeed if and only if counters are available */
+    TS_ASSERT_EQUALS(c.read(s1), c.available());
+
+    volatile double x = 0.0;
+    for (int i = 0; i < 100000; i++)
+      x = x + i;
+
+    TS_ASSERT_EQUALS(c.read(s2), c.available());
+
+    for (int i = 0; i < PC_NUM_COUNTERS; i++)
+    {
+      if (c.available((PerfCounter)i))
+        TS_ASSERT(s2.values[i] >= s1.values[i]);
+      else
+        TS_ASSERT_EQUALS(s2.values[i], 0);
+    }
+  }
+
+  void test_CounterNames(void)
+  {
+    TS_ASSERT_EQUALS(std::string(PerfCounters::name(PC_CYCLES)), "cycles");
+    TS_ASSERT_EQUALS(std::string(PerfCounters::name(PC_BRANCH_MISSES)),
+                     "branch misses");
+  }
+
+  void test_ScopeAddsCalls(void)
+  {
+    PhaseProfiler p(false);
+
+    for (int i = 0; i < 3; i++)
+      PhaseScope s(NULL, &p, "phase");
+    PhaseScope s(NULL, &p, "other");
+
+    TS_ASSERT_EQUALS(p.calls("phase"), 3);
+    TS_ASSERT_EQUALS(p.calls("other"), 0);
+    TS_ASSERT_EQUALS(p.calls("missing"), 0);
+  }
+
+  void test_WriteWithoutCounters(void)
+  {
+    PhaseProfiler p(false);
+    PerfSample start = PerfSample();
+    PerfSample end = PerfSample();
+    p.add("phase", 2500000, start, end);
+    p.add("phase", 500000, start, end);
+
+    std::stringstream out;
+    p.write(out);
+
+    TS_ASSERT(!p.countersAvailable());
+    TS_ASSERT_DIFFERS(out.str().find("phase"), std::string::npos);
+    TS_ASSERT_DIFFERS(out.str().find("3.000"), std::string::npos);
+    TS_ASSERT_DIFFERS(out.str().find("n/a"), std::string::npos);
+  }
+
+  void test_AddAccumulatesCounterDeltas(void)
+  {
+    PhaseProfiler p(false);
+    PerfSample start = PerfSample();
+    PerfSample end = PerfSample();
+    end.values[PC_CYCLES] = 200;
+    end.values[PC_INSTRUCTIONS] = 300;
+
+    p.add("phase", 1, start, end);
+    p.add("phase", 1, start, end);
+
+    std::stringstream out;
+    p.write(out);
+
+    /* IPC is computed from the accumulated totals */
+    TS_ASSERT_DIFFERS(out.str().find("1.50"), std::string::npos);
+  }
+};
@@ -0,0 +1,92 @@
+#include <cxxtest/TestSuite.h>
+
+#include "ShapeTable.h"
+#include "Circle.h"
+#include "Square.h"
+
+class ShapeTableTest : public CxxTest::TestSuite
+{
+public:
+  void test_Create(void)
+  {
+    ShapeTable t;
+
+    TS_ASSERT_EQUALS(t.size(), 0);
+    TS_ASSERT(t.get(0) == NULL);
+    TS_ASSERT(!t.contains(INVALID_SHAPE_ID));
+  }
+
+  void test_Insert(void)
+  {
+    ShapeTable t;
+    Circle *c = new Circle(1.0);
+    Square *s = new Square(2.0, 3.0);
+
+    ShapeID cId = t.insert(c);
+    ShapeID sId = t.insert(s);
+
+    TS_ASSERT_EQUALS(t.size(), 2);
+    TS_ASSERT_EQUALS(cId, 0);
+    TS_ASSERT_EQUALS(sId, 1);
+    TS_ASSERT_EQUALS(t.get(cId), c);
+    TS_ASSERT_EQUALS(t.get(sId), s);
+  }
+
+  void test_RemoveDoesNotInvalidateOthers(void)
+  {
+    ShapeTable t;
+    Circle *c1 = new Circle(1.0);
+    Circle *c2 = new Circle(2.0);
+    Circle *c3 = new Circle(3.0);
+
+    ShapeID id1 = t.insert(c1);
+    ShapeID id2 = t.insert(c2);
+    ShapeID id3 = t.insert(c3);
+
+    TS_ASSERT(t.remove(id2));
+    TS_ASSERT(!t.remove(id2));
+
+    TS_ASSERT_EQUALS(t.size(), 2);
+    TS_ASSERT_EQUALS(t.get(id1), c1);
+    TS_ASSERT(t.get(id2) == NULL);
+    TS_ASSERT_EQUALS(t.get(id3), c3);
+  }
+
+  void test_ReusedSlotHasNewGeneration(void)
+  {
+    ShapeTable t;
+
+    ShapeID oldId = t.insert(new Circle(1.0));
+    t.remove(oldId);
+    Circle *c = new Circle(2.0);
+    ShapeID newId = t.insert(c);
+
+    TS_ASSERT_EQUALS(ShapeTable::slotOf(newId), ShapeTable::slotOf(oldId));
+    TS_ASSERT_EQUALS(ShapeTable::generationOf(newId),
+                     ShapeTable::generationOf(oldId) + 1);
+    TS_ASSERT_DIFFERS(newId, oldId);
+
+    /* The stale ID must not resolve to the new shape */
+    TS_ASSERT(t.get(oldId) == NULL);
+    TS_ASSERT_EQUALS(t.get(newId), c);
+  }
+
+  void test_IdsAreNeverReused(void)
+  {
+    ShapeTable t;
+    ShapeID last = t.insert(new Circle(1.0));
+
+    /* Cycle one slot through every generation */
+    bool unique = true;
+    for (int i = 0; i < 5000; i++)
+    {
+      t.remove(last);
+      ShapeID id = t.insert(new Circle(1.0));
+      unique &= (id != last) && (id != INVALID_SHAPE_ID);
+      last = id;
+    }
+
+    TS_ASSERT(unique);
+    TS_ASSERT_EQUALS(t.size(), 1);
+  }
+};
@@ -0,0 +1,97 @@
+#include <cxxtest/TestSuite.h>
+
+#include <thread>
+
+#include "SpscRingBuffer.h"
+
+class SpscRingBufferTest : public CxxTest::TestSuite
+{
+public:
+  void test_CapacityRoundedToPowerOfTwo(void)
+  {
+    SpscRingBuffer<int> b(5);
+
+    TS_ASSERT_EQUALS(b.capacity(), 8);
+    TS_ASSERT(b.empty());
+  }
+
+  void test_PushPop(void)
+  {
+    SpscRingBuffer<int> b(4);
+    int v = 0;
+
+    TS_ASSERT(!b.tryPop(v));
+    TS_ASSERT(b.tryPush(1));
+    TS_ASSERT(b.tryPush(2));
+    TS_ASSERT_EQUALS(b.size(), 2);
+
+    TS_ASSERT(b.tryPop(v));
+    TS_ASSERT_EQUALS(v, 1);
+    TS_ASSERT(b.tryPop(v));
+    TS_ASSERT_EQUALS(v, 2);
+    TS_ASSERT(!b.tryPop(v));
+  }
+
+  void test_PushWhenFull(void)
+  {
+    SpscRingBuffer<int> b(4);
+
+    for (int i = 0; i < 4; i++)
+      TS_ASSERT(b.tryPush(i));
+
+    TS_ASSERT(!b.tryPush(4));
+    TS_ASSERT_EQUALS(b.size(), 4);
+  }
+
+  void test_WrapAround(void)
+  {
+    SpscRingBuffer<int> b(4);
+    int v = 0;
+
+    for (int i = 0; i < 100; i++)
+    {
+      TS_ASSERT(b.tryPush(i));
+      TS_ASSERT(b.tryPop(v));
+      TS_ASSERT_EQUALS(v, i);
+    }
+
+    TS_ASSERT(b.empty());
+  }
+
+  void test_ConcurrentProducerConsumer(void)
+  {
+    const int n = 100000;
+    SpscRingBuffer<int> b(64);
+
+    std::thread producer([&]()
+    {
+      for (int i = 0; i < n; i++)
+      {
+        while (!b.tryPush(i))
+          std::this_thread::yield();
+      }
+    });
+
+    /* Items must arrive in order with none missing */
+    int expected = 0;
+    bool inOrder = true;
+    while (expected < n)
+    {
+      int v;
+      if (b.tryPop(v))
+      {
+        inOrder &= (v == expected);
+        expected++;
+      }
+      else
+      {
+        std::this_thread::yield();
+      }
+    }
+
+    producer.join();
+
+    TS_ASSERT(inOrder);
+    TS_ASSERT(b.empty());
+  }
+};
@@ -0,0 +1,95 @@
+#include <cxxtest/TestSuite.h>
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "Tracer.h"
+
+class TracerTest : public CxxTest::TestSuite
+{
+public:
+  void test_Record(void)
+  {
+    Tracer t(4);
+
+    t.record("a", 1000, 3500);
+
+    TS_ASSERT_EQUALS(t.size(), 1);
+    TS_ASSERT_EQUALS(t.droppedCount(), 0);
+
+    std::stringstream out;
+    t.writeJson(out);
+    TS_ASSERT_DIFFERS(out.str().find("\"name\":\"a\",\"ph\":\"X\""),
+                      std::string::npos);
+    TS_ASSERT_DIFFERS(out.str().find("\"ts\":1.000,\"dur\":2.500"),
+                      std::string::npos);
+  }
+
+  void test_DropWhenFull(void)
+  {
+    Tracer t(2);
+
+    for (int i = 0; i < 5; i++)
+      t.record("a", 0, 1);
+
+    TS_ASSERT_EQUALS(t.size(), 2);
+    TS_ASSERT_EQUALS(t.droppedCount(), 3);
+
+    std::stringstream out;
+    t.writeJson(out);
+    TS_ASSERT_DIFFERS(out.str().find("\"droppedEvents\":3"),
+                      std::string::npos);
+  }
+
+  void test_Scope(void)
+  {
+    Tracer t(4);
+
+    {
+      TraceScope s(&t, "scope");
+      TS_ASSERT_EQUALS(t.size(), 0);
+    }
+
+    TS_ASSERT_EQUALS(t.size(), 1);
+  }
+
+  void test_ScopeWithoutTracer(void)
+  {
+    TS_ASSERT_THROWS_NOTHING(TraceScope s(NULL, "scope"));
+  }
+
+  void test_ThreadsHaveDistinctIds(void)
+  {
+    Tracer t(1000);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 4; i++)
+    {
+      threads.push_back(std::thread([&]()
+      {
+        for (int j = 0; j < 100; j++)
+          TraceScope s(&t, "work");
+      }));
+    }
+
+    for (size_t i = 0; i < threads.size(); i++)
+      threads[i].join();
+
+    TS_ASSERT_EQUALS(t.size(), 400);
+    TS_ASSERT_DIFFERS(Tracer::currentThreadId(), (uint32_t)-1);
+
+    /* Each thread records a tid of its own */
+    std::stringstream out;
+    t.writeJson(out);
+    size_t distinct = 0;
+    for (uint32_t id = 0; id < 16; id++)
+    {
+      std::stringstream tid;
+      tid << "\"tid\":" << id << ",";
+      if (out.str().find(tid.str()) != std::string::npos)
+        distinct++;
+    }
+    TS_ASSERT_EQUALS(distinct, 4);
+  }
+};